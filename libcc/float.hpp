@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 namespace LibCC
 {
   // this simple class just "attaches" to a float and provides a window into it's inner workings.
@@ -116,7 +118,7 @@ namespace LibCC
     {
       InternalType r;
       r = Sign ? SignMask : 0;// sign
-      r |= (ex + ExponentShift) << MantissaBits;// exponent
+      r |= (ex + ExponentBias) << MantissaBits;// exponent
       r |= m & MantissaMask;// mantissa
       return *(reinterpret_cast<BasicType*>(&r));
     }
@@ -212,8 +214,8 @@ namespace LibCC
       This& operator =(const This& rhs) { return *this; }// do not allow assignment.  this is also to prevent warning C4512 "'class' : assignment operator could not be generated"
 
   };
-  typedef IEEEFloat<float, unsigned __int32, signed __int8, unsigned __int32, 8, 23> SinglePrecisionFloat;
-  typedef IEEEFloat<double, unsigned __int64, signed __int16, unsigned __int64, 11, 52> DoublePrecisionFloat;
+  typedef IEEEFloat<float, uint32_t, int8_t, uint32_t, 8, 23> SinglePrecisionFloat;
+  typedef IEEEFloat<double, uint64_t, int16_t, uint64_t, 11, 52> DoublePrecisionFloat;
 }
 
 
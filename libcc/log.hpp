@@ -2,19 +2,37 @@
 
 #pragma once
 
-#ifndef WIN32
-#error LibCC::Log is only available on Windows platforms.
-#endif
-
 #include "stringutil.hpp"
-#include "winapi.hpp"
 #include <vector>
-#include <process.h>
-#include <shlwapi.h>
-#include <commctrl.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <type_traits>
+
+#ifdef WIN32
+# include "winapi.hpp"
+# include <process.h>
+# include <shlwapi.h>
+# include <commctrl.h>
+
+# pragma comment(lib, "shlwapi.lib")
+# pragma comment(lib, "comctl32.lib")
+#else
+# include <errno.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/stat.h>
+# include <sys/syscall.h>
+# include <time.h>
 
-#pragma comment(lib, "shlwapi.lib")
-#pragma comment(lib, "comctl32.lib")
+namespace LibCC
+{
+	typedef void* HINSTANCE;// only used for the log window, which is Windows-only
+}
+#endif
 
 // defaults
 #ifndef LIBCC_ENABLE_LOG_FILE
@@ -26,7 +44,7 @@
 #endif
 
 #ifndef LIBCC_ENABLE_LOG_WINDOW
-# define LIBCC_ENABLE_LOG_WINDOW true
+# define LIBCC_ENABLE_LOG_WINDOW true// Windows only
 #endif
 
 #ifndef LIBCC_LOG_WINDOW_WIDTH
@@ -37,12 +55,666 @@
 # define LIBCC_LOG_WINDOW_HEIGHT 300
 #endif
 
+#ifndef LIBCC_LOG_FILE_BUFFER
+# define LIBCC_LOG_FILE_BUFFER 65536// bytes collected per log file before they're written; see Log::SetFileBuffering()
+#endif
+
+#ifndef LIBCC_LOG_FLUSH_INTERVAL
+# define LIBCC_LOG_FLUSH_INTERVAL 1000// ms a log line may wait in the file buffer
+#endif
+
+#ifndef LIBCC_LOG_CLOCK_RESYNC
+# define LIBCC_LOG_CLOCK_RESYNC 1000// ms between rereading the wall clock; see LogClock
+#endif
+
+// string literals in the native log char type (see LIBCC_UTF8)
+#if LIBCC_UTF8 == 1
+# define LIBCC_LOG_TEXT(x) x
+#else
+# define LIBCC_LOG_TEXT(x) L ## x
+#endif
+
+// the lowest LogLevel compiled in. the macros below drop calls under it at compile time, arguments and all; the
+// runtime threshold (Log::SetLevel(), LogCategory::SetLevel()) is checked before any argument is evaluated.
+#ifndef LIBCC_LOG_MIN_LEVEL
+# define LIBCC_LOG_MIN_LEVEL LibCC::LogLevelTrace
+#endif
+
+// true if a message of this level would be logged
+#define LIBCC_LOG_ENABLED(log, level) ((level) >= LIBCC_LOG_MIN_LEVEL && (log).IsEnabled(level))
+
+// LIBCC_LOG(log, LibCC::LogLevelDebug, LibCC::FormatA("x = %").i(x)) logs like Log::Message(), with 1 or 2 strings.
+// the strings aren't built unless the level is on.
+#define LIBCC_LOG(log, level, ...) do { if(LIBCC_LOG_ENABLED(log, level)) (log).Message(level, __VA_ARGS__); } while(0)
+
+// the same, for a message in a LogCategory; the category's name goes before the message.
+#define LIBCC_LOG_CATEGORY(log, category, level, message) do { if((level) >= LIBCC_LOG_MIN_LEVEL && (category).IsEnabled(log, level)) (log).Message(category, level, message); } while(0)
+
+// logs a Log::Trace() message; the format string (a literal) is registered the first time this line runs.
+#define LIBCC_LOG_TRACE_LEVEL(log, level, format, ...) do { if(LIBCC_LOG_ENABLED(log, level)) { static const LibCC::LogFormatID libccLogFormatID = LibCC::LogRegisterFormat(format); (log).Trace(level, libccLogFormatID, ##__VA_ARGS__); } } while(0)
+#define LIBCC_LOG_TRACE(log, format, ...) LIBCC_LOG_TRACE_LEVEL(log, LibCC::LogLevelInfo, format, ##__VA_ARGS__)
+
+// line endings in log files and on stdout
+#ifdef WIN32
+# define LIBCC_LOG_NEWLINE LIBCC_LOG_TEXT("\r\n")
+#else
+# define LIBCC_LOG_NEWLINE LIBCC_LOG_TEXT("\n")
+#endif
+
 namespace LibCC
 {
+	// a bounded lock-free queue (Dmitry Vyukov's array queue) for small, trivially copyable items. each slot carries a
+	// sequence number saying whether it's free to write or ready to read, so Push and Pop take one CAS on their own
+	// index and never wait for each other. any thread may Pop, which is what lets a producer evict the oldest entry.
+	template<typename T>
+	class BoundedQueue
+	{
+	public:
+		// capacity is rounded up to a power of 2
+		explicit BoundedQueue(size_t capacity)
+		{
+			size_t n = 2;
+			while(n < capacity)
+				n *= 2;
+			m_cells = new Cell[n];
+			m_mask = n - 1;
+			for(size_t i = 0; i < n; ++ i)
+			{
+				m_cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+			m_pushPos.store(0, std::memory_order_relaxed);
+			m_popPos.store(0, std::memory_order_relaxed);
+		}
+
+		~BoundedQueue()
+		{
+			delete [] m_cells;
+		}
+
+		size_t Capacity() const
+		{
+			return m_mask + 1;
+		}
+
+		// false if the queue is full
+		bool Push(const T& item)
+		{
+			size_t pos = m_pushPos.load(std::memory_order_relaxed);
+			for(;;)
+			{
+				Cell& cell = m_cells[pos & m_mask];
+				size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+				if(diff == 0)
+				{
+					if(m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						cell.item = item;
+						cell.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if(diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = m_pushPos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		// false if the queue is empty
+		bool Pop(T& item)
+		{
+			size_t pos = m_popPos.load(std::memory_order_relaxed);
+			for(;;)
+			{
+				Cell& cell = m_cells[pos & m_mask];
+				size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)(pos + 1);
+				if(diff == 0)
+				{
+					if(m_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						item = cell.item;
+						cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if(diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = m_popPos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+	private:
+		BoundedQueue(const BoundedQueue<T>&);
+		BoundedQueue<T>& operator =(const BoundedQueue<T>&);
+
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			T item;
+		};
+
+		Cell* m_cells;
+		size_t m_mask;
+		char m_pad0[64];// keep the producers' and the consumer's index on different cache lines
+		std::atomic<size_t> m_pushPos;
+		char m_pad1[64];
+		std::atomic<size_t> m_popPos;
+	};
+
+	// what an asynchronous Log does with a message when its queue is full
+	enum LogBackpressure
+	{
+		LogBackpressureBlock,// wait for room
+		LogBackpressureDrop,// throw the new message away
+		LogBackpressureDropOldest// throw the oldest queued message away to make room
+	};
+
+	// message severity. Log::Message() and Log::Trace() without a level log at LogLevelInfo.
+	enum LogLevel
+	{
+		LogLevelDefault = 0,// LogCategory: use the Log's threshold. in binary logs: written before there were levels
+		LogLevelTrace,
+		LogLevelDebug,
+		LogLevelInfo,
+		LogLevelWarning,
+		LogLevelError,
+		LogLevelFatal,
+		LogLevelOff// as a threshold: nothing
+	};
+
+	// what goes in front of a message of this level; info messages are written as they always were.
+	inline const char* LogLevelTag(unsigned level)
+	{
+		switch(level)
+		{
+		case LogLevelTrace: return "trace: ";
+		case LogLevelDebug: return "debug: ";
+		case LogLevelWarning: return "warning: ";
+		case LogLevelError: return "error: ";
+		case LogLevelFatal: return "fatal: ";
+		}
+		return "";
+	}
+
+	// time-based log rotation; see Log::EnableRotation()
+	enum LogRotatePeriod
+	{
+		LogRotateNever,
+		LogRotateHourly,
+		LogRotateDaily
+	};
+
+	struct LogQueueStats
+	{
+		size_t dropped;// messages thrown away by LogBackpressureDrop
+		size_t droppedOldest;// messages evicted by LogBackpressureDropOldest
+		size_t blocked;// messages that had to wait for room under LogBackpressureBlock
+		size_t queues;// producer queues there are now
+	};
+
+	// local wall-clock time of a log message
+	struct LogTime
+	{
+		WORD wYear;
+		WORD wMonth;
+		WORD wDay;
+		WORD wHour;
+		WORD wMinute;
+		WORD wSecond;
+		WORD wMilliseconds;
+	};
+
+	// log messages are stamped with microseconds since 1970-01-01 UTC, which is also what binary log files store. the
+	// stamp is the monotonic clock plus an offset to the wall clock, and the offset is only measured again every
+	// LIBCC_LOG_CLOCK_RESYNC ms. so messages from one thread never go back in time between resyncs, even when the wall
+	// clock is set back, and a step of the wall clock shows up in the log within a resync interval.
+	class LogClock
+	{
+	public:
+		LogClock()
+		{
+			Resync(Monotonic());
+		}
+
+		uint64_t Now()
+		{
+			int64_t now = Monotonic();
+			if(now - m_syncedAt.load(std::memory_order_relaxed) >= (int64_t)LIBCC_LOG_CLOCK_RESYNC * 1000)
+			{
+				Resync(now);// any thread that gets here first; the others may resync too, which is harmless
+			}
+			return (uint64_t)(now + m_offset.load(std::memory_order_relaxed));
+		}
+
+		// microseconds since 1970-01-01 UTC, straight from the wall clock
+		static uint64_t WallClock()
+		{
+#ifdef WIN32
+			FILETIME ft;
+			GetSystemTimeAsFileTime(&ft);
+			uint64_t t = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;// 100ns units since 1601
+			return (t - 116444736000000000ULL) / 10;
+#else
+			struct timespec ts;
+			clock_gettime(CLOCK_REALTIME, &ts);
+			return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+		}
+
+	private:
+		static int64_t Monotonic()
+		{
+			return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		void Resync(int64_t now)
+		{
+			m_offset.store((int64_t)WallClock() - now, std::memory_order_relaxed);
+			m_syncedAt.store(now, std::memory_order_relaxed);
+		}
+
+		std::atomic<int64_t> m_offset;// wall clock - monotonic clock
+		std::atomic<int64_t> m_syncedAt;// monotonic clock
+	};
+
+	inline LogClock& GetLogClock()
+	{
+		static LogClock clock;
+		return clock;
+	}
+
+	inline uint64_t GetLogTimestamp()
+	{
+		return GetLogClock().Now();
+	}
+
+	inline void LogTimestampToLocalTime(uint64_t timestamp, LogTime& t)
+	{
+#ifdef WIN32
+		uint64_t ft64 = timestamp * 10 + 116444736000000000ULL;
+		FILETIME ft;
+		ft.dwLowDateTime = (DWORD)ft64;
+		ft.dwHighDateTime = (DWORD)(ft64 >> 32);
+		FILETIME local;
+		SYSTEMTIME st = {0};
+		FileTimeToLocalFileTime(&ft, &local);
+		FileTimeToSystemTime(&local, &st);
+		t.wYear = st.wYear;
+		t.wMonth = st.wMonth;
+		t.wDay = st.wDay;
+		t.wHour = st.wHour;
+		t.wMinute = st.wMinute;
+		t.wSecond = st.wSecond;
+		t.wMilliseconds = st.wMilliseconds;
+#else
+		time_t seconds = (time_t)(timestamp / 1000000);
+		struct tm tm;
+		localtime_r(&seconds, &tm);
+		t.wYear = (WORD)(tm.tm_year + 1900);
+		t.wMonth = (WORD)(tm.tm_mon + 1);
+		t.wDay = (WORD)tm.tm_mday;
+		t.wHour = (WORD)tm.tm_hour;
+		t.wMinute = (WORD)tm.tm_min;
+		t.wSecond = (WORD)tm.tm_sec;
+		t.wMilliseconds = (WORD)(timestamp % 1000000 / 1000);
+#endif
+	}
+
+	// the "[2024-01-01;12:00:00]" that starts a text log line. it's rendered again once a minute; in between, only the
+	// seconds digits are patched. time zone offsets are whole minutes, so the local minute changes with the UTC one.
+	template<typename Char>
+	class LogTimePrefix
+	{
+	public:
+		LogTimePrefix() :
+			m_second(~0ULL),
+			m_minute(~0ULL)
+		{
+		}
+
+		const std::basic_string<Char>& Get(uint64_t timestamp)
+		{
+			uint64_t second = timestamp / 1000000;
+			if(second != m_second)
+			{
+				m_second = second;
+				if(second / 60 == m_minute)
+				{
+					m_time.wSecond = (WORD)(second % 60);
+					m_text[SecondsAt] = (Char)('0' + m_time.wSecond / 10);
+					m_text[SecondsAt + 1] = (Char)('0' + m_time.wSecond % 10);
+				}
+				else
+				{
+					m_minute = second / 60;
+					LogTimestampToLocalTime(second * 1000000, m_time);
+					StringConvert(FormatA("[%-%-%;%:%:%]")
+						.ul<10,4>(m_time.wYear)
+						.ul<10,2>(m_time.wMonth)
+						.ul<10,2>(m_time.wDay)
+						.ul<10,2>(m_time.wHour)
+						.ul<10,2>(m_time.wMinute)
+						.ul<10,2>(m_time.wSecond)
+						.Str(), m_text);
+				}
+			}
+			return m_text;
+		}
+
+		// the local time of the last Get(), to the second
+		const LogTime& Time() const
+		{
+			return m_time;
+		}
+
+	private:
+		static const size_t SecondsAt = 18;
+		uint64_t m_second;
+		uint64_t m_minute;
+		LogTime m_time;
+		std::basic_string<Char> m_text;
+	};
+
+	// binary log files -------------------------------------------------------------------------------------------------
+	// with Log::EnableBinaryFormat(), log files hold records instead of text: a LogBinaryFileHeader, then for each
+	// message a LogBinaryRecordHeader followed by its packed arguments. a format string is written once per file, as a
+	// LogBinaryRecordFormat record before the first message that uses it. LogBinaryReader (and the logdecode tool) turn
+	// a file back into the text the log would have written. numbers are in the byte order of the machine that wrote
+	// them, which is little-endian everywhere this runs.
+	struct LogBinaryFileHeader
+	{
+		char magic[8];// LogBinaryMagic, without the terminator
+		uint32_t version;
+		uint32_t reserved;
+	};
+
+	static const char LogBinaryMagic[] = "LibCCLog";
+	static const uint32_t LogBinaryVersion = 1;
+
+	enum LogBinaryRecordType
+	{
+		LogBinaryRecordMessage = 1,// payload = packed arguments
+		LogBinaryRecordFormat = 2// defines formatID; payload = the UTF-8 format string
+	};
+
+	struct LogBinaryRecordHeader
+	{
+		uint64_t timestamp;// GetLogTimestamp()
+		uint32_t threadID;
+		uint32_t formatID;
+		uint32_t size;// payload bytes that follow
+		uint16_t level;// LogLevel
+		uint8_t type;// LogBinaryRecordType
+		uint8_t indent;// the thread's indent level
+	};
+
+	// a packed argument is one of these bytes followed by the value. strings are a uint32_t byte count and that many
+	// bytes of UTF-8.
+	enum LogBinaryArgType
+	{
+		LogArgInt32 = 1,
+		LogArgUInt32,
+		LogArgInt64,
+		LogArgUInt64,
+		LogArgDouble,
+		LogArgString
+	};
+
+	// format strings for Log::Trace(), in Format syntax. each one is registered once (normally into a static, see
+	// LIBCC_LOG_TRACE) and is only a number after that. ids are per process; a binary file carries the strings it uses.
+	typedef uint32_t LogFormatID;
+	static const LogFormatID LogFormatText = 0;// "%%"; Message() text in a binary file
+	static const LogFormatID LogFormatNone = 0xffffffff;
+
+	class LogFormatRegistry
+	{
+	public:
+		LogFormatRegistry()
+		{
+			Register("%%");// LogFormatText
+		}
+
+		// the same string always gets the same id
+		LogFormatID Register(const char* format)
+		{
+			InternedString<char> s = StringIntern(format);
+			std::lock_guard<std::mutex> lock(m_lock);
+			std::map<InternedString<char>, LogFormatID>::const_iterator it = m_ids.find(s);
+			if(it != m_ids.end())
+				return it->second;
+			LogFormatID id = (LogFormatID)m_formats.size();
+			m_formats.push_back(s);
+			m_ids[s] = id;
+			return id;
+		}
+
+		InternedString<char> Get(LogFormatID id) const
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			return id < m_formats.size() ? m_formats[id] : InternedString<char>();
+		}
+
+	private:
+		mutable std::mutex m_lock;
+		std::vector<InternedString<char> > m_formats;
+		std::map<InternedString<char>, LogFormatID> m_ids;
+	};
+
+	inline LogFormatRegistry& GetLogFormatRegistry()
+	{
+		static LogFormatRegistry registry;
+		return registry;
+	}
+
+	inline LogFormatID LogRegisterFormat(const char* format)
+	{
+		return GetLogFormatRegistry().Register(format);
+	}
+
+	// Log::Trace() arguments -> payload. each one is a type byte and a memcpy; only wide strings need converting.
+	template<typename T>
+	inline void LogPackValue(std::string& p, LogBinaryArgType type, T n)
+	{
+		p.push_back((char)type);
+		p.append(reinterpret_cast<const char*>(&n), sizeof(n));
+	}
+	template<typename T>
+	inline void LogPackInteger(std::string& p, T n)
+	{
+		if(sizeof(T) <= 4)
+		{
+			if(std::is_signed<T>::value)
+				LogPackValue(p, LogArgInt32, (int32_t)n);
+			else
+				LogPackValue(p, LogArgUInt32, (uint32_t)n);
+		}
+		else
+		{
+			if(std::is_signed<T>::value)
+				LogPackValue(p, LogArgInt64, (int64_t)n);
+			else
+				LogPackValue(p, LogArgUInt64, (uint64_t)n);
+		}
+	}
+	inline void LogPackString(std::string& p, const char* s, size_t len)
+	{
+		LogPackValue(p, LogArgString, (uint32_t)len);
+		p.append(s, len);
+	}
+
+	inline void LogPackArg(std::string& p, int n) { LogPackInteger(p, n); }
+	inline void LogPackArg(std::string& p, unsigned int n) { LogPackInteger(p, n); }
+	inline void LogPackArg(std::string& p, long n) { LogPackInteger(p, n); }
+	inline void LogPackArg(std::string& p, unsigned long n) { LogPackInteger(p, n); }
+	inline void LogPackArg(std::string& p, long long n) { LogPackInteger(p, n); }
+	inline void LogPackArg(std::string& p, unsigned long long n) { LogPackInteger(p, n); }
+	inline void LogPackArg(std::string& p, double n) { LogPackValue(p, LogArgDouble, n); }
+	inline void LogPackArg(std::string& p, const char* s) { LogPackString(p, s, StringLength(s)); }
+	inline void LogPackArg(std::string& p, const std::string& s) { LogPackString(p, s.c_str(), s.size()); }
+	inline void LogPackArg(std::string& p, const InternedString<char>& s) { LogPackString(p, s.c_str(), s.size()); }
+	inline void LogPackArg(std::string& p, const std::wstring& s)
+	{
+		std::string a;
+		UTF16ToUTF8(s.c_str(), s.size(), a);
+		LogPackString(p, a.c_str(), a.size());
+	}
+	inline void LogPackArg(std::string& p, const wchar_t* s) { LogPackArg(p, std::wstring(s)); }
+
+	inline void LogPackArgs(std::string&)
+	{
+	}
+	template<typename T, typename... Rest>
+	inline void LogPackArgs(std::string& p, const T& arg, const Rest&... rest)
+	{
+		LogPackArg(p, arg);
+		LogPackArgs(p, rest...);
+	}
+
+	// renders packed arguments through their format string. false if the payload is malformed.
+	inline bool LogRenderArgs(const char* format, const char* payload, size_t size, std::string& out)
+	{
+		FormatA f(format);
+		size_t pos = 0;
+		while(pos < size)
+		{
+			BYTE type = (BYTE)payload[pos ++];
+			size_t valueSize = (type == LogArgInt32 || type == LogArgUInt32 || type == LogArgString) ? 4 : 8;
+			if(type < LogArgInt32 || type > LogArgString || size - pos < valueSize)
+				return false;
+			const char* value = payload + pos;
+			pos += valueSize;
+			switch(type)
+			{
+			case LogArgInt32: { int32_t n; memcpy(&n, value, 4); f.i(n); break; }
+			case LogArgUInt32: { uint32_t n; memcpy(&n, value, 4); f.ul(n); break; }
+			case LogArgInt64: { int64_t n; memcpy(&n, value, 8); f.i64<10>((long long)n); break; }
+			case LogArgUInt64: { uint64_t n; memcpy(&n, value, 8); f.ui64<10>((unsigned long long)n); break; }
+			case LogArgDouble: { double n; memcpy(&n, value, 8); f.d(n); break; }
+			default:
+				{
+					uint32_t len;
+					memcpy(&len, value, 4);
+					if(size - pos < len)
+						return false;
+					f.s(std::string(payload + pos, len));
+					pos += len;
+					break;
+				}
+			}
+		}
+		out = f.Str();
+		return true;
+	}
+
+	// reads a binary log file back as the lines the text log would have had (without line breaks).
+	class LogBinaryReader
+	{
+	public:
+		LogBinaryReader(const void* data, size_t size) :
+			m_data(static_cast<const char*>(data)),
+			m_size(size),
+			m_pos(sizeof(LogBinaryFileHeader)),
+			m_timestamp(0)
+		{
+		}
+
+		// starts with a header of a version this can read
+		bool IsValid() const
+		{
+			LogBinaryFileHeader h;
+			if(m_size < sizeof(h))
+				return false;
+			memcpy(&h, m_data, sizeof(h));
+			return memcmp(h.magic, LogBinaryMagic, sizeof(h.magic)) == 0 && h.version == LogBinaryVersion;
+		}
+
+		// false at the end of the file, or where it's cut off or damaged (then AtEnd() is false).
+		bool ReadLine(std::string& line)
+		{
+			if(!IsValid())
+				return false;
+			LogBinaryRecordHeader h;
+			while(m_size - m_pos >= sizeof(h))
+			{
+				memcpy(&h, m_data + m_pos, sizeof(h));
+				if(m_size - m_pos - sizeof(h) < h.size)
+					return false;
+				if(h.type == LogBinaryRecordFormat && h.formatID == LogFormatNone)
+					return false;// never written; the file's damaged
+				const char* payload = m_data + m_pos + sizeof(h);
+				m_pos += sizeof(h) + h.size;
+
+				if(h.type == LogBinaryRecordFormat)
+				{
+					m_formats[h.formatID].assign(payload, h.size);
+				}
+				else if(h.type == LogBinaryRecordMessage)
+				{
+					m_timestamp = h.timestamp;
+					std::string text;
+					std::map<LogFormatID, std::string>::const_iterator format = m_formats.find(h.formatID);
+					if(format == m_formats.end() || !LogRenderArgs(format->second.c_str(), payload, h.size, text))
+					{
+						text = "(undecodable log message)";
+					}
+					for(std::string::iterator it = text.begin(); it != text.end(); ++ it)
+					{
+						if(*it == '\r' || *it == '\n') *it = '~';
+					}
+					line = m_timePrefix.Get(h.timestamp);
+					line += FormatA("[%] %%%")
+						.ul<16,8,'0'>(h.threadID)
+						.s(std::string(h.indent * 2, ' '))
+						.s(LogLevelTag(h.level))
+						.s(text)
+						.Str();
+					return true;
+				}
+				// other record types are from a newer writer; skip them
+			}
+			return false;
+		}
+
+		bool AtEnd() const
+		{
+			return m_pos == m_size;
+		}
+
+		// the GetLogTimestamp() of the line ReadLine() last returned
+		uint64_t Timestamp() const
+		{
+			return m_timestamp;
+		}
+
+	private:
+		const char* m_data;
+		size_t m_size;
+		size_t m_pos;
+		uint64_t m_timestamp;
+		std::map<LogFormatID, std::string> m_formats;// a file only has the ids it uses, out of the whole process's
+		LogTimePrefix<char> m_timePrefix;
+	};
+
+
+	class LogCategory;
+
 	class Log
 	{
 
 		friend struct LogReference;
+		struct MessageInfo;
+		struct ProducerQueue;
 
 		bool m_unicodeFileFormat;
 		bool m_writeHeader;
@@ -50,14 +722,21 @@ namespace LibCC
 		bool m_enableFile;
 		bool m_enableDebug;
 		bool m_enableStdOut;
+		bool m_enableStdErr;
+		bool m_binaryFormat;
+		std::atomic<int> m_level;// SetLevel()
+		std::atomic<int> m_threshold;// see IsEnabled()
+		uint64_t m_logID;// identifies this log in the threads' indent levels; new for each Create()
 		static const DWORD m_width = LIBCC_LOG_WINDOW_WIDTH;
 		static const DWORD m_height = LIBCC_LOG_WINDOW_HEIGHT;
 
 		static const size_t IndentSize = 2;
+		static const int MaxIndentLevel = 255;// as deep as a binary log record can say; deeper is written at this depth
 
 		bool m_enableRotate;
 		DWORD m_rotateKeepCount;
-		DWORD m_rotateByteSize;
+		uint64_t m_rotateByteSize;// 0 = no size limit
+		LogRotatePeriod m_rotatePeriod;
 
 		// ref count stuff only used by LogReference
 		int m_refcount;
@@ -78,7 +757,11 @@ namespace LibCC
 
 		inline bool WindowEnabled() const
 		{
+#ifdef WIN32
 			return LIBCC_ENABLE_LOG_WINDOW && m_enableWindow;
+#else
+			return false;
+#endif
 		}
 		inline bool FileEnabled() const
 		{
@@ -86,91 +769,131 @@ namespace LibCC
 		}
 		inline bool DebugEnabled() const
 		{
+#ifdef WIN32
 			return LIBCC_ENABLE_LOG_DEBUG && m_enableDebug;
+#else
+			return false;// there's no OutputDebugString
+#endif
 		}
 		inline bool StdOutEnabled() const
 		{
 			return LIBCC_ENABLE_LOG_DEBUG && m_enableStdOut;
 		}
+		inline bool StdErrEnabled() const
+		{
+			return LIBCC_ENABLE_LOG_DEBUG && m_enableStdErr;
+		}
 		inline bool EnabledAtAll() const
 		{
-			return DebugEnabled() || FileEnabled() || WindowEnabled() || StdOutEnabled();
+			return DebugEnabled() || FileEnabled() || WindowEnabled() || StdOutEnabled() || StdErrEnabled();
 		}
-		
+
 	public:
+#if LIBCC_UTF8 == 1
+		typedef std::string _String;// UTF-8; messages are stored and written without conversion.
+#else
 		typedef std::wstring _String;
+#endif
+		typedef _String::value_type _Char;
+		typedef FormatX<_Char> _Format;
 
 		Log() :
-			m_hMain(0),
-			m_hEdit(0),
-			m_hThread(0),
-			m_hInitialized(0),
-			m_hTab(0),
+			m_writeHeader(false),
 			m_enableWindow(false),
 			m_enableFile(false),
 			m_enableDebug(false),
 			m_enableStdOut(false),
-			m_writeHeader(false),
-			m_enableRotate(false)
+			m_enableStdErr(false),
+			m_binaryFormat(false),
+			m_enableRotate(false),
+			m_fileBufferSize(LIBCC_LOG_FILE_BUFFER),
+			m_flushInterval(LIBCC_LOG_FLUSH_INTERVAL)
 		{
+			InitLevel();
+			InitQueue();
+			InitWindow();
 		}
 		template<typename XChar>
 		Log(const std::basic_string<XChar>& fileName, HINSTANCE hInstance, bool enableDebug = true, bool enableWindow = true, bool enableFile = true, bool unicodeFileFormat = true, bool enableStdOut = false, bool writeHeader = true)
 		{
+			m_binaryFormat = false;
+			m_fileBufferSize = LIBCC_LOG_FILE_BUFFER;
+			m_flushInterval = LIBCC_LOG_FLUSH_INTERVAL;
+			InitLevel();
+			InitQueue();
+			InitWindow();
 			Create(fileName, hInstance, enableDebug, enableWindow, enableFile, unicodeFileFormat, enableStdOut, writeHeader);
 		}
 		template<typename XChar>
 		Log(const XChar* fileName, HINSTANCE hInstance, bool enableDebug = true, bool enableWindow = true, bool enableFile = true, bool unicodeFileFormat = true, bool enableStdOut = false, bool writeHeader = true)
 		{
+			m_binaryFormat = false;
+			m_fileBufferSize = LIBCC_LOG_FILE_BUFFER;
+			m_flushInterval = LIBCC_LOG_FLUSH_INTERVAL;
+			InitLevel();
+			InitQueue();
+			InitWindow();
 			Create(fileName, hInstance, enableDebug, enableWindow, enableFile, unicodeFileFormat, enableStdOut, writeHeader);
 		}
 
 		~Log()
 		{
 			Destroy();
+			DeleteQueues();
 		}
 
 		bool IsCreated() const
 		{
-			return m_hThread != 0;
+			return m_thread.joinable();
 		}
 
-		// filename
+		// filename. hInstance is only used for the window; without Windows pass 0.
 		template<typename XChar>
 		void Create(const std::basic_string<XChar>& fileName, HINSTANCE hInstance, bool enableDebug = true, bool enableWindow = true, bool enableFile = true, bool unicodeFileFormat = true, bool enableStdOut = false, bool writeHeader = true)
 		{
-			m_hMain = 0;
-			m_hEdit = 0;
-			m_hThread = 0;
-			m_hInitialized = 0;
-			m_hTab = 0;
 			m_enableDebug = enableDebug;
 			m_enableWindow = enableWindow;
 			m_enableFile = enableFile;
 			m_unicodeFileFormat = unicodeFileFormat;
 			m_enableStdOut = enableStdOut;
+			m_enableStdErr = false;
 			m_writeHeader = writeHeader;
 			m_enableRotate = false;
+			m_rotateByteSize = 0;
+			m_rotatePeriod = LogRotateNever;
+			m_flushTimerSet = false;
+			m_rotatePending = false;
+			m_exit = false;
+			m_logID = NewUniqueID();// indent levels from before are forgotten
+			m_commandsQueued = 0;
+			m_commandsDone = 0;
 			if(EnabledAtAll())
 			{
 				std::wstring fileNameW;
 				StringConvert(fileName, fileNameW);
 				m_fileNames.push_back(fileNameW);
 
+#ifdef WIN32
 				m_hInstance = hInstance;
-				m_hInitialized = CreateEvent(0, FALSE, FALSE, 0);
-				m_hThread = (HANDLE)_beginthread(Log::ThreadProc, 0, this);
-				//SetThreadPriority( m_hThread, THREAD_PRIORITY_NORMAL ); // i don't know what the point of this was.
-				WaitForSingleObject(m_hInitialized, INFINITE);
+				if(WindowEnabled())
+				{
+					m_hInitialized = CreateEvent(0, FALSE, FALSE, 0);
+					m_hWindowThread = (HANDLE)_beginthread(Log::WindowThreadProc, 0, this);
+					WaitForSingleObject(m_hInitialized, INFINITE);
+					CloseHandle(m_hInitialized);
+					m_hInitialized = 0;
+				}
+#else
+				(void)hInstance;
+#endif
+				m_thread = std::thread(&Log::WriterProc, this);
+				UpdateThreshold();
 
 				if(m_writeHeader)
 				{
-					Message(L"-------------------------------");
-					Message(L"Starting log");
+					HeaderMessage(LIBCC_LOG_TEXT("-------------------------------"));
+					HeaderMessage(LIBCC_LOG_TEXT("Starting log"));
 				}
-
-				CloseHandle(m_hInitialized);
-				m_hInitialized = 0;
 			}
 		}
 		template<typename XChar>
@@ -192,150 +915,1537 @@ namespace LibCC
 
 		void Destroy()
 		{
-			if(m_hThread)
+			if(IsCreated())
 			{
-				if(m_writeHeader)
+				if(m_writeHeader && EnabledAtAll())
 				{
-					Message(L"Stopping log");
+					HeaderMessage(LIBCC_LOG_TEXT("Stopping log"));
 				}
-				PostMessage(m_hMain, WM_LogExit, 0, 0);
-				WaitForSingleObject(m_hThread, INFINITE);
-				m_hThread = 0;
+				Flush();
+				{
+					std::lock_guard<std::mutex> lock(m_lock);
+					m_exit = true;
+				}
+				m_wake.notify_one();
+				m_thread.join();
+				UpdateThreshold();
+#ifdef WIN32
+				if(m_hWindowThread)
+				{
+					PostMessage(m_hMain, WM_LogExit, 0, 0);
+					WaitForSingleObject(m_hWindowThread, INFINITE);
+					m_hWindowThread = 0;
+				}
+#endif
+			}
+			// anything a racing producer queued after the last drain
+			DeleteQueues();
+			if(m_async && !m_queuePerThread)
+			{
+				m_queues.store(new ProducerQueue(m_queueCapacity, 0));// still async on the next Create()
 			}
 		}
 
+		// each thread keeps its own indent level, and every message it logs carries the level with it. so these never
+		// wait for the log thread, and the indent is always in order with the thread's messages.
 		void Indent()
 		{
-			if(EnabledAtAll())
+			if(EnabledAtAll() && IsCreated())
 			{
-				SendMessageW(m_hMain, WM_Indent, 0, GetCurrentThreadId());
+				std::vector<ThreadIndent>& indents = GetThreadIndents();
+				for(std::vector<ThreadIndent>::iterator it = indents.begin(); it != indents.end(); ++ it)
+				{
+					if(it->logID == m_logID)
+					{
+						++ it->level;
+						return;
+					}
+				}
+				ThreadIndent ti = { m_logID, 1 };
+				indents.push_back(ti);
 			}
 		}
 
 		void Outdent()
 		{
-			if(EnabledAtAll())
+			if(EnabledAtAll() && IsCreated())
 			{
-				SendMessageW(m_hMain, WM_Outdent, 0, GetCurrentThreadId());
+				std::vector<ThreadIndent>& indents = GetThreadIndents();
+				for(std::vector<ThreadIndent>::iterator it = indents.begin(); it != indents.end(); ++ it)
+				{
+					if(it->logID == m_logID)
+					{
+						if(-- it->level == 0)
+							indents.erase(it);
+						return;
+					}
+				}
 			}
 		}
 
-		int GetIndentLevel()
+		int GetIndentLevel() const
 		{
-			if(EnabledAtAll())
+			const std::vector<ThreadIndent>& indents = GetThreadIndents();
+			for(std::vector<ThreadIndent>::const_iterator it = indents.begin(); it != indents.end(); ++ it)
 			{
-				return (int)SendMessageW(m_hMain, WM_GetIndentLevel, 0, GetCurrentThreadId());
+				if(it->logID == m_logID)
+					return it->level;
 			}
 			return 0;
 		}
 
-		std::wstring GetIndentStringW()
+		// the calling thread's indent, as spaces. it points into a string that lives as long as the program.
+		const wchar_t* GetIndentStringW() const
 		{
-			return std::wstring(GetIndentLevel() * IndentSize, L' ');
+			return IndentSpaces<wchar_t>(GetIndentLevel());
 		}
 
-		std::string GetIndentStringA()
+		const char* GetIndentStringA() const
 		{
-			return std::string(GetIndentLevel() * IndentSize, ' ');
+			return IndentSpaces<char>(GetIndentLevel());
 		}
-    
+
+		// messages below level aren't logged. the default, LogLevelTrace, logs everything; LogLevelOff logs nothing.
+		void SetLevel(LogLevel level)
+		{
+			m_level.store(level, std::memory_order_relaxed);
+			UpdateThreshold();
+		}
+
+		LogLevel GetLevel() const
+		{
+			return (LogLevel)m_level.load(std::memory_order_relaxed);
+		}
+
+		// whether a message of this level would be logged: one compare, against a threshold that's LogLevelOff while
+		// there's nowhere to log to.
+		inline bool IsEnabled(LogLevel level) const
+		{
+			return level >= m_threshold.load(std::memory_order_relaxed);
+		}
+
+		// the same, against a threshold of the caller's (a LogCategory's) instead of the Log's own
+		inline bool IsEnabled(LogLevel level, LogLevel threshold) const
+		{
+			return level >= threshold && m_threshold.load(std::memory_order_relaxed) != LogLevelOff;
+		}
+
     // 2 string args...
     void Message(const _String& s1, const _String& s2)
     {
-			if(EnabledAtAll() && m_hThread)
+			if(IsEnabled(LogLevelInfo))
 			{
-				MessageInfo* pNew = new MessageInfo();
-				GetLocalTime(&pNew->localTime);
+				MessageInfo* pNew = NewMessageInfo(OpMessage);
 				StringConvert(s1, pNew->s1);
 				StringConvert(s2, pNew->s2);
-				pNew->threadID = GetCurrentThreadId();
+				Submit(pNew);
+			}
+    }
+    // an interned first field (a category name, say) is passed by handle and never copied; it has to come from a
+    // pool that outlives the log, like GetStringPool() / StringIntern().
+    void Message(const InternedString<_Char>& s1, const _String& s2)
+    {
+			if(IsEnabled(LogLevelInfo))
+			{
+				MessageInfo* pNew = NewMessageInfo(OpMessage);
+				pNew->s1Interned = s1;
+				StringConvert(s2, pNew->s2);
+				Submit(pNew);
+			}
+    }
+    template<typename YChar>
+    void Message(const InternedString<_Char>& s1, const std::basic_string<YChar>& y)
+    {
+			if(IsEnabled(LogLevelInfo))
+			{
+				_String s2;
+				StringConvert(y, s2);
+				Message(s1, s2);
+			}
+    }
+    template<typename YChar>
+    void Message(const InternedString<_Char>& s1, const YChar* y)
+    {
+			if(IsEnabled(LogLevelInfo))
+			{
+				Message(s1, std::basic_string<YChar>(y));
+			}
+    }
+    void Message(const InternedString<_Char>& s)
+    {
+			if(IsEnabled(LogLevelInfo))
+			{
+				Message(s, _String());
+			}
+    }
+    template<typename XChar, typename YChar>
+    void Message(const std::basic_string<XChar>& x, const std::basic_string<YChar>& y)
+    {
+			if(IsEnabled(LogLevelInfo))
+			{
+				_String s1;
+				_String s2;
+				StringConvert(x, s1);
+				StringConvert(y, s2);
+				Message(s1, s2);
+			}
+    }
+    template<typename XChar, typename YChar>
+    void Message(const std::basic_string<XChar>& x, const YChar* y)
+    {
+			if(IsEnabled(LogLevelInfo))
+			{
+				Message(x, std::basic_string<YChar>(y));
+			}
+    }
+    template<typename XChar, typename YChar>
+    void Message(const XChar* x, const std::basic_string<YChar>& y)
+    {
+			if(IsEnabled(LogLevelInfo))
+			{
+				Message(std::basic_string<XChar>(x), y);
+			}
+    }
+    template<typename XChar, typename YChar>
+    void Message(const XChar* x, const YChar* y)
+    {
+			if(IsEnabled(LogLevelInfo))
+			{
+				Message(std::basic_string<XChar>(x), std::basic_string<YChar>(y));
+			}
+    }
+    
+    // 1 string arg...
+    template<typename XChar>
+    void Message(const XChar* s)
+    {
+			if(IsEnabled(LogLevelInfo))
+			{
+				Message(std::basic_string<XChar>(s));
+			}
+    }
+    template<typename XChar>
+    void Message(const std::basic_string<XChar>& s)
+    {
+			if(IsEnabled(LogLevelInfo))
+			{
+				Message(s, std::string(""));
+			}
+    }
+    template<typename XChar, typename XTraits, typename XAlloc, size_t XInlineCapacity>
+    void Message(const FormatX<XChar, XTraits, XAlloc, XInlineCapacity>& s)
+    {
+			if(IsEnabled(LogLevelInfo))
+			{
+				Message(s.Str(), std::string(""));
+			}
+    }
+
+    // the same, at a level: 1 or 2 strings, each a string, a char pointer or a FormatX, and an InternedString first
+    // (a LogCategory's name, say) is passed by handle. LIBCC_LOG() checks the level before it builds the arguments.
+    template<typename X>
+    void Message(LogLevel level, const X& x)
+    {
+			if(IsEnabled(level))
+			{
+				MessageInfo* pNew = NewMessageInfo(OpMessage);
+				pNew->level = level;
+				MessageText(x, pNew->s1);
+				Submit(pNew);
+			}
+    }
+    template<typename X, typename Y>
+    void Message(LogLevel level, const X& x, const Y& y)
+    {
+			if(IsEnabled(level))
+			{
+				MessageInfo* pNew = NewMessageInfo(OpMessage);
+				pNew->level = level;
+				MessageText(x, pNew->s1);
+				MessageText(y, pNew->s2);
+				Submit(pNew);
+			}
+    }
+    template<typename Y>
+    void Message(LogLevel level, const InternedString<_Char>& s1, const Y& y)
+    {
+			if(IsEnabled(level))
+			{
+				MessageInfo* pNew = NewMessageInfo(OpMessage);
+				pNew->level = level;
+				pNew->s1Interned = s1;
+				MessageText(y, pNew->s2);
+				Submit(pNew);
+			}
+    }
+    // a message in a category goes by the category's threshold; its name is the first field.
+    template<typename Y>
+    void Message(const LogCategory& category, LogLevel level, const Y& y);
+
+	// a message made of a registered format string (LogRegisterFormat(), or LIBCC_LOG_TRACE to do it once per call
+	// site) and arguments: numbers and strings, which are copied as they are and only formatted by whoever reads the
+	// log. char strings are expected to be UTF-8.
+	template<typename... Args>
+	void Trace(LogFormatID format, const Args&... args)
+	{
+		Trace(LogLevelInfo, format, args...);
+	}
+	template<typename... Args>
+	void Trace(LogLevel level, LogFormatID format, const Args&... args)
+	{
+		if(IsEnabled(level))
+		{
+			MessageInfo* pNew = NewMessageInfo(OpMessage);
+			pNew->level = level;
+			pNew->formatID = format;
+			LogPackArgs(pNew->payload, args...);
+			Submit(pNew);
+		}
+	}
+
+	// a file is rotated when it grows past size bytes (0 = any size), and/or when the hour or day of the messages
+	// changes. count old files are kept, as name.0.ext (newest) through name.<count-1>.ext. the log thread checks this
+	// against sizes it keeps track of itself, and does the renaming once it's idle, not while a Message() call waits
+	// (unless the next message comes first).
+	void EnableRotation(bool enable, DWORD count, uint64_t size, LogRotatePeriod period = LogRotateNever)
+	{
+		m_enableRotate = enable;
+		if(m_enableRotate)
+		{
+			m_rotateKeepCount = count;
+			m_rotateByteSize = size;
+			m_rotatePeriod = period;
+		}
+	}
+
+	// log files are written as binary records (see LogBinaryFileHeader) instead of text; the logdecode tool turns them
+	// into text again. Trace() messages are then never formatted at all, unless the window, stdout / stderr or
+	// OutputDebugString want them. call it before Create(), and use a file name of its own.
+	void EnableBinaryFormat(bool enable)
+	{
+		m_binaryFormat = enable;
+	}
+
+	// stdout can also be turned on with the constructor's enableStdOut. call these before logging starts.
+	void EnableStdOut(bool enable)
+	{
+		m_enableStdOut = enable;
+		UpdateThreshold();
+	}
+
+	void EnableStdErr(bool enable)
+	{
+		m_enableStdErr = enable;
+		UpdateThreshold();
+	}
+
+	// asynchronous mode: Message() puts the message in a bounded lock-free queue and returns right away, instead of
+	// waiting for the log thread to write it everywhere. each thread gets a queue of its own (capacity messages), so
+	// threads don't contend with each other; the log thread drains them in batches, merged oldest message first.
+	// queuePerThread = false shares one queue between all threads instead. backpressure says what happens when a
+	// queue is full; GetQueueStats() counts what it did. a thread's queue is handed on to another thread once it exits,
+	// but queues are only freed here or by Destroy(): memory is capacity entries for the most threads that have ever
+	// logged at the same time. async mode stays on across Destroy() and Create().
+	// switch modes before logging starts, or at least while no other thread is logging.
+	void EnableAsync(bool enable, size_t capacity = 8192, LogBackpressure backpressure = LogBackpressureBlock, bool queuePerThread = true)
+	{
+		if(m_async)
+		{
+			m_async = false;
+			if(IsCreated())
+			{
+				MessageInfo mi;
+				mi.op = OpDeleteQueues;
+				Call(mi);// the log thread drains them first
+			}
+			else
+			{
+				DeleteQueues();
+			}
+		}
+		m_backpressure = backpressure;
+		m_queueCapacity = capacity;
+		m_queuePerThread = queuePerThread;
+		if(enable && !queuePerThread)
+		{
+			m_queues.store(new ProducerQueue(capacity, 0));
+		}
+		m_async = enable;
+	}
+
+	bool IsAsync() const
+	{
+		return m_async;
+	}
+
+	// waits until everything logged so far has been written: the async queue is drained and the file buffers are
+	// written out. don't call it from the log thread.
+	void Flush()
+	{
+		if(IsCreated())
+		{
+			MessageInfo mi;
+			mi.op = OpFlush;
+			Call(mi);
+		}
+	}
+
+	// the log thread keeps its files open and collects what it writes to each one in a buffer. a buffer is written
+	// when it reaches bufferSize bytes, flushIntervalMS after the first line went into it, on Flush(), and when the
+	// log is destroyed. bufferSize 0 writes every line as it's logged. call it before logging starts; it's kept across
+	// Create() and Destroy().
+	void SetFileBuffering(size_t bufferSize, DWORD flushIntervalMS)
+	{
+		m_fileBufferSize = bufferSize;
+		m_flushInterval = flushIntervalMS;
+	}
+
+	LogQueueStats GetQueueStats() const
+	{
+		LogQueueStats ret;
+		ret.dropped = m_dropped.load(std::memory_order_relaxed);
+		ret.droppedOldest = m_droppedOldest.load(std::memory_order_relaxed);
+		ret.blocked = m_blocked.load(std::memory_order_relaxed);
+		ret.queues = 0;
+		for(ProducerQueue* q = m_queues.load(std::memory_order_acquire); q; q = q->next)
+		{
+			++ ret.queues;
+		}
+		return ret;
+	}
+
+  private:
+		static const size_t DrainBatchSize = 256;
+
+		// what a MessageInfo asks the log thread to do
+		enum Op
+		{
+			OpMessage,
+			OpFlush,// synchronous only
+			OpDeleteQueues// synchronous only; EnableAsync()
+		};
+
+		static DWORD GetLogThreadID()
+		{
+#ifdef WIN32
+			return GetCurrentThreadId();
+#elif defined(__linux__)
+			static thread_local DWORD id = (DWORD)syscall(SYS_gettid);// the same id top and gdb show
+			return id;
+#else
+			static thread_local DWORD id = (DWORD)std::hash<std::thread::id>()(std::this_thread::get_id());
+			return id;
+#endif
+		}
+
+		void InitLevel()
+		{
+			m_level.store(LogLevelTrace);
+			m_threshold.store(LogLevelOff);
+			m_logID = NewUniqueID();
+		}
+
+		// IsEnabled() compares against this alone, so it has to be kept up to date with everything EnabledAtAll()
+		// and IsCreated() look at.
+		void UpdateThreshold()
+		{
+			m_threshold.store(EnabledAtAll() && IsCreated() ? m_level.load(std::memory_order_relaxed) : (int)LogLevelOff, std::memory_order_relaxed);
+		}
+
+		// the "Starting log" lines go in whatever the level is.
+		void HeaderMessage(const _Char* text)
+		{
+			MessageInfo* pNew = NewMessageInfo(OpMessage);
+			pNew->s1 = text;
+			Submit(pNew);
+		}
+
+		template<typename XChar>
+		static void MessageText(const XChar* x, _String& out)
+		{
+			StringConvert(x, out);
+		}
+		template<typename XChar>
+		static void MessageText(const std::basic_string<XChar>& x, _String& out)
+		{
+			StringConvert(x, out);
+		}
+		template<typename XChar, typename XTraits, typename XAlloc, size_t XInlineCapacity>
+		static void MessageText(const FormatX<XChar, XTraits, XAlloc, XInlineCapacity>& x, _String& out)
+		{
+			StringConvert(x.Str(), out);
+		}
+		static void MessageText(const InternedString<_Char>& x, _String& out)
+		{
+			out = x.str();
+		}
 
-				SendMessage(m_hMain, WM_LogMessage, 0, reinterpret_cast<LPARAM>(pNew));// doesnt return until it's done.
-				delete pNew;
+		void InitQueue()
+		{
+			m_async = false;
+			m_queues.store(0);
+			m_queuesID.store(NewUniqueID());
+			m_queueCapacity = 0;
+			m_queuePerThread = true;
+			m_backpressure = LogBackpressureBlock;
+			m_drainPosted.store(false);
+			m_dropped.store(0);
+			m_droppedOldest.store(0);
+			m_blocked.store(0);
+			m_reportedDrops = 0;
+		}
+
+		MessageInfo* NewMessageInfo(Op op)
+		{
+			MessageInfo* p = new MessageInfo();
+			p->op = op;
+			p->timestamp = GetLogTimestamp();
+			p->threadID = GetLogThreadID();
+			p->indent = GetIndentLevel();
+			return p;
+		}
+
+		// synchronous: hands mi to the log thread and waits until it's been carried out.
+		void Call(MessageInfo& mi)
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_commands.push_back(&mi);
+			uint64_t ticket = ++ m_commandsQueued;
+			m_wake.notify_one();
+			while(m_commandsDone < ticket)
+			{
+				m_done.wait(lock);
+			}
+		}
+
+		// something the log thread called has logged
+		bool OnLogThread() const
+		{
+			return std::this_thread::get_id() == m_thread.get_id();
+		}
+
+		// hands a message to the log thread, and takes ownership of it.
+		void Submit(MessageInfo* p)
+		{
+			if(!m_async)
+			{
+				if(OnLogThread())
+					Process(*p);// waiting for itself would never end
+				else
+					Call(*p);// doesnt return until it's done.
+				delete p;
+				return;
+			}
+			BoundedQueue<MessageInfo*>& queue = GetProducerQueue()->queue;
+			if(!queue.Push(p))
+			{
+				switch(m_backpressure)
+				{
+				case LogBackpressureDrop:
+					m_dropped.fetch_add(1, std::memory_order_relaxed);
+					delete p;
+					return;
+				case LogBackpressureDropOldest:
+					do
+					{
+						MessageInfo* old;
+						if(queue.Pop(old))
+						{
+							m_droppedOldest.fetch_add(1, std::memory_order_relaxed);
+							delete old;
+						}
+					}
+					while(!queue.Push(p));
+					break;
+				default:
+					m_blocked.fetch_add(1, std::memory_order_relaxed);
+					if(OnLogThread())
+					{
+						// nobody else empties the queue; write it now, ahead of what's queued
+						Process(*p);
+						delete p;
+						return;
+					}
+					for(int spin = 0; !queue.Push(p); ++ spin)
+					{
+						Wake();
+						if(spin < 16)
+							std::this_thread::yield();
+						else
+							std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+					break;
+				}
+			}
+			Wake();
+		}
+
+		// one wakeup at a time is enough; the log thread clears the flag before it starts draining.
+		void Wake()
+		{
+			if(!m_drainPosted.exchange(true))
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_lock);// so the log thread can't miss it between its check and its wait
+				}
+				m_wake.notify_one();
+			}
+		}
+
+		// the calling thread's queue. in per-thread mode it's created the first time the thread logs, and after that
+		// found through a thread-local cache.
+		ProducerQueue* GetProducerQueue()
+		{
+			if(!m_queuePerThread)
+				return m_queues.load(std::memory_order_acquire);
+
+			struct Cache
+			{
+				uint64_t queuesID;
+				ProducerQueue* queue;
+			};
+			static thread_local Cache cache = { 0, 0 };
+			uint64_t queuesID = m_queuesID.load(std::memory_order_relaxed);
+			if(cache.queuesID == queuesID)
+				return cache.queue;
+
+			// another Log (or another EnableAsync()) was cached
+			DWORD threadID = GetLogThreadID();
+			ProducerQueue* q = m_queues.load(std::memory_order_acquire);
+			while(q && !(q->threadID.load(std::memory_order_relaxed) == threadID && q->claimed->load(std::memory_order_acquire)))
+				q = q->next;
+			if(!q)
+			{
+				// the queue of a thread that's exited (what's left in it is older, so it's still written first), or a
+				// new one
+				for(q = m_queues.load(std::memory_order_acquire); q; q = q->next)
+				{
+					bool expected = false;
+					if(q->claimed->compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+					{
+						q->threadID.store(threadID, std::memory_order_relaxed);
+						break;
+					}
+				}
+				if(!q)
+				{
+					q = new ProducerQueue(m_queueCapacity, threadID);
+					ProducerQueue* head = m_queues.load(std::memory_order_relaxed);
+					do
+					{
+						q->next = head;
+					}
+					while(!m_queues.compare_exchange_weak(head, q, std::memory_order_release, std::memory_order_relaxed));
+				}
+				GetQueueClaims().Add(q->claimed);
+			}
+			cache.queuesID = queuesID;
+			cache.queue = q;
+			return q;
+		}
+
+		// the queues a thread has claimed, in every Log it's logged to. they're let go when the thread exits, so a
+		// program whose threads come and go has as many queues as it ever has threads logging at once.
+		struct QueueClaims
+		{
+			~QueueClaims()
+			{
+				for(size_t i = 0; i < claims.size(); ++ i)
+				{
+					claims[i]->store(false, std::memory_order_release);
+				}
+			}
+			void Add(const std::shared_ptr<std::atomic<bool> >& claimed)
+			{
+				// claims on queues that have been deleted since
+				for(size_t i = 0; i < claims.size(); )
+				{
+					if(claims[i].use_count() == 1)
+					{
+						claims[i] = claims.back();
+						claims.pop_back();
+					}
+					else
+					{
+						++ i;
+					}
+				}
+				claims.push_back(claimed);
+			}
+			std::vector<std::shared_ptr<std::atomic<bool> > > claims;
+		};
+
+		static QueueClaims& GetQueueClaims()
+		{
+			static thread_local QueueClaims claims;
+			return claims;
+		}
+
+		static uint64_t NewUniqueID()
+		{
+			static std::atomic<uint64_t> next(1);
+			return next.fetch_add(1);
+		}
+
+		// not while producers are logging, or the log thread is draining.
+		void DeleteQueues()
+		{
+			ProducerQueue* q = m_queues.exchange(0);
+			while(q)
+			{
+				MessageInfo* p;
+				while(q->queue.Pop(p))
+				{
+					delete p;
+				}
+				delete q->head;
+				ProducerQueue* next = q->next;
+				delete q;
+				q = next;
+			}
+			m_queuesID.store(NewUniqueID());// threads' cached queues are gone
+		}
+
+		// log thread. all = true drains at least everything that was queued when it was called. messages are written
+		// oldest first across the queues, as far as the log thread can see: a message that's stamped but not queued yet
+		// can still come after a newer one from another thread.
+		void Drain(bool all)
+		{
+			m_drainPosted.store(false);
+			size_t limit = DrainBatchSize;
+			if(all)
+			{
+				limit = 0;
+				for(ProducerQueue* q = m_queues.load(std::memory_order_acquire); q; q = q->next)
+				{
+					limit += q->queue.Capacity() + 1;
+				}
+			}
+			size_t n = 0;
+			for(; n < limit; ++ n)
+			{
+				ProducerQueue* oldest = 0;
+				for(ProducerQueue* q = m_queues.load(std::memory_order_acquire); q; q = q->next)
+				{
+					if(!q->head && !q->queue.Pop(q->head))
+						continue;
+					if(!oldest || q->head->timestamp < oldest->head->timestamp)
+						oldest = q;
+				}
+				if(!oldest)
+					break;
+				MessageInfo* p = oldest->head;
+				oldest->head = 0;
+				Process(*p);
+				delete p;
+			}
+
+			size_t drops = m_dropped.load(std::memory_order_relaxed) + m_droppedOldest.load(std::memory_order_relaxed);
+			if(drops != m_reportedDrops)
+			{
+				MessageInfo note;
+				note.timestamp = GetLogTimestamp();
+				note.threadID = GetLogThreadID();
+				note.s2 = _Format(LIBCC_LOG_TEXT("(% log messages dropped; queue full)")).ul(drops - m_reportedDrops).Str();
+				m_reportedDrops = drops;
+				WriteMessage(note);
+			}
+
+			if(n == limit)
+				Wake();// there may be more
+		}
+
+		void Process(MessageInfo& mi)
+		{
+			switch(mi.op)
+			{
+			case OpFlush:
+				if(m_async)
+					Drain(true);
+				FlushFiles();
+				break;
+			case OpDeleteQueues:
+				Drain(true);
+				DeleteQueues();
+				break;
+			default:
+				WriteMessage(mi);
+				break;
+			}
+		}
+
+		// the log thread. it writes to the files, stdout / stderr and OutputDebugString itself, and hands text for the
+		// window to the window's thread. a Message() from this thread is written right away; Flush() can't be called
+		// from it.
+		void WriterProc()
+		{
+			std::vector<MessageInfo*> commands;
+			std::unique_lock<std::mutex> lock(m_lock);
+			for(;;)
+			{
+				while(m_commands.empty() && !m_exit && !m_drainPosted.load())
+				{
+					if(m_rotatePending)
+					{
+						// nothing else to do; a good time for the renaming
+						lock.unlock();
+						RotatePendingFiles();
+						lock.lock();
+					}
+					else if(!m_flushTimerSet)
+					{
+						m_wake.wait(lock);
+					}
+					else if(m_wake.wait_until(lock, m_flushDeadline) == std::cv_status::timeout)
+					{
+						lock.unlock();
+						FlushFiles();
+						lock.lock();
+					}
+				}
+				if(m_commands.empty() && m_exit)
+					break;
+				commands.swap(m_commands);
+				lock.unlock();
+
+				if(m_drainPosted.load())
+				{
+					if(m_async)
+						Drain(false);
+					else
+						m_drainPosted.store(false);// async mode was switched off
+				}
+				for(size_t i = 0; i < commands.size(); ++ i)
+				{
+					Process(*commands[i]);
+				}
+
+				lock.lock();
+				m_commandsDone += commands.size();
+				commands.clear();
+				m_done.notify_all();
+			}
+			lock.unlock();
+			CloseFiles();
+		}
+
+		void WriteMessage(MessageInfo& mi)
+		{
+			// a Trace() message only becomes text if something here wants text
+			if(mi.formatID != LogFormatNone && (DebugEnabled() || WindowEnabled() || StdOutEnabled() || StdErrEnabled() || (FileEnabled() && !m_binaryFormat)))
+			{
+				std::string text;
+				LogRenderArgs(GetLogFormatRegistry().Get(mi.formatID).c_str(), mi.payload.c_str(), mi.payload.size(), text);
+				FromUTF8(text, mi.s2);
+			}
+
+			// convert all newline chars into something else. the interned field is shared, so it's only copied
+			// (into s1, which is otherwise empty for these messages) when it has newlines to replace.
+			for(size_t i = 0; i < mi.s1Interned.size(); ++ i)
+			{
+				_Char ch = mi.s1Interned.c_str()[i];
+				if(ch == '\r' || ch == '\n')
+				{
+					mi.s1 = mi.s1Interned.str();
+					mi.s1Interned = InternedString<_Char>();
+					break;
+				}
+			}
+			for(_String::iterator it = mi.s1.begin(); it != mi.s1.end(); ++ it)
+			{
+				if(*it == '\r') *it = '~';
+				if(*it == '\n') *it = '~';
+			}
+			for(_String::iterator it = mi.s2.begin(); it != mi.s2.end(); ++ it)
+			{
+				if(*it == '\r') *it = '~';
+				if(*it == '\n') *it = '~';
+			}
+
+			const _Char* indent = IndentSpaces<_Char>(mi.indent);
+			size_t indentLength = (size_t)(mi.indent < MaxIndentLevel ? mi.indent : MaxIndentLevel) * IndentSize;
+
+			// the time the message was logged (by the producer), not the time it's written
+			const _String& timePrefix = m_timePrefix.Get(mi.timestamp);
+			const LogTime& st = m_timePrefix.Time();
+
+			_String file;
+			if(DebugEnabled() || (FileEnabled() && !m_binaryFormat))
+			{
+				const char* levelTag = LogLevelTag(mi.level);
+				file.reserve(timePrefix.size() + 11 + indentLength + strlen(levelTag) + mi.s1Interned.size() + mi.s1.size() + mi.s2.size() + 2);
+				file.append(timePrefix);
+				AppendThreadID(file, mi.threadID);
+				file.append(indent, indentLength);
+				file.append(levelTag, levelTag + strlen(levelTag));
+				file.append(mi.s1Interned.c_str(), mi.s1Interned.size());
+				file.append(mi.s1);
+				file.append(mi.s2);
+				file.append(LIBCC_LOG_NEWLINE);
+			}
+
+#ifdef WIN32
+			// do ods
+			if(DebugEnabled())
+			{
+				OutputDebugStringW(ToWide(file).c_str());
+			}
+#endif
+
+			// do file
+			if(FileEnabled())
+			{
+				// files added with AddFilename() since the last message
+				while(m_files.size() < m_fileNames.size())
+				{
+					m_files.push_back(LogFile());
+					m_files.back().fileName = m_fileNames[m_files.size() - 1];
+				}
+
+				// the line is encoded at most once per encoding, however many files it goes to.
+				std::string utf8Temp;
+				const std::string* utf8 = 0;
+				std::string ansi;
+				std::string textPayload;
+				DWORD period = RotatePeriodKey(st);
+				for(std::vector<LogFile>::iterator it = m_files.begin(); it != m_files.end(); ++ it)
+				{
+					LogFile& f = *it;
+
+					if(f.h == InvalidFile() && !OpenFile(f, period))
+					{
+						continue;// try again next message
+					}
+
+					if(f.rotatePending)
+					{
+						Rotate(f);// the log thread hasn't been idle yet
+					}
+					if(m_enableRotate)
+					{
+						if(f.size == 0)
+						{
+							f.period = period;// nothing to rotate yet
+						}
+						else if(FileNeedsRotate(f, period))
+						{
+							// this line waits in the buffer until the file's been rotated, normally as soon as the log
+							// thread is idle
+							f.rotatePending = true;
+							f.rotateAt = f.buffer.size();
+							f.period = period;
+							m_rotatePending = true;
+						}
+					}
+					size_t bufferedBefore = f.buffer.size();
+
+					switch(f.encoding)
+					{
+					case FileEncodingBinary:
+						if(mi.formatID != LogFormatNone)
+						{
+							AppendBinaryRecord(f, mi, mi.formatID, mi.payload);
+							break;
+						}
+						if(textPayload.empty())
+						{
+							// Message() text is stored as LogFormatText's two strings
+							std::string temp;
+							LogPackArg(textPayload, ToUTF8(mi.s1Interned.str() + mi.s1, temp));
+							LogPackArg(textPayload, ToUTF8(mi.s2, temp));
+						}
+						AppendBinaryRecord(f, mi, LogFormatText, textPayload);
+						break;
+					case FileEncodingUTF16:
+						{
+							// UTF-16 files only come from Windows; wchar_t is 16 bits there.
+							const std::wstring& w = ToWide(file);
+							f.buffer.append(reinterpret_cast<const char*>(w.c_str()), sizeof(wchar_t) * w.size());
+							break;
+						}
+					case FileEncodingANSI:
+						if(ansi.empty())
+						{
+							StringConvert(file, ansi, LIBCC_CHAR_CODEPAGE, CP_ACP);
+						}
+						f.buffer.append(ansi);
+						break;
+					default:
+						if(!utf8)
+						{
+							utf8 = &ToUTF8(file, utf8Temp);
+						}
+						f.buffer.append(*utf8);
+						break;
+					}
+
+					f.size += f.buffer.size() - bufferedBefore;
+
+					if(f.buffer.size() >= m_fileBufferSize && !f.rotatePending)
+					{
+						FlushFile(f);
+					}
+					else if(!m_flushTimerSet)
+					{
+						m_flushDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_flushInterval);
+						m_flushTimerSet = true;
+					}
+				}
+			}
+
+			// do gui
+			if(WindowEnabled() || StdOutEnabled() || StdErrEnabled())
+			{
+				_String gui(_Format(LIBCC_LOG_TEXT("%%%%%%")).s(indent).s(LogLevelTag(mi.level)).s(mi.s1Interned).s(mi.s1).s(mi.s2).s(LIBCC_LOG_NEWLINE).Str());
+
+#ifdef WIN32
+				if(WindowEnabled())
+				{
+					const std::wstring& guiW = ToWide(gui);
+					SendMessageW(m_hMain, WM_LogWindowText, (WPARAM)mi.threadID, (LPARAM)guiW.c_str());
+				}
+#endif
+				if(StdOutEnabled())
+				{
+					WriteStd(false, gui);
+				}
+				if(StdErrEnabled())
+				{
+					WriteStd(true, gui);
+				}
+			}
+		}
+
+		// "[0000abcd] "
+		static void AppendThreadID(_String& s, DWORD threadID)
+		{
+			static const char digits[] = "0123456789abcdef";
+			s.push_back('[');
+			for(int shift = 28; shift >= 0; shift -= 4)
+			{
+				s.push_back(digits[(threadID >> shift) & 15]);
+			}
+			s.push_back(']');
+			s.push_back(' ');
+		}
+
+		static void WriteStd(bool stdErr, const _String& s)
+		{
+#ifdef WIN32
+			std::string a;
+			StringConvert(s, a);
+			DWORD bw;
+			WriteFile(GetStdHandle(stdErr ? STD_ERROR_HANDLE : STD_OUTPUT_HANDLE), a.c_str(), (DWORD)a.size(), &bw, 0);
+#else
+			std::string temp;
+			const std::string& a = ToUTF8(s, temp);
+			WriteAll(stdErr ? STDERR_FILENO : STDOUT_FILENO, a.c_str(), a.size());
+#endif
+		}
+
+    // a thread's indent level in one log. a thread only has entries for the logs it's indented in right now, so
+    // there's rarely more than one.
+    struct ThreadIndent
+    {
+      uint64_t logID;
+      int level;
+    };
+
+    static std::vector<ThreadIndent>& GetThreadIndents()
+    {
+      static thread_local std::vector<ThreadIndent> indents;
+      return indents;
+    }
+
+    // spaces for an indent level, from one string made the first time it's needed
+    template<typename Char>
+    static const Char* IndentSpaces(int level)
+    {
+      static const std::basic_string<Char> spaces(MaxIndentLevel * IndentSize, ' ');
+      return spaces.c_str() + spaces.size() - (size_t)(level < MaxIndentLevel ? level : MaxIndentLevel) * IndentSize;
+    }
+
+    // file i/o. Win32 handles on Windows, POSIX file descriptors everywhere else.
+#ifdef WIN32
+    typedef HANDLE FileHandle;
+    static FileHandle InvalidFile()
+    {
+      return INVALID_HANDLE_VALUE;
+    }
+#else
+    typedef int FileHandle;
+    static FileHandle InvalidFile()
+    {
+      return -1;
+    }
+    static std::string NativePath(const std::wstring& path)
+    {
+      std::string ret;
+      UTF16ToUTF8(path.c_str(), path.size(), ret);
+      return ret;
+    }
+    static void WriteAll(int fd, const char* p, size_t len)
+    {
+      while(len)
+      {
+        ssize_t n = ::write(fd, p, len);
+        if(n < 0)
+        {
+          if(errno == EINTR)
+            continue;
+          return;
+        }
+        p += n;
+        len -= (size_t)n;
+      }
+    }
+#endif
+
+    static FileHandle OpenFileHandle(const std::wstring& fileName)
+    {
+#ifdef WIN32
+      HANDLE h = CreateFileW(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, 0, OPEN_ALWAYS, 0, 0);
+      return h ? h : INVALID_HANDLE_VALUE;
+#else
+      return ::open(NativePath(fileName).c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+    }
+
+    static void CloseFileHandle(FileHandle h)
+    {
+#ifdef WIN32
+      CloseHandle(h);
+#else
+      ::close(h);
+#endif
+    }
+
+    static uint64_t GetFileHandleSize(FileHandle h)
+    {
+#ifdef WIN32
+      LARGE_INTEGER fileSize;
+      fileSize.QuadPart = 0;
+      GetFileSizeEx(h, &fileSize);
+      return fileSize.QuadPart;
+#else
+      struct stat st;
+      return ::fstat(h, &st) == 0 ? (uint64_t)st.st_size : 0;
+#endif
+    }
+
+    // last write time, as a log timestamp
+    static bool GetFileHandleTime(FileHandle h, uint64_t& timestamp)
+    {
+#ifdef WIN32
+      FILETIME ft;
+      if(!GetFileTime(h, 0, 0, &ft))
+        return false;
+      timestamp = ((((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime) - 116444736000000000ULL) / 10;
+      return true;
+#else
+      struct stat st;
+      if(::fstat(h, &st) != 0)
+        return false;
+      timestamp = (uint64_t)st.st_mtime * 1000000;
+      return true;
+#endif
+    }
+
+    // reads the first 2 bytes of the file, and leaves the file pointer at the end
+    static WORD ReadFileHandleBOM(FileHandle h)
+    {
+      WORD bom = 0;
+#ifdef WIN32
+      DWORD br = 0;
+      SetFilePointer(h, 0, NULL, FILE_BEGIN);
+      ReadFile(h, &bom, 2, &br, NULL);
+      SetFilePointer(h, 0, NULL, FILE_END);
+      return br == 2 ? bom : 0;
+#else
+      return ::pread(h, &bom, 2, 0) == 2 ? bom : 0;// O_APPEND writes go to the end anyway
+#endif
+    }
+
+    static void WriteFileHandle(FileHandle h, const char* p, size_t len)
+    {
+#ifdef WIN32
+      DWORD bw;
+      WriteFile(h, p, (DWORD)len, &bw, 0);
+#else
+      WriteAll(h, p, len);
+#endif
+    }
+
+    static void DeleteFileName(const std::wstring& fileName)
+    {
+#ifdef WIN32
+      DeleteFileW(fileName.c_str());
+#else
+      ::unlink(NativePath(fileName).c_str());
+#endif
+    }
+
+    static void MoveFileName(const std::wstring& from, const std::wstring& to)
+    {
+#ifdef WIN32
+      MoveFileW(from.c_str(), to.c_str());
+#else
+      ::rename(NativePath(from).c_str(), NativePath(to).c_str());
+#endif
+    }
+
+    enum FileEncoding
+    {
+      FileEncodingUTF8,
+      FileEncodingUTF16,// an old log file that started with a BOM
+      FileEncodingANSI,// unicodeFileFormat = false
+      FileEncodingBinary// EnableBinaryFormat()
+    };
+
+    // a log file the log thread keeps open
+    struct LogFile
+    {
+      LogFile() :
+        h(InvalidFile()),
+        encoding(FileEncodingUTF8),
+        size(0),
+        period(0),
+        rotatePending(false),
+        rotateAt(0)
+      {
+      }
+      std::wstring fileName;
+      FileHandle h;
+      FileEncoding encoding;// detected when it's opened
+      std::string buffer;// encoded lines that haven't been written yet
+      uint64_t size;// bytes in the file, including the buffer
+      DWORD period;// RotatePeriodKey() of the file's contents
+      bool rotatePending;// waiting for the log thread to be idle; until then the buffer isn't written
+      size_t rotateAt;// buffer bytes that still belong in the file before it's rotated
+      std::vector<bool> formats;// binary files: the format ids already defined in this file
+    };
+
+		// identifies the hour or day of a time, for time-based rotation
+		DWORD RotatePeriodKey(const LogTime& st) const
+		{
+			DWORD day = (st.wYear * 100 + st.wMonth) * 100 + st.wDay;
+			switch(m_rotatePeriod)
+			{
+			case LogRotateHourly:
+				return day * 100 + st.wHour;
+			case LogRotateDaily:
+				return day;
+			case LogRotateNever:
+				break;
+			}
+			return 0;
+		}
+
+		bool FileNeedsRotate(const LogFile& f, DWORD period) const
+		{
+			if(m_rotateByteSize && f.size > m_rotateByteSize)
+				return true;
+			return f.period != period;
+		}
+
+		// period is the current one, used if the file is empty. otherwise it's the period the file was last written in.
+		bool OpenFile(LogFile& f, DWORD period)
+		{
+			f.h = OpenFileHandle(f.fileName);
+			if(f.h == InvalidFile())
+			{
+				return false;
+			}
+
+			f.size = GetFileHandleSize(f.h);
+			f.period = period;
+			uint64_t lastWrite;
+			if(f.size && m_rotatePeriod != LogRotateNever && GetFileHandleTime(f.h, lastWrite))
+			{
+				LogTime st;
+				LogTimestampToLocalTime(lastWrite, st);
+				f.period = RotatePeriodKey(st);
+			}
+
+			f.encoding = FileEncodingANSI;
+			if(m_binaryFormat)
+			{
+				f.encoding = FileEncodingBinary;
+				if(f.size == 0)
+				{
+					// a new file starts with the header, and (after a rotation) the format strings that lines still in
+					// the buffer refer to.
+					std::string preamble;
+					LogBinaryFileHeader h = {};
+					memcpy(h.magic, LogBinaryMagic, sizeof(h.magic));
+					h.version = LogBinaryVersion;
+					preamble.append(reinterpret_cast<const char*>(&h), sizeof(h));
+					for(size_t i = 0; i < f.formats.size(); ++ i)
+					{
+						if(f.formats[i])
+							AppendFormatRecord(preamble, (LogFormatID)i);
+					}
+					f.buffer.insert(0, preamble);
+					f.size = preamble.size();
+				}
+				else
+				{
+					f.formats.clear();// the ids in it may be another process's
+				}
+			}
+			else if(m_unicodeFileFormat)
+			{
+				// new files are written in UTF-8. an old one might be UTF-16, and then it stays that way.
+
+				// After an arbitrary yet reasonable amount of time, this check should probably be removed
+				// as it only matters to not corrupt existing UTF16 log files as of r237 - 2011-01-20
+				f.encoding = FileEncodingUTF8;
+				if(f.size && ReadFileHandleBOM(f.h) == 0xFEFF) // UTF-16 Byte Order Mark
+				{
+					f.encoding = FileEncodingUTF16;
+				}
+			}
+#ifdef WIN32
+			SetFilePointer(f.h, 0, NULL, FILE_END);
+#endif
+			f.buffer.reserve(m_fileBufferSize);
+			return true;
+		}
+
+		void AppendBinaryRecord(LogFile& f, const MessageInfo& mi, LogFormatID formatID, const std::string& payload)
+		{
+			if(formatID >= f.formats.size() || !f.formats[formatID])
+			{
+				AppendFormatRecord(f.buffer, formatID);
+				if(formatID >= f.formats.size())
+					f.formats.resize(formatID + 1, false);
+				f.formats[formatID] = true;
+			}
+			LogBinaryRecordHeader h = {};
+			h.timestamp = mi.timestamp;
+			h.threadID = mi.threadID;
+			h.formatID = formatID;
+			h.size = (uint32_t)payload.size();
+			h.level = (uint16_t)mi.level;
+			h.type = LogBinaryRecordMessage;
+			h.indent = (uint8_t)(mi.indent < MaxIndentLevel ? mi.indent : MaxIndentLevel);
+			f.buffer.append(reinterpret_cast<const char*>(&h), sizeof(h));
+			f.buffer.append(payload);
+		}
+
+		static void AppendFormatRecord(std::string& buffer, LogFormatID formatID)
+		{
+			InternedString<char> format = GetLogFormatRegistry().Get(formatID);
+			LogBinaryRecordHeader h = {};
+			h.formatID = formatID;
+			h.size = (uint32_t)format.size();
+			h.type = LogBinaryRecordFormat;
+			buffer.append(reinterpret_cast<const char*>(&h), sizeof(h));
+			buffer.append(format.c_str(), format.size());
+		}
+
+		void FlushFile(LogFile& f)
+		{
+			if(f.rotatePending)
+			{
+				Rotate(f);
+			}
+			if(!f.buffer.empty() && f.h != InvalidFile())
+			{
+				WriteFileHandle(f.h, f.buffer.c_str(), f.buffer.size());
+			}
+			f.buffer.clear();
+		}
+
+		void CloseFile(LogFile& f)
+		{
+			FlushFile(f);
+			if(f.h != InvalidFile())
+			{
+				CloseFileHandle(f.h);
+				f.h = InvalidFile();
+			}
+		}
+
+		void FlushFiles()
+		{
+			for(std::vector<LogFile>::iterator it = m_files.begin(); it != m_files.end(); ++ it)
+			{
+				FlushFile(*it);
+			}
+			m_flushTimerSet = false;
+		}
+
+		// writes what belongs in the old file, renames it away, and starts a new one with the rest of the buffer.
+		void Rotate(LogFile& f)
+		{
+			std::string rest(f.buffer, f.rotateAt);
+			f.buffer.resize(f.rotateAt);
+			f.rotatePending = false;
+			DWORD period = f.period;
+			CloseFile(f);
+
+			RotateFile(f.fileName);
+
+			f.buffer.swap(rest);
+			size_t restSize = f.buffer.size();
+			if(!OpenFile(f, period))
+			{
+				f.buffer.clear();
+				return;
+			}
+			f.size += restSize;
+		}
+
+		void RotatePendingFiles()
+		{
+			m_rotatePending = false;
+			for(std::vector<LogFile>::iterator it = m_files.begin(); it != m_files.end(); ++ it)
+			{
+				if(it->rotatePending)
+				{
+					Rotate(*it);
+				}
+			}
+		}
+
+		void CloseFiles()
+		{
+			FlushFiles();
+			for(std::vector<LogFile>::iterator it = m_files.begin(); it != m_files.end(); ++ it)
+			{
+				CloseFile(*it);
+			}
+			m_files.clear();
+		}
+
+	void RotateFile( const std::wstring& fileName )
+	{
+		// the extension starts at the last dot of the file name part
+		size_t slash = fileName.find_last_of(L"\\/");
+		size_t dot = fileName.find_last_of(L'.');
+		if(dot == std::wstring::npos || (slash != std::wstring::npos && dot < slash))
+			dot = fileName.size();
+
+		std::wstring fileNameBase = fileName.substr(0, dot);
+		std::wstring fileNameExt = fileName.substr(dot);
+
+		for(int i = m_rotateKeepCount; i >= 0; --i)
+		{
+			std::wstring fromFile;
+			if(i == 0)
+			{
+				fromFile = fileName;
+			}
+			else
+			{
+				fromFile = LibCC::FormatW(L"%.%%")(fileNameBase).i(i - 1)(fileNameExt).Str();
 			}
-    }
-    template<typename XChar, typename YChar>
-    void Message(const std::basic_string<XChar>& x, const std::basic_string<YChar>& y)
-    {
-			if(EnabledAtAll())
+			std::wstring toFile = LibCC::FormatW(L"%.%%")(fileNameBase).i(i)(fileNameExt).Str();
+
+			if(i == (int)m_rotateKeepCount)
 			{
-				_String s1;
-				_String s2;
-				StringConvert(x, s1);
-				StringConvert(y, s2);
-				Message(s1, s2);
+				// Delete the oldest file
+				DeleteFileName(fromFile);
 			}
-    }
-    template<typename XChar, typename YChar>
-    void Message(const std::basic_string<XChar>& x, const YChar* y)
-    {
-			if(EnabledAtAll())
+			else
 			{
-				Message(x, std::basic_string<YChar>(y));
+				// Move each old file to next position
+				MoveFileName(fromFile, toFile);
 			}
+		}
+	}
+
+    // the window and OutputDebugString want UTF-16, files want UTF-8, regardless of the native char type.
+    static std::wstring ToWide(const std::string& s)
+    {
+      std::wstring ret;
+      UTF8ToUTF16(s.c_str(), s.size(), ret);
+      return ret;
     }
-    template<typename XChar, typename YChar>
-    void Message(const XChar* x, const std::basic_string<YChar>& y)
+    static const std::wstring& ToWide(const std::wstring& s)
     {
-			if(EnabledAtAll())
-			{
-				Message(std::basic_string<XChar>(x), y);
-			}
+      return s;
     }
-    template<typename XChar, typename YChar>
-    void Message(const XChar* x, const YChar* y)
+    static const std::string& ToUTF8(const std::string& s, std::string&)
     {
-			if(EnabledAtAll())
-			{
-				Message(std::basic_string<XChar>(x), std::basic_string<YChar>(y));
-			}
+      return s;
     }
-    
-    // 1 string arg...
-    template<typename XChar>
-    void Message(const XChar* s)
+    static const std::string& ToUTF8(const std::wstring& s, std::string& temp)
     {
-			if(EnabledAtAll())
-			{
-				Message(std::basic_string<XChar>(s));
-			}
+      UTF16ToUTF8(s.c_str(), s.size(), temp);
+      return temp;
     }
-    template<typename XChar>
-    void Message(const std::basic_string<XChar>& s)
+    static void FromUTF8(const std::string& s, std::string& out)
     {
-			if(EnabledAtAll())
-			{
-				Message(s, std::string(""));
-			}
+      out = s;
     }
-    template<typename XChar>
-    void Message(const FormatX<XChar>& s)
+    static void FromUTF8(const std::string& s, std::wstring& out)
     {
-			if(EnabledAtAll())
-			{
-				Message(s.Str(), std::string(""));
-			}
+      out.clear();
+      UTF8ToUTF16(s.c_str(), s.size(), out);
     }
 
-	void EnableRotation(bool enable, DWORD count, DWORD size)
-	{
-		m_enableRotate = enable;
-		if(m_enableRotate)
+    struct MessageInfo
+    {
+      MessageInfo() :
+        op(OpMessage),
+        threadID(0),
+        timestamp(0),
+        formatID(LogFormatNone),
+        level(LogLevelInfo),
+        indent(0)
+      {
+      }
+      Op op;
+      InternedString<_Char> s1Interned;// set instead of s1 by the InternedString overloads
+      _String s1;
+      _String s2;
+      DWORD threadID;
+      uint64_t timestamp;// GetLogTimestamp() when it was logged
+      LogFormatID formatID;// Trace() messages; the text is rendered from payload only if something needs text
+      std::string payload;
+      LogLevel level;
+      int indent;// the thread's indent level when it was logged
+    };
+
+#ifdef WIN32
+		// the window. it has its own thread, which just pumps messages; the log thread sends it the text to show.
+    static const UINT WM_LogExit = WM_APP + 2;
+    static const UINT WM_LogWindowText = WM_APP + 3;// wParam = thread id, lParam = const wchar_t*
+
+    // each thread gets a different edit and tab item.
+    struct WindowTab
+    {
+      WindowTab() :
+        hEdit(0),
+        threadID(0),
+        tabItem(0)
+      {
+      }
+      HWND hEdit;
+      DWORD threadID;
+      int tabItem;
+    };
+
+		void InitWindow()
 		{
-			m_rotateKeepCount = count;
-			m_rotateByteSize = size;
+			m_hWindowThread = 0;
+			m_hInitialized = 0;
+			m_hMain = 0;
+			m_hEdit = 0;
+			m_hFont = 0;
+			m_hTab = 0;
+			m_hInstance = 0;
 		}
-	}
 
-  private:
-    static void __cdecl ThreadProc(void* p)
+    static void __cdecl WindowThreadProc(void* p)
     {
-	    static_cast<Log*>(p)->ThreadProc();
+	    static_cast<Log*>(p)->WindowThreadProc();
     }
 
-    void ThreadProc()
+    void WindowThreadProc()
     {
-			// you *cannot* call Message() from this thread.  this thread needs to pump messages 24/7
 			WNDCLASSW wc = {0};
 			wc.style = CS_HREDRAW | CS_VREDRAW;
 			wc.lpfnWndProc = Log::MainProc;
@@ -360,10 +2470,7 @@ namespace LibCC
 			m_hMain = CreateWindowExW(0, m_fileNames[0].c_str(), PathFindFileNameW(m_fileNames[0].c_str()), WS_CLIPSIBLINGS | WS_CLIPCHILDREN | WS_OVERLAPPEDWINDOW,
 				m_x, m_y, m_width, m_height, 0, 0, m_hInstance, this);
 
-			if(WindowEnabled())
-			{
-				ShowWindow(m_hMain, SW_SHOW);
-			}
+			ShowWindow(m_hMain, SW_SHOW);
 			SetEvent(m_hInitialized);
 
 			MSG msg;
@@ -376,7 +2483,7 @@ namespace LibCC
 			CloseHandle(m_hGlobalSemaphore);
 			return;
     }
-    
+
     static LRESULT CALLBACK MainProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     {
 			Log* pThis = static_cast<Log*>(GetPropW(hWnd, L"LibCC Log Window"));
@@ -386,25 +2493,22 @@ namespace LibCC
 				return 0;
 			case WM_SIZE:
 				{
-					if(pThis->WindowEnabled())
+					RECT rc;
+					GetClientRect(hWnd, &rc);
+
+					HDWP hdwp = BeginDeferWindowPos(static_cast<int>(pThis->m_tabs.size() + 2));// + tabctrl + composite edit
+					// tab ctrl
+					DeferWindowPos(hdwp, pThis->m_hTab, 0, 0, 0, rc.right, rc.bottom, SWP_NOZORDER);
+					TabCtrl_AdjustRect(pThis->m_hTab, FALSE, &rc);
+					// all tab edit box
+					DeferWindowPos(hdwp, pThis->m_hEdit, 0, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top, SWP_NOZORDER);
+					for(std::vector<WindowTab>::const_iterator it = pThis->m_tabs.begin(); it != pThis->m_tabs.end(); ++ it)
 					{
-						RECT rc;
-						GetClientRect(hWnd, &rc);
-
-						HDWP hdwp = BeginDeferWindowPos(static_cast<int>(pThis->m_threads.size() + 2));// + tabctrl + composite edit
-						// tab ctrl
-						DeferWindowPos(hdwp, pThis->m_hTab, 0, 0, 0, rc.right, rc.bottom, SWP_NOZORDER);
-						TabCtrl_AdjustRect(pThis->m_hTab, FALSE, &rc);
-						// all tab edit box
-						DeferWindowPos(hdwp, pThis->m_hEdit, 0, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top, SWP_NOZORDER);
-						for(std::vector<ThreadInfo>::const_iterator it = pThis->m_threads.begin(); it != pThis->m_threads.end(); ++ it)
-						{
-							// thread edit box
-							DeferWindowPos(hdwp, it->hEdit, 0, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top, SWP_NOZORDER);
-						}
-
-						EndDeferWindowPos(hdwp);
+						// thread edit box
+						DeferWindowPos(hdwp, it->hEdit, 0, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top, SWP_NOZORDER);
 					}
+
+					EndDeferWindowPos(hdwp);
 					break;
 				}
 			case WM_DESTROY:
@@ -412,163 +2516,11 @@ namespace LibCC
 					PostQuitMessage(0);
 					return 0;
 				}
-			case WM_LogMessage:
-				{
-					MessageInfo& mi = *(MessageInfo*)lParam;
-					ThreadInfo& ti = pThis->GetThreadInfo(mi.threadID);
-
-					// convert all newline chars into something else
-					for(_String::iterator it = mi.s1.begin(); it != mi.s1.end(); ++ it)
-					{
-						if(*it == '\r') *it = '~';
-						if(*it == '\n') *it = '~';
-					}
-					for(_String::iterator it = mi.s2.begin(); it != mi.s2.end(); ++ it)
-					{
-						if(*it == '\r') *it = '~';
-						if(*it == '\n') *it = '~';
-					}
-
-					// create indent string
-					_String indent;
-					for(size_t i = 0; i < ti.indent * IndentSize; i ++)
-					{
-						indent.push_back(' ');
-					}
-
-					SYSTEMTIME st;
-					GetLocalTime(&st);
-
-					std::wstring file;
-					if(pThis->DebugEnabled() || pThis->FileEnabled())
-					{
-						file = LibCC::FormatW(L"[%-%-%;%:%:%][%] %%%|")
-							.ul<10,4>(st.wYear)
-							.ul<10,2>(st.wMonth)
-							.ul<10,2>(st.wDay)
-							.ul<10,2>(st.wHour)
-							.ul<10,2>(st.wMinute)
-							.ul<10,2>(st.wSecond)
-							.ul<16,8,'0'>(mi.threadID)
-							.s(indent)
-							.s(mi.s1)
-							.s(mi.s2)
-							.Str();
-					}
-
-					// do ods
-					if(pThis->DebugEnabled())
-					{
-						OutputDebugStringW(file.c_str());
-					}
-
-					// do file
-					if(pThis->FileEnabled())
-					{
-						for(std::vector<std::wstring>::iterator it = pThis->m_fileNames.begin(); it != pThis->m_fileNames.end(); ++ it)
-						{
-							std::wstring& fileName = *it;
-
-							if(pThis->m_enableRotate)
-							{
-								if(pThis->FileNeedsRotate(fileName))
-								{
-									pThis->RotateFile(fileName);
-								}
-							}
-
-							HANDLE h = CreateFileW(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, 0, OPEN_ALWAYS, 0, 0);
-							if(h && h != INVALID_HANDLE_VALUE)
-							{
-								DWORD bw;
-								if(pThis->m_unicodeFileFormat)
-								{
-									DWORD fileSize = GetFileSize(h, NULL);
-									if(fileSize == 0)
-									{
-										// the file is new. write out in UTF-8
-										std::string a;
-										StringConvert(file, a, 0, CP_UTF8);
-										WriteFile(h, a.c_str(), (DWORD)a.size(), &bw, 0);
-									}
-									else
-									{
-										// file is old, is it UTF-16?
-
-										// After an arbitrary yet reasonable amount of time, this check should probably be removed
-										// as it only matters to not corrupt existing UTF16 log files as of r237 - 2011-01-20
-
-										SetFilePointer(h, 0, NULL, FILE_BEGIN);
-										WORD bom = 0;
-										DWORD br;
-										ReadFile(h, &bom, 2, &br, NULL);
-										SetFilePointer(h, 0, NULL, FILE_END);
-
-										if(bom == 0xFEFF) // UTF-16 Byte Order Mark
-										{
-											// UTF-16 file
-											WriteFile(h, file.c_str(), (DWORD)(sizeof(wchar_t) * file.size()), &br, 0);
-										}
-										else
-										{
-											// Write UTF8
-											std::string a;
-											StringConvert(file, a, 0, CP_UTF8);
-											WriteFile(h, a.c_str(), (DWORD)a.size(), &bw, 0);
-										}
-									}
-								}
-								else
-								{
-									std::string a;
-									StringConvert(file, a);
-									WriteFile(h, a.c_str(), (DWORD)a.size(), &bw, 0);
-								}
-								CloseHandle(h);
-							}
-						}
-					}
-
-					// do gui
-					if(pThis->WindowEnabled() || pThis->StdOutEnabled())
-					{
-						std::wstring gui(LibCC::FormatW(L"%%%|").s(indent).s(mi.s1).s(mi.s2).Str());
-
-						if(pThis->WindowEnabled())
-						{
-							int ndx = GetWindowTextLength(pThis->m_hEdit);
-							SendMessage(pThis->m_hEdit, EM_SETSEL, (WPARAM)ndx, (LPARAM)ndx);
-							SendMessageW(pThis->m_hEdit, EM_REPLACESEL, 0, (LPARAM)gui.c_str());
-
-							ndx = GetWindowTextLength(ti.hEdit);
-							SendMessage(ti.hEdit, EM_SETSEL, (WPARAM)ndx, (LPARAM)ndx);
-							SendMessageW(ti.hEdit, EM_REPLACESEL, 0, (LPARAM)gui.c_str());
-						}
-						if(pThis->StdOutEnabled())
-						{
-							StdOutPrint(gui);
-						}
-					}
-					
-					return 0;
-				}
-			case WM_Indent:
-				{
-					ThreadInfo& ti = pThis->GetThreadInfo(static_cast<DWORD>(lParam));
-					ti.indent ++;
-					return 0;
-				}
-			case WM_Outdent:
+			case WM_LogWindowText:
 				{
-					ThreadInfo& ti = pThis->GetThreadInfo(static_cast<DWORD>(lParam));
-					ti.indent --;
+					pThis->AppendWindowText(static_cast<DWORD>(wParam), reinterpret_cast<const wchar_t*>(lParam));
 					return 0;
 				}
-			case WM_GetIndentLevel:
-				{
-					ThreadInfo& ti = pThis->GetThreadInfo(static_cast<DWORD>(lParam));
-					return ti.indent;
-				}
 			case WM_LogExit:
 				{
 					DestroyWindow(hWnd);
@@ -576,42 +2528,39 @@ namespace LibCC
 				}
 			case WM_NOTIFY:
 				{
-					if(pThis->WindowEnabled())
+					NMHDR& h = *(NMHDR*)lParam;
+					if(h.hwndFrom == pThis->m_hTab)
 					{
-						NMHDR& h = *(NMHDR*)lParam;
-						if(h.hwndFrom == pThis->m_hTab)
+						if(h.code == TCN_SELCHANGE)
 						{
-							if(h.code == TCN_SELCHANGE)
+							int iItem = TabCtrl_GetCurSel(pThis->m_hTab);
+							if(iItem == 0)
 							{
-								int iItem = TabCtrl_GetCurSel(pThis->m_hTab);
-								if(iItem == 0)
+								// show the ALL tab, hide all others.
+								SetWindowPos(pThis->m_hEdit, HWND_TOP, 0,0,0,0, SWP_NOMOVE | SWP_NOSIZE | SWP_SHOWWINDOW);
+								for(std::vector<WindowTab>::const_iterator it = pThis->m_tabs.begin(); it != pThis->m_tabs.end(); ++ it)
 								{
-									// show the ALL tab, hide all others.
-									SetWindowPos(pThis->m_hEdit, HWND_TOP, 0,0,0,0, SWP_NOMOVE | SWP_NOSIZE | SWP_SHOWWINDOW);
-									for(std::vector<ThreadInfo>::const_iterator it = pThis->m_threads.begin(); it != pThis->m_threads.end(); ++ it)
-									{
-										ShowWindow(it->hEdit, SW_HIDE);
-									}
+									ShowWindow(it->hEdit, SW_HIDE);
 								}
-								else
+							}
+							else
+							{
+								// hide the ALL tab, hide all others, show the selected one.
+								ShowWindow(pThis->m_hEdit, SW_HIDE);
+								for(std::vector<WindowTab>::const_iterator it = pThis->m_tabs.begin(); it != pThis->m_tabs.end(); ++ it)
 								{
-									// hide the ALL tab, hide all others, show the selected one.
-									ShowWindow(pThis->m_hEdit, SW_HIDE);
-									for(std::vector<ThreadInfo>::const_iterator it = pThis->m_threads.begin(); it != pThis->m_threads.end(); ++ it)
+									if(it->tabItem == iItem)
+									{
+										SetWindowPos(it->hEdit, HWND_TOP, 0,0,0,0, SWP_NOMOVE | SWP_NOSIZE | SWP_SHOWWINDOW);
+									}
+									else
 									{
-										if(it->tabItem == iItem)
-										{
-											SetWindowPos(it->hEdit, HWND_TOP, 0,0,0,0, SWP_NOMOVE | SWP_NOSIZE | SWP_SHOWWINDOW);
-										}
-										else
-										{
-											ShowWindow(it->hEdit, SW_HIDE);
-										}
+										ShowWindow(it->hEdit, SW_HIDE);
 									}
 								}
-
-								return 0;
 							}
+
+							return 0;
 						}
 					}
 					break;
@@ -622,30 +2571,28 @@ namespace LibCC
 					pThis = static_cast<Log*>(pcs->lpCreateParams);
 					SetPropW(hWnd, L"LibCC Log Window", static_cast<HANDLE>(pThis));
 					pThis->m_hMain = hWnd;
-					if(pThis->WindowEnabled())
-					{
-						HDC dc = GetDC(hWnd);
-						pThis->m_hFont = CreateFontW(-MulDiv(10, GetDeviceCaps(dc, LOGPIXELSY), 72),0,0,0,0,0,0,0,0,0,0,0,0,L"Courier");
-						ReleaseDC(hWnd, dc);
 
-						pThis->m_hTab = CreateWindowExW(0, WC_TABCONTROLW, L"", WS_CLIPSIBLINGS | WS_CHILD | WS_VISIBLE, 27, 74, 3, 2, hWnd, 0, pThis->m_hInstance, 0);
-						SendMessageW(pThis->m_hTab, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), TRUE);
-						TabCtrl_SetItemSize(pThis->m_hTab, 16, 16);
+					HDC dc = GetDC(hWnd);
+					pThis->m_hFont = CreateFontW(-MulDiv(10, GetDeviceCaps(dc, LOGPIXELSY), 72),0,0,0,0,0,0,0,0,0,0,0,0,L"Courier");
+					ReleaseDC(hWnd, dc);
 
-						// create the first tab for the composite
-						TCITEMW tci = {0};
-						tci.mask = TCIF_TEXT;
-						tci.pszText = L"All";
-						TabCtrl_InsertItem(pThis->m_hTab, 0, &tci);
+					pThis->m_hTab = CreateWindowExW(0, WC_TABCONTROLW, L"", WS_CLIPSIBLINGS | WS_CHILD | WS_VISIBLE, 27, 74, 3, 2, hWnd, 0, pThis->m_hInstance, 0);
+					SendMessageW(pThis->m_hTab, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), TRUE);
+					TabCtrl_SetItemSize(pThis->m_hTab, 16, 16);
 
-						pThis->m_hEdit = CreateWindowExW(0, L"EDIT", L"", WS_CLIPSIBLINGS | WS_VSCROLL | WS_HSCROLL | ES_AUTOHSCROLL | ES_AUTOVSCROLL | ES_MULTILINE | ES_READONLY | WS_CHILD | WS_VISIBLE,
-							27, 74, 3, 2, pThis->m_hMain, 0, 0, 0);
+					// create the first tab for the composite
+					TCITEMW tci = {0};
+					tci.mask = TCIF_TEXT;
+					tci.pszText = L"All";
+					TabCtrl_InsertItem(pThis->m_hTab, 0, &tci);
 
-						SetWindowPos(pThis->m_hEdit, HWND_TOP, 0,0,0,0, SWP_NOMOVE | SWP_NOSIZE | SWP_SHOWWINDOW);
+					pThis->m_hEdit = CreateWindowExW(0, L"EDIT", L"", WS_CLIPSIBLINGS | WS_VSCROLL | WS_HSCROLL | ES_AUTOHSCROLL | ES_AUTOVSCROLL | ES_MULTILINE | ES_READONLY | WS_CHILD | WS_VISIBLE,
+						27, 74, 3, 2, pThis->m_hMain, 0, 0, 0);
 
-						SendMessageW(pThis->m_hEdit, WM_SETFONT, (WPARAM)pThis->m_hFont, TRUE);
-						SendMessageW(pThis->m_hEdit, EM_SETLIMITTEXT, (WPARAM)0, 0);
-					}
+					SetWindowPos(pThis->m_hEdit, HWND_TOP, 0,0,0,0, SWP_NOMOVE | SWP_NOSIZE | SWP_SHOWWINDOW);
+
+					SendMessageW(pThis->m_hEdit, WM_SETFONT, (WPARAM)pThis->m_hFont, TRUE);
+					SendMessageW(pThis->m_hEdit, EM_SETLIMITTEXT, (WPARAM)0, 0);
 					return 0;
 				}
 			case WM_PAINT:
@@ -657,43 +2604,23 @@ namespace LibCC
 			return DefWindowProc(hWnd, uMsg, wParam, lParam);
 		}
 
-    static const UINT WM_LogMessage = WM_APP;
-    static const UINT WM_LogExit = WM_APP + 2;
-    static const UINT WM_Indent = WM_APP + 3;
-    static const UINT WM_Outdent = WM_APP + 4;
-    static const UINT WM_GetIndentLevel = WM_APP + 5;
+		// window thread
+		void AppendWindowText(DWORD threadID, const wchar_t* text)
+		{
+			WindowTab& tab = GetWindowTab(threadID);
 
-    // each thread gets a different edit, tab item, and id.
-    struct ThreadInfo
-    {
-      ThreadInfo() :
-        hEdit(0),
-        threadID(0),
-        tabItem(0),
-        indent(0)
-      {
-      }
-      ThreadInfo(const ThreadInfo& rhs) 
-      {
-        operator =(rhs);
-      }
-      ThreadInfo& operator =(const ThreadInfo& rhs) 
-      {
-        hEdit = rhs.hEdit;
-        threadID = rhs.threadID;
-        tabItem = rhs.tabItem;
-        indent = rhs.indent;
-        return *this;
-      }
-      HWND hEdit;
-      DWORD threadID;
-      int tabItem;
-      size_t indent;
-    };
+			int ndx = GetWindowTextLength(m_hEdit);
+			SendMessage(m_hEdit, EM_SETSEL, (WPARAM)ndx, (LPARAM)ndx);
+			SendMessageW(m_hEdit, EM_REPLACESEL, 0, (LPARAM)text);
+
+			ndx = GetWindowTextLength(tab.hEdit);
+			SendMessage(tab.hEdit, EM_SETSEL, (WPARAM)ndx, (LPARAM)ndx);
+			SendMessageW(tab.hEdit, EM_REPLACESEL, 0, (LPARAM)text);
+		}
 
-    ThreadInfo& GetThreadInfo(DWORD threadID)
+    WindowTab& GetWindowTab(DWORD threadID)
     {
-			for(std::vector<ThreadInfo>::iterator it = m_threads.begin(); it != m_threads.end(); ++ it)
+			for(std::vector<WindowTab>::iterator it = m_tabs.begin(); it != m_tabs.end(); ++ it)
 			{
 				if(it->threadID == threadID)
 				{
@@ -702,96 +2629,153 @@ namespace LibCC
 			}
 
 			// omg; not found.  create a new one.
-			HWND hNewEdit = 0;
-			int newTabItem = 0;
-			if(WindowEnabled())
-			{
-				newTabItem = TabCtrl_GetItemCount(m_hTab);
-				_String text(LibCC::FormatW(L"%").ul(threadID).Str());
-				TCITEMW tci = {0};
-				tci.mask = TCIF_TEXT;
-				tci.pszText = const_cast<PWSTR>(text.c_str());// i hate these damn non-const structs
-				TabCtrl_InsertItem(m_hTab, newTabItem, &tci);
-
-				hNewEdit = CreateWindowExW(0, L"EDIT", L"",
-					WS_CLIPSIBLINGS | WS_VSCROLL | WS_HSCROLL | ES_AUTOHSCROLL | ES_AUTOVSCROLL | ES_MULTILINE | ES_READONLY | WS_CHILD,
-					27, 74, 3, 2, m_hMain, 0, m_hInstance, 0);
-				SendMessage(hNewEdit, WM_SETFONT, (WPARAM)m_hFont, TRUE);
-				SendMessage(hNewEdit, EM_SETLIMITTEXT, (WPARAM)0, 0);
-				PostMessage(m_hMain, WM_SIZE, 0, 0);
-			}
-			m_threads.push_back(ThreadInfo());
-			ThreadInfo& ret(m_threads.back());
+			int newTabItem = TabCtrl_GetItemCount(m_hTab);
+			std::wstring text(LibCC::FormatW(L"%").ul(threadID).Str());
+			TCITEMW tci = {0};
+			tci.mask = TCIF_TEXT;
+			tci.pszText = const_cast<PWSTR>(text.c_str());// i hate these damn non-const structs
+			TabCtrl_InsertItem(m_hTab, newTabItem, &tci);
+
+			HWND hNewEdit = CreateWindowExW(0, L"EDIT", L"",
+				WS_CLIPSIBLINGS | WS_VSCROLL | WS_HSCROLL | ES_AUTOHSCROLL | ES_AUTOVSCROLL | ES_MULTILINE | ES_READONLY | WS_CHILD,
+				27, 74, 3, 2, m_hMain, 0, m_hInstance, 0);
+			SendMessage(hNewEdit, WM_SETFONT, (WPARAM)m_hFont, TRUE);
+			SendMessage(hNewEdit, EM_SETLIMITTEXT, (WPARAM)0, 0);
+			PostMessage(m_hMain, WM_SIZE, 0, 0);
+
+			m_tabs.push_back(WindowTab());
+			WindowTab& ret(m_tabs.back());
 			ret.tabItem = newTabItem;
 			ret.threadID = threadID;
 			ret.hEdit = hNewEdit;
-	    
+
 			return ret;
     }
 
-	void RotateFile( const std::wstring& fileName ) 
-	{
-		const wchar_t *fn = fileName.c_str();
-		const wchar_t* ext = PathFindExtensionW(fn);
-		
-		std::wstring fileNameBase = fileName.substr(0, ext - fn);
-		std::wstring fileNameExt = ext;
+    HANDLE m_hWindowThread;
+    HANDLE m_hInitialized;
+    HWND m_hMain;
+    HWND m_hEdit;// composite of all threads.
+    HFONT m_hFont;
 
-		for(int i = m_rotateKeepCount; i >= 0; --i)
+    HWND m_hTab;
+    std::vector<WindowTab> m_tabs;// window thread
+
+    HINSTANCE m_hInstance;
+#else
+		void InitWindow()
 		{
-			std::wstring fromFile;
-			if(i == 0)
-			{
-				fromFile = fileName;
-			}
-			else
-			{
-				fromFile = LibCC::FormatW(L"%.%%")(fileNameBase).i(i - 1)(fileNameExt).Str();
-			}
-			std::wstring toFile = LibCC::FormatW(L"%.%%")(fileNameBase).i(i)(fileNameExt).Str();
+		}
+#endif
 
-			if(i == (int)m_rotateKeepCount)
-			{
-				// Delete the oldest file
-				DeleteFileW(fromFile.c_str());
-			}
-			else
+		std::vector<std::wstring> m_fileNames;
+
+		// the log thread, and how the other threads talk to it
+		std::thread m_thread;
+		std::mutex m_lock;
+		std::condition_variable m_wake;// log thread waits on this
+		std::condition_variable m_done;// synchronous callers wait on this
+		std::vector<MessageInfo*> m_commands;// synchronous messages and requests; owned by the callers
+		uint64_t m_commandsQueued;
+		uint64_t m_commandsDone;
+		bool m_exit;
+
+		// log thread
+		LogTimePrefix<_Char> m_timePrefix;
+		std::vector<LogFile> m_files;
+		size_t m_fileBufferSize;
+		DWORD m_flushInterval;
+		bool m_flushTimerSet;// m_flushDeadline is when the file buffers get written
+		std::chrono::steady_clock::time_point m_flushDeadline;
+		bool m_rotatePending;// some file has LogFile::rotatePending
+
+		// async mode; see EnableAsync()
+		struct ProducerQueue
+		{
+			ProducerQueue(size_t capacity, DWORD threadID_) :
+				queue(capacity),
+				threadID(threadID_),
+				claimed(std::make_shared<std::atomic<bool> >(true)),
+				head(0),
+				next(0)
 			{
-				// Move each old file to next position
-				MoveFileW(fromFile.c_str(), toFile.c_str());
 			}
-		}
-	}
+			BoundedQueue<MessageInfo*> queue;
+			std::atomic<DWORD> threadID;// the thread that has it; 0 for the shared queue
+			std::shared_ptr<std::atomic<bool> > claimed;// false once that thread has exited; then another thread may take it
+			MessageInfo* head;// log thread: popped, but other queues may have older messages to write first
+			ProducerQueue* next;
+		};
+		bool m_async;// false when Message() is synchronous
+		std::atomic<ProducerQueue*> m_queues;// newest first; reused, but never shrinks until DeleteQueues()
+		std::atomic<uint64_t> m_queuesID;// identifies m_queues in the threads' caches
+		size_t m_queueCapacity;
+		bool m_queuePerThread;
+		LogBackpressure m_backpressure;
+		std::atomic<bool> m_drainPosted;// the log thread has been woken up to drain
+		std::atomic<size_t> m_dropped;
+		std::atomic<size_t> m_droppedOldest;
+		std::atomic<size_t> m_blocked;
+		size_t m_reportedDrops;// log thread
+	};
+
+	extern Log* g_pLog;
 
-	bool FileNeedsRotate( const std::wstring& fileName ) 
+	// a named group of messages with a threshold of its own, for LIBCC_LOG_CATEGORY. a category at LogLevelDefault
+	// goes by the Log's threshold; any other level replaces it, so one part of a program can log its debug messages
+	// while the rest only logs warnings. categories are normally statics; the name is interned once, and each message
+	// only carries the handle.
+	class LogCategory
 	{
-		WIN32_FILE_ATTRIBUTE_DATA fad = {};
-		GetFileAttributesExW(fileName.c_str(), GetFileExInfoStandard, &fad);
-		return fad.nFileSizeLow > m_rotateByteSize;
-	}
+	public:
+		template<typename XChar>
+		explicit LogCategory(const XChar* name, LogLevel level = LogLevelDefault)
+		{
+			Log::_String s;
+			StringConvert(name, s);
+			s.append(LIBCC_LOG_TEXT(": "));
+			m_name = StringIntern(s);
+			m_level.store(level);
+		}
 
-    struct MessageInfo
-    {
-      _String s1;
-      _String s2;
-      DWORD threadID;
-      SYSTEMTIME localTime;
-    };
+		const InternedString<Log::_Char>& Name() const
+		{
+			return m_name;
+		}
 
-    HANDLE m_hInitialized;
-    HANDLE m_hThread;
-    HWND m_hMain;
-    HWND m_hEdit;// composite of all threads.
-    HFONT m_hFont;
+		void SetLevel(LogLevel level)
+		{
+			m_level.store(level, std::memory_order_relaxed);
+		}
 
-    HWND m_hTab;
-    std::vector<ThreadInfo> m_threads;
+		LogLevel GetLevel() const
+		{
+			return (LogLevel)m_level.load(std::memory_order_relaxed);
+		}
 
-    HINSTANCE m_hInstance;
-		std::vector<std::wstring> m_fileNames;
+		bool IsEnabled(const Log& log, LogLevel level) const
+		{
+			LogLevel threshold = GetLevel();
+			return threshold == LogLevelDefault ? log.IsEnabled(level) : log.IsEnabled(level, threshold);
+		}
+
+	private:
+		InternedString<Log::_Char> m_name;
+		std::atomic<int> m_level;
 	};
 
-	extern Log* g_pLog;
+	template<typename Y>
+	inline void Log::Message(const LogCategory& category, LogLevel level, const Y& y)
+	{
+		if(category.IsEnabled(*this, level))
+		{
+			MessageInfo* pNew = NewMessageInfo(OpMessage);
+			pNew->level = level;
+			pNew->s1Interned = category.Name();
+			MessageText(y, pNew->s2);
+			Submit(pNew);
+		}
+	}
 
   class LogScopeMessage
   {
@@ -800,14 +2784,14 @@ namespace LibCC
     LogScopeMessage(const XChar* op, Log* pLog = g_pLog) :
       m_pLog(pLog)
     {
-      m_pLog->Message(std::wstring(L"{ "), std::basic_string<XChar>(op));
+      m_pLog->Message(Log::_String(LIBCC_LOG_TEXT("{ ")), std::basic_string<XChar>(op));
       m_pLog->Indent();
     }
 		template<typename XChar>
     LogScopeMessage(const std::basic_string<XChar>& op, Log* pLog = g_pLog) :
       m_pLog(pLog)
     {
-      m_pLog->Message(std::wstring(L"{ "), op);
+      m_pLog->Message(Log::_String(LIBCC_LOG_TEXT("{ ")), op);
       m_pLog->Indent();
     }
     
@@ -887,20 +2871,20 @@ namespace LibCC
     LogScopeMessageTimer(const XChar* op, Log* pLog = g_pLog) :
       m_pLog(pLog)
     {
-			t.Tick();
+			t.Start();
 			if(!m_pLog)
 				return;
-      m_pLog->Message(std::wstring(L"{ "), std::basic_string<XChar>(op));
+      m_pLog->Message(Log::_String(LIBCC_LOG_TEXT("{ ")), std::basic_string<XChar>(op));
       m_pLog->Indent();
     }
 		template<typename XChar>
     LogScopeMessageTimer(const std::basic_string<XChar>& op, Log* pLog = g_pLog) :
       m_pLog(pLog)
     {
-			t.Tick();
+			t.Start();
 			if(!m_pLog)
 				return;
-      m_pLog->Message(std::wstring(L"{ "), op);
+      m_pLog->Message(Log::_String(LIBCC_LOG_TEXT("{ ")), op);
       m_pLog->Indent();
     }
     
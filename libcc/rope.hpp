@@ -0,0 +1,320 @@
+// LibCC ~ Carl Corcoran, https://github.com/thenfour/LibCC
+
+#pragma once
+
+#include "stringutil.hpp"
+#include <deque>
+
+namespace LibCC
+{
+	/*
+		StringRope builds a large string out of chunks, so appending never moves what's already there.
+		- AppendRef() only records a reference; the chars have to outlive the rope (literals, interned strings).
+		- Take() adopts a std::basic_string or a FormatX's rendered output without copying the chars.
+		- Append() copies into the rope's own StringArena. consecutive copies are packed into one chunk.
+		Str() flattens with one allocation; Render() hands the chunks to a sink one at a time, so a multi-megabyte
+		output never has to exist as one buffer. a sink is anything with Write(const Char* p, size_t len).
+	*/
+	template<typename Char>
+	class StringRope
+	{
+	public:
+		typedef std::basic_string<Char> _String;
+
+		StringRope() :
+			m_size(0),
+			m_arena(16384),
+			m_copied(false)
+		{
+		}
+
+		size_t size() const
+		{
+			return m_size;
+		}
+
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+
+		size_t ChunkCount() const
+		{
+			return m_chunks.size();
+		}
+
+		void clear()
+		{
+			m_chunks.clear();
+			m_owned.clear();
+			m_arena.Reset();
+			m_size = 0;
+			m_copied = false;
+		}
+
+		// no copy
+		StringRope<Char>& AppendRef(const Char* s, size_t len)
+		{
+			if(len)
+			{
+				m_chunks.push_back(StringView<Char>(s, len));
+				m_size += len;
+				m_copied = false;
+			}
+			return *this;
+		}
+		StringRope<Char>& AppendRef(const Char* s)
+		{
+			return AppendRef(s, StringLength(s));
+		}
+		StringRope<Char>& AppendRef(const _String& s)
+		{
+			return AppendRef(s.c_str(), s.size());
+		}
+		StringRope<Char>& AppendRef(const StringView<Char>& s)
+		{
+			return AppendRef(s.data(), s.size());
+		}
+		StringRope<Char>& AppendRef(const InternedString<Char>& s)
+		{
+			return AppendRef(s.c_str(), s.size());
+		}
+
+		// no copy; s is left empty.
+		StringRope<Char>& Take(_String& s)
+		{
+			if(!s.empty())
+			{
+				m_owned.push_back(_String());
+				m_owned.back().swap(s);
+				AppendRef(m_owned.back().c_str(), m_owned.back().size());
+			}
+			return *this;
+		}
+		// the rendered string is adopted as it is, so only a FormatX with the default traits and allocator; Append()
+		// any other one.
+		template<size_t InlineCapacity>
+		StringRope<Char>& Take(FormatX<Char, std::char_traits<Char>, std::allocator<Char>, InlineCapacity>& f)
+		{
+			_String s(f.ReleaseStr());
+			return Take(s);
+		}
+
+		// copies
+		StringRope<Char>& Append(const Char* s, size_t len)
+		{
+			if(!len)
+				return *this;
+			// extend the last chunk if it's the arena's latest copy
+			if(m_copied)
+			{
+				StringView<Char>& last = m_chunks.back();
+				if(m_arena.Extend(const_cast<Char*>(last.p), last.len * sizeof(Char), (last.len + len) * sizeof(Char)))
+				{
+					memcpy(const_cast<Char*>(last.p) + last.len, s, len * sizeof(Char));
+					last.len += len;
+					m_size += len;
+					return *this;
+				}
+			}
+			Char* p = (Char*)m_arena.Allocate(len * sizeof(Char));
+			memcpy(p, s, len * sizeof(Char));
+			AppendRef(p, len);
+			m_copied = true;
+			return *this;
+		}
+		StringRope<Char>& Append(const Char* s)
+		{
+			return Append(s, StringLength(s));
+		}
+		StringRope<Char>& Append(const _String& s)
+		{
+			return Append(s.c_str(), s.size());
+		}
+		StringRope<Char>& Append(const StringView<Char>& s)
+		{
+			return Append(s.data(), s.size());
+		}
+		StringRope<Char>& Append(Char ch)
+		{
+			return Append(&ch, 1);
+		}
+		template<typename Traits, typename Alloc, size_t InlineCapacity>
+		StringRope<Char>& Append(const FormatX<Char, Traits, Alloc, InlineCapacity>& f)
+		{
+			const std::basic_string<Char, Traits, Alloc>& s = f.Str();
+			return Append(s.c_str(), s.size());
+		}
+
+		template<typename Sink>
+		void Render(Sink& sink) const
+		{
+			for(typename std::vector<StringView<Char> >::const_iterator it = m_chunks.begin(); it != m_chunks.end(); ++ it)
+			{
+				sink.Write(it->data(), it->size());
+			}
+		}
+
+		void Str(_String& out) const
+		{
+			out.clear();
+			out.reserve(m_size);
+			StringSink sink(out);
+			Render(sink);
+		}
+
+		_String Str() const
+		{
+			_String ret;
+			Str(ret);
+			return ret;
+		}
+
+	private:
+		StringRope(const StringRope<Char>&);
+		StringRope<Char>& operator =(const StringRope<Char>&);
+
+		struct StringSink
+		{
+			explicit StringSink(_String& out_) :
+				out(out_)
+			{
+			}
+			void Write(const Char* p, size_t len)
+			{
+				out.append(p, len);
+			}
+			_String& out;
+		};
+
+		std::vector<StringView<Char> > m_chunks;
+		std::deque<_String> m_owned;// deque, so taken strings never move (a short one's chars live inside it)
+		StringArena m_arena;
+		size_t m_size;
+		bool m_copied;// the last chunk is the arena's latest allocation
+	};
+
+	// a sink that converts UTF-16 to UTF-8 on the way to another sink. a surrogate pair split across two chunks is
+	// held back until the second half arrives; a high surrogate the next chunk doesn't pair up is written as U+FFFD.
+	template<typename Sink>
+	class Utf8Sink
+	{
+	public:
+		explicit Utf8Sink(Sink& sink) :
+			m_sink(sink),
+			m_pendingHigh(0)
+		{
+		}
+
+		void Write(const wchar_t* p, size_t len)
+		{
+			if(!len)
+				return;
+			if(m_pendingHigh && p[0] >= 0xdc00 && p[0] < 0xe000)
+			{
+				wchar_t pair[2] = { m_pendingHigh, p[0] };
+				m_pendingHigh = 0;
+				UTF16ToUTF8(pair, 2, m_temp);
+				m_sink.Write(m_temp.c_str(), m_temp.size());
+				++ p;
+				-- len;
+			}
+			Flush();// not followed by its low half
+			if(len && p[len - 1] >= 0xd800 && p[len - 1] < 0xdc00)
+			{
+				m_pendingHigh = p[len - 1];
+				-- len;
+			}
+			UTF16ToUTF8(p, len, m_temp);
+			m_sink.Write(m_temp.c_str(), m_temp.size());
+		}
+
+		// a high surrogate left over at the end is written as U+FFFD.
+		void Flush()
+		{
+			if(m_pendingHigh)
+			{
+				UTF16ToUTF8(&m_pendingHigh, 1, m_temp);
+				m_sink.Write(m_temp.c_str(), m_temp.size());
+				m_pendingHigh = 0;
+			}
+		}
+
+	private:
+		Sink& m_sink;
+		wchar_t m_pendingHigh;
+		std::string m_temp;
+	};
+
+#ifdef WIN32
+	// writes chunks to a file handle as they are in memory (wchar_t as UTF-16LE; wrap in Utf8Sink for UTF-8). small
+	// chunks are gathered in a buffer; chunks at least as big as the buffer are written straight through.
+	class HandleSink
+	{
+	public:
+		explicit HandleSink(HANDLE h, size_t bufferSize = 65536) :
+			m_h(h),
+			m_buffer(bufferSize),
+			m_used(0),
+			m_failed(false)
+		{
+		}
+
+		~HandleSink()
+		{
+			Flush();
+		}
+
+		template<typename Char>
+		void Write(const Char* p, size_t len)
+		{
+			WriteBytes(p, len * sizeof(Char));
+		}
+
+		void Flush()
+		{
+			if(m_used)
+			{
+				WriteThrough(&m_buffer[0], m_used);
+				m_used = 0;
+			}
+		}
+
+		bool Failed() const
+		{
+			return m_failed;
+		}
+
+	private:
+		HandleSink(const HandleSink&);
+		HandleSink& operator =(const HandleSink&);
+
+		void WriteBytes(const void* p, size_t bytes)
+		{
+			if(m_used + bytes > m_buffer.size())
+			{
+				Flush();
+				if(bytes >= m_buffer.size())
+				{
+					WriteThrough(p, bytes);
+					return;
+				}
+			}
+			memcpy(&m_buffer[m_used], p, bytes);
+			m_used += bytes;
+		}
+
+		void WriteThrough(const void* p, size_t bytes)
+		{
+			DWORD bw;
+			if(!WriteFile(m_h, p, (DWORD)bytes, &bw, 0) || bw != bytes)
+				m_failed = true;
+		}
+
+		HANDLE m_h;
+		std::vector<char> m_buffer;
+		size_t m_used;
+		bool m_failed;
+	};
+#endif
+}
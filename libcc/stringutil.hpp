@@ -3,16 +3,66 @@
 #pragma once
 
 #include <string>
-#include <tchar.h>
-#include <malloc.h>// for alloca()
+#include <stdint.h>
+#ifdef WIN32
+# include <tchar.h>
+# include <malloc.h>// for alloca()
+# define LIBCC_ALLOCA _alloca
+#else
+# include <alloca.h>
+# include <string.h>
+# include <stdlib.h>
+# define LIBCC_ALLOCA alloca
+#endif
 #include <math.h>// for fmod()
 #include <algorithm>
 #include <vector>
-#include "float.hpp"
+#include <initializer_list>
+#include <iterator>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <type_traits>
 
 #ifdef WIN32
 # include <windows.h>// for GetLastError() / LoadStrin / FormatMessage...
+#else
+namespace LibCC
+{
+	// just enough of the Win32 vocabulary for the portable parts, with the sizes Win32 gives them. there's no ANSI
+	// codepage outside of Windows, so char strings are UTF-8 there (see LIBCC_UTF8).
+	typedef unsigned int UINT;
+	typedef uint32_t DWORD;
+	typedef unsigned char BYTE;
+	typedef uint16_t WORD;
+	typedef char TCHAR;
+	typedef int32_t HRESULT;
+	// another portability layer may have these as macros already
+#ifndef S_OK
+	static const HRESULT S_OK = 0;
+#endif
+#ifndef E_FAIL
+	static const HRESULT E_FAIL = (HRESULT)0x80004005u;
 #endif
+#ifndef SUCCEEDED
+	inline bool SUCCEEDED(HRESULT hr) { return hr >= 0; }
+#endif
+#ifndef FAILED
+	inline bool FAILED(HRESULT hr) { return hr < 0; }
+#endif
+#ifndef CP_ACP
+	static const UINT CP_ACP = 0;
+#endif
+#ifndef CP_UTF8
+	static const UINT CP_UTF8 = 65001;
+#endif
+	inline void* GetProcessHeap() { return 0; }
+	inline void* HeapAlloc(void*, DWORD, size_t bytes) { return malloc(bytes); }
+	inline void* HeapReAlloc(void*, DWORD, void* p, size_t bytes) { return realloc(p, bytes); }
+	inline int HeapFree(void*, DWORD, void* p) { free(p); return 1; }
+}
+#endif
+#include "float.hpp"
 #undef max// WinDef.h can go to hell.
 
 #pragma warning(push)
@@ -31,6 +81,80 @@
 #  define CCSTR_OPTION_AUTOCAST 0// set this to 1 and class Format can auto-cast into std::string
 #endif
 
+// how many chars a FormatX argument can hold before it goes to the heap. FormatX / QuickStringList also take it as
+// a template parameter.
+#ifndef LIBCC_QUICKSTRING_INLINE
+#  define LIBCC_QUICKSTRING_INLINE 31
+#endif
+
+// StringConvertBatch splits a batch across threads once it holds at least this many code units in total.
+#ifndef LIBCC_BATCH_PARALLEL_UNITS
+#  define LIBCC_BATCH_PARALLEL_UNITS 262144
+#endif
+
+/*
+  UTF-8 mode. set LIBCC_UTF8 to 1 (before including any LibCC header) and char strings are treated as UTF-8
+  instead of the ANSI codepage. char becomes the native string type: LibCC::Format is FormatA, Log stores
+  and writes UTF-8 without conversion, and all the mixed char type overloads convert char <-> wchar_t as UTF-8.
+*/
+#ifndef LIBCC_UTF8
+#  ifdef WIN32
+#    define LIBCC_UTF8 0
+#  else
+#    define LIBCC_UTF8 1
+#  endif
+#endif
+
+#if LIBCC_UTF8 == 1
+#  define LIBCC_CHAR_CODEPAGE CP_UTF8
+#else
+#  define LIBCC_CHAR_CODEPAGE CP_ACP
+#endif
+
+// SSE2 is used for the bulk paths of some string functions. it's on by default for x64 and /arch:SSE2.
+#ifndef LIBCC_SSE2
+#  if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#    define LIBCC_SSE2 1
+#  else
+#    define LIBCC_SSE2 0
+#  endif
+#endif
+
+#if LIBCC_SSE2 == 1
+#  include <emmintrin.h>
+#endif
+
+// SSSE3 (pshufb) is used for character set classification. MSVC has no switch that implies it below /arch:AVX,
+// so define LIBCC_SSSE3 to 1 yourself if you know your targets have it.
+#ifndef LIBCC_SSSE3
+#  if defined(__SSSE3__) || defined(__AVX__)
+#    define LIBCC_SSSE3 1
+#  else
+#    define LIBCC_SSSE3 0
+#  endif
+#endif
+
+#if LIBCC_SSSE3 == 1
+#  include <tmmintrin.h>
+#endif
+
+// AVX2 widens a few of the SSE2 loops to 32 bytes. on by default for /arch:AVX2.
+#ifndef LIBCC_AVX2
+#  if defined(__AVX2__)
+#    define LIBCC_AVX2 1
+#  else
+#    define LIBCC_AVX2 0
+#  endif
+#endif
+
+#if LIBCC_AVX2 == 1
+#  include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#  include <intrin.h>// _BitScanForward / _BitScanReverse
+#endif
+
 namespace LibCC
 {
 	// random utility function
@@ -91,48 +215,300 @@ namespace LibCC
 	// CharConvert. --------------------------------------------------------------------------------------
 	// TODO. for now conversion of single characters is always just a cast.
 	template<typename CharOut, typename CharIn>
-	inline CharOut CharConvert(CharIn i, UINT inCP = CP_ACP, UINT outCP = CP_ACP)
+	inline CharOut CharConvert(CharIn i, UINT inCP = LIBCC_CHAR_CODEPAGE, UINT outCP = LIBCC_CHAR_CODEPAGE)
 	{
 		return (CharOut)i;
 	}
 
 
-	// CharToLower. --------------------------------------------------------------------------------------
-	// TODO: um, 
-	//inline wchar_t CharToLower(wchar_t c)
-	//{
-	//	return (wchar_t)CharLowerW((PWSTR)c);
-	//}
+	// CharToLower / CharToUpper / CharFoldCase. --------------------------------------------------------------------------------------
+	// single code unit case mapping, using the Unicode simple (1:1) mappings so string lengths never change.
+	// wchar_t is UTF-16 so only the BMP maps; wider char types are UTF-32 and map the supplementary planes too.
+	// char is the ANSI codepage and maps through a 256 entry table built once with CharUpperBuffA / CharLowerBuffA.
+	// under LIBCC_UTF8 a single char only maps if it's ASCII; the string functions take care of multibyte sequences.
+	// CharFoldCase is simple case folding, which is what the case-insensitive comparisons use.
+	enum CaseMapping
+	{
+		CaseMappingLower,
+		CaseMappingUpper,
+		CaseMappingFold
+	};
 
-	//inline char CharToLower(char c)
-	//{
-	//	return (char)CharLowerA((PSTR)c);
-	//}
+	struct CaseMappingRun
+	{
+		unsigned long first;
+		unsigned long last;
+		long delta;
+		unsigned long step;// 2 for alternating upper / lower pairs, where every other code point maps
+	};
 
-	//template<typename Char>
-	//inline Char CharToLower(Char c)
-	//{
-	//	return (Char)CharToLower((wchar_t)c);// TODO: make this work for 32-bit unicode scalars
-	//}
+	// generated from Unicode 14.0; UnicodeData.txt simple mappings and CaseFolding.txt C + S.
+	inline const CaseMappingRun* InternalCaseMappingRuns(CaseMapping mapping, size_t& count)
+	{
+		static const CaseMappingRun lower[] =
+		{
+			{ 0x0041, 0x005A, 32, 1 }, { 0x00C0, 0x00D6, 32, 1 }, { 0x00D8, 0x00DE, 32, 1 }, { 0x0100, 0x012E, 1, 2 },
+			{ 0x0130, 0x0130, -199, 1 }, { 0x0132, 0x0136, 1, 2 }, { 0x0139, 0x0147, 1, 2 }, { 0x014A, 0x0176, 1, 2 },
+			{ 0x0178, 0x0178, -121, 1 }, { 0x0179, 0x017D, 1, 2 }, { 0x0181, 0x0181, 210, 1 }, { 0x0182, 0x0184, 1, 2 },
+			{ 0x0186, 0x0186, 206, 1 }, { 0x0187, 0x0187, 1, 1 }, { 0x0189, 0x018A, 205, 1 }, { 0x018B, 0x018B, 1, 1 },
+			{ 0x018E, 0x018E, 79, 1 }, { 0x018F, 0x018F, 202, 1 }, { 0x0190, 0x0190, 203, 1 }, { 0x0191, 0x0191, 1, 1 },
+			{ 0x0193, 0x0193, 205, 1 }, { 0x0194, 0x0194, 207, 1 }, { 0x0196, 0x0196, 211, 1 }, { 0x0197, 0x0197, 209, 1 },
+			{ 0x0198, 0x0198, 1, 1 }, { 0x019C, 0x019C, 211, 1 }, { 0x019D, 0x019D, 213, 1 }, { 0x019F, 0x019F, 214, 1 },
+			{ 0x01A0, 0x01A4, 1, 2 }, { 0x01A6, 0x01A6, 218, 1 }, { 0x01A7, 0x01A7, 1, 1 }, { 0x01A9, 0x01A9, 218, 1 },
+			{ 0x01AC, 0x01AC, 1, 1 }, { 0x01AE, 0x01AE, 218, 1 }, { 0x01AF, 0x01AF, 1, 1 }, { 0x01B1, 0x01B2, 217, 1 },
+			{ 0x01B3, 0x01B5, 1, 2 }, { 0x01B7, 0x01B7, 219, 1 }, { 0x01B8, 0x01B8, 1, 1 }, { 0x01BC, 0x01BC, 1, 1 },
+			{ 0x01C4, 0x01C4, 2, 1 }, { 0x01C5, 0x01C5, 1, 1 }, { 0x01C7, 0x01C7, 2, 1 }, { 0x01C8, 0x01C8, 1, 1 },
+			{ 0x01CA, 0x01CA, 2, 1 }, { 0x01CB, 0x01DB, 1, 2 }, { 0x01DE, 0x01EE, 1, 2 }, { 0x01F1, 0x01F1, 2, 1 },
+			{ 0x01F2, 0x01F4, 1, 2 }, { 0x01F6, 0x01F6, -97, 1 }, { 0x01F7, 0x01F7, -56, 1 }, { 0x01F8, 0x021E, 1, 2 },
+			{ 0x0220, 0x0220, -130, 1 }, { 0x0222, 0x0232, 1, 2 }, { 0x023A, 0x023A, 10795, 1 }, { 0x023B, 0x023B, 1, 1 },
+			{ 0x023D, 0x023D, -163, 1 }, { 0x023E, 0x023E, 10792, 1 }, { 0x0241, 0x0241, 1, 1 }, { 0x0243, 0x0243, -195, 1 },
+			{ 0x0244, 0x0244, 69, 1 }, { 0x0245, 0x0245, 71, 1 }, { 0x0246, 0x024E, 1, 2 }, { 0x0370, 0x0372, 1, 2 },
+			{ 0x0376, 0x0376, 1, 1 }, { 0x037F, 0x037F, 116, 1 }, { 0x0386, 0x0386, 38, 1 }, { 0x0388, 0x038A, 37, 1 },
+			{ 0x038C, 0x038C, 64, 1 }, { 0x038E, 0x038F, 63, 1 }, { 0x0391, 0x03A1, 32, 1 }, { 0x03A3, 0x03AB, 32, 1 },
+			{ 0x03CF, 0x03CF, 8, 1 }, { 0x03D8, 0x03EE, 1, 2 }, { 0x03F4, 0x03F4, -60, 1 }, { 0x03F7, 0x03F7, 1, 1 },
+			{ 0x03F9, 0x03F9, -7, 1 }, { 0x03FA, 0x03FA, 1, 1 }, { 0x03FD, 0x03FF, -130, 1 }, { 0x0400, 0x040F, 80, 1 },
+			{ 0x0410, 0x042F, 32, 1 }, { 0x0460, 0x0480, 1, 2 }, { 0x048A, 0x04BE, 1, 2 }, { 0x04C0, 0x04C0, 15, 1 },
+			{ 0x04C1, 0x04CD, 1, 2 }, { 0x04D0, 0x052E, 1, 2 }, { 0x0531, 0x0556, 48, 1 }, { 0x10A0, 0x10C5, 7264, 1 },
+			{ 0x10C7, 0x10C7, 7264, 1 }, { 0x10CD, 0x10CD, 7264, 1 }, { 0x13A0, 0x13EF, 38864, 1 }, { 0x13F0, 0x13F5, 8, 1 },
+			{ 0x1C90, 0x1CBA, -3008, 1 }, { 0x1CBD, 0x1CBF, -3008, 1 }, { 0x1E00, 0x1E94, 1, 2 }, { 0x1E9E, 0x1E9E, -7615, 1 },
+			{ 0x1EA0, 0x1EFE, 1, 2 }, { 0x1F08, 0x1F0F, -8, 1 }, { 0x1F18, 0x1F1D, -8, 1 }, { 0x1F28, 0x1F2F, -8, 1 },
+			{ 0x1F38, 0x1F3F, -8, 1 }, { 0x1F48, 0x1F4D, -8, 1 }, { 0x1F59, 0x1F5F, -8, 2 }, { 0x1F68, 0x1F6F, -8, 1 },
+			{ 0x1F88, 0x1F8F, -8, 1 }, { 0x1F98, 0x1F9F, -8, 1 }, { 0x1FA8, 0x1FAF, -8, 1 }, { 0x1FB8, 0x1FB9, -8, 1 },
+			{ 0x1FBA, 0x1FBB, -74, 1 }, { 0x1FBC, 0x1FBC, -9, 1 }, { 0x1FC8, 0x1FCB, -86, 1 }, { 0x1FCC, 0x1FCC, -9, 1 },
+			{ 0x1FD8, 0x1FD9, -8, 1 }, { 0x1FDA, 0x1FDB, -100, 1 }, { 0x1FE8, 0x1FE9, -8, 1 }, { 0x1FEA, 0x1FEB, -112, 1 },
+			{ 0x1FEC, 0x1FEC, -7, 1 }, { 0x1FF8, 0x1FF9, -128, 1 }, { 0x1FFA, 0x1FFB, -126, 1 }, { 0x1FFC, 0x1FFC, -9, 1 },
+			{ 0x2126, 0x2126, -7517, 1 }, { 0x212A, 0x212A, -8383, 1 }, { 0x212B, 0x212B, -8262, 1 }, { 0x2132, 0x2132, 28, 1 },
+			{ 0x2160, 0x216F, 16, 1 }, { 0x2183, 0x2183, 1, 1 }, { 0x24B6, 0x24CF, 26, 1 }, { 0x2C00, 0x2C2F, 48, 1 },
+			{ 0x2C60, 0x2C60, 1, 1 }, { 0x2C62, 0x2C62, -10743, 1 }, { 0x2C63, 0x2C63, -3814, 1 }, { 0x2C64, 0x2C64, -10727, 1 },
+			{ 0x2C67, 0x2C6B, 1, 2 }, { 0x2C6D, 0x2C6D, -10780, 1 }, { 0x2C6E, 0x2C6E, -10749, 1 }, { 0x2C6F, 0x2C6F, -10783, 1 },
+			{ 0x2C70, 0x2C70, -10782, 1 }, { 0x2C72, 0x2C72, 1, 1 }, { 0x2C75, 0x2C75, 1, 1 }, { 0x2C7E, 0x2C7F, -10815, 1 },
+			{ 0x2C80, 0x2CE2, 1, 2 }, { 0x2CEB, 0x2CED, 1, 2 }, { 0x2CF2, 0x2CF2, 1, 1 }, { 0xA640, 0xA66C, 1, 2 },
+			{ 0xA680, 0xA69A, 1, 2 }, { 0xA722, 0xA72E, 1, 2 }, { 0xA732, 0xA76E, 1, 2 }, { 0xA779, 0xA77B, 1, 2 },
+			{ 0xA77D, 0xA77D, -35332, 1 }, { 0xA77E, 0xA786, 1, 2 }, { 0xA78B, 0xA78B, 1, 1 }, { 0xA78D, 0xA78D, -42280, 1 },
+			{ 0xA790, 0xA792, 1, 2 }, { 0xA796, 0xA7A8, 1, 2 }, { 0xA7AA, 0xA7AA, -42308, 1 }, { 0xA7AB, 0xA7AB, -42319, 1 },
+			{ 0xA7AC, 0xA7AC, -42315, 1 }, { 0xA7AD, 0xA7AD, -42305, 1 }, { 0xA7AE, 0xA7AE, -42308, 1 }, { 0xA7B0, 0xA7B0, -42258, 1 },
+			{ 0xA7B1, 0xA7B1, -42282, 1 }, { 0xA7B2, 0xA7B2, -42261, 1 }, { 0xA7B3, 0xA7B3, 928, 1 }, { 0xA7B4, 0xA7C2, 1, 2 },
+			{ 0xA7C4, 0xA7C4, -48, 1 }, { 0xA7C5, 0xA7C5, -42307, 1 }, { 0xA7C6, 0xA7C6, -35384, 1 }, { 0xA7C7, 0xA7C9, 1, 2 },
+			{ 0xA7D0, 0xA7D0, 1, 1 }, { 0xA7D6, 0xA7D8, 1, 2 }, { 0xA7F5, 0xA7F5, 1, 1 }, { 0xFF21, 0xFF3A, 32, 1 },
+			{ 0x10400, 0x10427, 40, 1 }, { 0x104B0, 0x104D3, 40, 1 }, { 0x10570, 0x1057A, 39, 1 }, { 0x1057C, 0x1058A, 39, 1 },
+			{ 0x1058C, 0x10592, 39, 1 }, { 0x10594, 0x10595, 39, 1 }, { 0x10C80, 0x10CB2, 64, 1 }, { 0x118A0, 0x118BF, 32, 1 },
+			{ 0x16E40, 0x16E5F, 32, 1 }, { 0x1E900, 0x1E921, 34, 1 },
+		};
+		static const CaseMappingRun upper[] =
+		{
+			{ 0x0061, 0x007A, -32, 1 }, { 0x00B5, 0x00B5, 743, 1 }, { 0x00E0, 0x00F6, -32, 1 }, { 0x00F8, 0x00FE, -32, 1 },
+			{ 0x00FF, 0x00FF, 121, 1 }, { 0x0101, 0x012F, -1, 2 }, { 0x0131, 0x0131, -232, 1 }, { 0x0133, 0x0137, -1, 2 },
+			{ 0x013A, 0x0148, -1, 2 }, { 0x014B, 0x0177, -1, 2 }, { 0x017A, 0x017E, -1, 2 }, { 0x017F, 0x017F, -300, 1 },
+			{ 0x0180, 0x0180, 195, 1 }, { 0x0183, 0x0185, -1, 2 }, { 0x0188, 0x0188, -1, 1 }, { 0x018C, 0x018C, -1, 1 },
+			{ 0x0192, 0x0192, -1, 1 }, { 0x0195, 0x0195, 97, 1 }, { 0x0199, 0x0199, -1, 1 }, { 0x019A, 0x019A, 163, 1 },
+			{ 0x019E, 0x019E, 130, 1 }, { 0x01A1, 0x01A5, -1, 2 }, { 0x01A8, 0x01A8, -1, 1 }, { 0x01AD, 0x01AD, -1, 1 },
+			{ 0x01B0, 0x01B0, -1, 1 }, { 0x01B4, 0x01B6, -1, 2 }, { 0x01B9, 0x01B9, -1, 1 }, { 0x01BD, 0x01BD, -1, 1 },
+			{ 0x01BF, 0x01BF, 56, 1 }, { 0x01C5, 0x01C5, -1, 1 }, { 0x01C6, 0x01C6, -2, 1 }, { 0x01C8, 0x01C8, -1, 1 },
+			{ 0x01C9, 0x01C9, -2, 1 }, { 0x01CB, 0x01CB, -1, 1 }, { 0x01CC, 0x01CC, -2, 1 }, { 0x01CE, 0x01DC, -1, 2 },
+			{ 0x01DD, 0x01DD, -79, 1 }, { 0x01DF, 0x01EF, -1, 2 }, { 0x01F2, 0x01F2, -1, 1 }, { 0x01F3, 0x01F3, -2, 1 },
+			{ 0x01F5, 0x01F5, -1, 1 }, { 0x01F9, 0x021F, -1, 2 }, { 0x0223, 0x0233, -1, 2 }, { 0x023C, 0x023C, -1, 1 },
+			{ 0x023F, 0x0240, 10815, 1 }, { 0x0242, 0x0242, -1, 1 }, { 0x0247, 0x024F, -1, 2 }, { 0x0250, 0x0250, 10783, 1 },
+			{ 0x0251, 0x0251, 10780, 1 }, { 0x0252, 0x0252, 10782, 1 }, { 0x0253, 0x0253, -210, 1 }, { 0x0254, 0x0254, -206, 1 },
+			{ 0x0256, 0x0257, -205, 1 }, { 0x0259, 0x0259, -202, 1 }, { 0x025B, 0x025B, -203, 1 }, { 0x025C, 0x025C, 42319, 1 },
+			{ 0x0260, 0x0260, -205, 1 }, { 0x0261, 0x0261, 42315, 1 }, { 0x0263, 0x0263, -207, 1 }, { 0x0265, 0x0265, 42280, 1 },
+			{ 0x0266, 0x0266, 42308, 1 }, { 0x0268, 0x0268, -209, 1 }, { 0x0269, 0x0269, -211, 1 }, { 0x026A, 0x026A, 42308, 1 },
+			{ 0x026B, 0x026B, 10743, 1 }, { 0x026C, 0x026C, 42305, 1 }, { 0x026F, 0x026F, -211, 1 }, { 0x0271, 0x0271, 10749, 1 },
+			{ 0x0272, 0x0272, -213, 1 }, { 0x0275, 0x0275, -214, 1 }, { 0x027D, 0x027D, 10727, 1 }, { 0x0280, 0x0280, -218, 1 },
+			{ 0x0282, 0x0282, 42307, 1 }, { 0x0283, 0x0283, -218, 1 }, { 0x0287, 0x0287, 42282, 1 }, { 0x0288, 0x0288, -218, 1 },
+			{ 0x0289, 0x0289, -69, 1 }, { 0x028A, 0x028B, -217, 1 }, { 0x028C, 0x028C, -71, 1 }, { 0x0292, 0x0292, -219, 1 },
+			{ 0x029D, 0x029D, 42261, 1 }, { 0x029E, 0x029E, 42258, 1 }, { 0x0345, 0x0345, 84, 1 }, { 0x0371, 0x0373, -1, 2 },
+			{ 0x0377, 0x0377, -1, 1 }, { 0x037B, 0x037D, 130, 1 }, { 0x03AC, 0x03AC, -38, 1 }, { 0x03AD, 0x03AF, -37, 1 },
+			{ 0x03B1, 0x03C1, -32, 1 }, { 0x03C2, 0x03C2, -31, 1 }, { 0x03C3, 0x03CB, -32, 1 }, { 0x03CC, 0x03CC, -64, 1 },
+			{ 0x03CD, 0x03CE, -63, 1 }, { 0x03D0, 0x03D0, -62, 1 }, { 0x03D1, 0x03D1, -57, 1 }, { 0x03D5, 0x03D5, -47, 1 },
+			{ 0x03D6, 0x03D6, -54, 1 }, { 0x03D7, 0x03D7, -8, 1 }, { 0x03D9, 0x03EF, -1, 2 }, { 0x03F0, 0x03F0, -86, 1 },
+			{ 0x03F1, 0x03F1, -80, 1 }, { 0x03F2, 0x03F2, 7, 1 }, { 0x03F3, 0x03F3, -116, 1 }, { 0x03F5, 0x03F5, -96, 1 },
+			{ 0x03F8, 0x03F8, -1, 1 }, { 0x03FB, 0x03FB, -1, 1 }, { 0x0430, 0x044F, -32, 1 }, { 0x0450, 0x045F, -80, 1 },
+			{ 0x0461, 0x0481, -1, 2 }, { 0x048B, 0x04BF, -1, 2 }, { 0x04C2, 0x04CE, -1, 2 }, { 0x04CF, 0x04CF, -15, 1 },
+			{ 0x04D1, 0x052F, -1, 2 }, { 0x0561, 0x0586, -48, 1 }, { 0x10D0, 0x10FA, 3008, 1 }, { 0x10FD, 0x10FF, 3008, 1 },
+			{ 0x13F8, 0x13FD, -8, 1 }, { 0x1C80, 0x1C80, -6254, 1 }, { 0x1C81, 0x1C81, -6253, 1 }, { 0x1C82, 0x1C82, -6244, 1 },
+			{ 0x1C83, 0x1C84, -6242, 1 }, { 0x1C85, 0x1C85, -6243, 1 }, { 0x1C86, 0x1C86, -6236, 1 }, { 0x1C87, 0x1C87, -6181, 1 },
+			{ 0x1C88, 0x1C88, 35266, 1 }, { 0x1D79, 0x1D79, 35332, 1 }, { 0x1D7D, 0x1D7D, 3814, 1 }, { 0x1D8E, 0x1D8E, 35384, 1 },
+			{ 0x1E01, 0x1E95, -1, 2 }, { 0x1E9B, 0x1E9B, -59, 1 }, { 0x1EA1, 0x1EFF, -1, 2 }, { 0x1F00, 0x1F07, 8, 1 },
+			{ 0x1F10, 0x1F15, 8, 1 }, { 0x1F20, 0x1F27, 8, 1 }, { 0x1F30, 0x1F37, 8, 1 }, { 0x1F40, 0x1F45, 8, 1 },
+			{ 0x1F51, 0x1F57, 8, 2 }, { 0x1F60, 0x1F67, 8, 1 }, { 0x1F70, 0x1F71, 74, 1 }, { 0x1F72, 0x1F75, 86, 1 },
+			{ 0x1F76, 0x1F77, 100, 1 }, { 0x1F78, 0x1F79, 128, 1 }, { 0x1F7A, 0x1F7B, 112, 1 }, { 0x1F7C, 0x1F7D, 126, 1 },
+			{ 0x1F80, 0x1F87, 8, 1 }, { 0x1F90, 0x1F97, 8, 1 }, { 0x1FA0, 0x1FA7, 8, 1 }, { 0x1FB0, 0x1FB1, 8, 1 },
+			{ 0x1FB3, 0x1FB3, 9, 1 }, { 0x1FBE, 0x1FBE, -7205, 1 }, { 0x1FC3, 0x1FC3, 9, 1 }, { 0x1FD0, 0x1FD1, 8, 1 },
+			{ 0x1FE0, 0x1FE1, 8, 1 }, { 0x1FE5, 0x1FE5, 7, 1 }, { 0x1FF3, 0x1FF3, 9, 1 }, { 0x214E, 0x214E, -28, 1 },
+			{ 0x2170, 0x217F, -16, 1 }, { 0x2184, 0x2184, -1, 1 }, { 0x24D0, 0x24E9, -26, 1 }, { 0x2C30, 0x2C5F, -48, 1 },
+			{ 0x2C61, 0x2C61, -1, 1 }, { 0x2C65, 0x2C65, -10795, 1 }, { 0x2C66, 0x2C66, -10792, 1 }, { 0x2C68, 0x2C6C, -1, 2 },
+			{ 0x2C73, 0x2C73, -1, 1 }, { 0x2C76, 0x2C76, -1, 1 }, { 0x2C81, 0x2CE3, -1, 2 }, { 0x2CEC, 0x2CEE, -1, 2 },
+			{ 0x2CF3, 0x2CF3, -1, 1 }, { 0x2D00, 0x2D25, -7264, 1 }, { 0x2D27, 0x2D27, -7264, 1 }, { 0x2D2D, 0x2D2D, -7264, 1 },
+			{ 0xA641, 0xA66D, -1, 2 }, { 0xA681, 0xA69B, -1, 2 }, { 0xA723, 0xA72F, -1, 2 }, { 0xA733, 0xA76F, -1, 2 },
+			{ 0xA77A, 0xA77C, -1, 2 }, { 0xA77F, 0xA787, -1, 2 }, { 0xA78C, 0xA78C, -1, 1 }, { 0xA791, 0xA793, -1, 2 },
+			{ 0xA794, 0xA794, 48, 1 }, { 0xA797, 0xA7A9, -1, 2 }, { 0xA7B5, 0xA7C3, -1, 2 }, { 0xA7C8, 0xA7CA, -1, 2 },
+			{ 0xA7D1, 0xA7D1, -1, 1 }, { 0xA7D7, 0xA7D9, -1, 2 }, { 0xA7F6, 0xA7F6, -1, 1 }, { 0xAB53, 0xAB53, -928, 1 },
+			{ 0xAB70, 0xABBF, -38864, 1 }, { 0xFF41, 0xFF5A, -32, 1 }, { 0x10428, 0x1044F, -40, 1 }, { 0x104D8, 0x104FB, -40, 1 },
+			{ 0x10597, 0x105A1, -39, 1 }, { 0x105A3, 0x105B1, -39, 1 }, { 0x105B3, 0x105B9, -39, 1 }, { 0x105BB, 0x105BC, -39, 1 },
+			{ 0x10CC0, 0x10CF2, -64, 1 }, { 0x118C0, 0x118DF, -32, 1 }, { 0x16E60, 0x16E7F, -32, 1 }, { 0x1E922, 0x1E943, -34, 1 },
+		};
+		static const CaseMappingRun fold[] =
+		{
+			{ 0x0041, 0x005A, 32, 1 }, { 0x00B5, 0x00B5, 775, 1 }, { 0x00C0, 0x00D6, 32, 1 }, { 0x00D8, 0x00DE, 32, 1 },
+			{ 0x0100, 0x012E, 1, 2 }, { 0x0132, 0x0136, 1, 2 }, { 0x0139, 0x0147, 1, 2 }, { 0x014A, 0x0176, 1, 2 },
+			{ 0x0178, 0x0178, -121, 1 }, { 0x0179, 0x017D, 1, 2 }, { 0x017F, 0x017F, -268, 1 }, { 0x0181, 0x0181, 210, 1 },
+			{ 0x0182, 0x0184, 1, 2 }, { 0x0186, 0x0186, 206, 1 }, { 0x0187, 0x0187, 1, 1 }, { 0x0189, 0x018A, 205, 1 },
+			{ 0x018B, 0x018B, 1, 1 }, { 0x018E, 0x018E, 79, 1 }, { 0x018F, 0x018F, 202, 1 }, { 0x0190, 0x0190, 203, 1 },
+			{ 0x0191, 0x0191, 1, 1 }, { 0x0193, 0x0193, 205, 1 }, { 0x0194, 0x0194, 207, 1 }, { 0x0196, 0x0196, 211, 1 },
+			{ 0x0197, 0x0197, 209, 1 }, { 0x0198, 0x0198, 1, 1 }, { 0x019C, 0x019C, 211, 1 }, { 0x019D, 0x019D, 213, 1 },
+			{ 0x019F, 0x019F, 214, 1 }, { 0x01A0, 0x01A4, 1, 2 }, { 0x01A6, 0x01A6, 218, 1 }, { 0x01A7, 0x01A7, 1, 1 },
+			{ 0x01A9, 0x01A9, 218, 1 }, { 0x01AC, 0x01AC, 1, 1 }, { 0x01AE, 0x01AE, 218, 1 }, { 0x01AF, 0x01AF, 1, 1 },
+			{ 0x01B1, 0x01B2, 217, 1 }, { 0x01B3, 0x01B5, 1, 2 }, { 0x01B7, 0x01B7, 219, 1 }, { 0x01B8, 0x01B8, 1, 1 },
+			{ 0x01BC, 0x01BC, 1, 1 }, { 0x01C4, 0x01C4, 2, 1 }, { 0x01C5, 0x01C5, 1, 1 }, { 0x01C7, 0x01C7, 2, 1 },
+			{ 0x01C8, 0x01C8, 1, 1 }, { 0x01CA, 0x01CA, 2, 1 }, { 0x01CB, 0x01DB, 1, 2 }, { 0x01DE, 0x01EE, 1, 2 },
+			{ 0x01F1, 0x01F1, 2, 1 }, { 0x01F2, 0x01F4, 1, 2 }, { 0x01F6, 0x01F6, -97, 1 }, { 0x01F7, 0x01F7, -56, 1 },
+			{ 0x01F8, 0x021E, 1, 2 }, { 0x0220, 0x0220, -130, 1 }, { 0x0222, 0x0232, 1, 2 }, { 0x023A, 0x023A, 10795, 1 },
+			{ 0x023B, 0x023B, 1, 1 }, { 0x023D, 0x023D, -163, 1 }, { 0x023E, 0x023E, 10792, 1 }, { 0x0241, 0x0241, 1, 1 },
+			{ 0x0243, 0x0243, -195, 1 }, { 0x0244, 0x0244, 69, 1 }, { 0x0245, 0x0245, 71, 1 }, { 0x0246, 0x024E, 1, 2 },
+			{ 0x0345, 0x0345, 116, 1 }, { 0x0370, 0x0372, 1, 2 }, { 0x0376, 0x0376, 1, 1 }, { 0x037F, 0x037F, 116, 1 },
+			{ 0x0386, 0x0386, 38, 1 }, { 0x0388, 0x038A, 37, 1 }, { 0x038C, 0x038C, 64, 1 }, { 0x038E, 0x038F, 63, 1 },
+			{ 0x0391, 0x03A1, 32, 1 }, { 0x03A3, 0x03AB, 32, 1 }, { 0x03C2, 0x03C2, 1, 1 }, { 0x03CF, 0x03CF, 8, 1 },
+			{ 0x03D0, 0x03D0, -30, 1 }, { 0x03D1, 0x03D1, -25, 1 }, { 0x03D5, 0x03D5, -15, 1 }, { 0x03D6, 0x03D6, -22, 1 },
+			{ 0x03D8, 0x03EE, 1, 2 }, { 0x03F0, 0x03F0, -54, 1 }, { 0x03F1, 0x03F1, -48, 1 }, { 0x03F4, 0x03F4, -60, 1 },
+			{ 0x03F5, 0x03F5, -64, 1 }, { 0x03F7, 0x03F7, 1, 1 }, { 0x03F9, 0x03F9, -7, 1 }, { 0x03FA, 0x03FA, 1, 1 },
+			{ 0x03FD, 0x03FF, -130, 1 }, { 0x0400, 0x040F, 80, 1 }, { 0x0410, 0x042F, 32, 1 }, { 0x0460, 0x0480, 1, 2 },
+			{ 0x048A, 0x04BE, 1, 2 }, { 0x04C0, 0x04C0, 15, 1 }, { 0x04C1, 0x04CD, 1, 2 }, { 0x04D0, 0x052E, 1, 2 },
+			{ 0x0531, 0x0556, 48, 1 }, { 0x10A0, 0x10C5, 7264, 1 }, { 0x10C7, 0x10C7, 7264, 1 }, { 0x10CD, 0x10CD, 7264, 1 },
+			{ 0x13F8, 0x13FD, -8, 1 }, { 0x1C80, 0x1C80, -6222, 1 }, { 0x1C81, 0x1C81, -6221, 1 }, { 0x1C82, 0x1C82, -6212, 1 },
+			{ 0x1C83, 0x1C84, -6210, 1 }, { 0x1C85, 0x1C85, -6211, 1 }, { 0x1C86, 0x1C86, -6204, 1 }, { 0x1C87, 0x1C87, -6180, 1 },
+			{ 0x1C88, 0x1C88, 35267, 1 }, { 0x1C90, 0x1CBA, -3008, 1 }, { 0x1CBD, 0x1CBF, -3008, 1 }, { 0x1E00, 0x1E94, 1, 2 },
+			{ 0x1E9B, 0x1E9B, -58, 1 }, { 0x1E9E, 0x1E9E, -7615, 1 }, { 0x1EA0, 0x1EFE, 1, 2 }, { 0x1F08, 0x1F0F, -8, 1 },
+			{ 0x1F18, 0x1F1D, -8, 1 }, { 0x1F28, 0x1F2F, -8, 1 }, { 0x1F38, 0x1F3F, -8, 1 }, { 0x1F48, 0x1F4D, -8, 1 },
+			{ 0x1F59, 0x1F5F, -8, 2 }, { 0x1F68, 0x1F6F, -8, 1 }, { 0x1F88, 0x1F8F, -8, 1 }, { 0x1F98, 0x1F9F, -8, 1 },
+			{ 0x1FA8, 0x1FAF, -8, 1 }, { 0x1FB8, 0x1FB9, -8, 1 }, { 0x1FBA, 0x1FBB, -74, 1 }, { 0x1FBC, 0x1FBC, -9, 1 },
+			{ 0x1FBE, 0x1FBE, -7173, 1 }, { 0x1FC8, 0x1FCB, -86, 1 }, { 0x1FCC, 0x1FCC, -9, 1 }, { 0x1FD8, 0x1FD9, -8, 1 },
+			{ 0x1FDA, 0x1FDB, -100, 1 }, { 0x1FE8, 0x1FE9, -8, 1 }, { 0x1FEA, 0x1FEB, -112, 1 }, { 0x1FEC, 0x1FEC, -7, 1 },
+			{ 0x1FF8, 0x1FF9, -128, 1 }, { 0x1FFA, 0x1FFB, -126, 1 }, { 0x1FFC, 0x1FFC, -9, 1 }, { 0x2126, 0x2126, -7517, 1 },
+			{ 0x212A, 0x212A, -8383, 1 }, { 0x212B, 0x212B, -8262, 1 }, { 0x2132, 0x2132, 28, 1 }, { 0x2160, 0x216F, 16, 1 },
+			{ 0x2183, 0x2183, 1, 1 }, { 0x24B6, 0x24CF, 26, 1 }, { 0x2C00, 0x2C2F, 48, 1 }, { 0x2C60, 0x2C60, 1, 1 },
+			{ 0x2C62, 0x2C62, -10743, 1 }, { 0x2C63, 0x2C63, -3814, 1 }, { 0x2C64, 0x2C64, -10727, 1 }, { 0x2C67, 0x2C6B, 1, 2 },
+			{ 0x2C6D, 0x2C6D, -10780, 1 }, { 0x2C6E, 0x2C6E, -10749, 1 }, { 0x2C6F, 0x2C6F, -10783, 1 }, { 0x2C70, 0x2C70, -10782, 1 },
+			{ 0x2C72, 0x2C72, 1, 1 }, { 0x2C75, 0x2C75, 1, 1 }, { 0x2C7E, 0x2C7F, -10815, 1 }, { 0x2C80, 0x2CE2, 1, 2 },
+			{ 0x2CEB, 0x2CED, 1, 2 }, { 0x2CF2, 0x2CF2, 1, 1 }, { 0xA640, 0xA66C, 1, 2 }, { 0xA680, 0xA69A, 1, 2 },
+			{ 0xA722, 0xA72E, 1, 2 }, { 0xA732, 0xA76E, 1, 2 }, { 0xA779, 0xA77B, 1, 2 }, { 0xA77D, 0xA77D, -35332, 1 },
+			{ 0xA77E, 0xA786, 1, 2 }, { 0xA78B, 0xA78B, 1, 1 }, { 0xA78D, 0xA78D, -42280, 1 }, { 0xA790, 0xA792, 1, 2 },
+			{ 0xA796, 0xA7A8, 1, 2 }, { 0xA7AA, 0xA7AA, -42308, 1 }, { 0xA7AB, 0xA7AB, -42319, 1 }, { 0xA7AC, 0xA7AC, -42315, 1 },
+			{ 0xA7AD, 0xA7AD, -42305, 1 }, { 0xA7AE, 0xA7AE, -42308, 1 }, { 0xA7B0, 0xA7B0, -42258, 1 }, { 0xA7B1, 0xA7B1, -42282, 1 },
+			{ 0xA7B2, 0xA7B2, -42261, 1 }, { 0xA7B3, 0xA7B3, 928, 1 }, { 0xA7B4, 0xA7C2, 1, 2 }, { 0xA7C4, 0xA7C4, -48, 1 },
+			{ 0xA7C5, 0xA7C5, -42307, 1 }, { 0xA7C6, 0xA7C6, -35384, 1 }, { 0xA7C7, 0xA7C9, 1, 2 }, { 0xA7D0, 0xA7D0, 1, 1 },
+			{ 0xA7D6, 0xA7D8, 1, 2 }, { 0xA7F5, 0xA7F5, 1, 1 }, { 0xAB70, 0xABBF, -38864, 1 }, { 0xFF21, 0xFF3A, 32, 1 },
+			{ 0x10400, 0x10427, 40, 1 }, { 0x104B0, 0x104D3, 40, 1 }, { 0x10570, 0x1057A, 39, 1 }, { 0x1057C, 0x1058A, 39, 1 },
+			{ 0x1058C, 0x10592, 39, 1 }, { 0x10594, 0x10595, 39, 1 }, { 0x10C80, 0x10CB2, 64, 1 }, { 0x118A0, 0x118BF, 32, 1 },
+			{ 0x16E40, 0x16E5F, 32, 1 }, { 0x1E900, 0x1E921, 34, 1 },
+		};
+		switch(mapping)
+		{
+		case CaseMappingUpper:
+			count = sizeof(upper) / sizeof(upper[0]);
+			return upper;
+		case CaseMappingFold:
+			count = sizeof(fold) / sizeof(fold[0]);
+			return fold;
+		case CaseMappingLower:
+			break;
+		}
+		count = sizeof(lower) / sizeof(lower[0]);
+		return lower;
+	}
 
+	inline unsigned long InternalAsciiCaseMap(unsigned long c, CaseMapping mapping)
+	{
+		if(mapping == CaseMappingUpper)
+			return c - 'a' <= 'z' - 'a' ? c - 32 : c;
+		return c - 'A' <= 'Z' - 'A' ? c + 32 : c;
+	}
 
-	// CharToLower. --------------------------------------------------------------------------------------
-	// TODO: um, 
-	//inline wchar_t CharToUpper(wchar_t c)
-	//{
-	//	return (wchar_t)CharUpperW((PWSTR)c);
-	//}
+	inline unsigned long InternalCodePointCaseMap(unsigned long c, CaseMapping mapping)
+	{
+		if(c < 0x80)
+			return InternalAsciiCaseMap(c, mapping);
+		size_t count;
+		const CaseMappingRun* runs = InternalCaseMappingRuns(mapping, count);
+		// find the last run starting at or before c
+		size_t lo = 0;
+		size_t hi = count;
+		while(lo < hi)
+		{
+			size_t mid = (lo + hi) / 2;
+			if(runs[mid].first <= c)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if(lo == 0)
+			return c;
+		const CaseMappingRun& run = runs[lo - 1];
+		if(c > run.last || ((c - run.first) % run.step) != 0)
+			return c;
+		return (unsigned long)((long)c + run.delta);
+	}
 
-	//inline char CharToUpper(char c)
-	//{
-	//	return (char)CharUpperA((PSTR)c);
-	//}
+	struct InternalAnsiCaseTables
+	{
+		unsigned char map[3][256];// [CaseMapping]
 
-	//template<typename Char>
-	//inline Char CharToUpper(Char c)
-	//{
-	//	return (Char)CharToUpper((wchar_t)c);// TODO: make this work for 32-bit unicode scalars
-	//}
+		InternalAnsiCaseTables()
+		{
+			for(int i = 0; i < 256; ++ i)
+			{
+				map[CaseMappingLower][i] = (unsigned char)InternalAsciiCaseMap(i, CaseMappingLower);
+				map[CaseMappingUpper][i] = (unsigned char)InternalAsciiCaseMap(i, CaseMappingUpper);
+			}
+#ifdef WIN32
+			if(LIBCC_CHAR_CODEPAGE != CP_UTF8)
+			{
+				CharLowerBuffA(reinterpret_cast<char*>(map[CaseMappingLower] + 128), 128);
+				CharUpperBuffA(reinterpret_cast<char*>(map[CaseMappingUpper] + 128), 128);
+			}
+#endif
+			for(int i = 0; i < 256; ++ i)
+			{
+				map[CaseMappingFold][i] = map[CaseMappingLower][map[CaseMappingUpper][i]];
+			}
+		}
+	};
+
+	inline const InternalAnsiCaseTables& InternalGetAnsiCaseTables()
+	{
+		static const InternalAnsiCaseTables tables;
+		return tables;
+	}
+
+	inline char InternalCharCaseMap(char c, CaseMapping mapping)
+	{
+		if((unsigned char)c < 0x80)
+			return (char)InternalAsciiCaseMap((unsigned char)c, mapping);
+		return (char)InternalGetAnsiCaseTables().map[mapping][(unsigned char)c];
+	}
+
+	template<typename Char>
+	inline Char InternalCharCaseMap(Char c, CaseMapping mapping)
+	{
+		return (Char)InternalCodePointCaseMap((unsigned long)c, mapping);
+	}
+
+	template<typename Char>
+	inline Char CharToLower(Char c)
+	{
+		return InternalCharCaseMap(c, CaseMappingLower);
+	}
+
+	template<typename Char>
+	inline Char CharToUpper(Char c)
+	{
+		return InternalCharCaseMap(c, CaseMappingUpper);
+	}
+
+	template<typename Char>
+	inline Char CharFoldCase(Char c)
+	{
+		return InternalCharCaseMap(c, CaseMappingFold);
+	}
 
   // Naive string upper / lower functions --------------------------------------------------------------------------------------
   template<typename Char>
@@ -156,7 +532,7 @@ namespace LibCC
 		// when there's no other way to convert from 1 string type to another, you can try this basic element-by-element copy
 		out.clear();
 		out.reserve(in.size());
-		for(std::basic_string<InChar>::const_iterator it = in.begin(); it != in.end(); ++ it)
+		for(typename std::basic_string<InChar>::const_iterator it = in.begin(); it != in.end(); ++ it)
 		{
 			out.push_back(CharConvert<OutChar>(*it));
 		}
@@ -185,7 +561,7 @@ namespace LibCC
   template<typename InChar, typename OutChar>
 	inline void XLastDitchStringCopy(const std::basic_string<InChar>& in, OutChar* out)// out must already be allocated
 	{
-		for(std::basic_string<InChar>::const_iterator it = in.begin(); it != in.end(); ++ it)
+		for(typename std::basic_string<InChar>::const_iterator it = in.begin(); it != in.end(); ++ it)
 		{
 			*out = *it;
 			out ++;
@@ -196,7 +572,7 @@ namespace LibCC
 
 	// StringLength. --------------------------------------------------------------------------------------
 	template<typename Char>
-	inline size_t StringLength(const Char* sz)// this only works for fixed-size char strings. not ANSI or MBCS or Unicode surrogates and shit.
+	inline size_t StringLength(const Char* sz)// this counts code units, not characters. see CodePointCount() for that.
 	{
 		size_t ret = 0;
 		while(*sz ++)
@@ -206,6 +582,17 @@ namespace LibCC
 		return ret;
 	}
 
+	// the CRT's are vectorized
+	inline size_t StringLength(const char* sz)
+	{
+		return strlen(sz);
+	}
+
+	inline size_t StringLength(const wchar_t* sz)
+	{
+		return wcslen(sz);
+	}
+
 	template<typename Char>
 	inline size_t StringLength(const std::basic_string<Char>& sz)
 	{
@@ -213,1216 +600,4342 @@ namespace LibCC
 	}
 
 
-	// StringConvert. this also acts as a StringCopy. --------------------------------------------------------------------------------------
-#ifdef WIN32
+	// StringView. --------------------------------------------------------------------------------------
+	// a (pointer, length) reference into someone else's string. it doesn't own anything, so the source has to outlive it.
+	template<typename Char>
+	struct StringView
+	{
+		typedef const Char* const_iterator;
+		typedef const_iterator iterator;
 
-	// TODO: http://www.unicode.org/Public/PROGRAMS/CVTUTF/ConvertUTF.c
-	//inline HRESULT UTF16ToUTF32(const wchar_t*, size_t, Blob<__int32>&)
-	//{
-	//	return E_NOTIMPL;
-	//}
+		StringView() :
+			p(0),
+			len(0)
+		{
+		}
 
-	//inline HRESULT UTF32ToUTF16(const wchar_t*, size_t, Blob<__int32>&)
-	//{
-	//	return E_NOTIMPL;
-	//}
+		StringView(const Char* p_, size_t len_) :
+			p(p_),
+			len(len_)
+		{
+		}
 
-	// http://www.themssforum.com/MFC/WideCharToMultiByte-works/
-	// converts from UTF-16 (true UTF-16 according to MS) to ANSI
-	inline HRESULT ToANSI(const wchar_t* in, size_t inLength, std::vector<BYTE>& out, UINT codepage = CP_ACP)
-	{
-		DWORD flags;
-	 
-		switch (codepage)
-		{
-		case 50220: case 50221: case 50222: case 50225:
-		case 50227: case 50229: case 52936: case 54936:
-		case 57002: case 57003: case 57004: case 57005:
-		case 57006: case 57007: case 57008: case 57009:
-		case 57010: case 57011: case 65000: case 42:
-			flags = 0;
-			break;
-		case 65001:
-			flags = 0; // or WC_ERR_INVALID_CHARS on winver >= 0x0600
-			break;
-		default:
-			{
-				flags = WC_NO_BEST_FIT_CHARS | WC_COMPOSITECHECK;
-				break;
-			}
+		StringView(const std::basic_string<Char>& s) :
+			p(s.c_str()),
+			len(s.size())
+		{
 		}
 
-		CPINFO cpinfo;
-		if(0 == GetCPInfo(codepage, &cpinfo))
+		const Char* data() const { return p; }
+		size_t size() const { return len; }
+		bool empty() const { return len == 0; }
+		const_iterator begin() const { return p; }
+		const_iterator end() const { return p + len; }
+		Char operator [](size_t i) const { return p[i]; }
+
+		std::basic_string<Char> str() const
 		{
-			return E_FAIL;
+			return len ? std::basic_string<Char>(p, len) : std::basic_string<Char>();
 		}
-	 
-		// get the length first
-		BOOL usedDefaultChar = FALSE;
-		int length = WideCharToMultiByte(codepage, flags, in, (int)inLength, NULL, 0,
-			(flags & WC_NO_BEST_FIT_CHARS) ? (const CHAR*)cpinfo.DefaultChar : 0,
-			(flags & WC_NO_BEST_FIT_CHARS) ? &usedDefaultChar : 0);
 
-		if (length == 0)
-			return E_FAIL;
+		bool operator ==(const StringView<Char>& rhs) const
+		{
+			return len == rhs.len && (len == 0 || memcmp(p, rhs.p, len * sizeof(Char)) == 0);
+		}
 
-		out.resize((size_t)length);// it is important to make sure the return Blob has the correct size here. so do not add +1 to this.
+		bool operator !=(const StringView<Char>& rhs) const
+		{
+			return !(*this == rhs);
+		}
 
-		WideCharToMultiByte(codepage, flags, in, (int)inLength, (LPSTR)out.data(), length,
-			(flags & WC_NO_BEST_FIT_CHARS) ? (const CHAR*)cpinfo.DefaultChar : 0,
-			(flags & WC_NO_BEST_FIT_CHARS) ? &usedDefaultChar : 0);
+		const Char* p;
+		size_t len;
+	};
 
-		return S_OK;
+	template<typename Char>
+	inline size_t StringLength(const StringView<Char>& sz)
+	{
+		return sz.size();
 	}
 
-	// from ANSI to Unicode (real UTF-16)
-	inline HRESULT ToUTF16(const BYTE* multistr, size_t sourceLength, std::wstring& widestr, UINT codepage = CP_ACP)
-	{
-		int length = MultiByteToWideChar(codepage, 0, (PCSTR)multistr, (int)sourceLength, NULL, 0);
-		if (length == 0)
-			return E_FAIL;
-		std::vector<WCHAR> buf;
-    buf.resize(length);
-		MultiByteToWideChar(codepage, 0, (PCSTR)multistr, (int)sourceLength, buf.data(), (int)length);
-		widestr.assign(buf.data(), buf.size());
- 
-		return S_OK;
-	}
 
-	/*
-		supported input / output types:
-		std::basic_string<xchar>
-		xchar*
-		LibCC::Blob<xchar>  [ limited ]
+	// UTF-8 <-> UTF-16 transcoding. --------------------------------------------------------------------------------------
+	// these don't go through the Win32 API so they are portable, and they have an ASCII fast path because most of
+	// what we convert (log lines, paths, identifiers) is ASCII. invalid sequences are replaced with U+FFFD, just like
+	// MultiByteToWideChar / WideCharToMultiByte do.
+	// pass out = 0 to just measure; the return value is always the number of output code units.
+	// where wchar_t is 32-bit, the "UTF-16" side is actually UTF-32.
+	inline size_t UTF8ToUTF16(const char* in, size_t inLength, wchar_t* out)
+	{
+		const unsigned char* s = reinterpret_cast<const unsigned char*>(in);
+		size_t i = 0;
+		size_t o = 0;
+		while(i < inLength)
+		{
+#if LIBCC_SSE2 == 1
+			// 16 ASCII chars at a time
+			while(i + 16 <= inLength)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+				if(_mm_movemask_epi8(v) != 0)
+					break;
+				if(out)
+				{
+					if(sizeof(wchar_t) == 2)
+					{
+						__m128i zero = _mm_setzero_si128();
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), _mm_unpacklo_epi8(v, zero));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(out + o + 8), _mm_unpackhi_epi8(v, zero));
+					}
+					else
+					{
+						for(size_t n = 0; n < 16; ++ n)
+							out[o + n] = (wchar_t)s[i + n];
+					}
+				}
+				i += 16;
+				o += 16;
+			}
+			if(i >= inLength)
+				break;
+#endif
+			unsigned long c = s[i];
+			if(c < 0x80)
+			{
+				if(out) out[o] = (wchar_t)c;
+				++ o;
+				++ i;
+				continue;
+			}
 
-		For each in/out type scenario
-		a) basic_string -> basic_string
-		a) xchar* -> basic_string
-		
-		here are the conversion cases to write functions for. it ends up being 5 functions to handle all cases:
+			// multibyte sequence
+			size_t extra;
+			unsigned long minimum;
+			if((c & 0xe0) == 0xc0) { extra = 1; minimum = 0x80; c &= 0x1f; }
+			else if((c & 0xf0) == 0xe0) { extra = 2; minimum = 0x800; c &= 0x0f; }
+			else if((c & 0xf8) == 0xf0) { extra = 3; minimum = 0x10000; c &= 0x07; }
+			else { extra = 0; minimum = 1; c = 0; }// stray continuation byte or invalid lead byte
 
-		#1: ansi cp1 str -> ansi cp1 str    (no conversion)
-		#2: utf16 str -> utf16 str          (no conversion)
-		#3: unknown str -> unknown str      (no conversion)
+			size_t n = 1;
+			for(; n <= extra; ++ n)
+			{
+				if(i + n >= inLength || (s[i + n] & 0xc0) != 0x80)
+					break;
+				c = (c << 6) | (s[i + n] & 0x3f);
+			}
 
-		#4: ansi str -> utf16 str           (known conversion)
-		#5: utf16 str -> ansi str           (known conversion)
-		#6: ansi str -> other ansi str      (known conversion)
+			if(n != extra + 1 || c < minimum || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff))
+			{
+				// invalid / truncated / overlong. replace the maximal invalid subpart with U+FFFD
+				if(out) out[o] = (wchar_t)0xfffd;
+				++ o;
+				i += (n > 1) ? n : 1;
+				continue;
+			}
 
-		#7: ansi str -> unknown str         (unknown conversion)
-		#8: utf16 str -> unknown str        (unknown conversion)
-		#9: unknown str -> utf16 str        (unknown conversion)
-		#10: unknown str -> ansi str        (unknown conversion)
+			i += n;
+			if(c >= 0x10000 && sizeof(wchar_t) == 2)
+			{
+				c -= 0x10000;
+				if(out)
+				{
+					out[o] = (wchar_t)(0xd800 + (c >> 10));
+					out[o + 1] = (wchar_t)(0xdc00 + (c & 0x3ff));
+				}
+				o += 2;
+			}
+			else
+			{
+				if(out) out[o] = (wchar_t)c;
+				++ o;
+			}
+		}
+		return o;
+	}
 
-		TODO:
-		#12: utf32 str -> utf32 str
-		#13: utf32 str -> utf16 str
-		#14: utf16 str -> utf32 str
-		#15: ansi str -> utf32 str
-		#16: utf32 str -> ansi str
-		#17: utf32 str -> unknown str
-		#18: unknown str -> utf32 str
+	inline size_t UTF16ToUTF8(const wchar_t* in, size_t inLength, char* out)
+	{
+		size_t i = 0;
+		size_t o = 0;
+		while(i < inLength)
+		{
+#if LIBCC_SSE2 == 1
+			// 8 ASCII chars at a time
+			if(sizeof(wchar_t) == 2)
+			{
+				const __m128i nonAscii = _mm_set1_epi16((short)0xff80);
+				const __m128i zero = _mm_setzero_si128();
+				while(i + 8 <= inLength)
+				{
+					__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+					if(_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, nonAscii), zero)) != 0xffff)
+						break;
+					if(out)
+					{
+						_mm_storel_epi64(reinterpret_cast<__m128i*>(out + o), _mm_packus_epi16(v, v));
+					}
+					i += 8;
+					o += 8;
+				}
+				if(i >= inLength)
+					break;
+			}
+#endif
+			unsigned long c = (unsigned long)in[i];
+			++ i;
+			if(c < 0x80)
+			{
+				if(out) out[o] = (char)c;
+				++ o;
+				continue;
+			}
+			if(sizeof(wchar_t) == 2 && c >= 0xd800 && c <= 0xdfff)
+			{
+				if(c <= 0xdbff && i < inLength && (unsigned long)in[i] >= 0xdc00 && (unsigned long)in[i] <= 0xdfff)
+				{
+					c = 0x10000 + ((c - 0xd800) << 10) + ((unsigned long)in[i] - 0xdc00);
+					++ i;
+				}
+				else
+				{
+					c = 0xfffd;// unpaired surrogate
+				}
+			}
+			else if(c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff))
+			{
+				c = 0xfffd;
+			}
 
-		NOTE:
-			- many functions take codepage arguments even though they will be ignored. this is to unify how they are called; more generic.
-			  for an ignored codepage, just use 0.
-	*/
+			if(c < 0x800)
+			{
+				if(out)
+				{
+					out[o] = (char)(0xc0 | (c >> 6));
+					out[o + 1] = (char)(0x80 | (c & 0x3f));
+				}
+				o += 2;
+			}
+			else if(c < 0x10000)
+			{
+				if(out)
+				{
+					out[o] = (char)(0xe0 | (c >> 12));
+					out[o + 1] = (char)(0x80 | ((c >> 6) & 0x3f));
+					out[o + 2] = (char)(0x80 | (c & 0x3f));
+				}
+				o += 3;
+			}
+			else
+			{
+				if(out)
+				{
+					out[o] = (char)(0xf0 | (c >> 18));
+					out[o + 1] = (char)(0x80 | ((c >> 12) & 0x3f));
+					out[o + 2] = (char)(0x80 | ((c >> 6) & 0x3f));
+					out[o + 3] = (char)(0x80 | (c & 0x3f));
+				}
+				o += 4;
+			}
+		}
+		return o;
+	}
 
-	// basic_string -> basic_string --------------------------------------------------------------------------------------
-	inline HRESULT StringConvert(const std::string& in, std::wstring& out, UINT fromcodepage = CP_ACP, UINT = CP_ACP)
+	// same thing, into a string. measures first so there is exactly 1 allocation.
+	inline void UTF8ToUTF16(const char* in, size_t inLength, std::wstring& out)
 	{
-		return ToUTF16((const BYTE*)in.c_str(), in.length(), out, fromcodepage);
+		out.resize(UTF8ToUTF16(in, inLength, (wchar_t*)0));
+		if(!out.empty())
+			UTF8ToUTF16(in, inLength, &out[0]);
 	}
-	// case #5:
-	inline HRESULT StringConvert(const std::wstring& in, std::string& out, UINT = CP_ACP, UINT tocodepage = CP_ACP)
+
+	inline void UTF16ToUTF8(const wchar_t* in, size_t inLength, std::string& out)
 	{
-		std::vector<BYTE> b;
-		HRESULT hr = ToANSI(in.c_str(), in.length(), b, tocodepage);
-		if(FAILED(hr)) return hr;
-		out.assign((const char*)b.data(), b.size());
-		return hr;
-	}
-	// case #1, #2, #3, #6:
-	inline HRESULT StringConvert(const std::string& in, std::string& out, UINT fromCodepage = CP_ACP, UINT toCodepage = CP_ACP)
-	{
-		if(fromCodepage == toCodepage)
-		{
-			out = in;
-			return S_OK;
-		}
-		std::wstring intermediate;
-		HRESULT hr = StringConvert(in, intermediate, fromCodepage);
-		if(FAILED(hr)) return hr;
-		return StringConvert(intermediate, out, toCodepage);
+		out.resize(UTF16ToUTF8(in, inLength, (char*)0));
+		if(!out.empty())
+			UTF16ToUTF8(in, inLength, &out[0]);
 	}
-	// case #7, #8, #9, #10:
-	template<typename CharIn, typename CharOut>
-	inline HRESULT StringConvert(const std::basic_string<CharIn>& in, std::basic_string<CharOut>& out, UINT fromcodepage = CP_ACP, UINT tocodepage = CP_ACP)
+
+
+	// code point counting & truncation. --------------------------------------------------------------------------------------
+	// truncation never splits a UTF-8 sequence or a surrogate pair. both only need to look at one code unit at a time
+	// (is it a UTF-8 continuation byte / a low surrogate?) so they're done 16 bytes at a time.
+	inline unsigned int PopCount16(unsigned int x)
 	{
-		XLastDitchStringCopy(in, out);
-		return S_OK;
+		x = x - ((x >> 1) & 0x5555);
+		x = (x & 0x3333) + ((x >> 2) & 0x3333);
+		x = (x + (x >> 4)) & 0x0f0f;
+		return (x + (x >> 8)) & 0x1f;
 	}
 
-	// xchar* -> basic_string --------------------------------------------------------------------------------------
-	inline HRESULT StringConvert(const char* in, std::wstring& out, UINT fromcodepage = CP_ACP, UINT = CP_ACP)
+#if LIBCC_SSE2 == 1
+	// bit per byte which starts a code point (not 10xxxxxx)
+	inline unsigned int Utf8LeadMask(const char* s)
 	{
-		return ToUTF16((const BYTE*)in, StringLength(in), out, fromcodepage);
+		const __m128i lastContinuation = _mm_set1_epi8((char)0xbf);// as signed chars, continuation bytes are all <= 0xbf
+		return (unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s)), lastContinuation));
 	}
-	// case #5:
-	inline HRESULT StringConvert(const wchar_t* in, std::string& out, UINT = CP_ACP, UINT tocodepage = CP_ACP)
+
+	// 2 bits per 16-bit unit which is a low surrogate
+	inline unsigned int Utf16TrailMask(const wchar_t* s)
 	{
-		std::vector<BYTE> b;
-		HRESULT hr = ToANSI(in, StringLength(in), b, tocodepage);
-		if(FAILED(hr)) return hr;
-		out.assign((const char*)b.data(), b.size());
-		return hr;
+		__m128i v = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s)), _mm_set1_epi16((short)0xfc00));
+		return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi16(v, _mm_set1_epi16((short)0xdc00)));
 	}
-	// case #1, #2, #3, #6:
-	inline HRESULT StringConvert(const char* in, std::string& out, UINT fromCodepage = CP_ACP, UINT toCodepage = CP_ACP)
+#endif
+
+	inline size_t Utf8CodePointCount(const char* s, size_t len)
 	{
-		if(fromCodepage == toCodepage)
+		size_t i = 0;
+		size_t ret = 0;
+#if LIBCC_SSE2 == 1
+		for(; i + 16 <= len; i += 16)
 		{
-			out = in;
-			return S_OK;
+			ret += PopCount16(Utf8LeadMask(s + i));
 		}
-		std::wstring intermediate;
-		HRESULT hr = StringConvert(in, intermediate, fromCodepage);
-		if(FAILED(hr)) return hr;
-		return StringConvert(intermediate, out, toCodepage);
-	}
-	// case #7, #8, #9, #10:
-	template<typename CharIn, typename CharOut>
-	inline HRESULT StringConvert(const CharIn* in, std::basic_string<CharOut>& out, UINT fromcodepage = CP_ACP, UINT tocodepage = CP_ACP)
-	{
-		XLastDitchStringCopy(in, out);
-		return S_OK;
+#endif
+		for(; i < len; ++ i)
+		{
+			if(((unsigned char)s[i] & 0xc0) != 0x80)
+				++ ret;
+		}
+		return ret;
 	}
 
-
-	// ToUTF16. --------------------------------------------------------------------------------------
-	template<typename Char>
-	inline std::wstring ToUTF16(const Char* sz, UINT fromcodepage = CP_ACP)
+	inline size_t Utf16CodePointCount(const wchar_t* s, size_t len)
 	{
-		std::wstring ret;
-		StringConvert(sz, ret, fromcodepage);
+		if(sizeof(wchar_t) != 2)
+			return len;
+		size_t i = 0;
+		size_t ret = 0;
+#if LIBCC_SSE2 == 1
+		for(; i + 8 <= len; i += 8)
+		{
+			ret += 8 - (PopCount16(Utf16TrailMask(s + i)) >> 1);
+		}
+#endif
+		for(; i < len; ++ i)
+		{
+			if((s[i] & 0xfc00) != 0xdc00)
+				++ ret;
+		}
 		return ret;
 	}
-	template<typename Char>
-	inline std::wstring ToUTF16(const std::basic_string<Char>& s, UINT fromcodepage = CP_ACP)
+
+	// returns the number of bytes making up the first maxCodePoints code points of s.
+	inline size_t Utf8Truncate(const char* s, size_t len, size_t maxCodePoints)
 	{
-		std::wstring ret;
-		StringConvert(s, ret, fromcodepage);
-		return ret;
+		size_t i = 0;
+		size_t count = 0;
+#if LIBCC_SSE2 == 1
+		// skip whole blocks while the limit isn't reached
+		for(; i + 16 <= len; i += 16)
+		{
+			size_t n = PopCount16(Utf8LeadMask(s + i));
+			if(count + n > maxCodePoints)
+				break;
+			count += n;
+		}
+#endif
+		// the cut is in this block (or the tail); find the lead byte of code point #maxCodePoints + 1
+		for(; i < len; ++ i)
+		{
+			if(((unsigned char)s[i] & 0xc0) != 0x80)
+			{
+				if(count == maxCodePoints)
+					return i;
+				++ count;
+			}
+		}
+		return len;
 	}
-	
 
-	// ToANSI. --------------------------------------------------------------------------------------
-	template<typename Char>
-	inline std::string ToANSI(const Char* sz, UINT fromcodepage = CP_ACP, UINT tocodepage = CP_ACP)
+	// returns the number of code units making up the first maxCodePoints code points of s.
+	inline size_t Utf16Truncate(const wchar_t* s, size_t len, size_t maxCodePoints)
 	{
-		std::string ret;
-		StringConvert(sz, ret, fromcodepage, tocodepage);
-		return ret;
+		if(sizeof(wchar_t) != 2)
+			return len < maxCodePoints ? len : maxCodePoints;
+		size_t i = 0;
+		size_t count = 0;
+#if LIBCC_SSE2 == 1
+		for(; i + 8 <= len; i += 8)
+		{
+			size_t n = 8 - (PopCount16(Utf16TrailMask(s + i)) >> 1);
+			if(count + n > maxCodePoints)
+				break;
+			count += n;
+		}
+#endif
+		for(; i < len; ++ i)
+		{
+			if((s[i] & 0xfc00) != 0xdc00)
+			{
+				if(count == maxCodePoints)
+					return i;
+				++ count;
+			}
+		}
+		return len;
 	}
-	template<typename Char>
-	inline std::string ToANSI(const std::basic_string<Char>& s, UINT fromcodepage = CP_ACP, UINT tocodepage = CP_ACP)
+
+	// the native-char versions; what FormatX uses for max-length arguments.
+	// char is only known to be UTF-8 under LIBCC_UTF8; otherwise it's ANSI and a byte is a char.
+	inline size_t CodePointCount(const char* s, size_t len)
 	{
-		std::string ret;
-		StringConvert(s, ret, fromcodepage, tocodepage);
-		return ret;
+#if LIBCC_UTF8 == 1
+		return Utf8CodePointCount(s, len);
+#else
+		return len;
+#endif
 	}
 
-
-	// ToUTF8. --------------------------------------------------------------------------------------
-	template<typename Char>
-	inline std::string ToUTF8(const Char* sz, UINT fromcodepage = CP_ACP)
+	inline size_t CodePointCount(const wchar_t* s, size_t len)
 	{
-		return ToANSI(sz, fromcodepage, CP_UTF8);
+		return Utf16CodePointCount(s, len);
 	}
+
 	template<typename Char>
-	inline std::string ToUTF8(const std::basic_string<Char>& s, UINT fromcodepage = CP_ACP)
+	inline size_t CodePointCount(const Char*, size_t len)
 	{
-		return ToANSI(s, fromcodepage, CP_UTF8);
+		return len;
 	}
 
-
-	// --------------------------------------------------------------------------------------------------------------------
-	// DUPLICATES OF ALL THE StringConvert APIs, but returning the string instead of the 2nd arg, throwing away the HRESULT 
-	// basic_string -> basic_string --------------------------------------------------------------------------------------
-	// case #7, #8, #9, #10:
-	template<typename CharOut, typename CharIn>
-	inline std::basic_string<CharOut> StringConvert(const std::basic_string<CharIn>& in, UINT fromcodepage, UINT tocodepage)
-	{
-		std::basic_string<CharOut> ret;
-		XLastDitchStringCopy(in, ret);
-		return ret;
-	}
-	template<typename CharOut, typename CharIn>
-	inline std::basic_string<CharOut> StringConvert(const std::basic_string<CharIn>& in, UINT fromcodepage)
-	{
-		return StringConvert<CharOut, CharIn>(in, fromcodepage, CP_ACP);
-	}
-	template<typename CharOut, typename CharIn>
-	inline std::basic_string<CharOut> StringConvert(const std::basic_string<CharIn>& in)
-	{
-		return StringConvert<CharOut, CharIn>(in, CP_ACP, CP_ACP);
-	}
-	// case #4:
-	// note: error C2765: 'LibCC::StringConvertX' : an explicit specialization of a function template cannot have any default arguments
-	template<>
-	inline std::wstring StringConvert<wchar_t, char>(const std::string& in, UINT fromcodepage, UINT)
-	{
-		return ToUTF16(in, fromcodepage);
-	}
-	template<>
-	inline std::wstring StringConvert<wchar_t, char>(const std::string& in, UINT fromcodepage)
-	{
-		return ToUTF16(in, fromcodepage);
-	}
-	template<>
-	inline std::wstring StringConvert<wchar_t, char>(const std::string& in)
-	{
-		return ToUTF16(in);
-	}
-	template<>
-	inline std::string StringConvert<char, wchar_t>(const std::wstring& in, UINT fromcodepage, UINT tocodepage)
-	{
-		return ToANSI(in, fromcodepage, tocodepage);
-	}
-	template<>
-	inline std::string StringConvert<char, wchar_t>(const std::wstring& in, UINT fromcodepage)
-	{
-		return ToANSI(in, fromcodepage);
-	}
-	template<>
-	inline std::string StringConvert<char, wchar_t>(const std::wstring& in)
-	{
-		return ToANSI(in);
-	}
-	// case #1, #2, #3, #6:
-	template<>
-	inline std::string StringConvert<char, char>(const std::string& in, UINT fromcodepage, UINT tocodepage)
+	inline size_t CodePointTruncate(const char* s, size_t len, size_t maxCodePoints)
 	{
-		return ToANSI(in, fromcodepage, tocodepage);
+#if LIBCC_UTF8 == 1
+		return Utf8Truncate(s, len, maxCodePoints);
+#else
+		return len < maxCodePoints ? len : maxCodePoints;
+#endif
 	}
-	template<>
-	inline std::string StringConvert<char, char>(const std::string& in, UINT fromcodepage)
+
+	inline size_t CodePointTruncate(const wchar_t* s, size_t len, size_t maxCodePoints)
 	{
-		return ToANSI(in, fromcodepage);
+		return Utf16Truncate(s, len, maxCodePoints);
 	}
-	template<>
-	inline std::string StringConvert<char, char>(const std::string& in)
+
+	template<typename Char>
+	inline size_t CodePointTruncate(const Char*, size_t len, size_t maxCodePoints)
 	{
-		return ToANSI(in);
+		return len < maxCodePoints ? len : maxCodePoints;
 	}
 
 
-	// xchar* -> basic_string --------------------------------------------------------------------------------------
-	// case #7, #8, #9, #10:
-	template<typename CharOut, typename CharIn>
-	inline std::basic_string<CharOut> StringConvert(const CharIn* in, UINT fromcodepage, UINT tocodepage)
+	// bit scanning. x must not be 0. --------------------------------------------------------------------------------------
+	inline unsigned int LowestBitIndex(unsigned int x)
 	{
-		std::basic_string<CharOut> ret;
-		XLastDitchStringCopy(in, ret);
+#ifdef _MSC_VER
+		unsigned long ret;
+		_BitScanForward(&ret, x);
 		return ret;
+#else
+		return __builtin_ctz(x);
+#endif
 	}
-	template<typename CharOut, typename CharIn>
-	inline std::basic_string<CharOut> StringConvert(const CharIn* in, UINT fromcodepage)
-	{
-		return StringConvert<CharOut, CharIn>(in, fromcodepage, CP_ACP);
-	}
-	template<typename CharOut, typename CharIn>
-	inline std::basic_string<CharOut> StringConvert(const CharIn* in)
-	{
-		return StringConvert<CharOut, CharIn>(in, CP_ACP, CP_ACP);
-	}
-	// case #4:
-	// note: error C2765: 'LibCC::StringConvertX' : an explicit specialization of a function template cannot have any default arguments
-	template<>
-	inline std::wstring StringConvert<wchar_t, char>(const char* in, UINT fromcodepage, UINT)
-	{
-		return ToUTF16(in, fromcodepage);
-	}
-	template<>
-	inline std::wstring StringConvert<wchar_t, char>(const char* in, UINT fromcodepage)
-	{
-		return ToUTF16(in, fromcodepage);
-	}
-	template<>
-	inline std::wstring StringConvert<wchar_t, char>(const char* in)
-	{
-		return ToUTF16(in);
-	}
-	template<>
-	inline std::string StringConvert<char, wchar_t>(const wchar_t* in, UINT fromcodepage, UINT tocodepage)
-	{
-		return ToANSI(in, fromcodepage, tocodepage);
-	}
-	template<>
-	inline std::string StringConvert<char, wchar_t>(const wchar_t* in, UINT fromcodepage)
-	{
-		return ToANSI(in, fromcodepage);
-	}
-	template<>
-	inline std::string StringConvert<char, wchar_t>(const wchar_t* in)
-	{
-		return ToANSI(in);
-	}
-	// case #1, #2, #3, #6:
-	template<>
-	inline std::string StringConvert<char, char>(const char* in, UINT fromcodepage, UINT tocodepage)
-	{
-		return ToANSI(in, fromcodepage, tocodepage);
-	}
-	template<>
-	inline std::string StringConvert<char, char>(const char* in, UINT fromcodepage)
+
+	inline unsigned int HighestBitIndex(unsigned int x)
 	{
-		return ToANSI(in, fromcodepage);
+#ifdef _MSC_VER
+		unsigned long ret;
+		_BitScanReverse(&ret, x);
+		return ret;
+#else
+		return 31 - __builtin_clz(x);
+#endif
 	}
-	template<>
-	inline std::string StringConvert<char, char>(const char* in)
+
+
+	// StringCharSet. --------------------------------------------------------------------------------------
+	// a set of chars built once, for searching with. code units < 256 are in a bitmap; anything bigger goes in a
+	// sorted list. the bitmap is laid out as 2 x 16 rows indexed by the low nibble with a bit per high nibble,
+	// which is what pshufb needs to classify 16 code units at once.
+	inline unsigned long CharSetIndex(char c) { return (unsigned char)c; }
+	inline unsigned long CharSetIndex(signed char c) { return (unsigned char)c; }
+	template<typename Char>
+	inline unsigned long CharSetIndex(Char c) { return (unsigned long)c; }
+
+	template<typename Char>
+	class StringCharSet
 	{
-		return ToANSI(in);
-	}
+	public:
+		StringCharSet()
+		{
+			Clear();
+		}
 
+		explicit StringCharSet(const Char* chars)
+		{
+			Clear();
+			Add(chars, StringLength(chars));
+		}
 
-	// StringContains. --------------------------------------------------------------------------------------
+		StringCharSet(const Char* chars, size_t len)
+		{
+			Clear();
+			Add(chars, len);
+		}
 
-	// find a char in a string.
-	template<typename TiteratorType, typename TstrType, typename Trhs>
-	inline bool InternalStringContainsChar(TstrType str, Trhs x)// not practical for most uses because it would be too ambiguous. this houses the basic generic algorithm
-  {
-		for(TiteratorType it = StringBegin(str); !StringIsEnd(it, str); ++ it)
+		explicit StringCharSet(const std::basic_string<Char>& chars)
 		{
-      if(*it == x) return true;
-    }
-    return false;
-	}
-	// no-conversion cases
-  template<typename Char>
-  inline bool StringContainsChar(const Char* source, Char x)
-  {
-		return InternalStringContainsChar<const Char*, const Char*, Char>(source, x);
-	}
-  template<typename Char>
-	inline bool StringContainsChar(const std::basic_string<Char>& source, Char x)
-  {
-		return InternalStringContainsChar<std::basic_string<Char>::const_iterator, const std::basic_string<Char>&, Char>(source, x);
-	}
-  template<typename CharL, typename CharR>
-  inline bool StringContainsChar(const CharL* source, CharR x, int codepageLeft = CP_ACP)
-  {
-		if (sizeof(CharL) > sizeof(CharR))
-		{
-			return StringContainsChar(source, CharConvert<CharL>(x));
+			Clear();
+			Add(chars.c_str(), chars.size());
 		}
-		else
+
+		void Clear()
 		{
-			std::basic_string<CharR> temp;
-			StringConvert(source, temp, codepageLeft);
-			return StringContainsChar(temp, x);
+			memset(m_rows, 0, sizeof(m_rows));
+			m_wide.clear();
 		}
-	}
 
-	template<typename CharL, typename CharR>
-	inline bool StringContainsChar(const std::basic_string<CharL>& source, CharR x, int codepageLeft = CP_ACP)
-  {
-		if (sizeof(CharL) > sizeof(CharR))
+		void Add(Char c)
 		{
-			return StringContainsChar(source, CharConvert<CharL>(x));
+			unsigned long u = CharSetIndex(c);
+			if(u < 256)
+			{
+				m_rows[u >> 7][u & 15] |= (unsigned char)(1 << ((u >> 4) & 7));
+				return;
+			}
+			std::vector<unsigned long>::iterator it = std::lower_bound(m_wide.begin(), m_wide.end(), u);
+			if(it == m_wide.end() || *it != u)
+			{
+				m_wide.insert(it, u);
+			}
 		}
-		else
+
+		void Add(const Char* chars, size_t len)
 		{
-			std::basic_string<CharR> temp;
-			StringConvert(source, temp, codepageLeft);
-			return StringContainsChar(temp, x);
+			for(size_t i = 0; i < len; ++ i)
+			{
+				Add(chars[i]);
+			}
 		}
-  }
 
-	// requires conversion
-  template<typename Char>
-  inline bool StringContainsString(const Char* source, const Char* x)
-  {
-		if(*x == 0)
-			return true;
-		//return wcsstr(source, x) != 0;
-		while(true)
+		bool Contains(Char c) const
 		{
-			if(*source == 0)
-				return false;
-			if(StringStartsWith(source, x))
-				return true;
-			source ++;
+			unsigned long u = CharSetIndex(c);
+			if(u < 256)
+				return ((m_rows[u >> 7][u & 15] >> ((u >> 4) & 7)) & 1) != 0;
+			return !m_wide.empty() && std::binary_search(m_wide.begin(), m_wide.end(), u);
 		}
-	}
-
-	//template<typename CharL, typename CharR>
-	//inline bool StringContainsString(const std::basic_string<CharL>& source, const std::basic_string<CharR>& x, int codepageLeft = CP_ACP)
- // {
-	//	__asm int 3;// this function is here to disambiguate template argument matching. it's not currently implemented.
-	//	return false;
- // }
-
-	template<typename Char>
-	inline bool StringContainsString(const std::basic_string<Char>& source, const std::basic_string<Char>& x)
-  {
-		return StringContainsString(source.c_str(), x.c_str());
-  }
-
-	template<typename Char>
-	inline bool StringContainsString(const std::basic_string<Char>& source, const Char* x)
-  {
-		return StringContainsString(source.c_str(), x);
-  }
-
-	// StringContains(case-insensitive). --------------------------------------------------------------------------------------
-	//template<typename Char>
-	//inline bool StringContainsStringI(const std::basic_string<Char>& source, const std::basic_string<Char>& x)
- // {
-	//	return StringContainsString(StringToLower(source), StringToLower(x));
- // }
-
-	// StringFindFirstOf, returning index --------------------------------------------------------------------------------------
 
-	// not practical for most uses because it would be too ambiguous. this houses the basic generic algorithm
-	// only accepts 1 string type because we don't want to convert for every call to StringContains()
-	template<typename TiteratorType, typename TstrType, typename TcharsType>
-  inline std::string::size_type InternalStringFindFirstOf1(TstrType str, TcharsType chars)
-  {
-		std::string::size_type ret = 0;
-		for(TiteratorType it = StringBegin(str); !StringIsEnd(it, str); ++ it)
+		std::string::size_type FindFirst(const Char* s, size_t len) const
 		{
-			if(StringContainsChar(chars, *it))// we don't want to do a conversion here
-				return ret;
-			ret ++;
+			size_t i = 0;
+#if LIBCC_SSSE3 == 1
+			if(sizeof(Char) <= 2)
+			{
+				for(; i + 16 <= len; i += 16)
+				{
+					unsigned int m = Match16(s + i);
+					if(m)
+						return i + LowestBitIndex(m);
+				}
+			}
+#endif
+			for(; i < len; ++ i)
+			{
+				if(Contains(s[i]))
+					return i;
+			}
+			return std::string::npos;
 		}
-    return std::string::npos;
-  }
-	// no-conversion cases
-  template<typename Char>
-	inline std::string::size_type StringFindFirstOf(const Char* s, const Char* chars)
-  {
-		return InternalStringFindFirstOf1<const Char*>(s, chars);
-  }
-  template<typename Char>
-	inline std::string::size_type StringFindFirstOf(const Char* s, const std::basic_string<Char>& chars)
-  {
-		return InternalStringFindFirstOf1<const Char*>(s, chars);
-  }
-  template<typename Char>
-	inline std::string::size_type StringFindFirstOf(const std::basic_string<Char>& s, const Char* chars)
-  {
-		return InternalStringFindFirstOf1<std::basic_string<Char>::const_iterator>(s, chars);
-  }
-  template<typename Char>
-	inline std::string::size_type StringFindFirstOf(const std::basic_string<Char>& s, const std::basic_string<Char>& chars)
-  {
-		return InternalStringFindFirstOf1<std::basic_string<Char>::const_iterator>(s, chars);
-  }
 
-	// conversion cases
-  template<typename CharL, typename CharR, typename Tleft, typename Tright>
-	inline std::string::size_type InternalStringFindFirstOf2(Tleft s, Tright chars)// this func does conversion to the biggest type
-  {
-		if(sizeof(CharL) > sizeof(CharR))
+		std::string::size_type FindLast(const Char* s, size_t len) const
 		{
-			std::basic_string<CharL> temp;
-			StringConvert(chars, temp);
-			return StringFindFirstOf(s, temp);
+			size_t end = len;
+#if LIBCC_SSSE3 == 1
+			if(sizeof(Char) <= 2)
+			{
+				for(; end >= 16; end -= 16)
+				{
+					unsigned int m = Match16(s + end - 16);
+					if(m)
+						return end - 16 + HighestBitIndex(m);
+				}
+			}
+#endif
+			while(end > 0)
+			{
+				-- end;
+				if(Contains(s[end]))
+					return end;
+			}
+			return std::string::npos;
 		}
-		else
+
+		// first / last code unit which is NOT in the set; this is what trimming wants.
+		std::string::size_type FindFirstNot(const Char* s, size_t len) const
 		{
-			std::basic_string<CharR> temp;
-			StringConvert(s, temp);
-			return StringFindFirstOf(temp, chars);
+			size_t i = 0;
+#if LIBCC_SSSE3 == 1
+			if(sizeof(Char) <= 2)
+			{
+				for(; i + 16 <= len; i += 16)
+				{
+					unsigned int m = ~Match16(s + i) & 0xffff;
+					if(m)
+						return i + LowestBitIndex(m);
+				}
+			}
+#endif
+			for(; i < len; ++ i)
+			{
+				if(!Contains(s[i]))
+					return i;
+			}
+			return std::string::npos;
 		}
-  }
-  template<typename CharL, typename CharR>
-	inline std::string::size_type StringFindFirstOf(const CharL* s, const CharR* chars)
-  {
-		return InternalStringFindFirstOf2<CharL, CharR>(s, chars);
-  }
-  template<typename CharL, typename CharR>
-	inline std::string::size_type StringFindFirstOf(const CharL* s, const std::basic_string<CharR>& chars)
-  {
-		return InternalStringFindFirstOf2<CharL, CharR>(s, chars);
-  }
-  template<typename CharL, typename CharR>
-	inline std::string::size_type StringFindFirstOf(const std::basic_string<CharL>& s, const CharR* chars)
-  {
-		return InternalStringFindFirstOf2<CharL, CharR>(s, chars);
-  }
-  template<typename CharL, typename CharR>
-	inline std::string::size_type StringFindFirstOf(const std::basic_string<CharL>& s, const std::basic_string<CharR>& chars)
-  {
-		return InternalStringFindFirstOf2<CharL, CharR>(s, chars);
-  }
-
 
-	// StringFindLastOf. --------------------------------------------------------------------------------------
-	template<typename TiteratorType, typename TstrType, typename TcharsType>
-  inline std::string::size_type InternalStringFindLastOf1(TstrType str, TcharsType chars)
-  {
-		size_t len = StringLength(str);
-		if(0 == len)
-	    return std::string::npos;
-		std::string::size_type ret = len - 1;
-		TiteratorType it = StringBegin(str) + ret;// last char
-		while(true)
+		std::string::size_type FindLastNot(const Char* s, size_t len) const
 		{
-			if(StringContainsChar(chars, *it))// we don't want to do a conversion here
-				return ret;
-			if(ret == 0)
-				break;
-			-- it;
-			-- ret;
+			size_t end = len;
+#if LIBCC_SSSE3 == 1
+			if(sizeof(Char) <= 2)
+			{
+				for(; end >= 16; end -= 16)
+				{
+					unsigned int m = ~Match16(s + end - 16) & 0xffff;
+					if(m)
+						return end - 16 + HighestBitIndex(m);
+				}
+			}
+#endif
+			while(end > 0)
+			{
+				-- end;
+				if(!Contains(s[end]))
+					return end;
+			}
+			return std::string::npos;
 		}
-    return std::string::npos;
-  }
-	// no-conversion cases
-  template<typename Char>
-	inline std::string::size_type StringFindLastOf(const Char* s, const Char* chars)
-  {
-		return InternalStringFindLastOf1<const Char*>(s, chars);
-  }
-  template<typename Char>
-	inline std::string::size_type StringFindLastOf(const Char* s, const std::basic_string<Char>& chars)
-  {
-		return InternalStringFindLastOf1<const Char*>(s, chars);
-  }
-  template<typename Char>
-	inline std::string::size_type StringFindLastOf(const std::basic_string<Char>& s, const Char* chars)
-  {
-		return InternalStringFindLastOf1<std::basic_string<Char>::const_iterator>(s, chars);
-  }
-  template<typename Char>
-	inline std::string::size_type StringFindLastOf(const std::basic_string<Char>& s, const std::basic_string<Char>& chars)
-  {
-		return InternalStringFindLastOf1<std::basic_string<Char>::const_iterator>(s, chars);
-  }
 
-	// conversion cases
-  template<typename CharL, typename CharR, typename Tleft, typename Tright>
-	inline std::string::size_type InternalStringFindLastOf2(Tleft s, Tright chars)
-  {
-		if(sizeof(CharL) > sizeof(CharR))
+		std::string::size_type FindFirst(const Char* s) const
 		{
-			std::basic_string<CharL> temp;
-			StringConvert(chars, temp);
-			return StringFindLastOf(s, temp);
+			return FindFirst(s, StringLength(s));
 		}
-		else
+		std::string::size_type FindFirst(const std::basic_string<Char>& s) const
 		{
-			std::basic_string<CharR> temp;
-			StringConvert(s, temp);
-			return StringFindLastOf(temp, chars);
+			return FindFirst(s.c_str(), s.size());
 		}
-  }
-  template<typename CharL, typename CharR>
-	inline std::string::size_type StringFindLastOf(const CharL* s, const CharR* chars)
-  {
-		return InternalStringFindLastOf2<CharL, CharR>(s, chars);
-  }
-  template<typename CharL, typename CharR>
-	inline std::string::size_type StringFindLastOf(const CharL* s, const std::basic_string<CharR>& chars)
-  {
-		return InternalStringFindLastOf2<CharL, CharR>(s, chars);
-  }
-  template<typename CharL, typename CharR>
-	inline std::string::size_type StringFindLastOf(const std::basic_string<CharL>& s, const CharR* chars)
-  {
-		return InternalStringFindLastOf2<CharL, CharR>(s, chars);
-  }
-  template<typename CharL, typename CharR>
-	inline std::string::size_type StringFindLastOf(const std::basic_string<CharL>& s, const std::basic_string<CharR>& chars)
-  {
-		return InternalStringFindLastOf2<CharL, CharR>(s, chars);
-  }
-
-
-	// StringSplit --------------------------------------------------------------------------------------
-	// TODO: make a string split that separates by simple char, or possible array of chars or array of strings (like .net)
-	// sep is a whole string, not a bunch of possible separator chars.
-  template<typename Tchar, class TiteratorIn, class TiteratorSep, typename TstrIn, typename TstrSep, class OutIt>
-  inline void InternalStringSplitByString1(TstrIn in, TstrSep sep, OutIt dest)
-  {
-		if(StringLength(in) == 0)
-			return;
-		if(StringLength(sep) == 0)
+		std::string::size_type FindLast(const Char* s) const
 		{
-			*dest = in;
-			++ dest;
-			return;
+			return FindLast(s, StringLength(s));
 		}
-		typedef std::basic_string<Tchar> _String;
-		_String token;
-		TiteratorSep sepIt = StringBegin(sep);
-		
-		for(TiteratorIn it = StringBegin(in); !StringIsEnd(it, in); ++ it)
+		std::string::size_type FindLast(const std::basic_string<Char>& s) const
 		{
-			if(*it == *sepIt)
+			return FindLast(s.c_str(), s.size());
+		}
+
+	private:
+		unsigned char m_rows[2][16];// [high nibble >= 8][low nibble], bit = high nibble & 7
+		std::vector<unsigned long> m_wide;// sorted
+
+#if LIBCC_SSSE3 == 1
+		// bit per byte which is in the set
+		unsigned int Classify16(__m128i v) const
+		{
+			const __m128i nibble = _mm_set1_epi8(0x0f);
+			__m128i lo = _mm_and_si128(v, nibble);
+			__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+			__m128i rows0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_rows[0])), lo);
+			__m128i rows1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_rows[1])), lo);
+			__m128i upper = _mm_cmpgt_epi8(hi, _mm_set1_epi8(7));
+			__m128i rows = _mm_or_si128(_mm_andnot_si128(upper, rows0), _mm_and_si128(upper, rows1));
+			__m128i bit = _mm_shuffle_epi8(_mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)0x80, 1, 2, 4, 8, 16, 32, 64, (char)0x80), hi);
+			return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(rows, bit), bit));
+		}
+
+		// bit per code unit which is in the set, for 16 code units.
+		unsigned int Match16(const Char* s) const
+		{
+			if(sizeof(Char) == 1)
+				return Classify16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+
+			// 16-bit: classify the low bytes, then mask out units >= 256 and look those up separately.
+			const __m128i lowByte = _mm_set1_epi16(0x00ff);
+			const __m128i zero = _mm_setzero_si128();
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 8));
+			__m128i narrowA = _mm_cmpeq_epi16(_mm_andnot_si128(lowByte, a), zero);
+			__m128i narrowB = _mm_cmpeq_epi16(_mm_andnot_si128(lowByte, b), zero);
+			unsigned int narrow = (unsigned int)_mm_movemask_epi8(_mm_packs_epi16(narrowA, narrowB));
+			unsigned int ret = Classify16(_mm_packus_epi16(_mm_and_si128(a, lowByte), _mm_and_si128(b, lowByte))) & narrow;
+			unsigned int wide = ~narrow & 0xffff;
+			if(wide && !m_wide.empty())
 			{
-				sepIt ++;
-				if(StringIsEnd(sepIt, sep))
-				{
-					// we found the whole separator. push the previous token.
-					*dest = token;
-					++ dest;
-					token.clear();
-					sepIt = StringBegin(sep);
-					// and if we are at the very end of the string, add a blank token (like "a,b,c," will give 4 results = a, b, c, and a blank one)
-					if(StringIsEnd(it + 1, in))
-					{
-						*dest = token;
-						++ dest;
-						break;
-					}
-				}
-				else
+				for(; wide; wide &= wide - 1)
 				{
-					// just another character in the separator.
+					unsigned int n = LowestBitIndex(wide);
+					if(std::binary_search(m_wide.begin(), m_wide.end(), CharSetIndex(s[n])))
+						ret |= 1 << n;
 				}
 			}
-			else
-			{
-				// just another character in a TOKEN
-				token.push_back(*it);
-				sepIt = StringBegin(sep);
-			}
+			return ret;
 		}
-		// if there's a token at the end of the string, append it. blank tokens would have already been added.
-		if(!token.empty())
-		{
-			*dest = token;
+#endif
+	};
+
+	// StringFindFirstOf / StringFindLastOf build a StringCharSet when the set is at least this long.
+	const size_t StringCharSetThreshold = 4;
+
+
+	// StringSearcher. --------------------------------------------------------------------------------------
+	// finds a needle in haystacks. the needle is preprocessed once on construction, so keep the searcher around when
+	// searching for the same thing repeatedly.
+	// short needles are found by filtering on their first and last chars (16 bytes of candidates at a time with SSE2)
+	// and comparing the middle of the candidates; long needles use Boyer-Moore-Horspool, whose skips grow with the needle.
+	template<typename Char>
+	class StringSearcher
+	{
+	public:
+		static const size_t HorspoolThreshold = 32;
+
+		StringSearcher()
+		{
+			Assign(0, 0);
+		}
+
+		explicit StringSearcher(const Char* needle)
+		{
+			Assign(needle, StringLength(needle));
+		}
+
+		StringSearcher(const Char* needle, size_t len)
+		{
+			Assign(needle, len);
+		}
+
+		explicit StringSearcher(const std::basic_string<Char>& needle)
+		{
+			Assign(needle.c_str(), needle.size());
+		}
+
+		void Assign(const Char* needle, size_t len)
+		{
+			m_needle.clear();
+			m_skip.clear();
+			if(len == 0)
+				return;
+			m_needle.assign(needle, len);
+			if(len >= HorspoolThreshold)
+			{
+				// code units are bucketed by their low byte; when several share a bucket the last (smallest) skip wins, which is safe.
+				m_skip.assign(256, len);
+				for(size_t i = 0; i + 1 < len; ++ i)
+				{
+					m_skip[CharSetIndex(needle[i]) & 0xff] = len - 1 - i;
+				}
+			}
+		}
+
+		const std::basic_string<Char>& Needle() const
+		{
+			return m_needle;
+		}
+
+		// returns the index of the first match at or after start, or npos. an empty needle matches at start.
+		std::string::size_type Find(const Char* s, size_t len, size_t start = 0) const
+		{
+			const size_t n = m_needle.size();
+			if(start > len)
+				return std::string::npos;
+			if(n == 0)
+				return start;
+			if(len - start < n)
+				return std::string::npos;
+			return m_skip.empty() ? FindFiltered(s, len, start) : FindHorspool(s, len, start);
+		}
+
+		std::string::size_type Find(const Char* s) const
+		{
+			return Find(s, StringLength(s));
+		}
+
+		std::string::size_type Find(const std::basic_string<Char>& s, size_t start = 0) const
+		{
+			return Find(s.c_str(), s.size(), start);
+		}
+
+	private:
+		std::basic_string<Char> m_needle;
+		std::vector<size_t> m_skip;// Horspool bad char table, only for long needles
+
+		std::string::size_type FindFiltered(const Char* s, size_t len, size_t i) const
+		{
+			const Char* needle = m_needle.c_str();
+			const size_t n = m_needle.size();
+			const size_t middle = n < 2 ? 0 : n - 2;// what's left to compare after first & last match
+#if LIBCC_SSE2 == 1
+			if(sizeof(Char) == 1 || sizeof(Char) == 2)
+			{
+				const size_t step = 16 / sizeof(Char);
+				const __m128i first = sizeof(Char) == 1 ? _mm_set1_epi8((char)needle[0]) : _mm_set1_epi16((short)needle[0]);
+				const __m128i last = sizeof(Char) == 1 ? _mm_set1_epi8((char)needle[n - 1]) : _mm_set1_epi16((short)needle[n - 1]);
+				for(; i + n - 1 + step <= len; i += step)
+				{
+					__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+					__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + n - 1));
+					unsigned int m;
+					if(sizeof(Char) == 1)
+						m = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+					else
+						m = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(a, first), _mm_cmpeq_epi16(b, last))) & 0x5555;
+					for(; m; m &= m - 1)
+					{
+						size_t pos = i + LowestBitIndex(m) / sizeof(Char);
+						if(memcmp(s + pos + 1, needle + 1, middle * sizeof(Char)) == 0)
+							return pos;
+					}
+				}
+			}
+#endif
+			const Char first = needle[0];
+			const Char last = needle[n - 1];
+			for(; i + n <= len; ++ i)
+			{
+				if(s[i] == first && s[i + n - 1] == last && memcmp(s + i + 1, needle + 1, middle * sizeof(Char)) == 0)
+					return i;
+			}
+			return std::string::npos;
+		}
+
+		std::string::size_type FindHorspool(const Char* s, size_t len, size_t i) const
+		{
+			const Char* needle = m_needle.c_str();
+			const size_t n = m_needle.size();
+			const Char last = needle[n - 1];
+			while(i + n <= len)
+			{
+				Char c = s[i + n - 1];
+				if(c == last && memcmp(s + i, needle, (n - 1) * sizeof(Char)) == 0)
+					return i;
+				i += m_skip[CharSetIndex(c) & 0xff];
+			}
+			return std::string::npos;
+		}
+	};
+
+
+	// StringConvert. this also acts as a StringCopy. --------------------------------------------------------------------------------------
+
+	// TODO: http://www.unicode.org/Public/PROGRAMS/CVTUTF/ConvertUTF.c
+	//inline HRESULT UTF16ToUTF32(const wchar_t*, size_t, Blob<__int32>&)
+	//{
+	//	return E_NOTIMPL;
+	//}
+
+	//inline HRESULT UTF32ToUTF16(const wchar_t*, size_t, Blob<__int32>&)
+	//{
+	//	return E_NOTIMPL;
+	//}
+
+	// http://www.themssforum.com/MFC/WideCharToMultiByte-works/
+	// converts from UTF-16 (true UTF-16 according to MS) to ANSI
+	inline HRESULT ToANSI(const wchar_t* in, size_t inLength, std::vector<BYTE>& out, UINT codepage = LIBCC_CHAR_CODEPAGE)
+	{
+#ifdef WIN32
+		if(codepage != CP_UTF8)
+		{
+			DWORD flags;
+	 
+			switch (codepage)
+			{
+			case 50220: case 50221: case 50222: case 50225:
+			case 50227: case 50229: case 52936: case 54936:
+			case 57002: case 57003: case 57004: case 57005:
+			case 57006: case 57007: case 57008: case 57009:
+			case 57010: case 57011: case 65000: case 42:
+				flags = 0;
+				break;
+			case 65001:
+				flags = 0; // or WC_ERR_INVALID_CHARS on winver >= 0x0600
+				break;
+			default:
+				{
+					flags = WC_NO_BEST_FIT_CHARS | WC_COMPOSITECHECK;
+					break;
+				}
+			}
+
+			CPINFO cpinfo;
+			if(0 == GetCPInfo(codepage, &cpinfo))
+			{
+				return E_FAIL;
+			}
+	 
+			// get the length first
+			BOOL usedDefaultChar = FALSE;
+			int length = WideCharToMultiByte(codepage, flags, in, (int)inLength, NULL, 0,
+				(flags & WC_NO_BEST_FIT_CHARS) ? (const CHAR*)cpinfo.DefaultChar : 0,
+				(flags & WC_NO_BEST_FIT_CHARS) ? &usedDefaultChar : 0);
+
+			if (length == 0)
+				return E_FAIL;
+
+			out.resize((size_t)length);// it is important to make sure the return Blob has the correct size here. so do not add +1 to this.
+
+			WideCharToMultiByte(codepage, flags, in, (int)inLength, (LPSTR)out.data(), length,
+				(flags & WC_NO_BEST_FIT_CHARS) ? (const CHAR*)cpinfo.DefaultChar : 0,
+				(flags & WC_NO_BEST_FIT_CHARS) ? &usedDefaultChar : 0);
+
+			return S_OK;
+		}
+#else
+		(void)codepage;
+#endif
+		// UTF-8. (without Windows every codepage is.)
+		out.resize(UTF16ToUTF8(in, inLength, (char*)0));
+		if(!out.empty())
+			UTF16ToUTF8(in, inLength, (char*)out.data());
+		return S_OK;
+	}
+
+	// from ANSI to Unicode (real UTF-16)
+	inline HRESULT ToUTF16(const BYTE* multistr, size_t sourceLength, std::wstring& widestr, UINT codepage = LIBCC_CHAR_CODEPAGE)
+	{
+#ifdef WIN32
+		if(codepage != CP_UTF8)
+		{
+			int length = MultiByteToWideChar(codepage, 0, (PCSTR)multistr, (int)sourceLength, NULL, 0);
+			if (length == 0)
+				return E_FAIL;
+			widestr.resize(length);
+			MultiByteToWideChar(codepage, 0, (PCSTR)multistr, (int)sourceLength, &widestr[0], (int)length);
+			return S_OK;
+		}
+#else
+		(void)codepage;
+#endif
+		UTF8ToUTF16((const char*)multistr, sourceLength, widestr);
+		return S_OK;
+	}
+
+	/*
+		supported input / output types:
+		std::basic_string<xchar>
+		xchar*
+		LibCC::Blob<xchar>  [ limited ]
+
+		For each in/out type scenario
+		a) basic_string -> basic_string
+		a) xchar* -> basic_string
+		
+		here are the conversion cases to write functions for. it ends up being 5 functions to handle all cases:
+
+		#1: ansi cp1 str -> ansi cp1 str    (no conversion)
+		#2: utf16 str -> utf16 str          (no conversion)
+		#3: unknown str -> unknown str      (no conversion)
+
+		#4: ansi str -> utf16 str           (known conversion)
+		#5: utf16 str -> ansi str           (known conversion)
+		#6: ansi str -> other ansi str      (known conversion)
+
+		#7: ansi str -> unknown str         (unknown conversion)
+		#8: utf16 str -> unknown str        (unknown conversion)
+		#9: unknown str -> utf16 str        (unknown conversion)
+		#10: unknown str -> ansi str        (unknown conversion)
+
+		TODO:
+		#12: utf32 str -> utf32 str
+		#13: utf32 str -> utf16 str
+		#14: utf16 str -> utf32 str
+		#15: ansi str -> utf32 str
+		#16: utf32 str -> ansi str
+		#17: utf32 str -> unknown str
+		#18: unknown str -> utf32 str
+
+		NOTE:
+			- many functions take codepage arguments even though they will be ignored. this is to unify how they are called; more generic.
+			  for an ignored codepage, just use 0.
+	*/
+
+	// basic_string -> basic_string --------------------------------------------------------------------------------------
+	inline HRESULT StringConvert(const std::string& in, std::wstring& out, UINT fromcodepage = LIBCC_CHAR_CODEPAGE, UINT = LIBCC_CHAR_CODEPAGE)
+	{
+		return ToUTF16((const BYTE*)in.c_str(), in.length(), out, fromcodepage);
+	}
+	// case #5:
+	inline HRESULT StringConvert(const std::wstring& in, std::string& out, UINT = LIBCC_CHAR_CODEPAGE, UINT tocodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		if(tocodepage == CP_UTF8)
+		{
+			UTF16ToUTF8(in.c_str(), in.length(), out);// straight into out; no intermediate buffer.
+			return S_OK;
+		}
+		std::vector<BYTE> b;
+		HRESULT hr = ToANSI(in.c_str(), in.length(), b, tocodepage);
+		if(FAILED(hr)) return hr;
+		out.assign((const char*)b.data(), b.size());
+		return hr;
+	}
+	// case #1, #2, #3, #6:
+	inline HRESULT StringConvert(const std::string& in, std::string& out, UINT fromCodepage = LIBCC_CHAR_CODEPAGE, UINT toCodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		if(fromCodepage == toCodepage)
+		{
+			out = in;
+			return S_OK;
+		}
+		std::wstring intermediate;
+		HRESULT hr = StringConvert(in, intermediate, fromCodepage);
+		if(FAILED(hr)) return hr;
+		return StringConvert(intermediate, out, toCodepage);
+	}
+	// case #7, #8, #9, #10:
+	template<typename CharIn, typename CharOut>
+	inline HRESULT StringConvert(const std::basic_string<CharIn>& in, std::basic_string<CharOut>& out, UINT fromcodepage = LIBCC_CHAR_CODEPAGE, UINT tocodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		XLastDitchStringCopy(in, out);
+		return S_OK;
+	}
+
+	// xchar* -> basic_string --------------------------------------------------------------------------------------
+	inline HRESULT StringConvert(const char* in, std::wstring& out, UINT fromcodepage = LIBCC_CHAR_CODEPAGE, UINT = LIBCC_CHAR_CODEPAGE)
+	{
+		return ToUTF16((const BYTE*)in, StringLength(in), out, fromcodepage);
+	}
+	// case #5:
+	inline HRESULT StringConvert(const wchar_t* in, std::string& out, UINT = LIBCC_CHAR_CODEPAGE, UINT tocodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		if(tocodepage == CP_UTF8)
+		{
+			UTF16ToUTF8(in, StringLength(in), out);
+			return S_OK;
+		}
+		std::vector<BYTE> b;
+		HRESULT hr = ToANSI(in, StringLength(in), b, tocodepage);
+		if(FAILED(hr)) return hr;
+		out.assign((const char*)b.data(), b.size());
+		return hr;
+	}
+	// case #1, #2, #3, #6:
+	inline HRESULT StringConvert(const char* in, std::string& out, UINT fromCodepage = LIBCC_CHAR_CODEPAGE, UINT toCodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		if(fromCodepage == toCodepage)
+		{
+			out = in;
+			return S_OK;
+		}
+		std::wstring intermediate;
+		HRESULT hr = StringConvert(in, intermediate, fromCodepage);
+		if(FAILED(hr)) return hr;
+		return StringConvert(intermediate, out, toCodepage);
+	}
+	// case #7, #8, #9, #10:
+	template<typename CharIn, typename CharOut>
+	inline HRESULT StringConvert(const CharIn* in, std::basic_string<CharOut>& out, UINT fromcodepage = LIBCC_CHAR_CODEPAGE, UINT tocodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		XLastDitchStringCopy(in, out);
+		return S_OK;
+	}
+
+
+	// StringConvertInto. --------------------------------------------------------------------------------------
+	// converts a run of code units straight into the caller's buffer; no temporaries. pass out = 0 to measure.
+	// returns the number of code units (to be) written; outLen is the space available at out.
+	// char <-> wchar_t uses LIBCC_CHAR_CODEPAGE; everything else is a unit by unit copy like XLastDitchStringCopy.
+	template<typename CharIn, typename CharOut>
+	inline size_t StringConvertInto(const CharIn* in, size_t len, CharOut* out, size_t outLen)
+	{
+		if(out)
+		{
+			if(len > outLen)
+				len = outLen;
+			for(size_t i = 0; i < len; ++ i)
+				out[i] = static_cast<CharOut>(in[i]);
+		}
+		return len;
+	}
+
+	inline size_t StringConvertInto(const char* in, size_t len, char* out, size_t outLen)
+	{
+		if(out)
+		{
+			if(len > outLen)
+				len = outLen;
+			memcpy(out, in, len);
+		}
+		return len;
+	}
+
+	inline size_t StringConvertInto(const wchar_t* in, size_t len, wchar_t* out, size_t outLen)
+	{
+		if(out)
+		{
+			if(len > outLen)
+				len = outLen;
+			memcpy(out, in, len * sizeof(wchar_t));
+		}
+		return len;
+	}
+
+	inline size_t StringConvertInto(const char* in, size_t len, wchar_t* out, size_t outLen)
+	{
+		if(len == 0)
+			return 0;
+#ifdef WIN32
+		if(LIBCC_CHAR_CODEPAGE != CP_UTF8)
+		{
+			return (size_t)MultiByteToWideChar(LIBCC_CHAR_CODEPAGE, 0, in, (int)len, out, out ? (int)outLen : 0);
+		}
+#endif
+		if(out && UTF8ToUTF16(in, len, (wchar_t*)0) > outLen)
+			return 0;
+		return UTF8ToUTF16(in, len, out);
+	}
+
+	inline size_t StringConvertInto(const wchar_t* in, size_t len, char* out, size_t outLen)
+	{
+		if(len == 0)
+			return 0;
+#ifdef WIN32
+		if(LIBCC_CHAR_CODEPAGE != CP_UTF8)
+		{
+			return (size_t)WideCharToMultiByte(LIBCC_CHAR_CODEPAGE, 0, in, (int)len, out, out ? (int)outLen : 0, 0, 0);
+		}
+#endif
+		if(out && UTF16ToUTF8(in, len, (char*)0) > outLen)
+			return 0;
+		return UTF16ToUTF8(in, len, out);
+	}
+
+
+	// StringTable / StringConvertBatch. --------------------------------------------------------------------------------------
+	// converts a whole array of strings at once: one pass measures every output with StringConvertInto, then one
+	// pass converts each string straight into its place. a StringTable keeps all the results zero terminated back to
+	// back in one buffer, so the whole batch is 2 allocations; a std::vector of strings gets exactly 1 allocation per
+	// string. batches of at least LIBCC_BATCH_PARALLEL_UNITS code units are split across threads (threads = 0 picks
+	// std::thread::hardware_concurrency(); 1 keeps it on the calling thread).
+	template<typename Char>
+	class StringTable
+	{
+	public:
+		size_t size() const
+		{
+			return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+		}
+		bool empty() const
+		{
+			return size() == 0;
+		}
+		void clear()
+		{
+			m_buffer.clear();
+			m_offsets.clear();
+		}
+
+		StringView<Char> operator [](size_t i) const
+		{
+			return StringView<Char>(c_str(i), length(i));
+		}
+		const Char* c_str(size_t i) const
+		{
+			return &m_buffer[m_offsets[i]];
+		}
+		size_t length(size_t i) const
+		{
+			return m_offsets[i + 1] - m_offsets[i] - 1;
+		}
+		std::basic_string<Char> str(size_t i) const
+		{
+			return std::basic_string<Char>(c_str(i), length(i));
+		}
+
+		// for StringConvertBatch: sets up room for count strings of the given lengths (each followed by a terminator)
+		Char* Allocate(const size_t* lengths, size_t count)
+		{
+			m_offsets.resize(count + 1);
+			size_t offset = 0;
+			for(size_t i = 0; i < count; ++ i)
+			{
+				m_offsets[i] = offset;
+				offset += lengths[i] + 1;
+			}
+			m_offsets[count] = offset;
+			m_buffer.resize(offset);
+			return m_buffer.empty() ? 0 : &m_buffer[0];
+		}
+		size_t Offset(size_t i) const
+		{
+			return m_offsets[i];
+		}
+
+	private:
+		std::vector<Char> m_buffer;
+		std::vector<size_t> m_offsets;// size() + 1 of them; the last is the end of the buffer
+	};
+
+	// StringConvertInto when out is known to be exactly big enough, so the UTF-8 paths don't measure a second time.
+	template<typename CharIn, typename CharOut>
+	inline void InternalStringConvertExact(const CharIn* in, size_t len, CharOut* out, size_t outLen)
+	{
+		StringConvertInto(in, len, out, outLen);
+	}
+	inline void InternalStringConvertExact(const char* in, size_t len, wchar_t* out, size_t outLen)
+	{
+		if(LIBCC_CHAR_CODEPAGE == CP_UTF8)
+			UTF8ToUTF16(in, len, out);
+		else
+			StringConvertInto(in, len, out, outLen);
+	}
+	inline void InternalStringConvertExact(const wchar_t* in, size_t len, char* out, size_t outLen)
+	{
+		if(LIBCC_CHAR_CODEPAGE == CP_UTF8)
+			UTF16ToUTF8(in, len, out);
+		else
+			StringConvertInto(in, len, out, outLen);
+	}
+
+	// calls fn(begin, end) for up to threads slices of [0, count); the first slice runs on the calling thread.
+	template<typename Fn>
+	inline void InternalParallelRanges(size_t count, size_t threads, Fn fn)
+	{
+		size_t per = threads > 1 ? (count + threads - 1) / threads : count;
+		std::vector<std::thread> workers;
+		for(size_t begin = per; begin < count; begin += per)
+		{
+			workers.push_back(std::thread(fn, begin, begin + per < count ? begin + per : count));
+		}
+		fn((size_t)0, per < count ? per : count);
+		for(size_t i = 0; i < workers.size(); ++ i)
+		{
+			workers[i].join();
+		}
+	}
+
+	template<typename CharIn>
+	inline size_t InternalBatchThreads(const StringView<CharIn>* in, size_t count, size_t threads)
+	{
+		if(threads == 0)
+		{
+			size_t units = 0;
+			for(size_t i = 0; i < count && units < LIBCC_BATCH_PARALLEL_UNITS; ++ i)
+			{
+				units += in[i].size();
+			}
+			threads = units < LIBCC_BATCH_PARALLEL_UNITS ? 1 : std::thread::hardware_concurrency();
+		}
+		if(threads > count)
+			threads = count;
+		return threads ? threads : 1;
+	}
+
+	template<typename CharIn, typename CharOut>
+	inline void StringConvertBatch(const StringView<CharIn>* in, size_t count, StringTable<CharOut>& out, size_t threads = 0)
+	{
+		threads = InternalBatchThreads(in, count, threads);
+		std::vector<size_t> lengths(count);
+		size_t* pLengths = count ? &lengths[0] : 0;
+		InternalParallelRanges(count, threads, [in, pLengths](size_t begin, size_t end)
+		{
+			for(size_t i = begin; i < end; ++ i)
+			{
+				pLengths[i] = StringConvertInto(in[i].data(), in[i].size(), (CharOut*)0, 0);
+			}
+		});
+		CharOut* buffer = out.Allocate(pLengths, count);
+		StringTable<CharOut>* table = &out;
+		InternalParallelRanges(count, threads, [in, pLengths, buffer, table](size_t begin, size_t end)
+		{
+			for(size_t i = begin; i < end; ++ i)
+			{
+				CharOut* p = buffer + table->Offset(i);
+				InternalStringConvertExact(in[i].data(), in[i].size(), p, pLengths[i]);
+				p[pLengths[i]] = 0;
+			}
+		});
+	}
+
+	template<typename CharIn, typename CharOut>
+	inline void StringConvertBatch(const StringView<CharIn>* in, size_t count, std::vector<std::basic_string<CharOut> >& out, size_t threads = 0)
+	{
+		threads = InternalBatchThreads(in, count, threads);
+		out.resize(count);
+		std::basic_string<CharOut>* pOut = count ? &out[0] : 0;
+		InternalParallelRanges(count, threads, [in, pOut](size_t begin, size_t end)
+		{
+			for(size_t i = begin; i < end; ++ i)
+			{
+				size_t length = StringConvertInto(in[i].data(), in[i].size(), (CharOut*)0, 0);
+				pOut[i].resize(length);
+				if(length)
+					InternalStringConvertExact(in[i].data(), in[i].size(), &pOut[i][0], length);
+			}
+		});
+	}
+
+	// std::basic_string / zero terminated inputs are viewed first; that's 1 small allocation for the whole batch.
+	template<typename CharIn, typename Out>
+	inline void StringConvertBatch(const std::basic_string<CharIn>* in, size_t count, Out& out, size_t threads = 0)
+	{
+		std::vector<StringView<CharIn> > views(in, in + count);
+		StringConvertBatch(count ? &views[0] : (const StringView<CharIn>*)0, count, out, threads);
+	}
+	template<typename CharIn, typename Out>
+	inline void StringConvertBatch(const CharIn* const* in, size_t count, Out& out, size_t threads = 0)
+	{
+		std::vector<StringView<CharIn> > views(count);
+		for(size_t i = 0; i < count; ++ i)
+		{
+			views[i] = StringView<CharIn>(in[i], StringLength(in[i]));
+		}
+		StringConvertBatch(count ? &views[0] : (const StringView<CharIn>*)0, count, out, threads);
+	}
+	template<typename CharIn, typename Out>
+	inline void StringConvertBatch(const std::vector<std::basic_string<CharIn> >& in, Out& out, size_t threads = 0)
+	{
+		StringConvertBatch(in.empty() ? (const std::basic_string<CharIn>*)0 : &in[0], in.size(), out, threads);
+	}
+	template<typename CharIn, typename Out>
+	inline void StringConvertBatch(const std::vector<StringView<CharIn> >& in, Out& out, size_t threads = 0)
+	{
+		StringConvertBatch(in.empty() ? (const StringView<CharIn>*)0 : &in[0], in.size(), out, threads);
+	}
+
+
+	// ToUTF16. --------------------------------------------------------------------------------------
+	template<typename Char>
+	inline std::wstring ToUTF16(const Char* sz, UINT fromcodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		std::wstring ret;
+		StringConvert(sz, ret, fromcodepage);
+		return ret;
+	}
+	template<typename Char>
+	inline std::wstring ToUTF16(const std::basic_string<Char>& s, UINT fromcodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		std::wstring ret;
+		StringConvert(s, ret, fromcodepage);
+		return ret;
+	}
+	
+
+	// ToANSI. --------------------------------------------------------------------------------------
+	template<typename Char>
+	inline std::string ToANSI(const Char* sz, UINT fromcodepage = LIBCC_CHAR_CODEPAGE, UINT tocodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		std::string ret;
+		StringConvert(sz, ret, fromcodepage, tocodepage);
+		return ret;
+	}
+	template<typename Char>
+	inline std::string ToANSI(const std::basic_string<Char>& s, UINT fromcodepage = LIBCC_CHAR_CODEPAGE, UINT tocodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		std::string ret;
+		StringConvert(s, ret, fromcodepage, tocodepage);
+		return ret;
+	}
+
+
+	// ToUTF8. --------------------------------------------------------------------------------------
+	template<typename Char>
+	inline std::string ToUTF8(const Char* sz, UINT fromcodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		return ToANSI(sz, fromcodepage, CP_UTF8);
+	}
+	template<typename Char>
+	inline std::string ToUTF8(const std::basic_string<Char>& s, UINT fromcodepage = LIBCC_CHAR_CODEPAGE)
+	{
+		return ToANSI(s, fromcodepage, CP_UTF8);
+	}
+
+
+	// --------------------------------------------------------------------------------------------------------------------
+	// DUPLICATES OF ALL THE StringConvert APIs, but returning the string instead of the 2nd arg, throwing away the HRESULT 
+	// basic_string -> basic_string --------------------------------------------------------------------------------------
+	// case #7, #8, #9, #10:
+	template<typename CharOut, typename CharIn>
+	inline std::basic_string<CharOut> StringConvert(const std::basic_string<CharIn>& in, UINT fromcodepage, UINT tocodepage)
+	{
+		std::basic_string<CharOut> ret;
+		XLastDitchStringCopy(in, ret);
+		return ret;
+	}
+	template<typename CharOut, typename CharIn>
+	inline std::basic_string<CharOut> StringConvert(const std::basic_string<CharIn>& in, UINT fromcodepage)
+	{
+		return StringConvert<CharOut, CharIn>(in, fromcodepage, LIBCC_CHAR_CODEPAGE);
+	}
+	template<typename CharOut, typename CharIn>
+	inline std::basic_string<CharOut> StringConvert(const std::basic_string<CharIn>& in)
+	{
+		return StringConvert<CharOut, CharIn>(in, LIBCC_CHAR_CODEPAGE, LIBCC_CHAR_CODEPAGE);
+	}
+	// case #4:
+	// note: error C2765: 'LibCC::StringConvertX' : an explicit specialization of a function template cannot have any default arguments
+	template<>
+	inline std::wstring StringConvert<wchar_t, char>(const std::string& in, UINT fromcodepage, UINT)
+	{
+		return ToUTF16(in, fromcodepage);
+	}
+	template<>
+	inline std::wstring StringConvert<wchar_t, char>(const std::string& in, UINT fromcodepage)
+	{
+		return ToUTF16(in, fromcodepage);
+	}
+	template<>
+	inline std::wstring StringConvert<wchar_t, char>(const std::string& in)
+	{
+		return ToUTF16(in);
+	}
+	template<>
+	inline std::string StringConvert<char, wchar_t>(const std::wstring& in, UINT fromcodepage, UINT tocodepage)
+	{
+		return ToANSI(in, fromcodepage, tocodepage);
+	}
+	template<>
+	inline std::string StringConvert<char, wchar_t>(const std::wstring& in, UINT fromcodepage)
+	{
+		return ToANSI(in, fromcodepage);
+	}
+	template<>
+	inline std::string StringConvert<char, wchar_t>(const std::wstring& in)
+	{
+		return ToANSI(in);
+	}
+	// case #1, #2, #3, #6:
+	template<>
+	inline std::string StringConvert<char, char>(const std::string& in, UINT fromcodepage, UINT tocodepage)
+	{
+		return ToANSI(in, fromcodepage, tocodepage);
+	}
+	template<>
+	inline std::string StringConvert<char, char>(const std::string& in, UINT fromcodepage)
+	{
+		return ToANSI(in, fromcodepage);
+	}
+	template<>
+	inline std::string StringConvert<char, char>(const std::string& in)
+	{
+		return ToANSI(in);
+	}
+
+
+	// xchar* -> basic_string --------------------------------------------------------------------------------------
+	// case #7, #8, #9, #10:
+	template<typename CharOut, typename CharIn>
+	inline std::basic_string<CharOut> StringConvert(const CharIn* in, UINT fromcodepage, UINT tocodepage)
+	{
+		std::basic_string<CharOut> ret;
+		XLastDitchStringCopy(in, ret);
+		return ret;
+	}
+	template<typename CharOut, typename CharIn>
+	inline std::basic_string<CharOut> StringConvert(const CharIn* in, UINT fromcodepage)
+	{
+		return StringConvert<CharOut, CharIn>(in, fromcodepage, LIBCC_CHAR_CODEPAGE);
+	}
+	template<typename CharOut, typename CharIn>
+	inline std::basic_string<CharOut> StringConvert(const CharIn* in)
+	{
+		return StringConvert<CharOut, CharIn>(in, LIBCC_CHAR_CODEPAGE, LIBCC_CHAR_CODEPAGE);
+	}
+	// case #4:
+	// note: error C2765: 'LibCC::StringConvertX' : an explicit specialization of a function template cannot have any default arguments
+	template<>
+	inline std::wstring StringConvert<wchar_t, char>(const char* in, UINT fromcodepage, UINT)
+	{
+		return ToUTF16(in, fromcodepage);
+	}
+	template<>
+	inline std::wstring StringConvert<wchar_t, char>(const char* in, UINT fromcodepage)
+	{
+		return ToUTF16(in, fromcodepage);
+	}
+	template<>
+	inline std::wstring StringConvert<wchar_t, char>(const char* in)
+	{
+		return ToUTF16(in);
+	}
+	template<>
+	inline std::string StringConvert<char, wchar_t>(const wchar_t* in, UINT fromcodepage, UINT tocodepage)
+	{
+		return ToANSI(in, fromcodepage, tocodepage);
+	}
+	template<>
+	inline std::string StringConvert<char, wchar_t>(const wchar_t* in, UINT fromcodepage)
+	{
+		return ToANSI(in, fromcodepage);
+	}
+	template<>
+	inline std::string StringConvert<char, wchar_t>(const wchar_t* in)
+	{
+		return ToANSI(in);
+	}
+	// case #1, #2, #3, #6:
+	template<>
+	inline std::string StringConvert<char, char>(const char* in, UINT fromcodepage, UINT tocodepage)
+	{
+		return ToANSI(in, fromcodepage, tocodepage);
+	}
+	template<>
+	inline std::string StringConvert<char, char>(const char* in, UINT fromcodepage)
+	{
+		return ToANSI(in, fromcodepage);
+	}
+	template<>
+	inline std::string StringConvert<char, char>(const char* in)
+	{
+		return ToANSI(in);
+	}
+
+
+	// StringContains. --------------------------------------------------------------------------------------
+
+	// find a char in a string.
+	template<typename TiteratorType, typename TstrType, typename Trhs>
+	inline bool InternalStringContainsChar(TstrType str, Trhs x)// not practical for most uses because it would be too ambiguous. this houses the basic generic algorithm
+  {
+		for(TiteratorType it = StringBegin(str); !StringIsEnd(it, str); ++ it)
+		{
+      if(*it == x) return true;
+    }
+    return false;
+	}
+	// no-conversion cases
+  template<typename Char>
+  inline bool StringContainsChar(const Char* source, Char x)
+  {
+		return InternalStringContainsChar<const Char*, const Char*, Char>(source, x);
+	}
+  template<typename Char>
+	inline bool StringContainsChar(const std::basic_string<Char>& source, Char x)
+  {
+		return InternalStringContainsChar<typename std::basic_string<Char>::const_iterator, const std::basic_string<Char>&, Char>(source, x);
+	}
+  template<typename CharL, typename CharR>
+  inline bool StringContainsChar(const CharL* source, CharR x, int codepageLeft = LIBCC_CHAR_CODEPAGE)
+  {
+		if (sizeof(CharL) > sizeof(CharR))
+		{
+			return StringContainsChar(source, CharConvert<CharL>(x));
+		}
+		else
+		{
+			std::basic_string<CharR> temp;
+			StringConvert(source, temp, codepageLeft);
+			return StringContainsChar(temp, x);
+		}
+	}
+
+	template<typename CharL, typename CharR>
+	inline bool StringContainsChar(const std::basic_string<CharL>& source, CharR x, int codepageLeft = LIBCC_CHAR_CODEPAGE)
+  {
+		if (sizeof(CharL) > sizeof(CharR))
+		{
+			return StringContainsChar(source, CharConvert<CharL>(x));
+		}
+		else
+		{
+			std::basic_string<CharR> temp;
+			StringConvert(source, temp, codepageLeft);
+			return StringContainsChar(temp, x);
+		}
+  }
+
+	// requires conversion
+  template<typename Char>
+  inline bool StringContainsString(const Char* source, const Char* x)
+  {
+		if(*x == 0)
+			return true;
+		return StringSearcher<Char>(x).Find(source) != std::string::npos;
+	}
+
+	// use this one when searching for the same thing repeatedly
+	template<typename Char>
+	inline bool StringContainsString(const Char* source, const StringSearcher<Char>& x)
+	{
+		return x.Find(source) != std::string::npos;
+	}
+
+	template<typename Char>
+	inline bool StringContainsString(const std::basic_string<Char>& source, const StringSearcher<Char>& x)
+	{
+		return x.Find(source) != std::string::npos;
+	}
+
+	//template<typename CharL, typename CharR>
+	//inline bool StringContainsString(const std::basic_string<CharL>& source, const std::basic_string<CharR>& x, int codepageLeft = CP_ACP)
+ // {
+	//	__asm int 3;// this function is here to disambiguate template argument matching. it's not currently implemented.
+	//	return false;
+ // }
+
+	template<typename Char>
+	inline bool StringContainsString(const std::basic_string<Char>& source, const std::basic_string<Char>& x)
+  {
+		if(x.empty())
+			return true;
+		return StringSearcher<Char>(x).Find(source) != std::string::npos;
+  }
+
+	template<typename Char>
+	inline bool StringContainsString(const std::basic_string<Char>& source, const Char* x)
+  {
+		return StringContainsString(source.c_str(), x);
+  }
+
+	// StringContains(case-insensitive). --------------------------------------------------------------------------------------
+	//template<typename Char>
+	//inline bool StringContainsStringI(const std::basic_string<Char>& source, const std::basic_string<Char>& x)
+ // {
+	//	return StringContainsString(StringToLower(source), StringToLower(x));
+ // }
+
+	// StringFindFirstOf, returning index --------------------------------------------------------------------------------------
+
+	// not practical for most uses because it would be too ambiguous. this houses the basic generic algorithm
+	// only accepts 1 string type because we don't want to convert for every call to StringContains()
+	template<typename TiteratorType, typename TstrType, typename TcharsType>
+  inline std::string::size_type InternalStringFindFirstOf1(TstrType str, TcharsType chars)
+  {
+		std::string::size_type ret = 0;
+		for(TiteratorType it = StringBegin(str); !StringIsEnd(it, str); ++ it)
+		{
+			if(StringContainsChar(chars, *it))// we don't want to do a conversion here
+				return ret;
+			ret ++;
+		}
+    return std::string::npos;
+  }
+	// for big sets, building a StringCharSet and scanning once beats testing each char against the whole set.
+	template<typename Char, typename TiteratorType, typename TstrType, typename TcharsType>
+	inline std::string::size_type InternalStringFindFirstOf0(const TstrType& s, const TcharsType& chars)
+	{
+		if(StringLength(chars) >= StringCharSetThreshold)
+			return StringCharSet<Char>(chars).FindFirst(s);
+		return InternalStringFindFirstOf1<TiteratorType, const TstrType&, const TcharsType&>(s, chars);
+	}
+
+	// no-conversion cases
+  template<typename Char>
+	inline std::string::size_type StringFindFirstOf(const Char* s, const Char* chars)
+  {
+		return InternalStringFindFirstOf0<Char, const Char*>(s, chars);
+  }
+  template<typename Char>
+	inline std::string::size_type StringFindFirstOf(const Char* s, const std::basic_string<Char>& chars)
+  {
+		return InternalStringFindFirstOf0<Char, const Char*>(s, chars);
+  }
+  template<typename Char>
+	inline std::string::size_type StringFindFirstOf(const std::basic_string<Char>& s, const Char* chars)
+  {
+		return InternalStringFindFirstOf0<Char, typename std::basic_string<Char>::const_iterator>(s, chars);
+  }
+  template<typename Char>
+	inline std::string::size_type StringFindFirstOf(const std::basic_string<Char>& s, const std::basic_string<Char>& chars)
+  {
+		return InternalStringFindFirstOf0<Char, typename std::basic_string<Char>::const_iterator>(s, chars);
+  }
+  // prebuilt set
+  template<typename Char>
+	inline std::string::size_type StringFindFirstOf(const Char* s, const StringCharSet<Char>& chars)
+  {
+		return chars.FindFirst(s);
+  }
+  template<typename Char>
+	inline std::string::size_type StringFindFirstOf(const std::basic_string<Char>& s, const StringCharSet<Char>& chars)
+  {
+		return chars.FindFirst(s);
+  }
+
+	// conversion cases
+  template<typename CharL, typename CharR, typename Tleft, typename Tright>
+	inline std::string::size_type InternalStringFindFirstOf2(Tleft s, Tright chars)// this func does conversion to the biggest type
+  {
+		if(sizeof(CharL) > sizeof(CharR))
+		{
+			std::basic_string<CharL> temp;
+			StringConvert(chars, temp);
+			return StringFindFirstOf(s, temp);
+		}
+		else
+		{
+			std::basic_string<CharR> temp;
+			StringConvert(s, temp);
+			return StringFindFirstOf(temp, chars);
+		}
+  }
+  template<typename CharL, typename CharR>
+	inline std::string::size_type StringFindFirstOf(const CharL* s, const CharR* chars)
+  {
+		return InternalStringFindFirstOf2<CharL, CharR>(s, chars);
+  }
+  template<typename CharL, typename CharR>
+	inline std::string::size_type StringFindFirstOf(const CharL* s, const std::basic_string<CharR>& chars)
+  {
+		return InternalStringFindFirstOf2<CharL, CharR>(s, chars);
+  }
+  template<typename CharL, typename CharR>
+	inline std::string::size_type StringFindFirstOf(const std::basic_string<CharL>& s, const CharR* chars)
+  {
+		return InternalStringFindFirstOf2<CharL, CharR>(s, chars);
+  }
+  template<typename CharL, typename CharR>
+	inline std::string::size_type StringFindFirstOf(const std::basic_string<CharL>& s, const std::basic_string<CharR>& chars)
+  {
+		return InternalStringFindFirstOf2<CharL, CharR>(s, chars);
+  }
+
+
+	// StringFindLastOf. --------------------------------------------------------------------------------------
+	template<typename TiteratorType, typename TstrType, typename TcharsType>
+  inline std::string::size_type InternalStringFindLastOf1(TstrType str, TcharsType chars)
+  {
+		size_t len = StringLength(str);
+		if(0 == len)
+	    return std::string::npos;
+		std::string::size_type ret = len - 1;
+		TiteratorType it = StringBegin(str) + ret;// last char
+		while(true)
+		{
+			if(StringContainsChar(chars, *it))// we don't want to do a conversion here
+				return ret;
+			if(ret == 0)
+				break;
+			-- it;
+			-- ret;
+		}
+    return std::string::npos;
+  }
+	template<typename Char, typename TiteratorType, typename TstrType, typename TcharsType>
+	inline std::string::size_type InternalStringFindLastOf0(const TstrType& s, const TcharsType& chars)
+	{
+		if(StringLength(chars) >= StringCharSetThreshold)
+			return StringCharSet<Char>(chars).FindLast(s);
+		return InternalStringFindLastOf1<TiteratorType, const TstrType&, const TcharsType&>(s, chars);
+	}
+
+	// no-conversion cases
+  template<typename Char>
+	inline std::string::size_type StringFindLastOf(const Char* s, const Char* chars)
+  {
+		return InternalStringFindLastOf0<Char, const Char*>(s, chars);
+  }
+  template<typename Char>
+	inline std::string::size_type StringFindLastOf(const Char* s, const std::basic_string<Char>& chars)
+  {
+		return InternalStringFindLastOf0<Char, const Char*>(s, chars);
+  }
+  template<typename Char>
+	inline std::string::size_type StringFindLastOf(const std::basic_string<Char>& s, const Char* chars)
+  {
+		return InternalStringFindLastOf0<Char, typename std::basic_string<Char>::const_iterator>(s, chars);
+  }
+  template<typename Char>
+	inline std::string::size_type StringFindLastOf(const std::basic_string<Char>& s, const std::basic_string<Char>& chars)
+  {
+		return InternalStringFindLastOf0<Char, typename std::basic_string<Char>::const_iterator>(s, chars);
+  }
+  // prebuilt set
+  template<typename Char>
+	inline std::string::size_type StringFindLastOf(const Char* s, const StringCharSet<Char>& chars)
+  {
+		return chars.FindLast(s);
+  }
+  template<typename Char>
+	inline std::string::size_type StringFindLastOf(const std::basic_string<Char>& s, const StringCharSet<Char>& chars)
+  {
+		return chars.FindLast(s);
+  }
+
+	// conversion cases
+  template<typename CharL, typename CharR, typename Tleft, typename Tright>
+	inline std::string::size_type InternalStringFindLastOf2(Tleft s, Tright chars)
+  {
+		if(sizeof(CharL) > sizeof(CharR))
+		{
+			std::basic_string<CharL> temp;
+			StringConvert(chars, temp);
+			return StringFindLastOf(s, temp);
+		}
+		else
+		{
+			std::basic_string<CharR> temp;
+			StringConvert(s, temp);
+			return StringFindLastOf(temp, chars);
+		}
+  }
+  template<typename CharL, typename CharR>
+	inline std::string::size_type StringFindLastOf(const CharL* s, const CharR* chars)
+  {
+		return InternalStringFindLastOf2<CharL, CharR>(s, chars);
+  }
+  template<typename CharL, typename CharR>
+	inline std::string::size_type StringFindLastOf(const CharL* s, const std::basic_string<CharR>& chars)
+  {
+		return InternalStringFindLastOf2<CharL, CharR>(s, chars);
+  }
+  template<typename CharL, typename CharR>
+	inline std::string::size_type StringFindLastOf(const std::basic_string<CharL>& s, const CharR* chars)
+  {
+		return InternalStringFindLastOf2<CharL, CharR>(s, chars);
+  }
+  template<typename CharL, typename CharR>
+	inline std::string::size_type StringFindLastOf(const std::basic_string<CharL>& s, const std::basic_string<CharR>& chars)
+  {
+		return InternalStringFindLastOf2<CharL, CharR>(s, chars);
+  }
+
+
+	// StringSplit --------------------------------------------------------------------------------------
+	// splitting is done by ranges which hand out StringViews into the source, one token at a time, as you iterate.
+	// nothing is copied and nothing is allocated per token; the source must outlive the range.
+	// n separators give n + 1 tokens (so leading / trailing / doubled separators give empty tokens), except that an
+	// empty source gives no tokens at all, and an empty separator gives the whole source as one token.
+	//
+	//   for(auto it = StringSplitByChar(line, ','); ...)
+	//
+	// the output iterator versions (which copy each token into a std::basic_string) are built on these.
+
+	// separator finders. Find() returns the position of the next separator at or after start (or npos) and its length.
+	inline const char* FindChar(const char* s, size_t len, char c)
+	{
+		return (const char*)memchr(s, c, len);
+	}
+	template<typename Char>
+	inline const Char* FindChar(const Char* s, size_t len, Char c)
+	{
+		for(const Char* end = s + len; s != end; ++ s)
+		{
+			if(*s == c)
+				return s;
+		}
+		return 0;
+	}
+
+	template<typename Char>
+	struct StringSplitFinderChar
+	{
+		explicit StringSplitFinderChar(Char c_) : c(c_) { }
+		std::string::size_type Find(const Char* s, size_t len, size_t start, size_t& sepLen) const
+		{
+			sepLen = 1;
+			const Char* found = FindChar(s + start, len - start, c);
+			return found ? (std::string::size_type)(found - s) : std::string::npos;
+		}
+		Char c;
+	};
+
+	template<typename Char>
+	struct StringSplitFinderCharSet
+	{
+		explicit StringSplitFinderCharSet(const StringCharSet<Char>& set_) : set(set_) { }
+		std::string::size_type Find(const Char* s, size_t len, size_t start, size_t& sepLen) const
+		{
+			sepLen = 1;
+			std::string::size_type found = set.FindFirst(s + start, len - start);
+			return found == std::string::npos ? found : start + found;
+		}
+		StringCharSet<Char> set;
+	};
+
+	template<typename Char>
+	struct StringSplitFinderString
+	{
+		explicit StringSplitFinderString(const StringSearcher<Char>& searcher_) : searcher(searcher_) { }
+		std::string::size_type Find(const Char* s, size_t len, size_t start, size_t& sepLen) const
+		{
+			sepLen = searcher.Needle().size();
+			if(sepLen == 0)
+				return std::string::npos;
+			return searcher.Find(s, len, start);
+		}
+		StringSearcher<Char> searcher;
+	};
+
+	template<typename Char, typename Finder>
+	class StringSplitRange
+	{
+	public:
+		StringSplitRange(const Char* s, size_t len, const Finder& finder) :
+			m_s(s),
+			m_len(len),
+			m_finder(finder)
+		{
+		}
+
+		class iterator
+		{
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef StringView<Char> value_type;
+			typedef ptrdiff_t difference_type;
+			typedef const StringView<Char>* pointer;
+			typedef const StringView<Char>& reference;
+
+			iterator() :
+				m_range(0),
+				m_pos(0),
+				m_next(std::string::npos)
+			{
+			}
+
+			iterator(const StringSplitRange<Char, Finder>* range, size_t pos) :
+				m_range(range),
+				m_pos(pos),
+				m_next(std::string::npos)
+			{
+				Read();
+			}
+
+			reference operator *() const { return m_token; }
+			pointer operator ->() const { return &m_token; }
+
+			iterator& operator ++()
+			{
+				if(m_next == std::string::npos)
+				{
+					m_range = 0;// that was the last token
+				}
+				else
+				{
+					m_pos = m_next;
+					Read();
+				}
+				return *this;
+			}
+
+			iterator operator ++(int)
+			{
+				iterator ret(*this);
+				++ *this;
+				return ret;
+			}
+
+			bool operator ==(const iterator& rhs) const
+			{
+				if(m_range == 0 || rhs.m_range == 0)
+					return m_range == rhs.m_range;
+				return m_pos == rhs.m_pos;
+			}
+
+			bool operator !=(const iterator& rhs) const
+			{
+				return !(*this == rhs);
+			}
+
+		private:
+			void Read()
+			{
+				size_t sepLen;
+				std::string::size_type found = m_range->m_finder.Find(m_range->m_s, m_range->m_len, m_pos, sepLen);
+				if(found == std::string::npos)
+				{
+					m_token = StringView<Char>(m_range->m_s + m_pos, m_range->m_len - m_pos);
+					m_next = std::string::npos;
+				}
+				else
+				{
+					m_token = StringView<Char>(m_range->m_s + m_pos, found - m_pos);
+					m_next = found + sepLen;
+				}
+			}
+
+			const StringSplitRange<Char, Finder>* m_range;// 0 = end
+			size_t m_pos;
+			size_t m_next;// start of the next token, or npos if this is the last one
+			StringView<Char> m_token;
+		};
+		typedef iterator const_iterator;
+
+		iterator begin() const
+		{
+			return m_len == 0 ? iterator() : iterator(this, 0);
+		}
+
+		iterator end() const
+		{
+			return iterator();
+		}
+
+	private:
+		const Char* m_s;
+		size_t m_len;
+		Finder m_finder;
+	};
+
+	// by char
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderChar<Char> > StringSplitByChar(const Char* s, size_t len, Char sep)
+	{
+		return StringSplitRange<Char, StringSplitFinderChar<Char> >(s, len, StringSplitFinderChar<Char>(sep));
+	}
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderChar<Char> > StringSplitByChar(const Char* s, Char sep)
+	{
+		return StringSplitByChar(s, StringLength(s), sep);
+	}
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderChar<Char> > StringSplitByChar(const std::basic_string<Char>& s, Char sep)
+	{
+		return StringSplitByChar(s.c_str(), s.size(), sep);
+	}
+
+	// by any of a set of chars
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderCharSet<Char> > StringSplitByChars(const Char* s, size_t len, const StringCharSet<Char>& seps)
+	{
+		return StringSplitRange<Char, StringSplitFinderCharSet<Char> >(s, len, StringSplitFinderCharSet<Char>(seps));
+	}
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderCharSet<Char> > StringSplitByChars(const Char* s, const StringCharSet<Char>& seps)
+	{
+		return StringSplitByChars(s, StringLength(s), seps);
+	}
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderCharSet<Char> > StringSplitByChars(const std::basic_string<Char>& s, const StringCharSet<Char>& seps)
+	{
+		return StringSplitByChars(s.c_str(), s.size(), seps);
+	}
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderCharSet<Char> > StringSplitByChars(const Char* s, const Char* seps)
+	{
+		return StringSplitByChars(s, StringLength(s), StringCharSet<Char>(seps));
+	}
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderCharSet<Char> > StringSplitByChars(const std::basic_string<Char>& s, const Char* seps)
+	{
+		return StringSplitByChars(s.c_str(), s.size(), StringCharSet<Char>(seps));
+	}
+
+	// by a whole string
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderString<Char> > StringSplitByString(const Char* s, size_t len, const StringSearcher<Char>& sep)
+	{
+		return StringSplitRange<Char, StringSplitFinderString<Char> >(s, len, StringSplitFinderString<Char>(sep));
+	}
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderString<Char> > StringSplitByString(const Char* s, const Char* sep)
+	{
+		return StringSplitByString(s, StringLength(s), StringSearcher<Char>(sep));
+	}
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderString<Char> > StringSplitByString(const Char* s, const std::basic_string<Char>& sep)
+	{
+		return StringSplitByString(s, StringLength(s), StringSearcher<Char>(sep));
+	}
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderString<Char> > StringSplitByString(const std::basic_string<Char>& s, const Char* sep)
+	{
+		return StringSplitByString(s.c_str(), s.size(), StringSearcher<Char>(sep));
+	}
+	template<typename Char>
+	inline StringSplitRange<Char, StringSplitFinderString<Char> > StringSplitByString(const std::basic_string<Char>& s, const std::basic_string<Char>& sep)
+	{
+		return StringSplitByString(s.c_str(), s.size(), StringSearcher<Char>(sep));
+	}
+
+	// copies each token of a split range into dest
+	template<typename Char, typename Finder, class OutIt>
+	inline void InternalStringSplitCopy(const StringSplitRange<Char, Finder>& range, OutIt dest)
+	{
+		for(typename StringSplitRange<Char, Finder>::iterator it = range.begin(); it != range.end(); ++ it)
+		{
+			*dest = it->str();
 			++ dest;
 		}
-		return;
+	}
+
+	template<typename Char, class OutIt>
+	inline void StringSplitByChar(const Char* s, Char sep, OutIt dest)
+	{
+		InternalStringSplitCopy(StringSplitByChar(s, sep), dest);
+	}
+	template<typename Char, class OutIt>
+	inline void StringSplitByChar(const std::basic_string<Char>& s, Char sep, OutIt dest)
+	{
+		InternalStringSplitCopy(StringSplitByChar(s, sep), dest);
+	}
+	template<typename Char, class OutIt>
+	inline void StringSplitByChars(const Char* s, const Char* seps, OutIt dest)
+	{
+		InternalStringSplitCopy(StringSplitByChars(s, seps), dest);
+	}
+	template<typename Char, class OutIt>
+	inline void StringSplitByChars(const std::basic_string<Char>& s, const Char* seps, OutIt dest)
+	{
+		InternalStringSplitCopy(StringSplitByChars(s, seps), dest);
+	}
+
+	// no-conversion cases
+  template<typename Char, class OutIt>
+	inline void StringSplitByString(const std::basic_string<Char>& s, const std::basic_string<Char>& sep, OutIt dest)
+  {
+		InternalStringSplitCopy(StringSplitByString(s, sep), dest);
+  }
+  template<typename Char, class OutIt>
+	inline void StringSplitByString(const std::basic_string<Char>& s, const Char* sep, OutIt dest)
+  {
+		InternalStringSplitCopy(StringSplitByString(s, sep), dest);
+  }
+  template<typename Char, class OutIt>
+	inline void StringSplitByString(const Char* s, const std::basic_string<Char>& sep, OutIt dest)
+  {
+		InternalStringSplitCopy(StringSplitByString(s, sep), dest);
+  }
+  template<typename Char, class OutIt>
+	inline void StringSplitByString(const Char* s, const Char* sep, OutIt dest)
+  {
+		InternalStringSplitCopy(StringSplitByString(s, sep), dest);
+  }
+	// conversion cases.
+	// note that because we cannot possibly convert output strings to that which the destination iterator wants,
+	// then we can ONLY convert the separator
+  template<typename CharL, typename CharR, typename Tleft, typename Tright, typename TOutIt>
+	inline void InternalStringSplitByString2(Tleft in, Tright sep, TOutIt dest)
+  {
+		std::basic_string<CharL> temp;
+		StringConvert(sep, temp);
+		StringSplitByString(in, temp, dest);
+  }
+  template<typename CharL, typename CharR, typename TOutIt>
+	inline void StringSplitByString(const CharL* in, const CharR* sep, TOutIt dest)
+  {
+		InternalStringSplitByString2<CharL, CharR>(in, sep, dest);
+  }
+  template<typename CharL, typename CharR, typename TOutIt>
+	inline void StringSplitByString(const CharL* in, const std::basic_string<CharR>& sep, TOutIt dest)
+  {
+		InternalStringSplitByString2<CharL, CharR>(in, sep, dest);
+  }
+  template<typename CharL, typename CharR, typename TOutIt>
+	inline void StringSplitByString(const std::basic_string<CharL>& in, const CharR* sep, TOutIt dest)
+  {
+		InternalStringSplitByString2<CharL, CharR>(in, sep, dest);
+  }
+  template<typename CharL, typename CharR, typename TOutIt>
+	inline void StringSplitByString(const std::basic_string<CharL>& in, const std::basic_string<CharR>& sep, TOutIt dest)
+  {
+		InternalStringSplitByString2<CharL, CharR>(in, sep, dest);
+  }
+
+
+	// StringJoin --------------------------------------------------------------------------------------
+	// ability to join from / to mismatching strings, with appropriate conversion.
+	// the first pass measures everything (including separators and conversion), so the result is allocated once and
+	// each element is converted straight into place. the iterators are walked twice, so they must be forward iterators.
+	template<typename Char>
+	inline StringView<Char> InternalStringJoinView(const std::basic_string<Char>& s)
+	{
+		return StringView<Char>(s);
+	}
+	template<typename Char>
+	inline StringView<Char> InternalStringJoinView(const Char* s)
+	{
+		return StringView<Char>(s, StringLength(s));
+	}
+	template<typename Char>
+	inline StringView<Char> InternalStringJoinView(const StringView<Char>& s)
+	{
+		return s;
+	}
+
+	template<typename CharOut, typename Element>
+	inline size_t InternalStringJoinMeasure(const Element& e)
+	{
+		return StringConvertInto(InternalStringJoinView(e).data(), InternalStringJoinView(e).size(), (CharOut*)0, 0);
+	}
+
+	template<typename CharOut, typename Element>
+	inline CharOut* InternalStringJoinCopy(const Element& e, CharOut* out, size_t outLen)
+	{
+		return out + StringConvertInto(InternalStringJoinView(e).data(), InternalStringJoinView(e).size(), out, outLen);
+	}
+
+  template<typename Char, typename TSep, typename InIt>
+  inline std::basic_string<Char> InternalStringJoin(InIt start, InIt end, TSep sep_)
+  {
+		std::basic_string<Char> sep;
+		StringConvert(sep_, sep);
+
+		size_t total = 0;
+		size_t count = 0;
+		for(InIt it = start; it != end; ++ it, ++ count)
+		{
+			total += InternalStringJoinMeasure<Char>(*it);
+		}
+		if(count > 1)
+		{
+			total += sep.size() * (count - 1);
+		}
+
+    std::basic_string<Char> r;
+		if(total == 0)
+			return r;
+		r.resize(total);
+		Char* out = &r[0];
+		Char* outEnd = out + total;
+    while(start != end)
+    {
+			out = InternalStringJoinCopy(*start, out, outEnd - out);
+      ++ start;
+      if(start != end)
+      {
+				memcpy(out, sep.c_str(), sep.size() * sizeof(Char));
+				out += sep.size();
+      }
+    }
+    return r;
+  }
+
+	// StringJoinParallel --------------------------------------------------------------------------------------
+	// for huge random access ranges. workers measure their slice of elements, the offsets are prefix-summed, then the
+	// workers convert & copy their slices into the one output buffer concurrently.
+	// threads = 0 means 1 per hardware thread. small ranges are just joined on this thread.
+  template<typename Char, typename TSep, typename RanIt>
+  inline std::basic_string<Char> InternalStringJoinParallel(RanIt start, RanIt end, TSep sep_, size_t threads)
+  {
+		const size_t MinElementsPerThread = 4096;
+		const size_t count = (size_t)(end - start);
+		if(threads == 0)
+			threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+		if(threads > count / MinElementsPerThread)
+			threads = count / MinElementsPerThread;
+		if(threads <= 1)
+			return InternalStringJoin<Char>(start, end, sep_);
+
+		std::basic_string<Char> sep;
+		StringConvert(sep_, sep);
+		const size_t sepLen = sep.size();
+		const size_t perThread = (count + threads - 1) / threads;
+
+		// offsets[i] = where element i goes in the output
+		std::vector<size_t> offsets(count + 1);
+		{
+			std::vector<std::thread> workers;
+			for(size_t t = 0; t < threads; ++ t)
+			{
+				workers.push_back(std::thread([&, t]()
+				{
+					size_t last = (t + 1) * perThread < count ? (t + 1) * perThread : count;
+					for(size_t i = t * perThread; i < last; ++ i)
+					{
+						offsets[i + 1] = InternalStringJoinMeasure<Char>(start[i]) + (i + 1 < count ? sepLen : 0);
+					}
+				}));
+			}
+			for(size_t t = 0; t < threads; ++ t)
+				workers[t].join();
+		}
+		offsets[0] = 0;
+		for(size_t i = 0; i < count; ++ i)
+		{
+			offsets[i + 1] += offsets[i];
+		}
+
+    std::basic_string<Char> r;
+		if(offsets[count] == 0)
+			return r;
+		r.resize(offsets[count]);
+		Char* out = &r[0];
+		{
+			std::vector<std::thread> workers;
+			for(size_t t = 0; t < threads; ++ t)
+			{
+				workers.push_back(std::thread([&, t]()
+				{
+					size_t last = (t + 1) * perThread < count ? (t + 1) * perThread : count;
+					for(size_t i = t * perThread; i < last; ++ i)
+					{
+						Char* p = InternalStringJoinCopy(start[i], out + offsets[i], offsets[i + 1] - offsets[i]);
+						if(i + 1 < count)
+							memcpy(p, sep.c_str(), sepLen * sizeof(Char));
+					}
+				}));
+			}
+			for(size_t t = 0; t < threads; ++ t)
+				workers[t].join();
+		}
+    return r;
+  }
+  template<typename RanIt, typename Char>
+  inline std::basic_string<Char> StringJoinParallel(RanIt start, RanIt end, const std::basic_string<Char>& sep, size_t threads = 0)
+  {
+		return InternalStringJoinParallel<Char>(start, end, sep, threads);
+	}
+  template<typename RanIt, typename Char>
+  inline std::basic_string<Char> StringJoinParallel(RanIt start, RanIt end, const Char* sep, size_t threads = 0)
+  {
+		return InternalStringJoinParallel<Char>(start, end, sep, threads);
+	}
+
+	// no-conversion cases
+  template<typename InIt, typename Char>
+  inline std::basic_string<Char> StringJoin(InIt start, InIt end, const std::basic_string<Char>& sep)
+  {
+		return InternalStringJoin<Char>(start, end, sep);
+	}
+  template<typename InIt, typename Char>
+  inline std::basic_string<Char> StringJoin(InIt start, InIt end, const Char* sep)
+  {
+		return InternalStringJoin<Char>(start, end, sep);
+	}
+	// conversion cases... probably not that usable
+  template<typename CharRet, typename CharSep, typename InIt>
+  inline std::basic_string<CharRet> StringJoin(InIt start, InIt end, const std::basic_string<CharSep>& sep)
+  {
+		return InternalStringJoin<CharRet>(start, end, sep);
+	}
+  template<typename CharRet, typename CharSep, typename InIt>
+  inline std::basic_string<CharRet> StringJoin(InIt start, InIt end, const CharSep* sep)
+  {
+		return InternalStringJoin<CharRet>(start, end, sep);
+	}
+  
+	// StringTrim --------------------------------------------------------------------------------------
+	// StringTrimView returns the part of s without leading & trailing trim chars, without copying (so s must outlive
+	// the view); StringTrimInPlace erases them from a string. StringTrim returns a new string like it always has.
+	// trim sets are classified 16 code units at a time with a StringCharSet bitmap. with no trim set, ASCII whitespace
+	// (space, \t \n \v \f \r) is trimmed, which has its own SSE2 classifier.
+	template<typename Char>
+	inline bool CharIsAsciiWhitespace(Char c)
+	{
+		return c == ' ' || CharSetIndex(c) - 9 <= 4;// 9-13 = \t \n \v \f \r. below 9 wraps around.
+	}
+
+#if LIBCC_SSE2 == 1
+	// bit per code unit which is ASCII whitespace, for 16 code units of 1 or 2 bytes.
+	template<typename Char>
+	inline unsigned int InternalWhitespace16(const Char* s)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		if(sizeof(Char) == 1)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+			__m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+			__m128i control = _mm_cmpeq_epi8(_mm_subs_epu8(_mm_sub_epi8(v, _mm_set1_epi8(9)), _mm_set1_epi8(4)), zero);
+			return (unsigned int)_mm_movemask_epi8(_mm_or_si128(space, control));
+		}
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 8));
+		__m128i space = _mm_set1_epi16(' ');
+		__m128i nine = _mm_set1_epi16(9);
+		__m128i four = _mm_set1_epi16(4);
+		__m128i wsA = _mm_or_si128(_mm_cmpeq_epi16(a, space), _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(a, nine), four), zero));
+		__m128i wsB = _mm_or_si128(_mm_cmpeq_epi16(b, space), _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(b, nine), four), zero));
+		return (unsigned int)_mm_movemask_epi8(_mm_packs_epi16(wsA, wsB));
+	}
+#endif
+
+	// index of the first non-whitespace code unit, or len
+	template<typename Char>
+	inline size_t InternalSkipWhitespace(const Char* s, size_t len)
+	{
+		size_t i = 0;
+#if LIBCC_SSE2 == 1
+		if(sizeof(Char) <= 2)
+		{
+			for(; i + 16 <= len; i += 16)
+			{
+				unsigned int m = ~InternalWhitespace16(s + i) & 0xffff;
+				if(m)
+					return i + LowestBitIndex(m);
+			}
+		}
+#endif
+		for(; i < len; ++ i)
+		{
+			if(!CharIsAsciiWhitespace(s[i]))
+				return i;
+		}
+		return len;
+	}
+
+	// one past the last non-whitespace code unit, or 0
+	template<typename Char>
+	inline size_t InternalSkipWhitespaceReverse(const Char* s, size_t len)
+	{
+		size_t end = len;
+#if LIBCC_SSE2 == 1
+		if(sizeof(Char) <= 2)
+		{
+			for(; end >= 16; end -= 16)
+			{
+				unsigned int m = ~InternalWhitespace16(s + end - 16) & 0xffff;
+				if(m)
+					return end - 15 + HighestBitIndex(m);
+			}
+		}
+#endif
+		for(; end > 0; -- end)
+		{
+			if(!CharIsAsciiWhitespace(s[end - 1]))
+				return end;
+		}
+		return 0;
+	}
+
+	// whitespace
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const Char* s, size_t len)
+  {
+		size_t first = InternalSkipWhitespace(s, len);
+		if(first == len)
+			return StringView<Char>(s + len, 0);
+		size_t end = InternalSkipWhitespaceReverse(s + first, len - first) + first;
+		return StringView<Char>(s + first, end - first);
+  }
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const Char* s)
+  {
+		return StringTrimView(s, StringLength(s));
+  }
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const std::basic_string<Char>& s)
+  {
+		return StringTrimView(s.c_str(), s.size());
+  }
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const StringView<Char>& s)
+  {
+		return StringTrimView(s.data(), s.size());
+  }
+	// trim set
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const Char* s, size_t len, const StringCharSet<Char>& chars)
+  {
+		std::string::size_type first = chars.FindFirstNot(s, len);
+		if(first == std::string::npos)
+			return StringView<Char>(s + len, 0);
+		std::string::size_type last = chars.FindLastNot(s + first, len - first) + first;
+		return StringView<Char>(s + first, last + 1 - first);
+  }
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const Char* s, const StringCharSet<Char>& chars)
+  {
+		return StringTrimView(s, StringLength(s), chars);
+  }
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const std::basic_string<Char>& s, const StringCharSet<Char>& chars)
+  {
+		return StringTrimView(s.c_str(), s.size(), chars);
+  }
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const StringView<Char>& s, const StringCharSet<Char>& chars)
+  {
+		return StringTrimView(s.data(), s.size(), chars);
+  }
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const Char* s, const Char* chars)
+  {
+		return StringTrimView(s, StringLength(s), StringCharSet<Char>(chars));
+  }
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const Char* s, const std::basic_string<Char>& chars)
+  {
+		return StringTrimView(s, StringLength(s), StringCharSet<Char>(chars));
+  }
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const std::basic_string<Char>& s, const Char* chars)
+  {
+		return StringTrimView(s.c_str(), s.size(), StringCharSet<Char>(chars));
+  }
+  template<typename Char>
+  inline StringView<Char> StringTrimView(const std::basic_string<Char>& s, const std::basic_string<Char>& chars)
+  {
+		return StringTrimView(s.c_str(), s.size(), StringCharSet<Char>(chars));
+  }
+
+	// in place
+  template<typename Char>
+  inline void InternalStringTrimInPlace(std::basic_string<Char>& s, const StringView<Char>& keep)
+  {
+		size_t first = keep.data() - s.c_str();
+		s.erase(first + keep.size());
+		s.erase(0, first);
+  }
+  template<typename Char>
+  inline void StringTrimInPlace(std::basic_string<Char>& s)
+  {
+		InternalStringTrimInPlace(s, StringTrimView(s));
+  }
+  template<typename Char>
+  inline void StringTrimInPlace(std::basic_string<Char>& s, const StringCharSet<Char>& chars)
+  {
+		InternalStringTrimInPlace(s, StringTrimView(s, chars));
+  }
+  template<typename Char>
+  inline void StringTrimInPlace(std::basic_string<Char>& s, const Char* chars)
+  {
+		InternalStringTrimInPlace(s, StringTrimView(s, chars));
+  }
+  template<typename Char>
+  inline void StringTrimInPlace(std::basic_string<Char>& s, const std::basic_string<Char>& chars)
+  {
+		InternalStringTrimInPlace(s, StringTrimView(s, chars));
+  }
+
+	// no-conversion cases
+  template<typename Char>
+  inline std::basic_string<Char> StringTrim(const std::basic_string<Char>& s, const std::basic_string<Char>& chars)
+  {
+		return StringTrimView(s, chars).str();
+  }
+  template<typename Char>
+  inline std::basic_string<Char> StringTrim(const Char* s, const std::basic_string<Char>& chars)
+  {
+		return StringTrimView(s, chars).str();
+  }
+  template<typename Char>
+  inline std::basic_string<Char> StringTrim(const std::basic_string<Char>& s, const Char* chars)
+  {
+		return StringTrimView(s, chars).str();
+  }
+  template<typename Char>
+  inline std::basic_string<Char> StringTrim(const Char* s, const Char* chars)
+  {
+		return StringTrimView(s, chars).str();
+  }
+	// conversion cases
+  template<typename CharLeft, typename CharRight>
+  inline std::basic_string<CharLeft> StringTrim(const std::basic_string<CharLeft>& s, const std::basic_string<CharRight>& chars)
+  {
+		std::basic_string<CharLeft> temp;
+		StringConvert(chars, temp);
+		return StringTrimView(s, temp).str();
+  }
+  template<typename CharLeft, typename CharRight>
+  inline std::basic_string<CharLeft> StringTrim(const CharLeft* s, const std::basic_string<CharRight>& chars)
+  {
+		std::basic_string<CharLeft> temp;
+		StringConvert(chars, temp);
+		return StringTrimView(s, temp).str();
+  }
+  template<typename CharLeft, typename CharRight>
+  inline std::basic_string<CharLeft> StringTrim(const std::basic_string<CharLeft>& s, const CharRight* chars)
+  {
+		std::basic_string<CharLeft> temp;
+		StringConvert(chars, temp);
+		return StringTrimView(s, temp).str();
+  }
+  template<typename CharLeft, typename CharRight>
+  inline std::basic_string<CharLeft> StringTrim(const CharLeft* s, const CharRight* chars)
+  {
+		std::basic_string<CharLeft> temp;
+		StringConvert(chars, temp);
+		return StringTrimView(s, temp).str();
+  }
+
+
+	// StringReplace --------------------------------------------------------------------------------------
+	// the first pass counts matches so the result is allocated exactly once, the second pass fills it in.
+  template<typename Char>
+  inline std::basic_string<Char> StringReplace(const std::basic_string<Char>& src, const StringSearcher<Char>& search, const std::basic_string<Char>& replaceString)
+  {
+		const size_t searchLen = search.Needle().size();
+		if(searchLen == 0) return src;// you can't have a 0 length search string.
+    typedef std::basic_string<Char> _String;
+		const Char* s = src.c_str();
+		const size_t len = src.size();
+
+		size_t count = 0;
+		for(size_t found = search.Find(s, len, 0); found != _String::npos; found = search.Find(s, len, found + searchLen))
+		{
+			count ++;
+		}
+		if(count == 0)
+			return src;
+
+    _String r;
+		r.resize(len - count * searchLen + count * replaceString.size());
+		Char* out = &r[0];
+    size_t pos = 0;
+		for(size_t found = search.Find(s, len, 0); found != _String::npos; found = search.Find(s, len, pos))
+		{
+			memcpy(out, s + pos, (found - pos) * sizeof(Char));// chunk from src
+			out += found - pos;
+			if(!replaceString.empty())
+			{
+				memcpy(out, replaceString.c_str(), replaceString.size() * sizeof(Char));// replacement
+			}
+			out += replaceString.size();
+			pos = found + searchLen;// advance
+		}
+		memcpy(out, s + pos, (len - pos) * sizeof(Char));// remainder of src
+		return r;
+  }
+  template<typename Char>
+  inline std::basic_string<Char> StringReplace(const std::basic_string<Char>& src, const std::basic_string<Char>& searchString, const std::basic_string<Char>& replaceString)
+  {
+		if(searchString.empty()) return src;
+		return StringReplace(src, StringSearcher<Char>(searchString), replaceString);
+  }
+  template<typename Char>// these overloads help compile with constant strings
+  inline std::basic_string<Char> StringReplace(const std::basic_string<Char>& src, const std::basic_string<Char>& searchString, const Char* replaceString)
+  {
+		return StringReplace(src, searchString, std::basic_string<Char>(replaceString));
+	}
+  template<typename Char>
+  inline std::basic_string<Char> StringReplace(const std::basic_string<Char>& src, const Char* searchString, const std::basic_string<Char>& replaceString)
+  {
+		return StringReplace(src, std::basic_string<Char>(searchString), replaceString);
+	}
+  template<typename Char>
+  inline std::basic_string<Char> StringReplace(const std::basic_string<Char>& src, const Char* searchString, const Char* replaceString)
+  {
+		return StringReplace(src, std::basic_string<Char>(searchString), std::basic_string<Char>(replaceString));
+	}
+  template<typename Char>
+  inline std::basic_string<Char> StringReplace(const Char* src, const std::basic_string<Char>& searchString, const std::basic_string<Char>& replaceString)
+  {
+		return StringReplace(std::basic_string<Char>(src), searchString, replaceString);
+	}
+  template<typename Char>
+  inline std::basic_string<Char> StringReplace(const Char* src, const std::basic_string<Char>& searchString, const Char* replaceString)
+  {
+		return StringReplace(std::basic_string<Char>(src), searchString, std::basic_string<Char>(replaceString));
+	}
+  template<typename Char>
+  inline std::basic_string<Char> StringReplace(const Char* src, const Char* searchString, const std::basic_string<Char>& replaceString)
+  {
+		return StringReplace(std::basic_string<Char>(src), std::basic_string<Char>(searchString), replaceString);
+	}
+  template<typename Char>
+  inline std::basic_string<Char> StringReplace(const Char* src, const Char* searchString, const Char* replaceString)
+  {
+		return StringReplace(std::basic_string<Char>(src), std::basic_string<Char>(searchString), std::basic_string<Char>(replaceString));
+	}
+
+	// StringReplaceMany --------------------------------------------------------------------------------------
+	// applies a whole set of replacements in one pass over the input, using an Aho-Corasick automaton which is built
+	// once by StringReplacer and can be reused.
+	// unlike chained StringReplace calls, replacements only ever see the original text: where matches overlap, the one
+	// starting first wins, and of those the longest.
+	template<typename Char>
+	class StringReplacer
+	{
+	public:
+		typedef std::basic_string<Char> _String;
+		typedef std::pair<_String, _String> Replacement;
+
+		StringReplacer()
+		{
+			Assign((const Replacement*)0, (const Replacement*)0);
+		}
+
+		explicit StringReplacer(const std::vector<Replacement>& replacements)
+		{
+			Assign(replacements.begin(), replacements.end());
+		}
+
+		StringReplacer(std::initializer_list<Replacement> replacements)
+		{
+			Assign(replacements.begin(), replacements.end());
+		}
+
+		// empty "from" strings are ignored. if the same "from" appears twice, the first one is used.
+		template<typename It>
+		void Assign(It begin, It end)
+		{
+			m_replacements.assign(begin, end);
+			m_classCount = 1;// class 0 is every char which doesn't appear in any pattern
+			memset(m_byteClass, 0, sizeof(m_byteClass));
+			m_wideClass.clear();
+			m_firstChars.Clear();
+
+			// assign char classes
+			for(size_t r = 0; r < m_replacements.size(); ++ r)
+			{
+				const _String& from = m_replacements[r].first;
+				for(size_t i = 0; i < from.size(); ++ i)
+				{
+					if(ClassOf(from[i]) == 0)
+						AddClass(from[i]);
+				}
+			}
+
+			// trie
+			m_delta.assign(m_classCount, -1);
+			m_depth.assign(1, 0);
+			m_output.assign(1, -1);
+			for(size_t r = 0; r < m_replacements.size(); ++ r)
+			{
+				const _String& from = m_replacements[r].first;
+				if(from.empty())
+					continue;
+				int state = 0;
+				for(size_t i = 0; i < from.size(); ++ i)
+				{
+					int& next = m_delta[state * m_classCount + ClassOf(from[i])];
+					if(next == -1)
+					{
+						next = (int)m_depth.size();
+						m_depth.push_back(m_depth[state] + 1);
+						m_output.push_back(-1);
+						m_delta.resize(m_delta.size() + m_classCount, -1);
+					}
+					state = m_delta[state * m_classCount + ClassOf(from[i])];
+				}
+				if(m_output[state] == -1)
+					m_output[state] = (int)r;
+				m_firstChars.Add(from[0]);
+			}
+
+			// failure links, breadth first, folded straight into the transition table so matching never follows them.
+			// m_output becomes the longest pattern which is a suffix of each state.
+			std::vector<int> fail(m_depth.size(), 0);
+			std::vector<int> queue;
+			queue.reserve(m_depth.size());
+			for(size_t c = 0; c < m_classCount; ++ c)
+			{
+				int& next = m_delta[c];
+				if(next == -1)
+					next = 0;
+				else
+					queue.push_back(next);
+			}
+			for(size_t q = 0; q < queue.size(); ++ q)
+			{
+				int u = queue[q];
+				if(m_output[u] == -1)
+					m_output[u] = m_output[fail[u]];
+				for(size_t c = 0; c < m_classCount; ++ c)
+				{
+					int& next = m_delta[u * m_classCount + c];
+					int viaFail = m_delta[fail[u] * m_classCount + c];
+					if(next == -1)
+					{
+						next = viaFail;
+					}
+					else
+					{
+						fail[next] = viaFail;
+						queue.push_back(next);
+					}
+				}
+			}
+		}
+
+		_String Replace(const Char* s, size_t len) const
+		{
+			// matching pass; finds the matches and the exact output size.
+			std::vector<std::pair<size_t, int> > matches;// position, replacement index
+			size_t outLen = len;
+			size_t pendingStart = 0;
+			int pending = -1;
+			int state = 0;
+			size_t i = 0;
+			while(true)
+			{
+				if(state == 0 && pending == -1 && i < len)
+				{
+					// nothing in progress; skip ahead to the next char which can start a match
+					std::string::size_type skip = m_firstChars.FindFirst(s + i, len - i);
+					if(skip == std::string::npos)
+						break;
+					i += skip;
+				}
+				if(i < len)
+				{
+					state = m_delta[state * m_classCount + ClassOf(s[i])];
+					int r = m_output[state];
+					if(r != -1)
+					{
+						size_t start = i + 1 - m_replacements[r].first.size();
+						if(pending == -1 || start < pendingStart || (start == pendingStart && m_replacements[r].first.size() > m_replacements[pending].first.size()))
+						{
+							pending = r;
+							pendingStart = start;
+						}
+					}
+					// can anything still in progress start at or before the pending match? if not, it's final.
+					if(pending == -1 || i + 1 - m_depth[state] <= pendingStart)
+					{
+						++ i;
+						continue;
+					}
+				}
+				else if(pending == -1)
+				{
+					break;
+				}
+
+				// commit the pending match and resume right after it.
+				matches.push_back(std::make_pair(pendingStart, pending));
+				outLen += m_replacements[pending].second.size();
+				outLen -= m_replacements[pending].first.size();
+				i = pendingStart + m_replacements[pending].first.size();
+				pending = -1;
+				state = 0;
+			}
+
+			// fill pass
+			_String ret;
+			if(matches.empty())
+			{
+				ret.assign(s, len);
+				return ret;
+			}
+			ret.resize(outLen);
+			Char* out = &ret[0];
+			size_t pos = 0;
+			for(size_t m = 0; m < matches.size(); ++ m)
+			{
+				const Replacement& r = m_replacements[matches[m].second];
+				size_t chunk = matches[m].first - pos;
+				memcpy(out, s + pos, chunk * sizeof(Char));
+				out += chunk;
+				if(!r.second.empty())
+					memcpy(out, r.second.c_str(), r.second.size() * sizeof(Char));
+				out += r.second.size();
+				pos = matches[m].first + r.first.size();
+			}
+			memcpy(out, s + pos, (len - pos) * sizeof(Char));
+			return ret;
+		}
+
+		_String Replace(const _String& s) const
+		{
+			return Replace(s.c_str(), s.size());
+		}
+
+		_String Replace(const Char* s) const
+		{
+			return Replace(s, StringLength(s));
+		}
+
+	private:
+		std::vector<Replacement> m_replacements;
+		size_t m_classCount;
+		int m_byteClass[256];
+		std::vector<std::pair<unsigned long, int> > m_wideClass;// sorted, for code units >= 256
+		std::vector<int> m_delta;// [state * m_classCount + class] -> state
+		std::vector<int> m_depth;
+		std::vector<int> m_output;// replacement index or -1
+		StringCharSet<Char> m_firstChars;
+
+		int ClassOf(Char c) const
+		{
+			unsigned long u = CharSetIndex(c);
+			if(u < 256)
+				return m_byteClass[u];
+			std::vector<std::pair<unsigned long, int> >::const_iterator it = std::lower_bound(m_wideClass.begin(), m_wideClass.end(), std::make_pair(u, 0));
+			return (it != m_wideClass.end() && it->first == u) ? it->second : 0;
+		}
+
+		void AddClass(Char c)
+		{
+			unsigned long u = CharSetIndex(c);
+			if(u < 256)
+				m_byteClass[u] = (int)m_classCount;
+			else
+				m_wideClass.insert(std::lower_bound(m_wideClass.begin(), m_wideClass.end(), std::make_pair(u, 0)), std::make_pair(u, (int)m_classCount));
+			++ m_classCount;
+		}
+	};
+
+	template<typename Char>
+	inline std::basic_string<Char> StringReplaceMany(const std::basic_string<Char>& src, const StringReplacer<Char>& replacer)
+	{
+		return replacer.Replace(src);
+	}
+	template<typename Char>
+	inline std::basic_string<Char> StringReplaceMany(const Char* src, const StringReplacer<Char>& replacer)
+	{
+		return replacer.Replace(src);
+	}
+	template<typename Char>
+	inline std::basic_string<Char> StringReplaceMany(const std::basic_string<Char>& src, std::initializer_list<std::pair<std::basic_string<Char>, std::basic_string<Char> > > replacements)
+	{
+		return StringReplacer<Char>(replacements).Replace(src);
+	}
+	template<typename Char>
+	inline std::basic_string<Char> StringReplaceMany(const Char* src, std::initializer_list<std::pair<std::basic_string<Char>, std::basic_string<Char> > > replacements)
+	{
+		return StringReplacer<Char>(replacements).Replace(src);
+	}
+
+	// StringToUpper / StringToLower --------------------------------------------------------------------------------------
+	// ASCII is mapped a whole block at a time (16 bytes with SSE2, 32 with AVX2). blocks with anything else in them
+	// go through CharToUpper / CharToLower per code unit. under LIBCC_UTF8, char strings with non-ASCII in them are
+	// mapped as UTF-16, because the UTF-8 length of a character can change.
+#if LIBCC_SSE2 == 1
+	// v holds 16 / 8 code units of unitSize bytes
+	inline bool InternalIsAscii16(__m128i v, size_t unitSize)
+	{
+		if(unitSize == 1)
+			return _mm_movemask_epi8(v) == 0;
+		return _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16((short)0xff80)), _mm_setzero_si128())) == 0xffff;
+	}
+
+	// flips the case bit of the letters in [first, first + 25]
+	inline __m128i InternalAsciiCaseMap16(__m128i v, size_t unitSize, CaseMapping mapping)
+	{
+		const int first = mapping == CaseMappingUpper ? 'a' : 'A';
+		if(unitSize == 1)
+		{
+			__m128i letters = _mm_cmpgt_epi8(_mm_set1_epi8((char)(-128 + 26)), _mm_add_epi8(v, _mm_set1_epi8((char)(-128 - first))));
+			return _mm_xor_si128(v, _mm_and_si128(letters, _mm_set1_epi8(0x20)));
+		}
+		__m128i letters = _mm_cmpgt_epi16(_mm_set1_epi16((short)(-32768 + 26)), _mm_add_epi16(v, _mm_set1_epi16((short)(-32768 - first))));
+		return _mm_xor_si128(v, _mm_and_si128(letters, _mm_set1_epi16(0x20)));
+	}
+#endif
+
+#if LIBCC_AVX2 == 1
+	inline __m256i InternalAsciiCaseMap32(__m256i v, CaseMapping mapping)
+	{
+		const int first = mapping == CaseMappingUpper ? 'a' : 'A';
+		__m256i letters = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + 26)), _mm256_add_epi8(v, _mm256_set1_epi8((char)(-128 - first))));
+		return _mm256_xor_si256(v, _mm256_and_si256(letters, _mm256_set1_epi8(0x20)));
+	}
+#endif
+
+	// maps whole blocks while they're pure ASCII; returns the number of code units done.
+	template<typename Char>
+	inline size_t InternalAsciiCaseMapBlocks(const Char* in, Char* out, size_t len, CaseMapping mapping)
+	{
+		size_t i = 0;
+#if LIBCC_SSE2 == 1
+		if(sizeof(Char) <= 2)
+		{
+#if LIBCC_AVX2 == 1
+			if(sizeof(Char) == 1)
+			{
+				for(; i + 32 <= len; i += 32)
+				{
+					__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+					if(_mm256_movemask_epi8(v) != 0)
+						return i;
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), InternalAsciiCaseMap32(v, mapping));
+				}
+			}
+#endif
+			const size_t units = 16 / sizeof(Char);
+			for(; i + units <= len; i += units)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+				if(!InternalIsAscii16(v, sizeof(Char)))
+					return i;
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), InternalAsciiCaseMap16(v, sizeof(Char), mapping));
+			}
+		}
+#endif
+		return i;
+	}
+
+	// in may be out
+	template<typename Char>
+	inline void InternalStringCaseMap(const Char* in, Char* out, size_t len, CaseMapping mapping)
+	{
+		size_t i = 0;
+		while(i < len)
+		{
+			i += InternalAsciiCaseMapBlocks(in + i, out + i, len - i, mapping);
+			size_t blockEnd = i + 16 < len ? i + 16 : len;
+			for(; i < blockEnd; ++ i)
+			{
+				out[i] = InternalCharCaseMap(in[i], mapping);
+			}
+		}
+	}
+
+	// length of the leading pure ASCII part of s
+	inline size_t InternalAsciiPrefix(const char* s, size_t len)
+	{
+		size_t i = 0;
+#if LIBCC_SSE2 == 1
+		for(; i + 16 <= len; i += 16)
+		{
+			int m = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)));
+			if(m)
+				return i + LowestBitIndex((unsigned int)m);
+		}
+#endif
+		for(; i < len; ++ i)
+		{
+			if((unsigned char)s[i] >= 0x80)
+				return i;
+		}
+		return len;
+	}
+
+	template<typename Char>
+	inline void InternalStringCaseMapInPlace(std::basic_string<Char>& s, CaseMapping mapping)
+	{
+		if(!s.empty())
+			InternalStringCaseMap(s.c_str(), &s[0], s.size(), mapping);
+	}
+	inline void InternalStringCaseMapInPlace(std::string& s, CaseMapping mapping)
+	{
+#if LIBCC_UTF8 == 1
+		if(InternalAsciiPrefix(s.c_str(), s.size()) != s.size())
+		{
+			std::wstring w;
+			UTF8ToUTF16(s.c_str(), s.size(), w);
+			InternalStringCaseMapInPlace(w, mapping);
+			UTF16ToUTF8(w.c_str(), w.size(), s);
+			return;
+		}
+#endif
+		if(!s.empty())
+			InternalStringCaseMap(s.c_str(), &s[0], s.size(), mapping);
+	}
+
+	template<typename Char>
+	inline std::basic_string<Char> InternalStringCaseMapCopy(const Char* s, size_t len, CaseMapping mapping)
+	{
+		std::basic_string<Char> r;
+		if(len == 0)
+			return r;
+		r.resize(len);
+		InternalStringCaseMap(s, &r[0], len, mapping);
+		return r;
+	}
+	inline std::string InternalStringCaseMapCopy(const char* s, size_t len, CaseMapping mapping)
+	{
+		std::string r;
+#if LIBCC_UTF8 == 1
+		if(InternalAsciiPrefix(s, len) != len)
+		{
+			r.assign(s, len);
+			InternalStringCaseMapInPlace(r, mapping);
+			return r;
+		}
+#endif
+		if(len == 0)
+			return r;
+		r.resize(len);
+		InternalStringCaseMap(s, &r[0], len, mapping);
+		return r;
+	}
+
+	template<typename Char>
+	inline std::basic_string<Char> StringToUpper(const std::basic_string<Char>& s)
+	{
+		return InternalStringCaseMapCopy(s.c_str(), s.size(), CaseMappingUpper);
+	}
+	template<typename Char>
+	inline std::basic_string<Char> StringToUpper(const Char* s)
+	{
+		return InternalStringCaseMapCopy(s, StringLength(s), CaseMappingUpper);
+	}
+	template<typename Char>
+	inline void StringToUpperInPlace(std::basic_string<Char>& s)
+	{
+		InternalStringCaseMapInPlace(s, CaseMappingUpper);
+	}
+
+	template<typename Char>
+	inline std::basic_string<Char> StringToLower(const std::basic_string<Char>& s)
+	{
+		return InternalStringCaseMapCopy(s.c_str(), s.size(), CaseMappingLower);
+	}
+	template<typename Char>
+	inline std::basic_string<Char> StringToLower(const Char* s)
+	{
+		return InternalStringCaseMapCopy(s, StringLength(s), CaseMappingLower);
+	}
+	template<typename Char>
+	inline void StringToLowerInPlace(std::basic_string<Char>& s)
+	{
+		InternalStringCaseMapInPlace(s, CaseMappingLower);
+	}
+
+
+
+	// StringEquals / StringCompare. --------------------------------------------------------------------------------------
+	// lengths are compared first wherever they're known, then the bulk is memcmp (equality) or a 16 bytes at a time
+	// SSE2 mismatch search (ordering). StringCompare orders by unsigned code unit, like std::basic_string::compare
+	// does for char. mixed char types are converted to the wider type first.
+
+	// index of the first code unit which differs, or len
+	template<typename Char>
+	inline size_t InternalStringMismatch(const Char* a, const Char* b, size_t len)
+	{
+		size_t i = 0;
+#if LIBCC_SSE2 == 1
+		const size_t units = 16 / sizeof(Char);
+		if(units * sizeof(Char) == 16)
+		{
+			for(; i + units <= len; i += units)
+			{
+				__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+				__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+				unsigned int m = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xffff;
+				if(m)
+					return i + LowestBitIndex(m) / sizeof(Char);
+			}
+		}
+#endif
+		for(; i < len; ++ i)
+		{
+			if(a[i] != b[i])
+				return i;
+		}
+		return len;
+	}
+
+	template<typename Char>
+	inline bool InternalStringEquals(const Char* a, size_t aLen, const Char* b, size_t bLen)
+	{
+		return aLen == bLen && (aLen == 0 || memcmp(a, b, aLen * sizeof(Char)) == 0);
+	}
+
+	template<typename Char>
+	inline int InternalStringCompare(const Char* a, size_t aLen, const Char* b, size_t bLen)
+	{
+		const size_t len = aLen < bLen ? aLen : bLen;
+		size_t i = InternalStringMismatch(a, b, len);
+		if(i < len)
+			return CharSetIndex(a[i]) < CharSetIndex(b[i]) ? -1 : 1;
+		return aLen == bLen ? 0 : (aLen < bLen ? -1 : 1);
+	}
+
+	// no-conversion cases
+	template<typename Char>
+  inline bool StringEquals(const Char* lhs, const Char* rhs)
+	{
+		if(*lhs != *rhs)// most unequal strings are found here without measuring them
+			return false;
+		return InternalStringEquals(lhs, StringLength(lhs), rhs, StringLength(rhs));
+	}
+	template<typename Char>
+	inline bool StringEquals(const Char* lhs, const std::basic_string<Char>& rhs)
+	{
+		return InternalStringEquals(lhs, StringLength(lhs), rhs.c_str(), rhs.size());
+	}
+	template<typename Char>
+  inline bool StringEquals(const std::basic_string<Char>& lhs, const Char* rhs)
+	{
+		return InternalStringEquals(lhs.c_str(), lhs.size(), rhs, StringLength(rhs));
+	}
+	template<typename Char>
+	inline bool StringEquals(const std::basic_string<Char>& lhs, const std::basic_string<Char>& rhs)
+	{
+		return InternalStringEquals(lhs.c_str(), lhs.size(), rhs.c_str(), rhs.size());
+	}
+	template<typename Char>
+	inline bool StringEquals(const StringView<Char>& lhs, const StringView<Char>& rhs)
+	{
+		return InternalStringEquals(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+	}
+	// conversion cases
+  template<typename CharL, typename CharR, typename Tleft, typename Tright>
+	inline bool InternalStringEquals2(Tleft lhs, Tright rhs)
+  {
+		if(sizeof(CharL) > sizeof(CharR))
+		{
+			std::basic_string<CharL> temp;
+			StringConvert(rhs, temp);
+			return StringEquals(lhs, temp);
+		}
+		else
+		{
+			std::basic_string<CharR> temp;
+			StringConvert(lhs, temp);
+			return StringEquals(temp, rhs);
+		}
   }
-	// no-conversion cases
-  template<typename Char, class OutIt>
-	inline void StringSplitByString(const std::basic_string<Char>& s, const std::basic_string<Char>& sep, OutIt dest)
+  template<typename CharL, typename CharR>
+	inline bool StringEquals(const CharL* lhs, const CharR* rhs)
   {
-		InternalStringSplitByString1<Char, std::basic_string<Char>::const_iterator, std::basic_string<Char>::const_iterator>(s, sep, dest);
+		return InternalStringEquals2<CharL, CharR>(lhs, rhs);
   }
-  template<typename Char, class OutIt>
-	inline void StringSplitByString(const std::basic_string<Char>& s, const Char* sep, OutIt dest)
+  template<typename CharL, typename CharR>
+	inline bool StringEquals(const CharL* lhs, const std::basic_string<CharR>& rhs)
   {
-		InternalStringSplitByString1<Char, std::basic_string<Char>::const_iterator, const Char*>(s, sep, dest);
+		return InternalStringEquals2<CharL, CharR>(lhs, rhs);
   }
-  template<typename Char, class OutIt>
-	inline void StringSplitByString(const Char* s, const std::basic_string<Char>& sep, OutIt dest)
+  template<typename CharL, typename CharR>
+	inline bool StringEquals(const std::basic_string<CharL>& lhs, const CharR* rhs)
   {
-		InternalStringSplitByString1<Char, const Char*, std::basic_string<Char>::const_iterator>(s, sep, dest);
+		return InternalStringEquals2<CharL, CharR>(lhs, rhs);
   }
-  template<typename Char, class OutIt>
-	inline void StringSplitByString(const Char* s, const Char* sep, OutIt dest)
+  template<typename CharL, typename CharR>
+	inline bool StringEquals(const std::basic_string<CharL>& lhs, const std::basic_string<CharR>& rhs)
   {
-		InternalStringSplitByString1<Char, const Char*, const Char*>(s, sep, dest);
+		return InternalStringEquals2<CharL, CharR>(lhs, rhs);
   }
-	// conversion cases.
-	// note that because we cannot possibly convert output strings to that which the destination iterator wants,
-	// then we can ONLY convert the separator
-  template<typename CharL, typename CharR, typename Tleft, typename Tright, typename TOutIt>
-	inline void InternalStringSplitByString2(Tleft in, Tright sep, TOutIt dest)
+
+	// no-conversion cases
+	template<typename Char>
+  inline int StringCompare(const Char* lhs, const Char* rhs)
+	{
+		return InternalStringCompare(lhs, StringLength(lhs), rhs, StringLength(rhs));
+	}
+	template<typename Char>
+	inline int StringCompare(const Char* lhs, const std::basic_string<Char>& rhs)
+	{
+		return InternalStringCompare(lhs, StringLength(lhs), rhs.c_str(), rhs.size());
+	}
+	template<typename Char>
+  inline int StringCompare(const std::basic_string<Char>& lhs, const Char* rhs)
+	{
+		return InternalStringCompare(lhs.c_str(), lhs.size(), rhs, StringLength(rhs));
+	}
+	template<typename Char>
+	inline int StringCompare(const std::basic_string<Char>& lhs, const std::basic_string<Char>& rhs)
+	{
+		return InternalStringCompare(lhs.c_str(), lhs.size(), rhs.c_str(), rhs.size());
+	}
+	template<typename Char>
+	inline int StringCompare(const StringView<Char>& lhs, const StringView<Char>& rhs)
+	{
+		return InternalStringCompare(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+	}
+	// conversion cases
+  template<typename CharL, typename CharR, typename Tleft, typename Tright>
+	inline int InternalStringCompare2(Tleft lhs, Tright rhs)
   {
-		std::basic_string<CharL> temp;
-		StringConvert(sep, temp);
-		StringSplitByString(in, temp, dest);
+		if(sizeof(CharL) > sizeof(CharR))
+		{
+			std::basic_string<CharL> temp;
+			StringConvert(rhs, temp);
+			return StringCompare(lhs, temp);
+		}
+		else
+		{
+			std::basic_string<CharR> temp;
+			StringConvert(lhs, temp);
+			return StringCompare(temp, rhs);
+		}
   }
-  template<typename CharL, typename CharR, typename TOutIt>
-	inline void StringSplitByString(const CharL* in, const CharR* sep, TOutIt dest)
+  template<typename CharL, typename CharR>
+	inline int StringCompare(const CharL* lhs, const CharR* rhs)
   {
-		InternalStringSplitByString2<CharL, CharR>(in, sep, dest);
+		return InternalStringCompare2<CharL, CharR>(lhs, rhs);
   }
-  template<typename CharL, typename CharR, typename TOutIt>
-	inline void StringSplitByString(const CharL* in, const std::basic_string<CharR>& sep, TOutIt dest)
+  template<typename CharL, typename CharR>
+	inline int StringCompare(const CharL* lhs, const std::basic_string<CharR>& rhs)
   {
-		InternalStringSplitByString2<CharL, CharR>(in, sep, dest);
+		return InternalStringCompare2<CharL, CharR>(lhs, rhs);
   }
-  template<typename CharL, typename CharR, typename TOutIt>
-	inline void StringSplitByString(const std::basic_string<CharL>& in, const CharR* sep, TOutIt dest)
+  template<typename CharL, typename CharR>
+	inline int StringCompare(const std::basic_string<CharL>& lhs, const CharR* rhs)
   {
-		InternalStringSplitByString2<CharL, CharR>(in, sep, dest);
+		return InternalStringCompare2<CharL, CharR>(lhs, rhs);
   }
-  template<typename CharL, typename CharR, typename TOutIt>
-	inline void StringSplitByString(const std::basic_string<CharL>& in, const std::basic_string<CharR>& sep, TOutIt dest)
+  template<typename CharL, typename CharR>
+	inline int StringCompare(const std::basic_string<CharL>& lhs, const std::basic_string<CharR>& rhs)
   {
-		InternalStringSplitByString2<CharL, CharR>(in, sep, dest);
+		return InternalStringCompare2<CharL, CharR>(lhs, rhs);
   }
 
 
-	// StringJoin --------------------------------------------------------------------------------------
-	// ability to join from / to mismatching strings, with appropriate conversion.
-  template<typename Char, typename TSep, typename InIt>
-  inline std::basic_string<Char> InternalStringJoin(InIt start, InIt end, TSep sep_)
-  {
-    std::basic_string<Char> r;
-		std::basic_string<Char> temp;
-		std::basic_string<Char> sep;
-		StringConvert(sep_, sep);
-    while(start != end)
-    {
-			StringConvert(*start, temp);
-      r.append(temp);
-      ++ start;
-      if(start != end)
-      {
-        r.append(sep);
-      }
-    }
-    return r;
-  }
+
+	// StringEqualsI / StringCompareI / StringHash / StringHashI --------------------------------------------------------------------------------------
+	// case-insensitive, by comparing CharFoldCase of each code unit. pure ASCII blocks are folded & compared 16 or 32
+	// bytes at a time. folding is 1:1 on code units, so different lengths are never equal, except for UTF-8 where
+	// everything from the first non-ASCII char on is compared as UTF-16.
+	// StringCompareI orders by folded code unit; StringHashI is consistent with StringEqualsI, StringHash with StringEquals.
+
+	// compares whole blocks while they're pure ASCII and equal ignoring case; returns the number of code units done.
+	template<typename Char>
+	inline size_t InternalAsciiEqualsIBlocks(const Char* a, const Char* b, size_t len)
+	{
+		size_t i = 0;
+#if LIBCC_SSE2 == 1
+		if(sizeof(Char) <= 2)
+		{
+#if LIBCC_AVX2 == 1
+			if(sizeof(Char) == 1)
+			{
+				for(; i + 32 <= len; i += 32)
+				{
+					__m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+					__m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+					if(_mm256_movemask_epi8(_mm256_or_si256(va, vb)) != 0)
+						return i;
+					__m256i eq = _mm256_cmpeq_epi8(InternalAsciiCaseMap32(va, CaseMappingLower), InternalAsciiCaseMap32(vb, CaseMappingLower));
+					if(_mm256_movemask_epi8(eq) != -1)
+						return i;
+				}
+			}
+#endif
+			const size_t units = 16 / sizeof(Char);
+			for(; i + units <= len; i += units)
+			{
+				__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+				__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+				if(!InternalIsAscii16(_mm_or_si128(va, vb), sizeof(Char)))
+					return i;
+				__m128i eq = _mm_cmpeq_epi8(InternalAsciiCaseMap16(va, sizeof(Char), CaseMappingLower), InternalAsciiCaseMap16(vb, sizeof(Char), CaseMappingLower));
+				if(_mm_movemask_epi8(eq) != 0xffff)
+					return i;
+			}
+		}
+#endif
+		return i;
+	}
+
+	template<typename Char>
+	inline int InternalStringCompareI(const Char* a, size_t aLen, const Char* b, size_t bLen)
+	{
+		const size_t len = aLen < bLen ? aLen : bLen;
+		size_t i = 0;
+		while(i < len)
+		{
+			i += InternalAsciiEqualsIBlocks(a + i, b + i, len - i);
+			size_t blockEnd = i + 16 < len ? i + 16 : len;
+			for(; i < blockEnd; ++ i)
+			{
+				unsigned long fa = CharSetIndex(CharFoldCase(a[i]));
+				unsigned long fb = CharSetIndex(CharFoldCase(b[i]));
+				if(fa != fb)
+					return fa < fb ? -1 : 1;
+			}
+		}
+		return aLen == bLen ? 0 : (aLen < bLen ? -1 : 1);
+	}
+	inline int InternalStringCompareI(const char* a, size_t aLen, const char* b, size_t bLen)
+	{
+#if LIBCC_UTF8 == 1
+		size_t asciiA = InternalAsciiPrefix(a, aLen);
+		size_t asciiB = InternalAsciiPrefix(b, bLen);
+		if(asciiA != aLen || asciiB != bLen)
+		{
+			size_t ascii = asciiA < asciiB ? asciiA : asciiB;
+			int r = InternalStringCompareI<char>(a, ascii, b, ascii);
+			if(r != 0)
+				return r;
+			std::wstring wa, wb;
+			UTF8ToUTF16(a + ascii, aLen - ascii, wa);
+			UTF8ToUTF16(b + ascii, bLen - ascii, wb);
+			return InternalStringCompareI(wa.c_str(), wa.size(), wb.c_str(), wb.size());
+		}
+#endif
+		return InternalStringCompareI<char>(a, aLen, b, bLen);
+	}
+
+	template<typename Char>
+	inline bool InternalStringEqualsI(const Char* a, size_t aLen, const Char* b, size_t bLen)
+	{
+		if(aLen != bLen && (sizeof(Char) != 1 || LIBCC_CHAR_CODEPAGE != CP_UTF8))
+			return false;
+		return InternalStringCompareI(a, aLen, b, bLen) == 0;
+	}
+
+	// hashing is a 64 bit multiply-mix in the style of wyhash over the bytes of the code units, so the same text hashes
+	// differently as char and wchar_t. strings over 48 bytes go 48 bytes a round in 3 independent lanes, then 16 bytes
+	// a round; the last 0-16 bytes are read in place. there is no per-code-unit work in the raw hash. the
+	// case-insensitive hash folds 192 bytes at a time into a stack buffer with the block case mapping and hashes
+	// that, so both give the same value for strings that only differ in case.
+	struct InternalHasher
+	{
+		static const uint64_t P0 = 0xa0761d6478bd642fULL;
+		static const uint64_t P1 = 0xe7037ed1a0b428dbULL;
+		static const uint64_t P2 = 0x8ebc6af09c88c6e3ULL;
+		static const uint64_t P3 = 0x589965cc75374cc3ULL;
+
+		// full 64 x 64 -> 128 bit product; a gets the low half, b the high half
+		static void Multiply(uint64_t& a, uint64_t& b)
+		{
+#if defined(_M_X64)
+			a = _umul128(a, b, &b);
+#elif defined(__SIZEOF_INT128__)
+			unsigned __int128 r = (unsigned __int128)a * b;
+			a = (uint64_t)r;
+			b = (uint64_t)(r >> 64);
+#else
+			uint64_t ha = a >> 32, hb = b >> 32, la = (unsigned int)a, lb = (unsigned int)b;
+			uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+			uint64_t t = rl + (rm0 << 32);
+			uint64_t carry = t < rl ? 1 : 0;
+			uint64_t lo = t + (rm1 << 32);
+			carry += lo < t ? 1 : 0;
+			b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+			a = lo;
+#endif
+		}
+		static uint64_t Mix(uint64_t a, uint64_t b)
+		{
+			Multiply(a, b);
+			return a ^ b;
+		}
+		static uint64_t Read8(const unsigned char* p)
+		{
+			uint64_t v;
+			memcpy(&v, p, 8);
+			return v;
+		}
+		static uint64_t Read4(const unsigned char* p)
+		{
+			unsigned int v;
+			memcpy(&v, p, 4);
+			return v;
+		}
+
+		explicit InternalHasher(uint64_t seed)
+		{
+			lane0 = seed ^ Mix(seed ^ P0, P1);
+			lane1 = lane0;
+			lane2 = lane0;
+		}
+
+		void Round48(const unsigned char* p)
+		{
+			lane0 = Mix(Read8(p) ^ P1, Read8(p + 8) ^ lane0);
+			lane1 = Mix(Read8(p + 16) ^ P2, Read8(p + 24) ^ lane1);
+			lane2 = Mix(Read8(p + 32) ^ P3, Read8(p + 40) ^ lane2);
+		}
+
+		// the rest of a string whose first totalBytes - bytes have gone through Round48.
+		size_t Finish(const unsigned char* p, size_t bytes, size_t totalBytes)
+		{
+			for(; bytes > 48; bytes -= 48, p += 48)
+			{
+				Round48(p);
+			}
+			lane0 ^= lane1 ^ lane2;
+			for(; bytes > 16; bytes -= 16, p += 16)
+			{
+				lane0 = Mix(Read8(p) ^ P1, Read8(p + 8) ^ lane0);
+			}
+			uint64_t a = 0;
+			uint64_t b = 0;
+			if(bytes >= 4)
+			{
+				size_t middle = (bytes >> 3) << 2;
+				a = (Read4(p) << 32) | Read4(p + middle);
+				b = (Read4(p + bytes - 4) << 32) | Read4(p + bytes - 4 - middle);
+			}
+			else if(bytes > 0)
+			{
+				a = ((uint64_t)p[0] << 16) | ((uint64_t)p[bytes >> 1] << 8) | p[bytes - 1];
+			}
+			a ^= P1;
+			b ^= lane0;
+			Multiply(a, b);
+			uint64_t h = Mix(a ^ P0 ^ totalBytes, b ^ P1);
+			return sizeof(size_t) == 8 ? (size_t)h : (size_t)(h ^ (h >> 32));
+		}
+
+		uint64_t lane0;
+		uint64_t lane1;
+		uint64_t lane2;
+	};
+
+	template<typename Char>
+	inline size_t InternalStringHash(const Char* s, size_t len, size_t seed = 0)
+	{
+		return InternalHasher(seed).Finish(reinterpret_cast<const unsigned char*>(s), len * sizeof(Char), len * sizeof(Char));
+	}
+
+	template<typename Char>
+	inline size_t InternalStringHashI(const Char* s, size_t len, size_t seed = 0)
+	{
+		const size_t BufferUnits = 192 / sizeof(Char);// a whole number of 48 byte rounds
+		Char buffer[BufferUnits];
+		const unsigned char* bufferBytes = reinterpret_cast<const unsigned char*>(buffer);
+		const size_t totalBytes = len * sizeof(Char);
+		InternalHasher h(seed);
+		for(; len > BufferUnits; len -= BufferUnits, s += BufferUnits)
+		{
+			InternalStringCaseMap(s, buffer, BufferUnits, CaseMappingFold);
+			for(size_t i = 0; i < 192; i += 48)
+			{
+				h.Round48(bufferBytes + i);
+			}
+		}
+		InternalStringCaseMap(s, buffer, len, CaseMappingFold);
+		return h.Finish(bufferBytes, len * sizeof(Char), totalBytes);
+	}
+	inline size_t InternalStringHashI(const char* s, size_t len, size_t seed = 0)
+	{
+#if LIBCC_UTF8 == 1
+		if(InternalAsciiPrefix(s, len) != len)
+		{
+			// the UTF-8 of the folded UTF-16. for ASCII that's the same bytes the folding hash below sees, so strings
+			// StringEqualsI calls equal hash the same whether they're all ASCII or not ("k" and the kelvin sign).
+			std::wstring w;
+			UTF8ToUTF16(s, len, w);
+			std::wstring folded(w.size(), 0);
+			InternalStringCaseMap(w.c_str(), &folded[0], w.size(), CaseMappingFold);
+			std::string utf8;
+			UTF16ToUTF8(folded.c_str(), folded.size(), utf8);
+			return InternalStringHash(utf8.c_str(), utf8.size(), seed);
+		}
+#endif
+		return InternalStringHashI<char>(s, len, seed);
+	}
+
+	// no-conversion cases
+	template<typename Char>
+	inline bool StringEqualsI(const Char* lhs, const Char* rhs)
+	{
+		return InternalStringEqualsI(lhs, StringLength(lhs), rhs, StringLength(rhs));
+	}
+	template<typename Char>
+	inline bool StringEqualsI(const Char* lhs, const std::basic_string<Char>& rhs)
+	{
+		return InternalStringEqualsI(lhs, StringLength(lhs), rhs.c_str(), rhs.size());
+	}
+	template<typename Char>
+	inline bool StringEqualsI(const std::basic_string<Char>& lhs, const Char* rhs)
+	{
+		return InternalStringEqualsI(lhs.c_str(), lhs.size(), rhs, StringLength(rhs));
+	}
+	template<typename Char>
+	inline bool StringEqualsI(const std::basic_string<Char>& lhs, const std::basic_string<Char>& rhs)
+	{
+		return InternalStringEqualsI(lhs.c_str(), lhs.size(), rhs.c_str(), rhs.size());
+	}
+	template<typename Char>
+	inline bool StringEqualsI(const StringView<Char>& lhs, const StringView<Char>& rhs)
+	{
+		return InternalStringEqualsI(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+	}
+	// conversion cases
+	template<typename CharL, typename CharR, typename Tleft, typename Tright>
+	inline bool InternalStringEqualsI2(Tleft lhs, Tright rhs)
+	{
+		if(sizeof(CharL) > sizeof(CharR))
+		{
+			std::basic_string<CharL> temp;
+			StringConvert(rhs, temp);
+			return StringEqualsI(lhs, temp);
+		}
+		else
+		{
+			std::basic_string<CharR> temp;
+			StringConvert(lhs, temp);
+			return StringEqualsI(temp, rhs);
+		}
+	}
+	template<typename CharL, typename CharR>
+	inline bool StringEqualsI(const CharL* lhs, const CharR* rhs)
+	{
+		return InternalStringEqualsI2<CharL, CharR>(lhs, rhs);
+	}
+	template<typename CharL, typename CharR>
+	inline bool StringEqualsI(const CharL* lhs, const std::basic_string<CharR>& rhs)
+	{
+		return InternalStringEqualsI2<CharL, CharR>(lhs, rhs);
+	}
+	template<typename CharL, typename CharR>
+	inline bool StringEqualsI(const std::basic_string<CharL>& lhs, const CharR* rhs)
+	{
+		return InternalStringEqualsI2<CharL, CharR>(lhs, rhs);
+	}
+	template<typename CharL, typename CharR>
+	inline bool StringEqualsI(const std::basic_string<CharL>& lhs, const std::basic_string<CharR>& rhs)
+	{
+		return InternalStringEqualsI2<CharL, CharR>(lhs, rhs);
+	}
+
+	template<typename Char>
+	inline int StringCompareI(const Char* lhs, const Char* rhs)
+	{
+		return InternalStringCompareI(lhs, StringLength(lhs), rhs, StringLength(rhs));
+	}
+	template<typename Char>
+	inline int StringCompareI(const Char* lhs, const std::basic_string<Char>& rhs)
+	{
+		return InternalStringCompareI(lhs, StringLength(lhs), rhs.c_str(), rhs.size());
+	}
+	template<typename Char>
+	inline int StringCompareI(const std::basic_string<Char>& lhs, const Char* rhs)
+	{
+		return InternalStringCompareI(lhs.c_str(), lhs.size(), rhs, StringLength(rhs));
+	}
+	template<typename Char>
+	inline int StringCompareI(const std::basic_string<Char>& lhs, const std::basic_string<Char>& rhs)
+	{
+		return InternalStringCompareI(lhs.c_str(), lhs.size(), rhs.c_str(), rhs.size());
+	}
+	template<typename Char>
+	inline int StringCompareI(const StringView<Char>& lhs, const StringView<Char>& rhs)
+	{
+		return InternalStringCompareI(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+	}
+
+	// seed picks a different hash function, e.g. per table, so colliding keys can't be chosen up front. a zero
+	// terminated string has no seed parameter (it would be taken for the length); give it a length to seed it.
+	template<typename Char>
+	inline size_t StringHashI(const Char* s, size_t len, size_t seed = 0)
+	{
+		return InternalStringHashI(s, len, seed);
+	}
+	template<typename Char>
+	inline size_t StringHashI(const Char* s)
+	{
+		return InternalStringHashI(s, StringLength(s));
+	}
+	template<typename Char>
+	inline size_t StringHashI(const std::basic_string<Char>& s, size_t seed = 0)
+	{
+		return InternalStringHashI(s.c_str(), s.size(), seed);
+	}
+	template<typename Char>
+	inline size_t StringHashI(const StringView<Char>& s, size_t seed = 0)
+	{
+		return InternalStringHashI(s.data(), s.size(), seed);
+	}
+
+	template<typename Char>
+	inline size_t StringHash(const Char* s, size_t len, size_t seed = 0)
+	{
+		return InternalStringHash(s, len, seed);
+	}
+	template<typename Char>
+	inline size_t StringHash(const Char* s)
+	{
+		return InternalStringHash(s, StringLength(s));
+	}
+	template<typename Char>
+	inline size_t StringHash(const std::basic_string<Char>& s, size_t seed = 0)
+	{
+		return InternalStringHash(s.c_str(), s.size(), seed);
+	}
+	template<typename Char>
+	inline size_t StringHash(const StringView<Char>& s, size_t seed = 0)
+	{
+		return InternalStringHash(s.data(), s.size(), seed);
+	}
+
+	// StringStartsWith / StringEndsWith --------------------------------------------------------------------------------------
+	// the prefix / suffix is measured and compared with memcmp. a zero terminated str is never measured by
+	// StringStartsWith (it may be much longer than find); it's compared up to find's length and its terminator
+	// stops the comparison. with mixed char types, find is converted to str's char type.
+	template<typename Char>
+	inline bool InternalStringStartsWith(const Char* str, const Char* find, size_t findLen)
+	{
+		for(size_t i = 0; i < findLen; ++ i)
+		{
+			if(str[i] != find[i])
+				return false;
+		}
+		return true;
+	}
+	template<typename Char>
+	inline bool InternalStringStartsWith(const Char* str, size_t strLen, const Char* find, size_t findLen)
+	{
+		return strLen >= findLen && (findLen == 0 || memcmp(str, find, findLen * sizeof(Char)) == 0);
+	}
+	template<typename Char>
+	inline bool InternalStringEndsWith(const Char* str, size_t strLen, const Char* find, size_t findLen)
+	{
+		return strLen >= findLen && (findLen == 0 || memcmp(str + strLen - findLen, find, findLen * sizeof(Char)) == 0);
+	}
+
 	// no-conversion cases
-  template<typename InIt, typename Char>
-  inline std::basic_string<Char> StringJoin(InIt start, InIt end, const std::basic_string<Char>& sep)
-  {
-		return InternalStringJoin<Char>(start, end, sep);
+	template<typename Char>
+	inline bool StringStartsWith(const Char* str, const Char* find)
+	{
+		return InternalStringStartsWith(str, find, StringLength(find));
 	}
-  template<typename InIt, typename Char>
-  inline std::basic_string<Char> StringJoin(InIt start, InIt end, const Char* sep)
-  {
-		return InternalStringJoin<Char>(start, end, sep);
+	template<typename Char>
+	inline bool StringStartsWith(const Char* str, const std::basic_string<Char>& find)
+	{
+		return InternalStringStartsWith(str, find.c_str(), find.size());
 	}
-	// conversion cases... probably not that usable
-  template<typename CharRet, typename CharSep, typename InIt>
-  inline std::basic_string<CharRet> StringJoin(InIt start, InIt end, const std::basic_string<CharSep>& sep)
-  {
-		return InternalStringJoin<CharRet>(start, end, sep);
+	template<typename Char>
+	inline bool StringStartsWith(const std::basic_string<Char>& str, const Char* find)
+	{
+		return InternalStringStartsWith(str.c_str(), str.size(), find, StringLength(find));
 	}
-  template<typename CharRet, typename CharSep, typename InIt>
-  inline std::basic_string<CharRet> StringJoin(InIt start, InIt end, const CharSep* sep)
-  {
-		return InternalStringJoin<CharRet>(start, end, sep);
+	template<typename Char>
+	inline bool StringStartsWith(const std::basic_string<Char>& str, const std::basic_string<Char>& find)
+	{
+		return InternalStringStartsWith(str.c_str(), str.size(), find.c_str(), find.size());
 	}
-  
-	// StringTrim --------------------------------------------------------------------------------------
-  template<typename Char, typename Titer, typename TStrIn, typename TStrChars>
-  inline std::basic_string<Char> InternalStringTrim(TStrIn s, TStrChars chars)
-  {
-		std::basic_string<Char> ret;
-		ret.reserve(StringLength(s));
-		// first skip.
-		Titer it = StringBegin(s);
-		while(true)
+	template<typename Char>
+	inline bool StringStartsWith(const StringView<Char>& str, const StringView<Char>& find)
+	{
+		return InternalStringStartsWith(str.data(), str.size(), find.data(), find.size());
+	}
+	// conversion cases
+	template<typename CharL, typename CharR>
+	inline bool StringStartsWith(const CharL* str, const CharR* find)
+	{
+		std::basic_string<CharL> temp;
+		StringConvert(find, temp);
+		return StringStartsWith(str, temp);
+	}
+	template<typename CharL, typename CharR>
+	inline bool StringStartsWith(const CharL* str, const std::basic_string<CharR>& find)
+	{
+		std::basic_string<CharL> temp;
+		StringConvert(find, temp);
+		return StringStartsWith(str, temp);
+	}
+	template<typename CharL, typename CharR>
+	inline bool StringStartsWith(const std::basic_string<CharL>& str, const CharR* find)
+	{
+		std::basic_string<CharL> temp;
+		StringConvert(find, temp);
+		return StringStartsWith(str, temp);
+	}
+	template<typename CharL, typename CharR>
+	inline bool StringStartsWith(const std::basic_string<CharL>& str, const std::basic_string<CharR>& find)
+	{
+		std::basic_string<CharL> temp;
+		StringConvert(find, temp);
+		return StringStartsWith(str, temp);
+	}
+
+	// no-conversion cases
+	template<typename Char>
+	inline bool StringEndsWith(const Char* str, const Char* find)
+	{
+		return InternalStringEndsWith(str, StringLength(str), find, StringLength(find));
+	}
+	template<typename Char>
+	inline bool StringEndsWith(const Char* str, const std::basic_string<Char>& find)
+	{
+		return InternalStringEndsWith(str, StringLength(str), find.c_str(), find.size());
+	}
+	template<typename Char>
+	inline bool StringEndsWith(const std::basic_string<Char>& str, const Char* find)
+	{
+		return InternalStringEndsWith(str.c_str(), str.size(), find, StringLength(find));
+	}
+	template<typename Char>
+	inline bool StringEndsWith(const std::basic_string<Char>& str, const std::basic_string<Char>& find)
+	{
+		return InternalStringEndsWith(str.c_str(), str.size(), find.c_str(), find.size());
+	}
+	template<typename Char>
+	inline bool StringEndsWith(const StringView<Char>& str, const StringView<Char>& find)
+	{
+		return InternalStringEndsWith(str.data(), str.size(), find.data(), find.size());
+	}
+	// conversion cases
+	template<typename CharL, typename CharR>
+	inline bool StringEndsWith(const CharL* str, const CharR* find)
+	{
+		std::basic_string<CharL> temp;
+		StringConvert(find, temp);
+		return StringEndsWith(str, temp);
+	}
+	template<typename CharL, typename CharR>
+	inline bool StringEndsWith(const CharL* str, const std::basic_string<CharR>& find)
+	{
+		std::basic_string<CharL> temp;
+		StringConvert(find, temp);
+		return StringEndsWith(str, temp);
+	}
+	template<typename CharL, typename CharR>
+	inline bool StringEndsWith(const std::basic_string<CharL>& str, const CharR* find)
+	{
+		std::basic_string<CharL> temp;
+		StringConvert(find, temp);
+		return StringEndsWith(str, temp);
+	}
+	template<typename CharL, typename CharR>
+	inline bool StringEndsWith(const std::basic_string<CharL>& str, const std::basic_string<CharR>& find)
+	{
+		std::basic_string<CharL> temp;
+		StringConvert(find, temp);
+		return StringEndsWith(str, temp);
+	}
+
+	// StringHashMap --------------------------------------------------------------------------------------
+	// a string-keyed hash map for lookups that don't need ordering. open addressing with linear probing: the hashes
+	// and the entries live in 2 flat arrays, so a lookup is 1 StringHash plus, nearly always, 1 key compare. it grows
+	// to keep the load under 3/4, and Erase shifts the following entries back instead of leaving tombstones.
+	// keys are looked up by pointer & length, so there's no temporary std::basic_string for a const Char* key.
+	// Ops supplies Hash(p, len, seed) and Equals(a, aLen, b, bLen); StringKeyOpsI makes the map case-insensitive.
+	// each map has its own seed (see SetSeed()). entries move when the map grows, so don't hold on to Value pointers
+	// across an insert.
+	template<typename Char>
+	struct StringKeyOps
+	{
+		static size_t Hash(const Char* s, size_t len, size_t seed)
 		{
-			if(StringIsEnd(it, s))// hit the end of the string during skipping; it only contains trim chars!
-				return ret;
-			if(!StringContainsChar(chars, *it))
-				break;
-			++ it;
+			return InternalStringHash(s, len, seed);
+		}
+		static bool Equals(const Char* a, size_t aLen, const Char* b, size_t bLen)
+		{
+			return InternalStringEquals(a, aLen, b, bLen);
+		}
+	};
+
+	template<typename Char>
+	struct StringKeyOpsI
+	{
+		static size_t Hash(const Char* s, size_t len, size_t seed)
+		{
+			return InternalStringHashI(s, len, seed);
+		}
+		static bool Equals(const Char* a, size_t aLen, const Char* b, size_t bLen)
+		{
+			return InternalStringEqualsI(a, aLen, b, bLen);
+		}
+	};
+
+	template<typename Char, typename Value, typename Ops = StringKeyOps<Char> >
+	class StringHashMap
+	{
+	public:
+		typedef std::basic_string<Char> _String;
+		typedef StringHashMap<Char, Value, Ops> _This;
+
+		struct Entry
+		{
+			Entry(const Char* s, size_t len, const Value& value_) :
+				key(s, len),
+				value(value_)
+			{
+			}
+			_String key;
+			Value value;
+		};
+
+		StringHashMap() :
+			m_hashes(0),
+			m_entries(0),
+			m_mask(0),
+			m_size(0),
+			m_seed(0)
+		{
+		}
+
+		StringHashMap(const _This& rhs) :
+			m_hashes(0),
+			m_entries(0),
+			m_mask(0),
+			m_size(0),
+			m_seed(rhs.m_seed)
+		{
+			Reserve(rhs.m_size);
+			rhs.ForEach([this](const _String& key, const Value& value) { Insert(key, value); });
+		}
+
+		_This& operator =(const _This& rhs)
+		{
+			if(this != &rhs)
+			{
+				clear();
+				m_seed = rhs.m_seed;
+				Reserve(rhs.m_size);
+				rhs.ForEach([this](const _String& key, const Value& value) { Insert(key, value); });
+			}
+			return *this;
+		}
+
+		~StringHashMap()
+		{
+			clear();
+			Release();
+		}
+
+		size_t size() const
+		{
+			return m_size;
+		}
+		bool empty() const
+		{
+			return m_size == 0;
+		}
+
+		// only takes effect while the map is empty
+		void SetSeed(size_t seed)
+		{
+			if(m_size == 0)
+				m_seed = seed;
+		}
+
+		void clear()
+		{
+			for(size_t i = 0; m_size && i <= m_mask; ++ i)
+			{
+				if(m_hashes[i])
+				{
+					m_entries[i].~Entry();
+					m_hashes[i] = 0;
+					-- m_size;
+				}
+			}
+		}
+
+		// makes room for n entries without growing
+		void Reserve(size_t n)
+		{
+			size_t capacity = m_hashes ? m_mask + 1 : 0;
+			if(n < capacity - capacity / 4)
+				return;
+			size_t newCapacity = 16;
+			while(n >= newCapacity - newCapacity / 4)
+				newCapacity *= 2;
+			Rehash(newCapacity);
+		}
+
+		// 0 if the key isn't there
+		Value* Find(const Char* s, size_t len)
+		{
+			size_t i = Lookup(s, len, Hash(s, len));
+			return i == NotFound ? 0 : &m_entries[i].value;
+		}
+		const Value* Find(const Char* s, size_t len) const
+		{
+			return const_cast<_This*>(this)->Find(s, len);
+		}
+		Value* Find(const Char* s)
+		{
+			return Find(s, StringLength(s));
+		}
+		const Value* Find(const Char* s) const
+		{
+			return Find(s, StringLength(s));
+		}
+		Value* Find(const _String& s)
+		{
+			return Find(s.c_str(), s.size());
+		}
+		const Value* Find(const _String& s) const
+		{
+			return Find(s.c_str(), s.size());
+		}
+		Value* Find(const StringView<Char>& s)
+		{
+			return Find(s.data(), s.size());
+		}
+		const Value* Find(const StringView<Char>& s) const
+		{
+			return Find(s.data(), s.size());
+		}
+
+		bool Contains(const Char* s, size_t len) const
+		{
+			return Find(s, len) != 0;
+		}
+		template<typename Key>
+		bool Contains(const Key& s) const
+		{
+			return Find(s) != 0;
+		}
+
+		// inserts a default Value if the key isn't there
+		Value& operator [](const _String& s)
+		{
+			return FindOrAdd(s.c_str(), s.size(), Value(), 0);
+		}
+		Value& operator [](const Char* s)
+		{
+			return FindOrAdd(s, StringLength(s), Value(), 0);
+		}
+		Value& operator [](const StringView<Char>& s)
+		{
+			return FindOrAdd(s.data(), s.size(), Value(), 0);
+		}
+
+		// returns false, leaving the existing value alone, if the key is already there.
+		bool Insert(const Char* s, size_t len, const Value& value)
+		{
+			bool added;
+			FindOrAdd(s, len, value, &added);
+			return added;
+		}
+		bool Insert(const _String& s, const Value& value)
+		{
+			return Insert(s.c_str(), s.size(), value);
+		}
+		bool Insert(const Char* s, const Value& value)
+		{
+			return Insert(s, StringLength(s), value);
+		}
+		bool Insert(const StringView<Char>& s, const Value& value)
+		{
+			return Insert(s.data(), s.size(), value);
+		}
+
+		// returns false if the key wasn't there
+		bool Erase(const Char* s, size_t len)
+		{
+			size_t i = Lookup(s, len, Hash(s, len));
+			if(i == NotFound)
+				return false;
+			// shift back every following entry that's allowed to sit in the gap
+			for(size_t j = (i + 1) & m_mask; m_hashes[j]; j = (j + 1) & m_mask)
+			{
+				size_t home = m_hashes[j] & m_mask;
+				bool fillsGap = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+				if(fillsGap)
+				{
+					m_entries[i].~Entry();
+					new(&m_entries[i]) Entry(std::move(m_entries[j]));
+					m_hashes[i] = m_hashes[j];
+					i = j;
+				}
+			}
+			m_entries[i].~Entry();
+			m_hashes[i] = 0;
+			-- m_size;
+			return true;
+		}
+		bool Erase(const _String& s)
+		{
+			return Erase(s.c_str(), s.size());
+		}
+		bool Erase(const Char* s)
+		{
+			return Erase(s, StringLength(s));
+		}
+		bool Erase(const StringView<Char>& s)
+		{
+			return Erase(s.data(), s.size());
+		}
+
+		// fn(const std::basic_string<Char>& key, Value& value), in no particular order. don't insert or erase from fn.
+		template<typename Fn>
+		void ForEach(Fn fn)
+		{
+			for(size_t i = 0; m_hashes && i <= m_mask; ++ i)
+			{
+				if(m_hashes[i])
+					fn((const _String&)m_entries[i].key, m_entries[i].value);
+			}
 		}
-		// it points to the first non trim char. now find the last one
-		Titer itTemp = it;
-		Titer lastNonTrimChar = it;
-		while(true)
+		template<typename Fn>
+		void ForEach(Fn fn) const
 		{
-			if(StringIsEnd(itTemp, s))
-				break;
-			if(!StringContainsChar(chars, *itTemp))
-				lastNonTrimChar = itTemp;
-			++ itTemp;
+			for(size_t i = 0; m_hashes && i <= m_mask; ++ i)
+			{
+				if(m_hashes[i])
+					fn(m_entries[i].key, (const Value&)m_entries[i].value);
+			}
 		}
-		// append chars between it and lastNonTrimChar
-		while(true)
+
+	private:
+		static const size_t NotFound = ~(size_t)0;
+
+		// 0 marks an empty slot, so stored hashes always have the top bit set. the slot index comes from the low bits.
+		size_t Hash(const Char* s, size_t len) const
 		{
-			ret.push_back(*it);
-			if(it == lastNonTrimChar)
-				return ret;
-			++ it;
+			return Ops::Hash(s, len, m_seed) | ~(~(size_t)0 >> 1);
 		}
-  }
-	// no-conversion cases
-  template<typename Char>
-  inline std::basic_string<Char> StringTrim(const std::basic_string<Char>& s, const std::basic_string<Char>& chars)
-  {
-		return InternalStringTrim<Char, std::basic_string<Char>::const_iterator>(s, chars);
-  }
-  template<typename Char>
-  inline std::basic_string<Char> StringTrim(const Char* s, const std::basic_string<Char>& chars)
-  {
-		return InternalStringTrim<Char, const Char*>(s, chars);
-  }
-  template<typename Char>
-  inline std::basic_string<Char> StringTrim(const std::basic_string<Char>& s, const Char* chars)
-  {
-		return InternalStringTrim<Char, std::basic_string<Char>::const_iterator>(s, chars);
-  }
-  template<typename Char>
-  inline std::basic_string<Char> StringTrim(const Char* s, const Char* chars)
-  {
-		return InternalStringTrim<Char, const Char*>(s, chars);
-  }
-	// conversion cases
-  template<typename CharLeft, typename CharRight>
-  inline std::basic_string<CharLeft> StringTrim(const std::basic_string<CharLeft>& s, const std::basic_string<CharRight>& chars)
-  {
-		std::basic_string<CharLeft> temp;
-		StringConvert(chars, temp);
-		return InternalStringTrim<CharLeft, std::basic_string<CharLeft>::const_iterator>(s, temp);
-  }
-  template<typename CharLeft, typename CharRight>
-  inline std::basic_string<CharLeft> StringTrim(const CharLeft* s, const std::basic_string<CharRight>& chars)
-  {
-		std::basic_string<CharLeft> temp;
-		StringConvert(chars, temp);
-		return InternalStringTrim<CharLeft, const CharLeft*>(s, temp);
-  }
-  template<typename CharLeft, typename CharRight>
-  inline std::basic_string<CharLeft> StringTrim(const std::basic_string<CharLeft>& s, const CharRight* chars)
-  {
-		std::basic_string<CharLeft> temp;
-		StringConvert(chars, temp);
-		return InternalStringTrim<CharLeft, std::basic_string<CharLeft>::const_iterator>(s, temp);
-  }
-  template<typename CharLeft, typename CharRight>
-  inline std::basic_string<CharLeft> StringTrim(const CharLeft* s, const CharRight* chars)
-  {
-		std::basic_string<CharLeft> temp;
-		StringConvert(chars, temp);
-		return InternalStringTrim<CharLeft, const CharLeft*>(s, temp);
-  }
 
+		size_t Lookup(const Char* s, size_t len, size_t hash) const
+		{
+			if(!m_size)
+				return NotFound;
+			for(size_t i = hash & m_mask; m_hashes[i]; i = (i + 1) & m_mask)
+			{
+				if(m_hashes[i] == hash && Ops::Equals(m_entries[i].key.c_str(), m_entries[i].key.size(), s, len))
+					return i;
+			}
+			return NotFound;
+		}
 
-	// StringReplace --------------------------------------------------------------------------------------
-  template<typename Char>
-  inline std::basic_string<Char> StringReplace(const std::basic_string<Char>& src, const std::basic_string<Char>& searchString, const std::basic_string<Char>& replaceString)
-  {
-		if(searchString.empty()) return src;// you can't have a 0 length search string.
-    typedef std::basic_string<Char> _String;
-    _String r;
-    size_t pos = 0;
-		while(1)
+		Value& FindOrAdd(const Char* s, size_t len, const Value& value, bool* added)
 		{
-			size_t found = src.find(searchString, pos);
-			if(found == _String::npos)
+			size_t hash = Hash(s, len);
+			size_t i = Lookup(s, len, hash);
+			if(i != NotFound)
 			{
-				// append the remainder of src.
-				r.append(src, pos, src.length() - pos);
-				return r;
+				if(added)
+					*added = false;
+				return m_entries[i].value;
 			}
-			r.append(src, pos, found - pos);// append chunk from src.
-			r.append(replaceString);// append replacement
-			pos = found + searchString.length();// advance
+			Reserve(m_size + 1);
+			for(i = hash & m_mask; m_hashes[i]; i = (i + 1) & m_mask)
+			{
+			}
+			new(&m_entries[i]) Entry(s, len, value);
+			m_hashes[i] = hash;
+			++ m_size;
+			if(added)
+				*added = true;
+			return m_entries[i].value;
+		}
+
+		void Rehash(size_t newCapacity)
+		{
+			size_t* oldHashes = m_hashes;
+			Entry* oldEntries = m_entries;
+			size_t oldCapacity = m_hashes ? m_mask + 1 : 0;
+			m_hashes = new size_t[newCapacity];
+			memset(m_hashes, 0, newCapacity * sizeof(size_t));
+			m_entries = static_cast<Entry*>(::operator new(newCapacity * sizeof(Entry)));
+			m_mask = newCapacity - 1;
+			for(size_t i = 0; i < oldCapacity; ++ i)
+			{
+				if(oldHashes[i])
+				{
+					size_t j = oldHashes[i] & m_mask;
+					while(m_hashes[j])
+						j = (j + 1) & m_mask;
+					new(&m_entries[j]) Entry(std::move(oldEntries[i]));
+					m_hashes[j] = oldHashes[i];
+					oldEntries[i].~Entry();
+				}
+			}
+			delete [] oldHashes;
+			::operator delete(oldEntries);
 		}
-  }
-  template<typename Char>// these overloads help compile with constant strings
-  inline std::basic_string<Char> StringReplace(const std::basic_string<Char>& src, const std::basic_string<Char>& searchString, const Char* replaceString)
-  {
-		return StringReplace(src, searchString, std::basic_string<Char>(replaceString));
-	}
-  template<typename Char>
-  inline std::basic_string<Char> StringReplace(const std::basic_string<Char>& src, const Char* searchString, const std::basic_string<Char>& replaceString)
-  {
-		return StringReplace(src, std::basic_string<Char>(searchString), replaceString);
-	}
-  template<typename Char>
-  inline std::basic_string<Char> StringReplace(const std::basic_string<Char>& src, const Char* searchString, const Char* replaceString)
-  {
-		return StringReplace(src, std::basic_string<Char>(searchString), std::basic_string<Char>(replaceString));
-	}
-  template<typename Char>
-  inline std::basic_string<Char> StringReplace(const Char* src, const std::basic_string<Char>& searchString, const std::basic_string<Char>& replaceString)
-  {
-		return StringReplace(std::basic_string<Char>(src), searchString, replaceString);
-	}
-  template<typename Char>
-  inline std::basic_string<Char> StringReplace(const Char* src, const std::basic_string<Char>& searchString, const Char* replaceString)
-  {
-		return StringReplace(std::basic_string<Char>(src), searchString, std::basic_string<Char>(replaceString));
-	}
-  template<typename Char>
-  inline std::basic_string<Char> StringReplace(const Char* src, const Char* searchString, const std::basic_string<Char>& replaceString)
-  {
-		return StringReplace(std::basic_string<Char>(src), std::basic_string<Char>(searchString), replaceString);
-	}
-  template<typename Char>
-  inline std::basic_string<Char> StringReplace(const Char* src, const Char* searchString, const Char* replaceString)
-  {
-		return StringReplace(std::basic_string<Char>(src), std::basic_string<Char>(searchString), std::basic_string<Char>(replaceString));
-	}
 
-	// StringToUpper --------------------------------------------------------------------------------------
-	// NOTE: the stdlib toupper functions do not handle unicode very well, so this will have to do.
-	//inline std::wstring StringToUpper(const std::wstring& s)
-	//{
-	//	std::vector<wchar_t> buf(s.length() + 1);
-	//	wcscpy(buf.data(), s.c_str());
-	//	CharUpperBuffW(buf.data(), (DWORD)s.length());
-	//	return std::wstring(buf.data());
-	//}
-	//inline std::string StringToUpper(const std::string& s)
-	//{
- //   std::vector<char> buf(s.length() + 1);
-	//	strcpy(buf.data(), s.c_str());
-	//	CharUpperBuffA(buf.data(), (DWORD)s.length());
-	//	return std::string(buf.data());
-	//}
-	//template<typename Char>
-	//inline std::basic_string<Char> StringToUpper(const std::basic_string<Char>& s)// last-ditch for alternative char types
-	//{
- //   std::basic_string<Char> r;
- //   r.reserve(s.size());
- //   std::basic_string<Char>::const_iterator it;
- //   for(it = s.begin(); it != s.end(); ++ it)
- //   {
-	//		if(*it < 0x8000)
-	//		{
-	//			r.push_back((Char)CharUpperW((PWSTR)*it));
- //     }
- //     else
- //     {
-	//			r.push_back(*it);
- //     }
- //   }
- //   return r;
-	//}
- // template<typename Char>
- // inline std::basic_string<Char> StringToUpper(const Char* s)
- // {
-	//	return StringToUpper(std::basic_string<Char>(s));
- // }
+		void Release()
+		{
+			delete [] m_hashes;
+			::operator delete(m_entries);
+			m_hashes = 0;
+			m_entries = 0;
+			m_mask = 0;
+		}
 
+		size_t* m_hashes;
+		Entry* m_entries;
+		size_t m_mask;
+		size_t m_size;
+		size_t m_seed;
+	};
 
-	//// StringToLower --------------------------------------------------------------------------------------
-	//inline std::wstring StringToLower(const std::wstring& s)
-	//{
-	//	Blob<wchar_t> buf(s.length() + 1);
-	//	wcscpy(buf.GetBuffer(), s.c_str());
-	//	CharLowerBuffW(buf.GetBuffer(), (DWORD)s.length());
-	//	return std::wstring(buf.GetBuffer());
-	//}
-	//inline std::string StringToLower(const std::string& s)
-	//{
-	//	Blob<char> buf(s.length() + 1);
-	//	strcpy(buf.GetBuffer(), s.c_str());
-	//	CharLowerBuffA(buf.GetBuffer(), (DWORD)s.length());
-	//	return std::string(buf.GetBuffer());
-	//}
-	//template<typename Char>
-	//inline std::basic_string<Char> StringToLower(const std::basic_string<Char>& s)// last-ditch for alternative char types
-	//{
- //   std::basic_string<Char> r;
- //   r.reserve(s.size());
- //   std::basic_string<Char>::const_iterator it;
- //   for(it = s.begin(); it != s.end(); ++ it)
- //   {
-	//		if(*it < 0x8000)
-	//		{
-	//			r.push_back((Char)CharLowerW((PWSTR)*it));
- //     }
- //     else
- //     {
-	//			r.push_back(*it);
- //     }
- //   }
- //   return r;
-	//}
- // template<typename Char>
- // inline std::basic_string<Char> StringToLower(const Char* s)
- // {
-	//	return StringToLower(std::basic_string<Char>(s));
- // }
+	// StringPool / InternedString --------------------------------------------------------------------------------------
+	// interns strings: each distinct string is stored once, at an address that doesn't change until the pool is
+	// destroyed. an InternedString handle is just that address, so handles from the same pool compare in O(1) and
+	// carry the string's length and StringHash. an empty string interns to the null handle.
+	// looking up a string that's already in the pool takes no lock. adding one takes the pool's mutex. the table is
+	// open addressing over atomic entry pointers, published with release stores; when it grows, the new table is
+	// published whole and the old ones are kept until the pool is destroyed, so a reader never sees freed memory.
+	template<typename Char>
+	struct InternedStringEntry
+	{
+		size_t hash;
+		size_t len;
+		Char str[1];// allocated to len + 1
+	};
 
+	template<typename Char>
+	class InternedString
+	{
+	public:
+		typedef InternedStringEntry<Char> Entry;
 
+		InternedString() :
+			m_entry(0)
+		{
+		}
 
-	// StringEquals. --------------------------------------------------------------------------------------
-	template<typename TiterL, typename TiterR, typename TstrL, typename TstrR>
-	inline bool InternalStringEquals1(TstrL lhs, TstrR rhs)
-  {
-		TiterL itl = StringBegin(lhs);
-		TiterR itr = StringBegin(rhs);
-		while(true)
+		explicit InternedString(const Entry* e) :
+			m_entry(e)
 		{
-			bool lend = StringIsEnd(itl, lhs);
-			bool rend = StringIsEnd(itr, rhs);
-			if(lend)
-				return rend;
-			if(rend)
-				return lend;
-			if(*itl != *itr)
-				return false;
-			++ itl;
-			++ itr;
 		}
-		return true;
-  }
-	// no-conversion cases
-	template<typename Char>
-  inline bool StringEquals(const Char* lhs, const Char* rhs)
-	{
-		return InternalStringEquals1<const Char*, const Char*>(lhs, rhs);
-	}
-	template<typename Char>
-	inline bool StringEquals(const Char* lhs, const std::basic_string<Char>& rhs)
-	{
-		return InternalStringEquals1<const Char*, std::basic_string<Char>::const_iterator>(lhs, rhs);
-	}
-	template<typename Char>
-  inline bool StringEquals(const std::basic_string<Char>& lhs, const Char* rhs)
-	{
-		return InternalStringEquals1<std::basic_string<Char>::const_iterator, const Char*>(lhs, rhs);
-	}
+
+		const Char* c_str() const
+		{
+			static const Char empty = 0;
+			return m_entry ? m_entry->str : &empty;
+		}
+		size_t size() const
+		{
+			return m_entry ? m_entry->len : 0;
+		}
+		bool empty() const
+		{
+			return m_entry == 0;
+		}
+		size_t hash() const
+		{
+			return m_entry ? m_entry->hash : InternalStringHash<Char>(0, 0);
+		}
+		StringView<Char> view() const
+		{
+			return StringView<Char>(c_str(), size());
+		}
+		std::basic_string<Char> str() const
+		{
+			return std::basic_string<Char>(c_str(), size());
+		}
+
+		// only meaningful between handles from the same pool.
+		bool operator ==(const InternedString<Char>& rhs) const
+		{
+			return m_entry == rhs.m_entry;
+		}
+		bool operator !=(const InternedString<Char>& rhs) const
+		{
+			return m_entry != rhs.m_entry;
+		}
+		// orders by address (stable for the life of the pool, but not alphabetical), for use as a map key.
+		bool operator <(const InternedString<Char>& rhs) const
+		{
+			return std::less<const Entry*>()(m_entry, rhs.m_entry);
+		}
+
+	private:
+		const Entry* m_entry;
+	};
+
 	template<typename Char>
-	inline bool StringEquals(const std::basic_string<Char>& lhs, const std::basic_string<Char>& rhs)
+	class StringPool
 	{
-		return InternalStringEquals1<std::basic_string<Char>::const_iterator, std::basic_string<Char>::const_iterator>(lhs, rhs);
-	}
-	// conversion cases
-  template<typename CharL, typename CharR, typename Tleft, typename Tright>
-	inline bool InternalStringEquals2(Tleft lhs, Tright rhs)
-  {
-		if(sizeof(CharL) > sizeof(CharR))
+	public:
+		typedef InternedStringEntry<Char> Entry;
+
+		explicit StringPool(size_t initialCapacity = 64) :
+			m_count(0)
 		{
-			std::basic_string<CharL> temp;
-			StringConvert(rhs, temp);
-			return StringEquals(lhs, temp);
+			size_t capacity = 16;
+			while(capacity < initialCapacity * 2)
+				capacity <<= 1;
+			m_table.store(NewTable(capacity, 0), std::memory_order_relaxed);
 		}
-		else
+
+		~StringPool()
 		{
-			std::basic_string<CharR> temp;
-			StringConvert(lhs, temp);
-			return StringEquals(temp, rhs);
+			Table* t = m_table.load(std::memory_order_relaxed);
+			for(size_t i = 0; i <= t->mask; ++ i)
+			{
+				const Entry* e = t->slots[i].load(std::memory_order_relaxed);
+				if(e)
+					::operator delete(const_cast<Entry*>(e));
+			}
+			while(t)
+			{
+				Table* previous = t->previous;
+				delete [] t->slots;
+				delete t;
+				t = previous;
+			}
+		}
+
+		// lock-free. returns the null handle if s hasn't been interned.
+		InternedString<Char> Find(const Char* s, size_t len) const
+		{
+			if(len == 0)
+				return InternedString<Char>();
+			return InternedString<Char>(Lookup(m_table.load(std::memory_order_acquire), s, len, InternalStringHash(s, len)));
+		}
+		InternedString<Char> Find(const Char* s) const
+		{
+			return Find(s, StringLength(s));
+		}
+		InternedString<Char> Find(const std::basic_string<Char>& s) const
+		{
+			return Find(s.c_str(), s.size());
+		}
+		InternedString<Char> Find(const StringView<Char>& s) const
+		{
+			return Find(s.data(), s.size());
 		}
-  }
-  template<typename CharL, typename CharR>
-	inline bool StringEquals(const CharL* lhs, const CharR* rhs)
-  {
-		return InternalStringEquals2<CharL, CharR>(lhs, rhs);
-  }
-  template<typename CharL, typename CharR>
-	inline bool StringEquals(const CharL* lhs, const std::basic_string<CharR>& rhs)
-  {
-		return InternalStringEquals2<CharL, CharR>(lhs, rhs);
-  }
-  template<typename CharL, typename CharR>
-	inline bool StringEquals(const std::basic_string<CharL>& lhs, const CharR* rhs)
-  {
-		return InternalStringEquals2<CharL, CharR>(lhs, rhs);
-  }
-  template<typename CharL, typename CharR>
-	inline bool StringEquals(const std::basic_string<CharL>& lhs, const std::basic_string<CharR>& rhs)
-  {
-		return InternalStringEquals2<CharL, CharR>(lhs, rhs);
-  }
 
+		InternedString<Char> Intern(const Char* s, size_t len)
+		{
+			if(len == 0)
+				return InternedString<Char>();
+			size_t hash = InternalStringHash(s, len);
+			const Entry* e = Lookup(m_table.load(std::memory_order_acquire), s, len, hash);
+			if(e)
+				return InternedString<Char>(e);
 
+			std::lock_guard<std::mutex> lock(m_mutex);
+			Table* t = m_table.load(std::memory_order_relaxed);
+			e = Lookup(t, s, len, hash);// someone may have added it since.
+			if(e)
+				return InternedString<Char>(e);
 
-	// StringEqualsI --------------------------------------------------------------------------------------
-	//template<typename TiterL, typename TiterR, typename TstrL, typename TstrR>
-	//inline bool InternalStringEqualsI1(TstrL lhs, TstrR rhs)
- // {
-	//	TiterL itl = StringBegin(lhs);
-	//	TiterR itr = StringBegin(rhs);
-	//	while(true)
-	//	{
-	//		bool lend = StringIsEnd(itl, lhs);
-	//		bool rend = StringIsEnd(itr, rhs);
-	//		if(lend)
-	//			return rend;
-	//		if(rend)
-	//			return lend;
-	//		if(CharToLower(*itl) != CharToLower(*itr))
-	//			return false;
-	//		++ itl;
-	//		++ itr;
-	//	}
-	//	return true;
- // }
-	//// no-conversion cases
-	//template<typename Char>
- // inline bool StringEqualsI(const Char* lhs, const Char* rhs)
-	//{
-	//	return InternalStringEqualsI1<const Char*, const Char*>(lhs, rhs);
-	//}
-	//template<typename Char>
-	//inline bool StringEqualsI(const Char* lhs, const std::basic_string<Char>& rhs)
-	//{
-	//	return InternalStringEqualsI1<const Char*, std::basic_string<Char>::const_iterator>(lhs, rhs);
-	//}
-	//template<typename Char>
- // inline bool StringEqualsI(const std::basic_string<Char>& lhs, const Char* rhs)
-	//{
-	//	return InternalStringEqualsI1<std::basic_string<Char>::const_iterator, const Char*>(lhs, rhs);
-	//}
-	//template<typename Char>
-	//inline bool StringEqualsI(const std::basic_string<Char>& lhs, const std::basic_string<Char>& rhs)
-	//{
-	//	return InternalStringEqualsI1<std::basic_string<Char>::const_iterator, std::basic_string<Char>::const_iterator>(lhs, rhs);
-	//}
-	//// conversion cases
- // template<typename CharL, typename CharR, typename Tleft, typename Tright>
-	//inline bool InternalStringEqualsI2(Tleft lhs, Tright rhs)
- // {
-	//	if(sizeof(CharL) > sizeof(CharR))
-	//	{
-	//		std::basic_string<CharL> temp;
-	//		StringConvert(rhs, temp);
-	//		return StringEqualsI(lhs, temp);
-	//	}
-	//	else
-	//	{
-	//		std::basic_string<CharR> temp;
-	//		StringConvert(lhs, temp);
-	//		return StringEqualsI(temp, rhs);
-	//	}
- // }
- // template<typename CharL, typename CharR>
-	//inline bool StringEqualsI(const CharL* lhs, const CharR* rhs)
- // {
-	//	return InternalStringEqualsI2<CharL, CharR>(lhs, rhs);
- // }
- // template<typename CharL, typename CharR>
-	//inline bool StringEqualsI(const CharL* lhs, const std::basic_string<CharR>& rhs)
- // {
-	//	return InternalStringEqualsI2<CharL, CharR>(lhs, rhs);
- // }
- // template<typename CharL, typename CharR>
-	//inline bool StringEqualsI(const std::basic_string<CharL>& lhs, const CharR* rhs)
- // {
-	//	return InternalStringEqualsI2<CharL, CharR>(lhs, rhs);
- // }
- // template<typename CharL, typename CharR>
-	//inline bool StringEqualsI(const std::basic_string<CharL>& lhs, const std::basic_string<CharR>& rhs)
- // {
-	//	return InternalStringEqualsI2<CharL, CharR>(lhs, rhs);
- // }
+			// keep the load factor at or below 1/2
+			if((m_count + 1) * 2 > t->mask + 1)
+			{
+				Table* bigger = NewTable((t->mask + 1) * 2, t);
+				for(size_t i = 0; i <= t->mask; ++ i)
+				{
+					const Entry* old = t->slots[i].load(std::memory_order_relaxed);
+					if(old)
+						bigger->slots[FindEmptySlot(bigger, old->hash)].store(old, std::memory_order_relaxed);
+				}
+				m_table.store(bigger, std::memory_order_release);
+				t = bigger;
+			}
 
-	// StringStartsWith (unfinished) --------------------------------------------------------------------------------------
-	template<typename CharL, typename CharR>
-	inline bool StringStartsWith(const CharL* str, const CharR* find)
-	{
-		while(*find != 0)
+			Entry* n = static_cast<Entry*>(::operator new(sizeof(Entry) + len * sizeof(Char)));
+			n->hash = hash;
+			n->len = len;
+			memcpy(n->str, s, len * sizeof(Char));
+			n->str[len] = 0;
+			t->slots[FindEmptySlot(t, hash)].store(n, std::memory_order_release);
+			++ m_count;
+			return InternedString<Char>(n);
+		}
+		InternedString<Char> Intern(const Char* s)
 		{
-			if(str == 0)
-				return false;
-			if(*str != *find)
-				return false;
-			str ++;
-			find ++;
+			return Intern(s, StringLength(s));
+		}
+		InternedString<Char> Intern(const std::basic_string<Char>& s)
+		{
+			return Intern(s.c_str(), s.size());
+		}
+		InternedString<Char> Intern(const StringView<Char>& s)
+		{
+			return Intern(s.data(), s.size());
 		}
-		return true;
-	}
 
-	template<typename CharL, typename CharR>
-	inline bool StringStartsWith(const std::basic_string<CharL>& str, const CharR* find)
-	{
-		std::basic_string<CharL>::const_iterator it = str.begin();
-		while(*find != 0)
+		size_t size() const
 		{
-			if(it == str.end())
-				return false;// str is ended, but find has not.
-			if(*it != *find)
-				return false;
-			++ it;
-			++ find;
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_count;
 		}
-		return true;
-	}
 
+	private:
+		StringPool(const StringPool<Char>&);
+		StringPool<Char>& operator =(const StringPool<Char>&);
+
+		struct Table
+		{
+			size_t mask;
+			std::atomic<const Entry*>* slots;
+			Table* previous;// outgrown tables; readers may still be looking at them.
+		};
 
+		static Table* NewTable(size_t capacity, Table* previous)
+		{
+			Table* t = new Table;
+			t->mask = capacity - 1;
+			t->slots = new std::atomic<const Entry*>[capacity];
+			for(size_t i = 0; i < capacity; ++ i)
+				t->slots[i].store(0, std::memory_order_relaxed);
+			t->previous = previous;
+			return t;
+		}
+
+		static const Entry* Lookup(const Table* t, const Char* s, size_t len, size_t hash)
+		{
+			for(size_t i = hash & t->mask; ; i = (i + 1) & t->mask)
+			{
+				const Entry* e = t->slots[i].load(std::memory_order_acquire);
+				if(!e)
+					return 0;
+				if(e->hash == hash && e->len == len && memcmp(e->str, s, len * sizeof(Char)) == 0)
+					return e;
+			}
+		}
+
+		static size_t FindEmptySlot(const Table* t, size_t hash)
+		{
+			size_t i = hash & t->mask;
+			while(t->slots[i].load(std::memory_order_relaxed))
+				i = (i + 1) & t->mask;
+			return i;
+		}
+
+		std::atomic<Table*> m_table;
+		mutable std::mutex m_mutex;
+		size_t m_count;
+	};
+
+	// a process-wide pool per char type, for names that live as long as the program does (log categories, etc.)
+	template<typename Char>
+	inline StringPool<Char>& GetStringPool()
+	{
+		static StringPool<Char> pool;
+		return pool;
+	}
+
+	template<typename Char>
+	inline InternedString<Char> StringIntern(const Char* s, size_t len)
+	{
+		return GetStringPool<Char>().Intern(s, len);
+	}
+	template<typename Char>
+	inline InternedString<Char> StringIntern(const Char* s)
+	{
+		return GetStringPool<Char>().Intern(s);
+	}
+	template<typename Char>
+	inline InternedString<Char> StringIntern(const std::basic_string<Char>& s)
+	{
+		return GetStringPool<Char>().Intern(s);
+	}
+	template<typename Char>
+	inline InternedString<Char> StringIntern(const StringView<Char>& s)
+	{
+		return GetStringPool<Char>().Intern(s);
+	}
 
-#endif
 
 }
 
@@ -1478,206 +4991,424 @@ namespace LibCC
 {
 	// faster than std::basic_string ?
 
-	// this needs to be a POD for the QuickStringList optimized vector.
-	template<typename _Char>
+	// StringArena. a bump allocator for request-scoped strings: allocations come out of a chain of chunks and are only
+	// released all at once, by Reset() or the destructor. it isn't thread-safe; use one per request or per thread.
+	class StringArena
+	{
+	public:
+		static const size_t Alignment = sizeof(void*) > sizeof(size_t) ? sizeof(void*) : sizeof(size_t);
+
+		explicit StringArena(size_t chunkSize = 4096) :
+			m_chunk(0),
+			m_top(0),
+			m_end(0),
+			m_chunkSize(chunkSize < 256 ? 256 : chunkSize),
+			m_chunkCount(0)
+		{
+		}
+
+		~StringArena()
+		{
+			FreeChunks(0);
+		}
+
+		void* Allocate(size_t bytes)
+		{
+			bytes = (bytes + Alignment - 1) & ~(Alignment - 1);
+			if((size_t)(m_end - m_top) < bytes)
+			{
+				// big allocations get a chunk to themselves so they don't waste the rest of the current one.
+				if(bytes > m_chunkSize / 4)
+				{
+					Chunk* c = NewChunk(bytes);
+					if(m_chunk)
+					{
+						c->next = m_chunk->next;
+						m_chunk->next = c;
+					}
+					else
+					{
+						m_chunk = c;
+						m_top = m_end = c->Begin() + bytes;
+					}
+					return c->Begin();
+				}
+				Chunk* c = NewChunk(m_chunkSize);
+				c->next = m_chunk;
+				m_chunk = c;
+				m_top = c->Begin();
+				m_end = m_top + m_chunkSize;
+			}
+			void* ret = m_top;
+			m_top += bytes;
+			return ret;
+		}
+
+		// grows p in place, if it's the most recent allocation and there's room left in its chunk.
+		bool Extend(void* p, size_t oldBytes, size_t newBytes)
+		{
+			oldBytes = (oldBytes + Alignment - 1) & ~(Alignment - 1);
+			newBytes = (newBytes + Alignment - 1) & ~(Alignment - 1);
+			if((char*)p + oldBytes != m_top || (size_t)(m_end - (char*)p) < newBytes)
+				return false;
+			m_top = (char*)p + newBytes;
+			return true;
+		}
+
+		// releases everything, so nothing that allocated from the arena can still be in use. one default-size chunk is
+		// kept for reuse.
+		void Reset()
+		{
+			Chunk* keep = 0;
+			for(Chunk* c = m_chunk; c; c = c->next)
+			{
+				if(c->size == m_chunkSize)
+				{
+					keep = c;
+					break;
+				}
+			}
+			FreeChunks(keep);
+			m_chunk = keep;
+			m_top = keep ? keep->Begin() : 0;
+			m_end = keep ? m_top + m_chunkSize : 0;
+		}
+
+		size_t ChunkCount() const
+		{
+			return m_chunkCount;
+		}
+
+	private:
+		StringArena(const StringArena&);
+		StringArena& operator =(const StringArena&);
+
+		struct Chunk
+		{
+			Chunk* next;
+			size_t size;
+			char* Begin()
+			{
+				return (char*)this + ((sizeof(Chunk) + Alignment - 1) & ~(Alignment - 1));
+			}
+		};
+
+		Chunk* NewChunk(size_t bytes)
+		{
+			Chunk* c = (Chunk*)HeapAlloc(GetProcessHeap(), 0, ((sizeof(Chunk) + Alignment - 1) & ~(Alignment - 1)) + bytes);
+			c->next = 0;
+			c->size = bytes;
+			++ m_chunkCount;
+			return c;
+		}
+
+		void FreeChunks(Chunk* except)
+		{
+			Chunk* c = m_chunk;
+			while(c)
+			{
+				Chunk* next = c->next;
+				if(c != except)
+				{
+					HeapFree(GetProcessHeap(), 0, c);
+					-- m_chunkCount;
+				}
+				else
+				{
+					c->next = 0;
+				}
+				c = next;
+			}
+		}
+
+		Chunk* m_chunk;// the current chunk, followed by older ones
+		char* m_top;
+		char* m_end;
+		size_t m_chunkSize;
+		size_t m_chunkCount;
+	};
+
+	// a small-string-optimized string. it needs to be a POD so QuickStringList can move it around with memcpy / realloc,
+	// and since nothing points into it, moving it needs no fix-ups.
+	// up to Capacity chars (at least InlineCapacity) are stored in buffer. the last unit of buffer holds how much inline
+	// capacity is left (Capacity - length), so for a full inline string it's also the terminator. a heap string sets
+	// that unit to HeapMarker and keeps pointer / length / allocation in the front of buffer. heap.allocated == 0 means
+	// the chars are borrowed (an interned string, for example); they're never freed and the first change copies them.
+	// the functions that allocate take the StringArena the string's list uses, or 0 for the process heap.
+	template<typename _Char, size_t InlineCapacity>
 	struct QuickStringData
 	{
-		size_t m_len;
-		size_t m_allocated;
-		static const size_t staticBufferSize = 16;
-		_Char staticBuffer[staticBufferSize];
-		_Char* dynBuffer;
-		_Char* p;
+		typedef typename std::make_unsigned<_Char>::type Unit;
+
+		struct Heap
+		{
+			_Char* p;
+			size_t len;
+			size_t allocated;// in chars, including the terminator
+		};
+
+		// at least InlineCapacity + 1 units and enough to hold Heap plus the marker, rounded up to use the padding.
+		static const size_t MinUnits = (InlineCapacity * sizeof(_Char) >= sizeof(Heap)) ? InlineCapacity + 1 : (sizeof(Heap) + sizeof(_Char) - 1) / sizeof(_Char) + 1;
+		static const size_t AlignUnits = sizeof(_Char) < sizeof(size_t) ? sizeof(size_t) / sizeof(_Char) : 1;
+		static const size_t BufferUnits = (MinUnits + AlignUnits - 1) / AlignUnits * AlignUnits;
+		static const size_t Capacity = BufferUnits - 1;
+		static const Unit HeapMarker = (Unit)~(Unit)0;
+		static_assert(Capacity < HeapMarker, "QuickStringData inline capacity is too large for the char type");
+
+		union
+		{
+			Heap heap;
+			_Char buffer[BufferUnits];
+		};
+
+		bool IsHeap() const
+		{
+			return (Unit)buffer[Capacity] == HeapMarker;
+		}
+
+		size_t size() const
+		{
+			return IsHeap() ? heap.len : Capacity - (Unit)buffer[Capacity];
+		}
+
+		const _Char* c_str() const
+		{
+			return IsHeap() ? heap.p : buffer;
+		}
+
+		// empty, inline.
+		void Init()
+		{
+			SetInline(0);
+		}
+
+		// refers to s without copying it; s must be null terminated and stay put.
+		void Borrow(const _Char* s, size_t len)
+		{
+			SetHeap(const_cast<_Char*>(s), len, 0);
+		}
+
+		void Free(StringArena* arena)
+		{
+			if(!arena && IsHeap() && heap.allocated != 0)
+			{
+				HeapFree(GetProcessHeap(), 0, heap.p);
+			}
+		}
+
+		// after memcpy'ing another QuickStringData over this, gives it its own heap allocation.
+		void Unshare(StringArena* arena)
+		{
+			if(IsHeap() && heap.allocated != 0)
+			{
+				_Char* p = Allocate(arena, heap.allocated);
+				memcpy(p, heap.p, (heap.len + 1) * sizeof(_Char));
+				heap.p = p;
+			}
+		}
+
+		// makes room for n chars plus the terminator, keeping the contents. growth is geometric; a heap string grows
+		// with HeapReAlloc, and an arena string in place when it's the arena's latest allocation.
+		void Reserve(size_t n, StringArena* arena)
+		{
+			size_t allocated;
+			if(!IsHeap())
+			{
+				if(n <= Capacity)
+					return;
+				allocated = std::max(n + 1, BufferUnits * 2);
+			}
+			else
+			{
+				if(n < heap.allocated)
+					return;
+				allocated = std::max(n + 1, heap.allocated * 2);
+			}
+
+			size_t len = size();
+			_Char* p;
+			if(IsHeap() && heap.allocated != 0 && !arena)
+			{
+				p = (_Char*)HeapReAlloc(GetProcessHeap(), 0, heap.p, allocated * sizeof(_Char));
+			}
+			else if(IsHeap() && heap.allocated != 0 && arena->Extend(heap.p, heap.allocated * sizeof(_Char), allocated * sizeof(_Char)))
+			{
+				p = heap.p;
+			}
+			else
+			{
+				p = Allocate(arena, allocated);
+				memcpy(p, c_str(), len * sizeof(_Char));
+				p[len] = 0;
+			}
+			SetHeap(p, len, allocated);
+		}
+
+		// sets the length to n (keeping what's there, up to n) and returns the writable chars, already terminated.
+		_Char* Resize(size_t n, StringArena* arena)
+		{
+			Reserve(n, arena);
+			if(IsHeap())
+			{
+				heap.len = n;
+				heap.p[n] = 0;
+				return heap.p;
+			}
+			SetInline(n);
+			return buffer;
+		}
+
+	private:
+		static _Char* Allocate(StringArena* arena, size_t units)
+		{
+			if(arena)
+				return (_Char*)arena->Allocate(units * sizeof(_Char));
+			return (_Char*)HeapAlloc(GetProcessHeap(), 0, units * sizeof(_Char));
+		}
+
+		void SetInline(size_t n)
+		{
+			buffer[n] = 0;
+			buffer[Capacity] = (_Char)(Capacity - n);// when n == Capacity, this is the terminator
+		}
+
+		void SetHeap(_Char* p, size_t len, size_t allocated)
+		{
+			heap.p = p;
+			heap.len = len;
+			heap.allocated = allocated;
+			buffer[Capacity] = (_Char)HeapMarker;
+		}
 	};
 
 	// attaches to QuickStringData to act like a std::wstring.
-	template<typename _Char>
+	template<typename _Char, size_t InlineCapacity = LIBCC_QUICKSTRING_INLINE>
 	struct QuickString
 	{
-	//private:
-	//	QuickString<_Char>& operator =(QuickString<_Char>& rhs)
-	//	{
-	//		return *this;
-	//	}
-	//	QuickString(QuickString<_Char>& rhs)
-	//	{
-	//	}
-
 	public:
-		QuickString(QuickStringData<_Char>* data_) :
-			data(data_)
+		QuickString(QuickStringData<_Char, InlineCapacity>* data_, StringArena* arena_ = 0) :
+			data(data_),
+			arena(arena_)
 		{
 		}
 
 		inline const _Char* c_str() const
 		{
-			return data->p;
+			return data->c_str();
 		}
 
 		inline size_t size() const
 		{
-			return data->m_len;
+			return data->size();
 		}
 
 		inline void append(const _Char* c)
 		{
 			size_t inputLen = LibCC::StringLength(c);
-			AddAlloc(inputLen);
-			_Char* i = data->p + data->m_len;
-			memcpy(i, c, sizeof(_Char) * inputLen);
-			i += inputLen;
-			*i = 0;
-			data->m_len += inputLen;
+			size_t len = data->size();
+			_Char* p = data->Resize(len + inputLen, arena);
+			memcpy(p + len, c, sizeof(_Char) * inputLen);
 		}
 
 		inline void push_back(_Char ch)
 		{
-			AddAlloc(1);
-			_Char* i = data->p + data->m_len;
-			*i = ch;
-			++ i;
-			*i = 0;
-			data->m_len ++;
+			size_t len = data->size();
+			_Char* p = data->Resize(len + 1, arena);
+			p[len] = ch;
 		}
 
 		inline void reserve(size_t n)
 		{
-			if(data->m_allocated >= n)
-				return;
-
-			if(data->p != data->staticBuffer)
-			{
-				HeapFree(GetProcessHeap(), 0, data->p);
-			}
-			data->m_len = 0;
-			data->m_allocated = n + 1;
-			data->dynBuffer = (_Char*)HeapAlloc(GetProcessHeap(), 0, data->m_allocated * sizeof(_Char));
-			data->p = data->dynBuffer;
+			data->Reserve(n, arena);
 		}
 
 		bool empty() const
 		{
-			return data->p[0] == 0;
+			return data->size() == 0;
 		}
 
 		typedef _Char* iterator;
 		typedef const _Char* const_iterator;
 		iterator begin()
 		{
-			return data->p;
+			return const_cast<_Char*>(data->c_str());
 		}
 		iterator end()
 		{
-			return data->p + data->m_len;
+			return begin() + data->size();
 		}
 
 		const_iterator begin() const
 		{
-			return data->p;
+			return data->c_str();
 		}
 		const_iterator end() const
 		{
-			return data->p + data->m_len;
+			return data->c_str() + data->size();
 		}
 
 		void assign(const _Char* rhs)
 		{
-			size_t inputLen = LibCC::StringLength(rhs) + 1;
-			reserve(inputLen);
-			memcpy(data->p, rhs, sizeof(_Char) * inputLen);
+			size_t inputLen = LibCC::StringLength(rhs);
+			memcpy(data->Resize(inputLen, arena), rhs, sizeof(_Char) * inputLen);
 		}
 
 	private:
-		inline void AddAlloc(size_t additional)
-		{
-			if(data->m_allocated < (data->m_len + 1 + additional))// 1 for null term
-			{
-				data->m_allocated = std::max(additional + 1, data->m_allocated << 1);
-				_Char* newp = (_Char*)HeapAlloc(GetProcessHeap(), 0, data->m_allocated * sizeof(_Char));
-				memcpy(newp, data->p, data->m_len * sizeof(_Char));
-				if(data->p != data->staticBuffer)
-				{
-					HeapFree(GetProcessHeap(), 0, data->p);
-				}
-				data->p = newp;
-			}
-		}
-
-		QuickStringData<_Char>* data;
+		QuickStringData<_Char, InlineCapacity>* data;
+		StringArena* arena;
 	};
 
 	// optimized vector which handles construction / destruction of QuickStringData, and hands out QuickString to act
-	// somewhat like a std::string
-	template<typename _Char>
+	// somewhat like a std::string. given a StringArena, everything it allocates (strings that spill out of their
+	// inline buffer, and the list itself past 16 strings) comes from the arena, and is never freed individually.
+	template<typename _Char, size_t InlineCapacity = LIBCC_QUICKSTRING_INLINE>
 	struct QuickStringList
 	{
-	private:
-		//QuickStringList<_Char>& operator =(QuickStringList<_Char>& rhs)
-		//{
-		//	return *this;
-		//}
-		//QuickStringList(QuickStringList<_Char>& rhs)
-		//{
-		//}
+		typedef QuickStringData<_Char, InlineCapacity> Data;
+		typedef QuickString<_Char, InlineCapacity> String;
 
-	public:
-		QuickStringList() :
+		explicit QuickStringList(StringArena* arena = 0) :
 			m_listLen(0),
 			m_listAllocated(listStaticBufferSize),
-			listp(listStaticBuffer)
+			listp(listStaticBuffer),
+			m_arena(arena)
 		{
 		}
 
 		// hope we can avoid this 
-		QuickStringList<_Char>& operator =(const QuickStringList<_Char>& rhs)
+		QuickStringList<_Char, InlineCapacity>& operator =(const QuickStringList<_Char, InlineCapacity>& rhs)
 		{
+			if(this == &rhs)
+				return *this;
 			clear();
+			Reserve(rhs.m_listLen);
 
+			// copy, then give the heap strings their own copies.
+			memcpy(listp, rhs.listp, rhs.m_listLen * sizeof(Data));
 			m_listLen = rhs.m_listLen;
-			m_listAllocated = rhs.m_listAllocated;
-
-			// allocate.
-			if(m_listAllocated > listStaticBufferSize)
-			{
-				listp = (QuickStringData<_Char>*)HeapAlloc(GetProcessHeap(), 0, sizeof(QuickStringData<_Char>) * m_listAllocated);
-				listp = listDynBuffer;
-			}
-
-			// copy.
-			memcpy(listp, rhs.listp, m_listLen * sizeof(QuickStringData<_Char>));
-			// fix up pointers to static data
-			QuickStringData<_Char>* i = listp;
-			QuickStringData<_Char>* end = listp + m_listLen;
-			for(; i != end; ++ i)
+			for(size_t i = 0; i < m_listLen; ++ i)
 			{
-				if(i->m_allocated <= QuickStringData<_Char>::staticBufferSize)
-					i->p = i->staticBuffer;
-				else
-				{
-					// dynamic alloc :(
-					i->dynBuffer = (_Char*)HeapAlloc(GetProcessHeap(), 0, i->m_allocated * sizeof(_Char));
-					memcpy(i->dynBuffer, i->p, (i->m_len + 1) * sizeof(_Char));
-					i->p = i->dynBuffer;
-				}
+				listp[i].Unshare(m_arena);
 			}
 
 			return *this;
 		}
 
-		QuickStringList(const QuickStringList<_Char>& rhs) :
+		// the copy allocates from the same arena as rhs.
+		QuickStringList(const QuickStringList<_Char, InlineCapacity>& rhs) :
 			m_listLen(0),
 			m_listAllocated(listStaticBufferSize),
-			listp(listStaticBuffer)
+			listp(listStaticBuffer),
+			m_arena(rhs.m_arena)
 		{
 			*this = rhs;
 		}
 
-
 		~QuickStringList()
 		{
 			// free all strings
 			clear();
-			if(listp != listStaticBuffer)
+			if(listp != listStaticBuffer && !m_arena)
 			{
 				HeapFree(GetProcessHeap(), 0, listp);
 			}
@@ -1690,218 +5421,195 @@ namespace LibCC
 
 		void clear()
 		{
-			QuickStringData<_Char>* i = listp;
-			QuickStringData<_Char>* end = listp + m_listLen;
-			for(;i != end; ++ i)
+			if(!m_arena)// arena strings go when the arena does
 			{
-				if(i->p != i->staticBuffer)
+				Data* i = listp;
+				Data* end = listp + m_listLen;
+				for(;i != end; ++ i)
 				{
-					HeapFree(GetProcessHeap(), 0, i->p);
+					i->Free(0);
 				}
 			}
 			m_listLen = 0;
 		}
 
-		QuickString<_Char> operator[] (size_t index)
+		String operator[] (size_t index)
 		{
-			return QuickString<_Char>(&listp[index]);
+			return String(&listp[index], m_arena);
 		}
 
-		QuickString<_Char> operator[] (size_t index) const
+		String operator[] (size_t index) const
 		{
-			return QuickString<_Char>(&listp[index]);
+			return String(&listp[index], m_arena);
 		}
 
-		// creates room for X strings, and returns the first one available, UNCONSTRUCTED.
-		QuickStringData<_Char>* AddAlloc(size_t additional)
+		StringArena* GetArena() const
 		{
-			if(m_listAllocated < (m_listLen + additional))
-			{
-				// realloc. todo: actually use realloc
-				size_t newAllocated = std::max(m_listAllocated * 2, m_listLen + additional);
-				QuickStringData<_Char>* newp = (QuickStringData<_Char>*)HeapAlloc(GetProcessHeap(), 0, sizeof(QuickStringData<_Char>) * newAllocated);
-				// copy dynBuffer to newp
-				memcpy(newp, listp, m_listLen * sizeof(QuickStringData<_Char>));
-				//memset(p, 0, m_len * sizeof(QuickStringData<_Char>));// DEBUGGING PURPOSES ONLY
-				if(listp != listStaticBuffer)
-				{
-					HeapFree(GetProcessHeap(), 0, listp);
-				}
+			return m_arena;
+		}
 
-				m_listAllocated = newAllocated;
-				listDynBuffer = newp;
-				listp = listDynBuffer;
+		// room for n strings in all
+		void Reserve(size_t n)
+		{
+			if(m_listAllocated >= n)
+				return;
 
-				// fix up pointers to static data
-				QuickStringData<_Char>* i = listp;
-				QuickStringData<_Char>* end = listp + m_listLen;
-				for(; i != end; ++ i)
+			// the strings don't point into themselves, so they can be moved with realloc.
+			size_t newAllocated = std::max(m_listAllocated * 2, n);
+			if(m_arena)
+			{
+				if(listp == listStaticBuffer || !m_arena->Extend(listp, sizeof(Data) * m_listAllocated, sizeof(Data) * newAllocated))
 				{
-					if(i->m_allocated <= QuickStringData<_Char>::staticBufferSize)
-						i->p = i->staticBuffer;
+					Data* newp = (Data*)m_arena->Allocate(sizeof(Data) * newAllocated);
+					memcpy(newp, listp, m_listLen * sizeof(Data));
+					listp = newp;
 				}
 			}
-			m_listLen ++;
-			return listp + m_listLen - 1;
-		}
-
-		void ConstructAlloc(QuickStringData<_Char>* data)
-		{
-			if(data->m_allocated > QuickStringData<_Char>::staticBufferSize)
+			else if(listp == listStaticBuffer)
 			{
-				data->dynBuffer = (_Char*)HeapAlloc(GetProcessHeap(), 0, data->m_allocated * sizeof(_Char));
-				data->p = data->dynBuffer;
+				listp = (Data*)HeapAlloc(GetProcessHeap(), 0, sizeof(Data) * newAllocated);
+				memcpy(listp, listStaticBuffer, m_listLen * sizeof(Data));
 			}
 			else
 			{
-				data->p = data->staticBuffer;
+				listp = (Data*)HeapReAlloc(GetProcessHeap(), 0, listp, sizeof(Data) * newAllocated);
 			}
+			m_listAllocated = newAllocated;
 		}
 
-		QuickString<_Char> push_back()
+		// creates room for X strings, and returns the first one available, UNCONSTRUCTED.
+		Data* AddAlloc(size_t additional)
 		{
-			QuickStringData<_Char>* back = AddAlloc(1);
-			ConstructQuickString(back);
-			return QuickString<_Char>(back);
+			Reserve(m_listLen + additional);
+			Data* ret = listp + m_listLen;
+			m_listLen += additional;
+			return ret;
 		}
 
-		void ConstructQuickString(QuickStringData<_Char>* data)
+		String push_back()
 		{
-			data->p = data->staticBuffer;
-			data->m_len = 0;
-			data->m_allocated = QuickStringData<_Char>::staticBufferSize;
+			Data* back = AddAlloc(1);
+			back->Init();
+			return String(back, m_arena);
 		}
 
-		QuickString<_Char> push_back(const _Char* s, _Char open, _Char close)
+		String push_back(const _Char* s, _Char open, _Char close)
 		{
-			QuickStringData<_Char>* back = AddAlloc(1);
+			Data* back = AddAlloc(1);
 			ConstructQuickString(back, s, open, close);
-			return QuickString<_Char>(back);
+			return String(back, m_arena);
 		}
 
-		void ConstructQuickString(QuickStringData<_Char>* data, const _Char* s, _Char open, _Char close)
+		void ConstructQuickString(Data* data, const _Char* s, _Char open, _Char close)
 		{
 			size_t inputLen = s == 0 ? 0 : LibCC::StringLength(s);
-			data->m_len = inputLen + 2;
-			data->m_allocated = std::max(data->m_len + 1, QuickStringData<_Char>::staticBufferSize);
-			ConstructAlloc(data);
-
-			_Char* i = data->p;
+			data->Init();
+			_Char* i = data->Resize(inputLen + 2, m_arena);
 			*i = open;
 			++i;
 			memcpy(i, s, sizeof(_Char) * inputLen);
 			i += inputLen;
 			*i = close;
-			++i;
-			*i = 0;
 		}
 
-		QuickString<_Char> push_back(const _Char* s, int maxLen)
+		String push_back(const _Char* s, int maxLen)
 		{
-			QuickStringData<_Char>* back = AddAlloc(1);
+			Data* back = AddAlloc(1);
 			ConstructQuickString(back, s, maxLen);
-			return QuickString<_Char>(back);
+			return String(back, m_arena);
 		}
 
-		void ConstructQuickString(QuickStringData<_Char>* data, const _Char* s, int maxLen)
+		// maxLen is in code points; the cut never splits a character.
+		void ConstructQuickString(Data* data, const _Char* s, int maxLen)
 		{
-			data->m_len = s == 0 ? 0 : min((int)LibCC::StringLength(s), maxLen);
-			data->m_allocated = std::max(data->m_len + 1, QuickStringData<_Char>::staticBufferSize);
-			ConstructAlloc(data);
-
-			_Char* i = data->p;
-			memcpy(i, s, sizeof(_Char) * data->m_len);
-			i += data->m_len;
-			*i = 0;
+			size_t len = (s == 0 || maxLen <= 0) ? 0 : LibCC::CodePointTruncate(s, LibCC::StringLength(s), (size_t)maxLen);
+			data->Init();
+			memcpy(data->Resize(len, m_arena), s, sizeof(_Char) * len);
 		}
 
-		QuickString<_Char> push_back(const _Char* s)
+		String push_back(const _Char* s)
 		{
-			QuickStringData<_Char>* back = AddAlloc(1);
+			Data* back = AddAlloc(1);
 			ConstructQuickString(back, s);
-			return QuickString<_Char>(back);
+			return String(back, m_arena);
 		}
 
-		void ConstructQuickString(QuickStringData<_Char>* data, const _Char* s)
+		void ConstructQuickString(Data* data, const _Char* s)
 		{
-			data->m_len = s == 0 ? 0 : LibCC::StringLength(s);
-			data->m_allocated = std::max(data->m_len + 1, QuickStringData<_Char>::staticBufferSize);
-			ConstructAlloc(data);
+			size_t len = s == 0 ? 0 : LibCC::StringLength(s);
+			data->Init();
+			memcpy(data->Resize(len, m_arena), s, sizeof(_Char) * len);
+		}
 
-			_Char* i = data->p;
-			memcpy(i, s, sizeof(_Char) * data->m_len);
-			i += data->m_len;
-			*i = 0;
+		// references s instead of copying it; s must be null terminated and stay put for as long as the list holds it.
+		String push_back_ref(const _Char* s, size_t len)
+		{
+			Data* back = AddAlloc(1);
+			back->Borrow(s, len);
+			return String(back, m_arena);
 		}
 
-		QuickString<_Char> push_back(_Char ch, size_t count)
+		String push_back(_Char ch, size_t count)
 		{
-			QuickStringData<_Char>* back = AddAlloc(1);
+			Data* back = AddAlloc(1);
 			ConstructQuickString(back, ch, count);
-			return QuickString<_Char>(back);
+			return String(back, m_arena);
 		}
 
-		void ConstructQuickString(QuickStringData<_Char>* data, _Char ch, size_t count)
+		void ConstructQuickString(Data* data, _Char ch, size_t count)
 		{
-			data->m_len = count;
-			data->m_allocated = std::max(data->m_len + 1, QuickStringData<_Char>::staticBufferSize);
-			ConstructAlloc(data);
-
-			_Char* i = data->p;
+			data->Init();
+			_Char* i = data->Resize(count, m_arena);
 			_Char* end = i + count;
 			while(i != end)
 			{
 				*i = ch;
 				++ i;
 			}
-			*i = 0;
 		}
 
-		QuickString<_Char> push_back(const _Char* s, int maxLen, _Char open, _Char close)
+		String push_back(const _Char* s, int maxLen, _Char open, _Char close)
 		{
-			QuickStringData<_Char>* back = AddAlloc(1);
+			Data* back = AddAlloc(1);
 			ConstructQuickString(back, s, maxLen, open, close);
-			return QuickString<_Char>(back);
+			return String(back, m_arena);
 		}
 
-		void ConstructQuickString(QuickStringData<_Char>* data, const _Char* s, int maxLen, _Char open, _Char close)
+		void ConstructQuickString(Data* data, const _Char* s, int maxLen, _Char open, _Char close)
 		{
-			data->m_len = s == 0 ? min(maxLen, 2) : min((int)LibCC::StringLength(s) + 2, maxLen);
-			data->m_allocated = std::max(data->m_len + 1, QuickStringData<_Char>::staticBufferSize);
-			ConstructAlloc(data);
-
-			_Char* i = data->p;
-			if(data->m_len > 0)
+			size_t inputLen = (s == 0 || maxLen <= 2) ? 0 : LibCC::CodePointTruncate(s, LibCC::StringLength(s), (size_t)(maxLen - 2));
+			size_t len = maxLen < 2 ? (size_t)std::max(maxLen, 0) : inputLen + 2;
+			data->Init();
+			_Char* i = data->Resize(len, m_arena);
+			if(len > 0)
 			{
 				*i = open;
 				++i;
-				if(data->m_len > 1)
+				if(len > 1)
 				{
-					memcpy(i, s, sizeof(_Char) * (data->m_len - 2));
-					i += data->m_len - 2;
+					memcpy(i, s, sizeof(_Char) * (len - 2));
+					i += len - 2;
 					*i = close;
-					++i;
 				}
 			}
-			*i = 0;
 		}
 
 		size_t m_listLen;
 		size_t m_listAllocated;
 		static const size_t listStaticBufferSize = 16;
-		QuickStringData<_Char> listStaticBuffer[listStaticBufferSize];
-		QuickStringData<_Char>* listDynBuffer;
-		QuickStringData<_Char>* listp;
+		Data listStaticBuffer[listStaticBufferSize];
+		Data* listp;
+		StringArena* m_arena;
 	};
 
-	template<typename Tlhs, typename Trhs>
-	inline void __StringAppend(QuickString<Tlhs>& lhs, Trhs* rhs)
+	template<typename Tlhs, size_t InlineCapacity, typename Trhs>
+	inline void __StringAppend(QuickString<Tlhs, InlineCapacity>& lhs, Trhs* rhs)
 	{
 		lhs.append(StringConvert<Tlhs>(rhs).c_str());
 	}
 
-    template<typename _Char>
-		inline void _RuntimeAppendZeroFloat(size_t DecimalWidthMax, size_t DecimalWidthMin, size_t IntegralWidthMin, _Char PaddingChar, bool /*ForceSign*/, QuickString<_Char>& output)
+    template<typename _Char, size_t InlineCapacity>
+		inline void _RuntimeAppendZeroFloat(size_t DecimalWidthMax, size_t DecimalWidthMin, size_t IntegralWidthMin, _Char PaddingChar, bool /*ForceSign*/, QuickString<_Char, InlineCapacity>& output)
 		{
 			// zero.
 			// pre-decimal part.
@@ -1929,33 +5637,33 @@ namespace LibCC
 			}
 		}
 
-    template<typename FloatType, typename _Char>
-    inline void _RuntimeAppendNormalizedFloat(FloatType& _f, size_t Base, size_t DecimalWidthMax, size_t DecimalWidthMin, size_t IntegralWidthMin, _Char PaddingChar, bool ForceSign, QuickString<_Char>& output)
+    template<typename FloatType, typename _Char, size_t InlineCapacity>
+    inline void _RuntimeAppendNormalizedFloat(FloatType& _f, size_t Base, size_t DecimalWidthMax, size_t DecimalWidthMin, size_t IntegralWidthMin, _Char PaddingChar, bool ForceSign, QuickString<_Char, InlineCapacity>& output)
 		{
 			// how do we know how many chars we will use?  we don't right now.
-			_Char* buf = reinterpret_cast<_Char*>(_alloca(sizeof(_Char) * (2200 + IntegralWidthMin + DecimalWidthMax)));
+			_Char* buf = reinterpret_cast<_Char*>(LIBCC_ALLOCA(sizeof(_Char) * (2200 + IntegralWidthMin + DecimalWidthMax)));
 			long IntegralWidthLeft = static_cast<long>(IntegralWidthMin);
 			_Char* middle = buf + 2100 - DecimalWidthMax;
 			_Char* sIntPart = middle;
 			_Char* sDecPart = middle;
-			FloatType::Mantissa _int;// integer part raw value
-			FloatType::Mantissa _dec;// decimal part raw value
-			FloatType::Exponent exp = _f.GetExponent();// exponent raw value
-			FloatType::Mantissa m = _f.GetMantissa();
+			typename FloatType::Mantissa _int;// integer part raw value
+			typename FloatType::Mantissa _dec;// decimal part raw value
+			typename FloatType::Exponent exp = _f.GetExponent();// exponent raw value
+			typename FloatType::Mantissa m = _f.GetMantissa();
 			size_t DecBits;// how many bits out of the mantissa are used by the decimal part?
 
-			const size_t BasicTypeBits = sizeof(FloatType::BasicType)*8;
+			const size_t BasicTypeBits = sizeof(typename FloatType::BasicType)*8;
 			if((exp < FloatType::MantissaBits) && (exp > (FloatType::MantissaBits - BasicTypeBits)))
 			{
 				// write the integral (before decimal point) part.
 				DecBits = _f.MantissaBits - exp;
 				_int = m >> DecBits;// the integer part.
-				_dec = m & (((FloatType::Mantissa)1 << DecBits) - 1);
+				_dec = m & (((typename FloatType::Mantissa)1 << DecBits) - 1);
 				do
 				{
 					--IntegralWidthLeft;
 					*(-- sIntPart) = DigitToChar(static_cast<unsigned char>(_int % Base));
-					_int = _int / static_cast<FloatType::Mantissa>(Base);
+					_int = _int / static_cast<typename FloatType::Mantissa>(Base);
 				}
 				while(_int);
 
@@ -1974,17 +5682,17 @@ namespace LibCC
 					size_t DecimalWidthLeft = DecimalWidthMax;
 					size_t DecimalUsed = 0;
 					middle[0] = '.';
-					FloatType::Mantissa denominator = (FloatType::Mantissa)1 << DecBits;// same as 'capacity'.
-					FloatType::Mantissa& numerator(_dec);
-					numerator *= static_cast<FloatType::Mantissa>(Base);
-					FloatType::Mantissa digit;
+					typename FloatType::Mantissa denominator = (typename FloatType::Mantissa)1 << DecBits;// same as 'capacity'.
+					typename FloatType::Mantissa& numerator(_dec);
+					numerator *= static_cast<typename FloatType::Mantissa>(Base);
+					typename FloatType::Mantissa digit;
 					while((numerator || (DecimalUsed < DecimalWidthMin)) && DecimalWidthLeft)
 					{
 						digit = numerator / denominator;// integer division
 						// add the digit, and drill down into the remainder.
 						*(++ sDecPart) = DigitToChar(static_cast<unsigned char>(digit % Base));
 						numerator -= digit * denominator;
-						numerator *= static_cast<FloatType::Mantissa>(Base);
+						numerator *= static_cast<typename FloatType::Mantissa>(Base);
 						-- DecimalWidthLeft;
 						DecimalUsed ++;
 					}
@@ -2001,10 +5709,10 @@ namespace LibCC
 				// just do floating point divides and 
 
 				// do the integral part just like a normal int.
-				FloatType::This integerPart(_f);
+				typename FloatType::This integerPart(_f);
 				integerPart.RemoveDecimal();
 				integerPart.AbsoluteValue();
-				FloatType::BasicType fBase = static_cast<FloatType::BasicType>(Base);
+				typename FloatType::BasicType fBase = static_cast<typename FloatType::BasicType>(Base);
 				do
 				{
 					IntegralWidthLeft --;
@@ -2027,10 +5735,10 @@ namespace LibCC
 					size_t DecimalWidthLeft = DecimalWidthMax;
 					size_t DecimalUsed = 0;
 					middle[0] = '.';
-					FloatType::This val(_f);
+					typename FloatType::This val(_f);
 					val.AbsoluteValue();
 					// remove integer part.
-					FloatType::This integerPart2(val);
+					typename FloatType::This integerPart2(val);
           integerPart2.RemoveDecimal();
 					val.m_BasicVal -= integerPart2.m_BasicVal;
 					do
@@ -2072,8 +5780,8 @@ namespace LibCC
     /*
       Converts any floating point (LibCC::IEEEFloat<>) number to a string, and appends it just like any other string.
     */
-    template<typename FloatType, typename _Char>
-		inline void _RuntimeAppendFloat(const FloatType& _f, size_t Base, size_t DecimalWidthMax, size_t DecimalWidthMin, size_t IntegralWidthMin, _Char PaddingChar, bool ForceSign, QuickString<_Char>& output)
+    template<typename FloatType, typename _Char, size_t InlineCapacity>
+		inline void _RuntimeAppendFloat(const FloatType& _f, size_t Base, size_t DecimalWidthMax, size_t DecimalWidthMin, size_t IntegralWidthMin, _Char PaddingChar, bool ForceSign, QuickString<_Char, InlineCapacity>& output)
 		{
 			if(!(_f.m_val & _f.ExponentMask))
 			{
@@ -2114,8 +5822,8 @@ namespace LibCC
 			_RuntimeAppendNormalizedFloat(_f, Base, DecimalWidthMax, DecimalWidthMin, IntegralWidthMin, PaddingChar, ForceSign, output);
 		}
 
-    template<typename _Char, typename FloatType, size_t Base, size_t DecimalWidthMax, size_t DecimalWidthMin, size_t IntegralWidthMin, _Char PaddingChar, bool ForceSign>
-    inline void _AppendFloat(const FloatType& _f, QuickString<_Char>& output)
+    template<typename _Char, typename FloatType, size_t Base, size_t DecimalWidthMax, size_t DecimalWidthMin, size_t IntegralWidthMin, _Char PaddingChar, bool ForceSign, size_t InlineCapacity>
+    inline void _AppendFloat(const FloatType& _f, QuickString<_Char, InlineCapacity>& output)
 		{
 	    return _RuntimeAppendFloat<FloatType>(_f, Base, DecimalWidthMax, DecimalWidthMin, IntegralWidthMin, PaddingChar, ForceSign, output);
 		}
@@ -2290,7 +5998,7 @@ namespace LibCC
 namespace LibCC
 {
   // FormatX class declaration -----------------------------------------------------------------------------------
-  template<typename Ch = char, typename Traits = std::char_traits<Ch>, typename Alloc = std::allocator<Ch> >
+  template<typename Ch = char, typename Traits = std::char_traits<Ch>, typename Alloc = std::allocator<Ch>, size_t InlineCapacity = LIBCC_QUICKSTRING_INLINE>
   class FormatX
   {
   public:
@@ -2298,7 +6006,8 @@ namespace LibCC
     typedef Traits _Traits;
     typedef Alloc _Alloc;
     typedef std::basic_string<_Char, _Traits, _Alloc> _String;
-    typedef FormatX<_Char, _Traits, _Alloc> _This;
+    typedef FormatX<_Char, _Traits, _Alloc, InlineCapacity> _This;
+    typedef QuickString<_Char, InlineCapacity> _QuickString;
 
 		static const _Char OpenQuote = '\"';
 		static const _Char CloseQuote = '\"';
@@ -2394,6 +6103,31 @@ namespace LibCC
 		{
 		}
 
+		// arguments are kept in arena, so building and rendering the message costs the one allocation for the result
+		// (plus a format string too long for the std::string's own buffer). arena has to outlive this object.
+		explicit FormatX(StringArena& arena) :
+			m_isRendered(false),
+			m_argumentCharSize(0),
+			m_dynArguments(&arena)
+		{
+		}
+
+		FormatX(const _String& s, StringArena& arena) :
+			m_Format(s),
+			m_isRendered(false),
+			m_argumentCharSize(0),
+			m_dynArguments(&arena)
+		{
+		}
+
+		FormatX(const _Char* s, StringArena& arena) :
+			m_Format(s),
+			m_isRendered(false),
+			m_argumentCharSize(0),
+			m_dynArguments(&arena)
+		{
+		}
+
       // there's no good reason to allow this. Use the appropriate FormatA/FormatW/etc.
   //  template<typename CharX>
   //  explicit inline FormatX(const CharX* s) :
@@ -2493,6 +6227,15 @@ namespace LibCC
 			Render();
 			return m_rendered.c_str();
 		}
+		// renders and hands the result over without copying it. this is left empty, as after Clear().
+		_String ReleaseStr()
+		{
+			Render();
+			_String ret;
+			ret.swap(m_rendered);
+			Clear();
+			return ret;
+		}
 		operator _String() const
 		{
 			Render();
@@ -2580,6 +6323,13 @@ namespace LibCC
 			return *this;
 		}
 
+		// interned strings are referenced rather than copied; the pool has to outlive this object.
+    _This& s(const InternedString<_Char>& s)
+		{
+			AddArg(s);
+			return *this;
+		}
+
 		// now all that but in foreign char types
     template<typename aChar>
     _This& s(const aChar* foreign)
@@ -2593,8 +6343,8 @@ namespace LibCC
 			return *this;
 		}
 
-    template<typename fChar, typename fTraits, typename fAlloc>
-		_This& s(const LibCC::FormatX<fChar, fTraits, fAlloc>& str)
+    template<typename fChar, typename fTraits, typename fAlloc, size_t fInlineCapacity>
+		_This& s(const LibCC::FormatX<fChar, fTraits, fAlloc, fInlineCapacity>& str)
 		{
 			return s(str.Str());
 		}
@@ -2655,14 +6405,16 @@ namespace LibCC
 		
 		_This& NewLine()
 		{
-			AppendNewLine(m_Composite);
-			return *this;
+			_String nl;
+			AppendNewLine(nl);
+			return s(nl);
 		}
 		
 		_This& NewParagraph()
 		{
-			AppendNewParagraph(m_Composite);
-			return *this;
+			_String nl;
+			AppendNewParagraph(nl);
+			return s(nl);
 		}
 
     // QUOTED STRINGS (maxlen)
@@ -2796,7 +6548,7 @@ namespace LibCC
     _This& ul(unsigned long n, size_t Base, size_t Width = 0, _Char PadChar = '0')
 		{
 			const size_t BufferSize = _RuntimeBufferSizeNeededInteger<unsigned long>(Width);
-			_Char* buf = (_Char*)_alloca(BufferSize * sizeof(_Char));
+			_Char* buf = (_Char*)LIBCC_ALLOCA(BufferSize * sizeof(_Char));
 			_Char* p = buf + BufferSize - 1;
 			*p = 0;
 			return s(_RuntimeUnsignedNumberToString<unsigned long>(p, n, Base, Width, PadChar));
@@ -2839,7 +6591,7 @@ namespace LibCC
     _This& l(signed long n, size_t Base, size_t Width = 0, _Char PadChar = '0', bool ForceShowSign = false)
 		{
 			const size_t BufferSize = _RuntimeBufferSizeNeededInteger<unsigned long>(Width);
-			_Char* buf = (_Char*)_alloca(BufferSize * sizeof(_Char));
+			_Char* buf = (_Char*)LIBCC_ALLOCA(BufferSize * sizeof(_Char));
 			_Char* p = buf + BufferSize - 1;
 			*p = 0;
 			return s(_RuntimeSignedNumberToString(p, n, Base, Width, PadChar, ForceShowSign));
@@ -2905,7 +6657,7 @@ namespace LibCC
     template<size_t DecimalWidthMax, size_t DecimalWidthMin, size_t IntegralWidthMin, _Char PaddingChar, bool ForceSign, size_t Base>
     _This& f(float val)
 		{
-			QuickString<_Char> back = AddArg();
+			_QuickString back = AddArg();
 	    _AppendFloat<_Char, SinglePrecisionFloat, Base, DecimalWidthMax, DecimalWidthMin, IntegralWidthMin, PaddingChar, ForceSign>(val, back);
 			m_argumentCharSize += back.size();
 			return *this;
@@ -2942,7 +6694,7 @@ namespace LibCC
 
     _This& f(float val, size_t DecimalWidthMax, size_t IntegralWidthMin = 1, _Char PaddingChar = '0', bool ForceSign = false, size_t Base = 10)
 		{
-			QuickString<_Char> back = AddArg();
+			_QuickString back = AddArg();
 			_RuntimeAppendFloat<SinglePrecisionFloat>(val, Base, DecimalWidthMax, 1, IntegralWidthMin, PaddingChar, ForceSign, back);
 			m_argumentCharSize += back.size();
 			return *this;
@@ -2952,7 +6704,7 @@ namespace LibCC
     template<size_t DecimalWidthMax, size_t IntegralWidthMin, _Char PaddingChar, bool ForceSign, size_t Base>
     _This& d(double val)
 		{
-			QuickString<_Char> back = AddArg();
+			_QuickString back = AddArg();
 	    _AppendFloat<_Char, DoublePrecisionFloat, Base, DecimalWidthMax, 1, IntegralWidthMin, PaddingChar, ForceSign>(val, back);
 			m_argumentCharSize += back.size();
 			return *this;
@@ -2989,7 +6741,7 @@ namespace LibCC
 
     _This& d(double val, size_t DecimalWidthMax, size_t IntegralWidthMin = 1, _Char PaddingChar = '0', bool ForceSign = false, size_t Base = 10)
 		{
-			QuickString<_Char> n = AddArg();
+			_QuickString n = AddArg();
 	    _RuntimeAppendFloat<DoublePrecisionFloat, _Char>(val, Base, DecimalWidthMax, 1, IntegralWidthMin, PaddingChar, ForceSign, n);
 			m_argumentCharSize += n.size();
 			return *this;
@@ -2997,9 +6749,9 @@ namespace LibCC
 
     // UNSIGNED INT 64 -----------------------------
     template<size_t Base, size_t Width, _Char PadChar>
-    _This& ui64(unsigned __int64 n)
+    _This& ui64(unsigned long long n)
 		{
-			const size_t BufferSize = _BufferSizeNeededInteger<Width, unsigned __int64>::Value;
+			const size_t BufferSize = _BufferSizeNeededInteger<Width, unsigned long long>::Value;
 			_Char buf[BufferSize];
 			_Char* p = buf + BufferSize - 1;
 			*p = 0;
@@ -3007,72 +6759,72 @@ namespace LibCC
 		}
 
     template<size_t Base, size_t Width>
-    _This& ui64(unsigned __int64 n)
+    _This& ui64(unsigned long long n)
 		{
 	    return ui64<Base, Width, '0'>(n);
 		}
 
     template<size_t Base> 
-    _This& ui64(unsigned __int64 n)
+    _This& ui64(unsigned long long n)
 		{
 	    return ui64<Base, 0, 0>(n);
 		}
 
-    _This& ui64(unsigned __int64 n)
+    _This& ui64(unsigned long long n)
 		{
 	    return ui64<10, 0, 0>(n);
 		}
 
-    _This& ui64(unsigned __int64 n, size_t Base, size_t Width = 0, _Char PadChar = '0')
+    _This& ui64(unsigned long long n, size_t Base, size_t Width = 0, _Char PadChar = '0')
 		{
-			const size_t BufferSize = _RuntimeBufferSizeNeededInteger<unsigned __int64>(Width);
-			_Char* buf = (_Char*)_alloca(BufferSize * sizeof(_Char));
+			const size_t BufferSize = _RuntimeBufferSizeNeededInteger<unsigned long long>(Width);
+			_Char* buf = (_Char*)LIBCC_ALLOCA(BufferSize * sizeof(_Char));
 			_Char* p = buf + BufferSize - 1;
 			*p = 0;
-			return s(_RuntimeUnsignedNumberToString<unsigned __int64>(p, n, Base, Width, PadChar));
+			return s(_RuntimeUnsignedNumberToString<unsigned long long>(p, n, Base, Width, PadChar));
 		}
 
     // SIGNED INT 64 -----------------------------
     template<size_t Base, size_t Width, _Char PadChar, bool ForceShowSign>
-    _This& i64(signed __int64 n)
+    _This& i64(long long n)
 		{
-			const size_t BufferSize = _BufferSizeNeededInteger<Width, unsigned __int64>::Value;
+			const size_t BufferSize = _BufferSizeNeededInteger<Width, unsigned long long>::Value;
 			_Char buf[BufferSize];
 			_Char* p = buf + BufferSize - 1;
 			*p = 0;
-			return s(_SignedNumberToString<Base, Width, PadChar, ForceShowSign>(p, n));
+			return s(_SignedNumberToString<_Char, Base, Width, PadChar, ForceShowSign>(p, n));
 		}
 
     template<size_t Base, size_t Width, _Char PadChar>
-    _This& i64(__int64 n)
+    _This& i64(long long n)
 		{
 	    return i64<Base, Width, PadChar, false>(n);
 		}
 
     template<size_t Base, size_t Width>
-    _This& i64(__int64 n)
+    _This& i64(long long n)
 		{
 	    return i64<Base, Width, '0', false>(n);
 		}
 
     template<size_t Base>
-    _This& i64(__int64 n)
+    _This& i64(long long n)
 		{
 	    return i64<Base, 0, 0, false>(n);
 		}
 
-    _This& i64(__int64 n)
+    _This& i64(long long n)
 		{
 	    return i64<10, 0, 0, false>(n);
 		}
 
-    _This& i64(signed __int64 n, size_t Base = 10, size_t Width = 0, _Char PadChar = '0', bool ForceShowSign = false)
+    _This& i64(long long n, size_t Base = 10, size_t Width = 0, _Char PadChar = '0', bool ForceShowSign = false)
 		{
-			const size_t BufferSize = _RuntimeBufferSizeNeededInteger<unsigned __int64>(Width);
-			_Char* buf = (_Char*)_alloca(BufferSize * sizeof(_Char));
+			const size_t BufferSize = _RuntimeBufferSizeNeededInteger<unsigned long long>(Width);
+			_Char* buf = (_Char*)LIBCC_ALLOCA(BufferSize * sizeof(_Char));
 			_Char* p = buf + BufferSize - 1;
 			*p = 0;
-			return s(_RuntimeSignedNumberToString<signed __int64>(p, n, Base, Width, PadChar, ForceShowSign));
+			return s(_RuntimeSignedNumberToString<long long>(p, n, Base, Width, PadChar, ForceShowSign));
 		}
 
     // GETLASTERROR() -----------------------------
@@ -3099,11 +6851,11 @@ namespace LibCC
     {
       return ui(n, Base, Width, PadChar);
     }
-    _This& operator ()(__int64 n, size_t Base = 10, size_t Width = 0, _Char PadChar = '0', bool ForceShowSign = false)
+    _This& operator ()(long long n, size_t Base = 10, size_t Width = 0, _Char PadChar = '0', bool ForceShowSign = false)
     {
       return i64(n, Base, Width, PadChar, ForceShowSign);
     }
-    _This& operator ()(unsigned __int64 n, size_t Base = 10, size_t Width = 0, _Char PadChar = '0')
+    _This& operator ()(unsigned long long n, size_t Base = 10, size_t Width = 0, _Char PadChar = '0')
     {
       return ui64(n, Base, Width, PadChar);
     }
@@ -3132,8 +6884,8 @@ namespace LibCC
     {
       return s(n);
     }
-		template<typename RChar>
-    _This& operator ()(const FormatX<RChar>& n)
+		template<typename RChar, typename RTraits, typename RAlloc, size_t RInlineCapacity>
+    _This& operator ()(const FormatX<RChar, RTraits, RAlloc, RInlineCapacity>& n)
     {
       return s(n);
     }
@@ -3258,14 +7010,18 @@ namespace LibCC
 
 		void AddArg(const _Char* s, int maxLen)
 		{
-			m_dynArguments.push_back(s, maxLen);
-			m_argumentCharSize += maxLen;
+			m_argumentCharSize += m_dynArguments.push_back(s, maxLen).size();
 		}
 
 		void AddArg(const _Char* s, int maxLen, _Char open, _Char close)
 		{
-			m_dynArguments.push_back(s, maxLen, open, close);
-			m_argumentCharSize += maxLen;
+			m_argumentCharSize += m_dynArguments.push_back(s, maxLen, open, close).size();
+		}
+
+		void AddArg(const InternedString<_Char>& s)
+		{
+			m_argumentCharSize += s.size();
+			m_dynArguments.push_back_ref(s.c_str(), s.size());
 		}
 
 		void AddArg(_Char ch, size_t count)
@@ -3274,23 +7030,23 @@ namespace LibCC
 			m_argumentCharSize += count;
 		}
 
-		QuickString<_Char> AddArg()
+		_QuickString AddArg()
 		{
 			return m_dynArguments.push_back();
 		}
 
-		const QuickString<_Char> GetArg(size_t i) const
+		const _QuickString GetArg(size_t i) const
 		{
 			return m_dynArguments[i];
 		}
 
 		size_t m_argumentCharSize;
-		QuickStringList<_Char> m_dynArguments;
+		QuickStringList<_Char, InlineCapacity> m_dynArguments;
 
 # ifdef WIN32
 		// a couple functions here are copied from winapi for local use.
-		template<typename Traits, typename Alloc>
-		static void FormatMessageGLE(std::basic_string<wchar_t, Traits, Alloc>& out, int code)
+		template<typename TraitsX, typename AllocX>
+		static void FormatMessageGLE(std::basic_string<wchar_t, TraitsX, AllocX>& out, int code)
 		{
 			wchar_t* lpMsgBuf(0);
 			FormatMessageW(FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_IGNORE_INSERTS,
@@ -3309,8 +7065,8 @@ namespace LibCC
 			}
 		}
 
-		template<typename Char, typename Traits, typename Alloc>
-		static void FormatMessageGLE(std::basic_string<Char, Traits, Alloc>& out, int code)
+		template<typename Char, typename TraitsX, typename AllocX>
+		static void FormatMessageGLE(std::basic_string<Char, TraitsX, AllocX>& out, int code)
 		{
 			std::wstring s;
 			FormatMessageGLE(s, code);
@@ -3319,8 +7075,8 @@ namespace LibCC
 			return;
 		}
 
-		template<typename Traits, typename Alloc>
-		static bool LoadStringX(HINSTANCE hInstance, UINT stringID, std::basic_string<wchar_t, Traits, Alloc>& out)
+		template<typename TraitsX, typename AllocX>
+		static bool LoadStringX(HINSTANCE hInstance, UINT stringID, std::basic_string<wchar_t, TraitsX, AllocX>& out)
 		{
 			static const int StaticBufferSize = 1024;
 			static const int MaximumAllocSize = 5242880;// don't attempt loading strings larger than 10 megs
@@ -3360,8 +7116,8 @@ namespace LibCC
 			return r;
 		}
 
-		template<typename Char, typename Traits, typename Alloc>
-		inline bool static LoadStringX(HINSTANCE hInstance, UINT stringID, std::basic_string<Char, Traits, Alloc>& out)
+		template<typename Char, typename TraitsX, typename AllocX>
+		inline bool static LoadStringX(HINSTANCE hInstance, UINT stringID, std::basic_string<Char, TraitsX, AllocX>& out)
 		{
 			bool r = false;
 			std::wstring ws;
@@ -3377,7 +7133,11 @@ namespace LibCC
 
   typedef FormatX<char, std::char_traits<char>, std::allocator<char> > FormatA;
   typedef FormatX<wchar_t, std::char_traits<wchar_t>, std::allocator<wchar_t> > FormatW;
+#if LIBCC_UTF8 == 1
+  typedef FormatA Format;// char is the native (UTF-8) type
+#else
   typedef FormatX<TCHAR, std::char_traits<TCHAR>, std::allocator<TCHAR> > Format;
+#endif
 }
 
 #pragma warning(pop)
@@ -2,7 +2,44 @@
 
 #pragma once
 
-#include <windows.h>
+#ifdef WIN32
+# include <windows.h>
+#else
+# include <stdint.h>
+# include <time.h>
+# include <chrono>
+
+namespace LibCC
+{
+  // the performance counter on top of std::chrono, and thread cycles as thread CPU nanoseconds.
+  typedef long long LONGLONG;
+  union LARGE_INTEGER
+  {
+    LONGLONG QuadPart;
+  };
+  inline int QueryPerformanceFrequency(LARGE_INTEGER* p)
+  {
+    p->QuadPart = (LONGLONG)std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num;
+    return 1;
+  }
+  inline int QueryPerformanceCounter(LARGE_INTEGER* p)
+  {
+    p->QuadPart = (LONGLONG)std::chrono::steady_clock::now().time_since_epoch().count();
+    return 1;
+  }
+  inline int GetCurrentThread()
+  {
+    return 0;
+  }
+  inline int QueryThreadCycleTime(int, uint64_t* p)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    *p = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    return 1;
+  }
+}
+#endif
 
 namespace LibCC
 {
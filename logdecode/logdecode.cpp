@@ -0,0 +1,61 @@
+// LibCC ~ Carl Corcoran, https://github.com/thenfour/LibCC
+
+// logdecode: prints binary log files (LibCC::Log::EnableBinaryFormat()) as the text log would have had them.
+// usage: logdecode file [file ...]
+
+#include "libcc/log.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static bool ReadWholeFile(const char* fileName, std::string& data)
+{
+	std::ifstream f(fileName, std::ios::binary);
+	if(!f)
+		return false;
+	std::stringstream ss;
+	ss << f.rdbuf();
+	data = ss.str();
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		std::cerr << "usage: logdecode file [file ...]" << std::endl;
+		return 2;
+	}
+
+	int ret = 0;
+	for(int i = 1; i < argc; ++ i)
+	{
+		std::string data;
+		if(!ReadWholeFile(argv[i], data))
+		{
+			std::cerr << argv[i] << ": can't open" << std::endl;
+			ret = 1;
+			continue;
+		}
+
+		LibCC::LogBinaryReader r(data.c_str(), data.size());
+		if(!r.IsValid())
+		{
+			std::cerr << argv[i] << ": not a binary log file" << std::endl;
+			ret = 1;
+			continue;
+		}
+
+		std::string line;
+		while(r.ReadLine(line))
+		{
+			std::cout << line << '\n';
+		}
+		if(!r.AtEnd())
+		{
+			std::cerr << argv[i] << ": cut off or damaged after the last line" << std::endl;
+			ret = 1;
+		}
+	}
+	return ret;
+}
@@ -2,6 +2,8 @@
 
 #include "test.h"
 #include "libcc\Log.hpp"
+#include <fstream>
+#include <sstream>
 using namespace LibCC;
 
 namespace LibCC
@@ -23,5 +25,426 @@ void LogTest()
 		delete LibCC::g_pLog;
 		x.Message(L"hi");
 	}
+
+	// buffering set up before Create() stays; unbuffered lines are in the file right away
+	DeleteFileW(L"testunbuffered.log");
+	LibCC::Log u;
+	u.SetFileBuffering(0, LIBCC_LOG_FLUSH_INTERVAL);
+	u.Create("testunbuffered.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+	u.Message("written at once");
+	std::ifstream f("testunbuffered.log", std::ios::binary);
+	std::stringstream ss;
+	ss << f.rdbuf();
+	TestAssert(ss.str().find("written at once") != std::string::npos);
+}
+
+void LogAsyncTest()
+{
+	DeleteFileW(L"testasync.log");
+	size_t evicted = 0;
+	{
+		LibCC::Log x;
+		x.Create("testasync.log", GetModuleHandle(NULL), false, true, true);
+		x.EnableAsync(true, 64, LogBackpressureBlock);
+		TestAssert(x.IsAsync());
+		{
+			LogScopeMessage l("async scope", &x);
+			for(int i = 0; i < 1000; ++ i)
+			{
+				x.Message(FormatW(L"async message %").i(i));
+			}
+			TestAssert(x.GetIndentLevel() == 1);// the thread's own count, whatever is still queued
+		}
+		TestAssert(x.GetIndentLevel() == 0);
+		TestAssert(x.GetQueueStats().dropped == 0 && x.GetQueueStats().droppedOldest == 0);
+
+		x.EnableAsync(true, 16, LogBackpressureDrop);
+		for(int i = 0; i < 1000; ++ i)
+		{
+			x.Message(L"this one might be dropped");
+		}
+		x.Flush();
+		TestAssert(x.GetQueueStats().droppedOldest == 0);
+
+		x.EnableAsync(true, 16, LogBackpressureDropOldest);
+		x.Indent();
+		for(int i = 0; i < 1000; ++ i)
+		{
+			x.Message(L"this one might be evicted");
+		}
+		x.Outdent();
+		x.Flush();
+		TestAssert(x.GetIndentLevel() == 0);// the thread keeps its indent level itself; evicting messages can't lose it
+		evicted = x.GetQueueStats().droppedOldest;
+		x.EnableAsync(false);
+		x.Message("synchronous again");
+	}
+
+	// each of the last 1000 messages was either written or evicted
+	std::ifstream f("testasync.log", std::ios::binary);
+	std::stringstream ss;
+	ss << f.rdbuf();
+	std::string text = ss.str();
+	size_t written = 0;
+	for(size_t pos = text.find("this one might be evicted"); pos != std::string::npos; pos = text.find("this one might be evicted", pos + 1))
+	{
+		++ written;
+	}
+	TestAssert(written + evicted == 1000);
+
+	// one queue shared by all threads stays async across Destroy() and the next Create()
+	DeleteFileW(L"testasync2.log");
+	{
+		LibCC::Log x;
+		x.EnableAsync(true, 64, LogBackpressureBlock, false);
+		x.Create("testasync2.log", GetModuleHandle(NULL), false, false, true, true);
+		x.Message("before Destroy");
+		x.Destroy();
+		x.Create("testasync2.log", GetModuleHandle(NULL), false, false, true, true);
+		TestAssert(x.IsAsync());
+		x.Message("after Create");
+		x.Flush();
+	}
+	std::ifstream f2("testasync2.log", std::ios::binary);
+	std::stringstream ss2;
+	ss2 << f2.rdbuf();
+	TestAssert(ss2.str().find("before Destroy") != std::string::npos);
+	TestAssert(ss2.str().find("after Create") != std::string::npos);
+}
+
+
+void LogRotationTest()
+{
+	const wchar_t* names[] = { L"testrotate.log", L"testrotate.0.log", L"testrotate.1.log", L"testrotate.2.log" };
+	for(int i = 0; i < 4; ++ i)
+	{
+		DeleteFileW(names[i]);
+	}
+	{
+		LibCC::Log x(L"testrotate.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+		x.EnableRotation(true, 2, 1000);
+		for(int i = 0; i < 200; ++ i)
+		{
+			x.Message(FormatW(L"rotation message %").i(i));
+		}
+		x.Flush();
+	}
+	for(int i = 0; i < 3; ++ i)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA fad = {};
+		TestAssert(GetFileAttributesExW(names[i], GetFileExInfoStandard, &fad) == TRUE);
+		TestAssert(fad.nFileSizeHigh == 0 && fad.nFileSizeLow > 0 && fad.nFileSizeLow < 1200);// threshold + one line
+	}
+	TestAssert(GetFileAttributesW(names[3]) == INVALID_FILE_ATTRIBUTES);// only 2 old files are kept
+
+	// time-based: a file last written 2 days ago is rotated by the first message, which goes in the new file. the new
+	// file is then in the current period, so the next message doesn't rotate it again.
+	const LogRotatePeriod periods[] = { LogRotateHourly, LogRotateDaily };
+	for(int p = 0; p < 2; ++ p)
+	{
+		for(int i = 0; i < 3; ++ i)
+		{
+			DeleteFileW(names[i]);
+		}
+		{
+			std::ofstream old("testrotate.log", std::ios::binary);
+			old << "from 2 days ago\r\n";
+		}
+		HANDLE h = CreateFileW(names[0], GENERIC_WRITE, 0, 0, OPEN_EXISTING, 0, 0);
+		TestAssert(h != INVALID_HANDLE_VALUE);
+		FILETIME ft;
+		GetSystemTimeAsFileTime(&ft);
+		uint64_t ft64 = (((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime) - 2ULL * 24 * 60 * 60 * 10000000;
+		ft.dwLowDateTime = (DWORD)ft64;
+		ft.dwHighDateTime = (DWORD)(ft64 >> 32);
+		TestAssert(SetFileTime(h, 0, 0, &ft) == TRUE);
+		CloseHandle(h);
+		{
+			LibCC::Log x(L"testrotate.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+			x.EnableRotation(true, 2, 0, periods[p]);
+			x.Message(L"first of this period");
+			x.Flush();
+			x.Message(L"second of this period");
+			x.Flush();
+		}
+		const char* narrowNames[] = { "testrotate.log", "testrotate.0.log" };
+		std::string contents[2];
+		for(int i = 0; i < 2; ++ i)
+		{
+			std::ifstream f(narrowNames[i], std::ios::binary);
+			std::stringstream ss;
+			ss << f.rdbuf();
+			contents[i] = ss.str();
+		}
+		TestAssert(contents[0].find("from 2 days ago") == std::string::npos);
+		TestAssert(contents[0].find("first of this period") != std::string::npos);
+		TestAssert(contents[0].find("second of this period") != std::string::npos);
+		TestAssert(contents[1] == "from 2 days ago\r\n");
+		TestAssert(GetFileAttributesW(names[2]) == INVALID_FILE_ATTRIBUTES);
+	}
+}
+
+void LogBinaryTest()
+{
+	DeleteFileW(L"testbinary.log");
+	{
+		LibCC::Log x;
+		x.EnableBinaryFormat(true);
+		x.Create(L"testbinary.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+		x.Message("plain text");
+		x.Indent();
+		LIBCC_LOG_TRACE(x, "trace % % % %", 42, -7LL, 1.5, "str");
+		LIBCC_LOG_TRACE(x, "wide %", L"string");
+		x.Outdent();
+	}
+
+	std::ifstream f("testbinary.log", std::ios::binary);
+	std::stringstream ss;
+	ss << f.rdbuf();
+	std::string data = ss.str();
+
+	LogBinaryReader r(data.c_str(), data.size());
+	TestAssert(r.IsValid());
+	std::string line;
+	TestAssert(r.ReadLine(line));
+	TestAssert(line.substr(line.find("] ") + 2) == "plain text");
+	TestAssert(r.ReadLine(line));
+	TestAssert(line.substr(line.find("] ") + 2) == "  trace 42 -7 1.5 str");
+	TestAssert(r.ReadLine(line));
+	TestAssert(line.substr(line.find("] ") + 2) == "  wide string");
+	TestAssert(!r.ReadLine(line));
+	TestAssert(r.AtEnd());
+
+	// a far-off format id costs nothing; LogFormatNone can't have been written, so the file's damaged there
+	LogBinaryRecordHeader h = {};
+	h.type = LogBinaryRecordFormat;
+	h.formatID = 1000000000;
+	h.size = 5;
+	data.append((const char*)&h, sizeof(h));
+	data.append("big %");
+	std::string payload;
+	LogPackArgs(payload, 5);
+	h.type = LogBinaryRecordMessage;
+	h.size = (uint32_t)payload.size();
+	data.append((const char*)&h, sizeof(h));
+	data.append(payload);
+	h.type = LogBinaryRecordFormat;
+	h.formatID = LogFormatNone;
+	h.size = 0;
+	data.append((const char*)&h, sizeof(h));
+
+	LogBinaryReader damaged(data.c_str(), data.size());
+	for(int i = 0; i < 3; ++ i)
+	{
+		TestAssert(damaged.ReadLine(line));
+	}
+	TestAssert(damaged.ReadLine(line));
+	TestAssert(line.substr(line.find("] ") + 2) == "big 5");
+	TestAssert(!damaged.ReadLine(line));
+	TestAssert(!damaged.AtEnd());
+}
+
+// several producers, each with its own queue; every line arrives, each thread's lines stay in order, and the lines
+// are merged by timestamp. the queues are big enough that nobody waits for room, so the only messages that can be
+// written out of order are ones stamped but not queued yet while the log thread drained; those are a moment late.
+// the queues of threads that have exited are used again, so threads coming and going don't add any.
+void LogThreadQueueTest()
+{
+	const int Threads = 8;
+	const int PerThread = 2000;
+	const uint64_t Tolerance = 100000;// microseconds
+	DeleteFileW(L"testthreads.log");
+	{
+		LibCC::Log x;
+		x.EnableBinaryFormat(true);
+		x.Create(L"testthreads.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+		x.EnableAsync(true, Threads * PerThread, LogBackpressureBlock);
+		std::vector<std::thread> threads;
+		for(int t = 0; t < Threads; ++ t)
+		{
+			threads.push_back(std::thread([&x, t, PerThread]()
+			{
+				for(int i = 0; i < PerThread; ++ i)
+				{
+					LIBCC_LOG_TRACE(x, "% %", t, i);
+				}
+			}));
+		}
+		for(int t = 0; t < Threads; ++ t)
+		{
+			threads[t].join();
+		}
+		x.Flush();
+		TestAssert(x.GetQueueStats().dropped == 0 && x.GetQueueStats().blocked == 0);
+		size_t queues = x.GetQueueStats().queues;
+		TestAssert(queues >= 1 && queues <= Threads);// fewer if a thread was done before another started
+
+		// threads that come and go, one at a time, take over the queues of the ones that have exited
+		for(int t = 0; t < 50; ++ t)
+		{
+			std::thread([&x]() { x.Message("short-lived thread"); }).join();
+		}
+		x.Flush();
+		TestAssert(x.GetQueueStats().queues == queues);
+	}
+
+	std::ifstream f("testthreads.log", std::ios::binary);
+	std::stringstream ss;
+	ss << f.rdbuf();
+	std::string data = ss.str();
+
+	LogBinaryReader r(data.c_str(), data.size());
+	TestAssert(r.IsValid());
+	std::vector<int> next(Threads, 0);
+	int lines = 0;
+	uint64_t newest = 0;
+	std::string line;
+	while(lines < Threads * PerThread && r.ReadLine(line))
+	{
+		int t = -1, i = -1;
+		TestAssert(sscanf(line.c_str() + line.find("] ") + 2, "%d %d", &t, &i) == 2);
+		TestAssert(t >= 0 && t < Threads && i == next[t]);
+		next[t] = i + 1;
+		TestAssert(r.Timestamp() + Tolerance >= newest);
+		if(r.Timestamp() > newest)
+			newest = r.Timestamp();
+		++ lines;
+	}
+	TestAssert(lines == Threads * PerThread);
+	int shortLived = 0;
+	while(r.ReadLine(line))
+	{
+		TestAssert(line.substr(line.find("] ") + 2) == "short-lived thread");
+		++ shortLived;
+	}
+	TestAssert(shortLived == 50);
+	DeleteFileW(L"testthreads.log");
+}
+
+static int g_levelArgsBuilt = 0;
+static const char* LevelArg(const char* s)
+{
+	++ g_levelArgsBuilt;
+	return s;
 }
 
+void LogLevelTest()
+{
+	static LogCategory net("net");
+	DeleteFileW(L"testlevels.log");
+	{
+		LibCC::Log x;
+		x.EnableBinaryFormat(true);
+		TestAssert(!x.IsEnabled(LogLevelFatal));// not created yet
+		x.Create(L"testlevels.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+		x.SetLevel(LogLevelInfo);
+		TestAssert(x.IsEnabled(LogLevelInfo) && !x.IsEnabled(LogLevelDebug));
+
+		// arguments of a message that's off are never evaluated
+		LIBCC_LOG(x, LogLevelDebug, LevelArg("hidden"));
+		TestAssert(g_levelArgsBuilt == 0);
+		LIBCC_LOG(x, LogLevelWarning, LevelArg("shown"));
+		TestAssert(g_levelArgsBuilt == 1);
+
+		LIBCC_LOG_CATEGORY(x, net, LogLevelDebug, "net hidden");
+		net.SetLevel(LogLevelDebug);
+		LIBCC_LOG_CATEGORY(x, net, LogLevelDebug, FormatA("net %").s("shown"));
+		LIBCC_LOG_TRACE_LEVEL(x, LogLevelError, "code %", 5);
+		LIBCC_LOG_TRACE_LEVEL(x, LogLevelDebug, "code %", 6);
+		x.Message("plain");
+		x.SetLevel(LogLevelOff);
+		x.Message("off");
+		TestAssert(!x.IsEnabled(LogLevelFatal));
+		LIBCC_LOG_CATEGORY(x, net, LogLevelDebug, "net off");
+	}
+
+	std::ifstream f("testlevels.log", std::ios::binary);
+	std::stringstream ss;
+	ss << f.rdbuf();
+	std::string data = ss.str();
+
+	LogBinaryReader r(data.c_str(), data.size());
+	TestAssert(r.IsValid());
+	std::string line;
+	TestAssert(r.ReadLine(line));
+	TestAssert(line.substr(line.find("] ") + 2) == "warning: shown");
+	TestAssert(r.ReadLine(line));
+	TestAssert(line.substr(line.find("] ") + 2) == "debug: net: net shown");
+	TestAssert(r.ReadLine(line));
+	TestAssert(line.substr(line.find("] ") + 2) == "error: code 5");
+	TestAssert(r.ReadLine(line));
+	TestAssert(line.substr(line.find("] ") + 2) == "plain");
+	TestAssert(!r.ReadLine(line));
+	TestAssert(r.AtEnd());
+	DeleteFileW(L"testlevels.log");
+}
+
+// the cached time prefix against rendering each time from scratch, across minute and hour boundaries and going back.
+void LogTimePrefixTest()
+{
+	LogTimePrefix<wchar_t> prefix;
+	uint64_t start = GetLogTimestamp();
+	for(int i = 0; i < 2000; ++ i)
+	{
+		uint64_t t = start + (uint64_t)(i % 500) * 7300000 + (i / 500) * 1000;
+		LogTime st;
+		LogTimestampToLocalTime(t, st);
+		std::wstring expected = FormatW(L"[%-%-%;%:%:%]")
+			.ul<10,4>(st.wYear)
+			.ul<10,2>(st.wMonth)
+			.ul<10,2>(st.wDay)
+			.ul<10,2>(st.wHour)
+			.ul<10,2>(st.wMinute)
+			.ul<10,2>(st.wSecond)
+			.Str();
+		TestAssert(prefix.Get(t) == expected);
+		TestAssert(prefix.Time().wSecond == st.wSecond && prefix.Time().wHour == st.wHour);
+	}
+}
+
+// indent levels are per thread, and each line is written at the level its thread had when it logged it.
+void LogIndentTest()
+{
+	DeleteFileW(L"testindent.log");
+	{
+		LibCC::Log x;
+		x.EnableBinaryFormat(true);
+		x.Create(L"testindent.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+		x.EnableAsync(true, 64, LogBackpressureBlock);
+		std::thread other([&x]()
+		{
+			x.Indent();
+			x.Indent();
+			x.Message("other");
+			TestAssert(x.GetIndentLevel() == 2);
+			TestAssert(std::string(x.GetIndentStringA()) == "    ");
+		});
+		other.join();
+		TestAssert(x.GetIndentLevel() == 0);
+		{
+			LogScopeMessage l("scope", &x);
+			TestAssert(x.GetIndentLevel() == 1);
+			TestAssert(std::wstring(x.GetIndentStringW()) == L"  ");
+			x.Message("inside");
+		}
+		x.Message("outside");
+		TestAssert(x.GetIndentLevel() == 0 && *x.GetIndentStringA() == 0);
+	}
+
+	std::ifstream f("testindent.log", std::ios::binary);
+	std::stringstream ss;
+	ss << f.rdbuf();
+	std::string data = ss.str();
+
+	const char* expected[] = { "    other", "{ scope", "  inside", "}", "outside" };
+	LogBinaryReader r(data.c_str(), data.size());
+	TestAssert(r.IsValid());
+	std::string line;
+	for(int i = 0; i < 5; ++ i)
+	{
+		TestAssert(r.ReadLine(line));
+		TestAssert(line.substr(line.find("] ") + 2) == expected[i]);
+	}
+	TestAssert(!r.ReadLine(line));
+	DeleteFileW(L"testindent.log");
+}
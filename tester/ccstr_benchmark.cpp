@@ -2,7 +2,11 @@
 
 #include "test.h"
 #include "libcc\timer.hpp"
+#include "libcc\rope.hpp"
+#include "libcc\log.hpp"
 #include <sstream>
+#include <map>
+#include <unordered_map>
 #pragma warning(disable:4996)// warning C4996: 'wcscpy' was declared deprecated  -- uh, i know how to use this function just fine, thanks.
 
 namespace Test
@@ -249,3 +253,1390 @@ bool FormatBenchmark()
 }
 
 
+
+// compares the UTF-16 world with LIBCC_UTF8 (char is UTF-8): rendering a typical log line, and getting it onto disk as UTF-8.
+bool Utf8Benchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int MaxNum = 10000;
+#else
+  const int MaxNum = 1000000;
+#endif
+
+	std::cout << std::endl << "UTF-8 vs UTF-16 benchmarks, " << MaxNum << " passes." << std::endl;
+
+	//////////////////////////////////
+	std::cout << std::endl << "render a log line:" << std::endl;
+	size_t bytesW = 0;
+	StartBenchmark(t);
+	for(int n = 0; n < MaxNum; n ++)
+  {
+		std::wstring s = LibCC::FormatW(L"[%-%-%;%:%:%][%] %%%|").i<4>(2026).i<2>(10).i<2>(19).i<2>(n % 24).i<2>(n % 60).i<2>(n % 60).ul(1234)
+			.s(L"    ").s(L"Opening file ").s(L"C:\\Users\\Carl\\Documents\\log.txt").Str();
+		bytesW += s.size() * sizeof(wchar_t);
+		DoNotOptimize(s);
+  }
+	ReportBenchmark(t, "FormatW");
+
+	size_t bytesA = 0;
+	StartBenchmark(t);
+	for(int n = 0; n < MaxNum; n ++)
+  {
+		std::string s = LibCC::FormatA("[%-%-%;%:%:%][%] %%%|").i<4>(2026).i<2>(10).i<2>(19).i<2>(n % 24).i<2>(n % 60).i<2>(n % 60).ul(1234)
+			.s("    ").s("Opening file ").s("C:\\Users\\Carl\\Documents\\log.txt").Str();
+		bytesA += s.size() * sizeof(char);
+		DoNotOptimize(s);
+  }
+	ReportBenchmark(t, "FormatA (UTF-8)");
+	std::cout << "rendered bytes: UTF-16 " << bytesW << ", UTF-8 " << bytesA << std::endl;
+
+	//////////////////////////////////
+	std::cout << std::endl << "UTF-16 log line -> UTF-8 for the file:" << std::endl;
+	std::wstring line(L"[2026-10-19;12:34:56][1234]     Opening file C:\\Users\\Carl\\Documents\\log.txt\r\n");
+	std::string a;
+	StartBenchmark(t);
+	for(int n = 0; n < MaxNum; n ++)
+  {
+		int len = WideCharToMultiByte(CP_UTF8, 0, line.c_str(), (int)line.size(), 0, 0, 0, 0);
+		a.resize(len);
+		WideCharToMultiByte(CP_UTF8, 0, line.c_str(), (int)line.size(), &a[0], len, 0, 0);
+		DoNotOptimize(a);
+  }
+	ReportBenchmark(t, "WideCharToMultiByte");
+
+	StartBenchmark(t);
+	for(int n = 0; n < MaxNum; n ++)
+  {
+		LibCC::UTF16ToUTF8(line.c_str(), line.size(), a);
+		DoNotOptimize(a);
+  }
+	ReportBenchmark(t, "UTF16ToUTF8");
+
+	// UTF-8 mode: the rendered line is already what goes to disk, and the conversion is a copy.
+	const std::string lineA(a);
+	StartBenchmark(t);
+	for(int n = 0; n < MaxNum; n ++)
+  {
+		LibCC::StringConvert(lineA, a, CP_UTF8, CP_UTF8);
+		DoNotOptimize(a);
+  }
+	ReportBenchmark(t, "StringConvert char -> char (LIBCC_UTF8)");
+
+	return true;
+}
+
+// tokenizing a few MB of CSV-ish text by a set of separators.
+bool CharSetBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 1;
+#else
+  const int Passes = 10;
+#endif
+	const size_t InputSize = 8 * 1024 * 1024;
+	const char* seps = ",;\t\r\n\"";
+
+	std::string input;
+	input.reserve(InputSize);
+	for(int n = 0; input.size() < InputSize; n ++)
+	{
+		input.append("some longer field value;1234567;");
+		input.append((n % 4) == 0 ? "\"quoted\"\r\n" : "x,");
+	}
+
+	std::cout << std::endl << "StringFindFirstOf on " << (InputSize / (1024 * 1024)) << " MB, " << Passes << " passes." << std::endl;
+
+	size_t tokens = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		const char* p = input.c_str();
+		while(true)
+		{
+			std::string::size_type i = LibCC::InternalStringFindFirstOf1<const char*>(p, seps);// the old nested loop
+			if(i == std::string::npos)
+				break;
+			p += i + 1;
+			tokens ++;
+		}
+	}
+	ReportBenchmark(t, "nested loop");
+	DoNotOptimize(tokens);
+
+	tokens = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		std::string::size_type pos = 0;
+		while((pos = input.find_first_of(seps, pos)) != std::string::npos)
+		{
+			pos ++;
+			tokens ++;
+		}
+	}
+	ReportBenchmark(t, "std::string::find_first_of");
+	DoNotOptimize(tokens);
+
+	tokens = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		LibCC::StringCharSet<char> set(seps);
+		size_t pos = 0;
+		while(true)
+		{
+			std::string::size_type i = set.FindFirst(input.c_str() + pos, input.size() - pos);
+			if(i == std::string::npos)
+				break;
+			pos += i + 1;
+			tokens ++;
+		}
+	}
+	ReportBenchmark(t, "LibCC::StringCharSet");
+	DoNotOptimize(tokens);
+
+	// one long scan with no match until the end
+	std::string noMatch(InputSize, 'a');
+	noMatch.push_back(';');
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		DoNotOptimize(LibCC::InternalStringFindFirstOf1<const char*>(noMatch.c_str() + pass, seps));
+	}
+	ReportBenchmark(t, "nested loop, single match at end");
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		DoNotOptimize(LibCC::StringFindFirstOf(noMatch.c_str() + pass, seps));
+	}
+	ReportBenchmark(t, "StringFindFirstOf, single match at end");
+
+	return true;
+}
+
+// substring search & replace on a few MB of text.
+bool SearchBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 1;
+#else
+  const int Passes = 10;
+#endif
+	const size_t InputSize = 8 * 1024 * 1024;
+
+	std::string input;
+	input.reserve(InputSize + 100);
+	for(int n = 0; input.size() < InputSize; n ++)
+	{
+		input.append("[2026-10-19;12:34:56][1234] the quick brown fox jumps over the lazy dog; ");
+		input.append((n % 16) == 0 ? "ERROR\r\n" : "ok\r\n");
+	}
+	std::string shortNeedle = "ERROR";
+	std::string longNeedle = "the quick brown fox jumps over the lazy cat";// almost matches everywhere
+
+	std::cout << std::endl << "substring search on " << (InputSize / (1024 * 1024)) << " MB, " << Passes << " passes." << std::endl;
+
+	//////////////////////////////////
+	std::cout << std::endl << "search for a needle that's not there:" << std::endl;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		// the old restart loop
+		const char* p = input.c_str() + pass;
+		bool found = false;
+		for(; *p && !found; ++ p)
+			found = LibCC::StringStartsWith(p, "WARNING");
+		DoNotOptimize(found);
+	}
+	ReportBenchmark(t, "restart loop, short");
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		DoNotOptimize(input.find("WARNING", pass));
+	}
+	ReportBenchmark(t, "std::string::find, short");
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		DoNotOptimize(LibCC::StringContainsString(input.c_str() + pass, "WARNING"));
+	}
+	ReportBenchmark(t, "StringContainsString, short");
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		DoNotOptimize(input.find(longNeedle, pass));
+	}
+	ReportBenchmark(t, "std::string::find, long");
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		DoNotOptimize(LibCC::StringContainsString(input.c_str() + pass, longNeedle.c_str()));
+	}
+	ReportBenchmark(t, "StringContainsString, long");
+
+	//////////////////////////////////
+	std::cout << std::endl << "replace:" << std::endl;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		// the old find & append loop
+		std::string r;
+		size_t pos = 0;
+		while(1)
+		{
+			size_t found = input.find(shortNeedle, pos);
+			if(found == std::string::npos)
+			{
+				r.append(input, pos, input.length() - pos);
+				break;
+			}
+			r.append(input, pos, found - pos);
+			r.append("WARNING");
+			pos = found + shortNeedle.length();
+		}
+		DoNotOptimize(r);
+	}
+	ReportBenchmark(t, "find & append");
+
+	LibCC::StringSearcher<char> searcher(shortNeedle);
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		DoNotOptimize(LibCC::StringReplace(input, searcher, std::string("WARNING")));
+	}
+	ReportBenchmark(t, "StringReplace");
+
+	return true;
+}
+
+// 20 substitutions over a couple MB of text: chained StringReplace vs. one StringReplaceMany pass.
+bool ReplaceManyBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 1;
+#else
+  const int Passes = 10;
+#endif
+	const size_t InputSize = 2 * 1024 * 1024;
+
+	std::vector<std::pair<std::string, std::string> > replacements;
+	for(int n = 0; n < 20; n ++)
+	{
+		replacements.push_back(std::make_pair(LibCC::FormatA("{var%}").i(n).Str(), LibCC::FormatA("value number %").i(n).Str()));
+	}
+
+	std::string input;
+	input.reserve(InputSize + 100);
+	for(int n = 0; input.size() < InputSize; n ++)
+	{
+		input.append(LibCC::FormatA("<p class=\"x\">some template text {var%} & more</p>\r\n").i(n % 25).Str());
+	}
+
+	std::cout << std::endl << "20 replacements on " << (InputSize / (1024 * 1024)) << " MB, " << Passes << " passes." << std::endl;
+
+	std::string chained;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		chained = input;
+		for(size_t i = 0; i < replacements.size(); i ++)
+		{
+			chained = LibCC::StringReplace(chained, replacements[i].first, replacements[i].second);
+		}
+		DoNotOptimize(chained);
+	}
+	ReportBenchmark(t, "chained StringReplace");
+
+	std::string many;
+	StartBenchmark(t);
+	LibCC::StringReplacer<char> replacer(replacements);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		many = LibCC::StringReplaceMany(input, replacer);
+		DoNotOptimize(many);
+	}
+	ReportBenchmark(t, "StringReplaceMany (compiled once)");
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		many = LibCC::StringReplaceMany(input, LibCC::StringReplacer<char>(replacements));
+		DoNotOptimize(many);
+	}
+	ReportBenchmark(t, "StringReplaceMany (compiled each pass)");
+
+	TestAssert(many == chained);
+	return true;
+}
+
+// splitting a big buffer into lines, then fields: copying tokens vs. views.
+bool SplitBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const size_t InputSize = 1024 * 1024;
+#else
+  const size_t InputSize = 32 * 1024 * 1024;
+#endif
+
+	std::string input;
+	input.reserve(InputSize + 100);
+	for(int n = 0; input.size() < InputSize; n ++)
+	{
+		input.append(LibCC::FormatA("%,field two,%,,last field\n").i(n).i(n * 7).Str());
+	}
+
+	std::cout << std::endl << "split " << (InputSize / (1024 * 1024)) << " MB into lines and fields:" << std::endl;
+
+	size_t fields = 0;
+	StartBenchmark(t);
+	{
+		std::vector<std::string> lines;
+		LibCC::StringSplitByString(input, "\n", std::back_inserter(lines));
+		for(size_t i = 0; i < lines.size(); i ++)
+		{
+			std::vector<std::string> v;
+			LibCC::StringSplitByString(lines[i], ",", std::back_inserter(v));
+			fields += v.size();
+		}
+	}
+	ReportBenchmark(t, "StringSplitByString into vector<string>");
+	DoNotOptimize(fields);
+
+	fields = 0;
+	StartBenchmark(t);
+	{
+		typedef LibCC::StringSplitRange<char, LibCC::StringSplitFinderChar<char> > Range;
+		Range lines = LibCC::StringSplitByChar(input, '\n');
+		for(Range::iterator line = lines.begin(); line != lines.end(); ++ line)
+		{
+			Range v = LibCC::StringSplitByChar(line->data(), line->size(), ',');
+			for(Range::iterator field = v.begin(); field != v.end(); ++ field)
+			{
+				fields ++;
+			}
+		}
+	}
+	ReportBenchmark(t, "StringSplitByChar views");
+	DoNotOptimize(fields);
+
+	return true;
+}
+
+bool JoinBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const size_t Count = 100000;
+#else
+  const size_t Count = 4 * 1024 * 1024;
+#endif
+
+	std::vector<std::string> input;
+	input.reserve(Count);
+	for(size_t n = 0; n < Count; n ++)
+	{
+		input.push_back(std::string(n % 23, (char)('a' + n % 26)));
+	}
+
+	std::cout << std::endl << "join " << Count << " strings:" << std::endl;
+
+	std::string appended;
+	StartBenchmark(t);
+	for(size_t i = 0; i < input.size(); i ++)
+	{
+		if(i)
+			appended.append(", ");
+		appended.append(input[i]);
+	}
+	ReportBenchmark(t, "append loop");
+	DoNotOptimize(appended);
+
+	StartBenchmark(t);
+	std::string joined = LibCC::StringJoin(input.begin(), input.end(), ", ");
+	ReportBenchmark(t, "StringJoin");
+	DoNotOptimize(joined);
+
+	StartBenchmark(t);
+	std::string parallel = LibCC::StringJoinParallel(input.begin(), input.end(), ", ");
+	ReportBenchmark(t, "StringJoinParallel");
+	DoNotOptimize(parallel);
+
+	std::wstring wide;
+	StartBenchmark(t);
+	for(size_t i = 0; i < input.size(); i ++)
+	{
+		if(i)
+			wide.append(L", ");
+		std::wstring temp;
+		LibCC::StringConvert(input[i], temp);
+		wide.append(temp);
+	}
+	ReportBenchmark(t, "append loop char -> wchar_t");
+	DoNotOptimize(wide);
+
+	StartBenchmark(t);
+	std::wstring joinedW = LibCC::StringJoin<wchar_t>(input.begin(), input.end(), L", ");
+	ReportBenchmark(t, "StringJoin<wchar_t>");
+	DoNotOptimize(joinedW);
+
+	StartBenchmark(t);
+	std::wstring parallelW = LibCC::StringJoinParallel(input.begin(), input.end(), L", ");
+	ReportBenchmark(t, "StringJoinParallel<wchar_t>");
+	DoNotOptimize(parallelW);
+
+	TestAssert(joined == appended && parallel == appended);
+	TestAssert(joinedW == wide && parallelW == wide);
+
+	return true;
+}
+
+bool TrimBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const size_t Count = 100000;
+#else
+  const size_t Count = 2 * 1024 * 1024;
+#endif
+	const char* whitespace = " \t\r\n\v\f";
+
+	std::vector<std::string> fields;
+	fields.reserve(Count);
+	for(size_t n = 0; n < Count; n ++)
+	{
+		fields.push_back(LibCC::FormatA("%field value %%").s(std::string(n % 5, ' ')).ul(n).s(std::string(n % 19, (n & 1) ? ' ' : '\t')).Str());
+	}
+
+	std::cout << std::endl << "trim " << Count << " CSV fields:" << std::endl;
+
+	size_t total = 0;
+	StartBenchmark(t);
+	for(size_t i = 0; i < fields.size(); i ++)
+	{
+		// the old StringTrim: StringContainsChar per char, from both ends
+		const std::string& f = fields[i];
+		size_t first = 0;
+		while(first < f.size() && LibCC::StringContainsChar(whitespace, f[first]))
+			first ++;
+		size_t end = f.size();
+		while(end > first && LibCC::StringContainsChar(whitespace, f[end - 1]))
+			end --;
+		total += std::string(f, first, end - first).size();
+	}
+	ReportBenchmark(t, "per char StringContainsChar");
+	DoNotOptimize(total);
+
+	total = 0;
+	StartBenchmark(t);
+	for(size_t i = 0; i < fields.size(); i ++)
+	{
+		total += LibCC::StringTrim(fields[i], whitespace).size();
+	}
+	ReportBenchmark(t, "StringTrim");
+	DoNotOptimize(total);
+
+	total = 0;
+	LibCC::StringCharSet<char> set(whitespace);
+	StartBenchmark(t);
+	for(size_t i = 0; i < fields.size(); i ++)
+	{
+		total += LibCC::StringTrimView(fields[i], set).size();
+	}
+	ReportBenchmark(t, "StringTrimView with a StringCharSet");
+	DoNotOptimize(total);
+
+	total = 0;
+	StartBenchmark(t);
+	for(size_t i = 0; i < fields.size(); i ++)
+	{
+		total += LibCC::StringTrimView(fields[i]).size();
+	}
+	ReportBenchmark(t, "StringTrimView whitespace");
+	DoNotOptimize(total);
+
+	return true;
+}
+
+bool CaseBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 1;
+#else
+  const int Passes = 20;
+#endif
+	const char* names[] = { "Content-Type", "Content-Length", "Accept-Encoding", "X-Forwarded-For", "Cache-Control", "If-None-Match", "Authorization", "User-Agent" };
+	const size_t nameCount = sizeof(names) / sizeof(names[0]);
+
+	std::vector<std::string> headers;
+	for(int n = 0; n < 100000; n ++)
+	{
+		std::string h = names[n % nameCount];
+		if(n & 1)
+			LibCC::NaiveStringToLower(h);
+		headers.push_back(h);
+	}
+	std::string body;
+	while(body.size() < 4 * 1024 * 1024)
+	{
+		body.append("The Quick Brown Fox Jumps Over The Lazy Dog. ");
+	}
+
+	std::cout << std::endl << "case mapping, " << Passes << " passes:" << std::endl;
+
+	size_t total = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		std::vector<char> buf(body.begin() + (pass & 1), body.end());// the old StringToUpper
+		CharUpperBuffA(buf.data(), (DWORD)buf.size());
+		total += buf[pass];
+	}
+	ReportBenchmark(t, "copy + CharUpperBuffA, 4 MB");
+	DoNotOptimize(total);
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		total += LibCC::StringToUpper(body.c_str() + (pass & 1))[pass];
+	}
+	ReportBenchmark(t, "StringToUpper, 4 MB");
+	DoNotOptimize(total);
+
+	size_t matches = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		const char* find = names[pass % nameCount];
+		for(size_t i = 0; i < headers.size(); i ++)
+		{
+			if(_stricmp(headers[i].c_str(), find) == 0)
+				matches ++;
+		}
+	}
+	ReportBenchmark(t, "_stricmp header lookup");
+	DoNotOptimize(matches);
+
+	matches = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		const std::string find = names[pass % nameCount];
+		for(size_t i = 0; i < headers.size(); i ++)
+		{
+			if(LibCC::StringEqualsI(headers[i], find))
+				matches ++;
+		}
+	}
+	ReportBenchmark(t, "StringEqualsI header lookup");
+	TestAssert(matches == Passes * headers.size() / nameCount);
+
+	int equal = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		std::string other = body.substr(pass & 1);
+		LibCC::StringToLowerInPlace(other);
+		equal += LibCC::StringEqualsI(body.c_str() + (pass & 1), other) ? 1 : 0;
+	}
+	ReportBenchmark(t, "copy + StringToLowerInPlace + StringEqualsI, 4 MB");
+	TestAssert(equal == Passes);
+
+	return true;
+}
+
+template<typename Char>
+bool PerCharEquals(const std::basic_string<Char>& a, const std::basic_string<Char>& b)// the old InternalStringEquals1
+{
+	typename std::basic_string<Char>::const_iterator ia = a.begin();
+	typename std::basic_string<Char>::const_iterator ib = b.begin();
+	while(true)
+	{
+		bool aEnd = ia == a.end();
+		bool bEnd = ib == b.end();
+		if(aEnd || bEnd)
+			return aEnd && bEnd;
+		if(*ia != *ib)
+			return false;
+		++ ia;
+		++ ib;
+	}
+}
+
+bool EqualsBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 1000;
+#else
+  const int Passes = 200000;
+#endif
+
+	std::wstring a(1000, L'x');
+	std::wstring b(a);
+	std::wstring c(a + L"y");
+
+	std::cout << std::endl << "compare 1000 char wstrings, " << Passes << " passes:" << std::endl;
+
+	int equal = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		equal += PerCharEquals(a, (pass & 1) ? b : c) ? 1 : 0;
+	}
+	ReportBenchmark(t, "per char");
+	DoNotOptimize(equal);
+
+	int equal2 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		equal2 += LibCC::StringEquals(a, (pass & 1) ? b : c) ? 1 : 0;
+	}
+	ReportBenchmark(t, "StringEquals");
+	TestAssert(equal == equal2);
+
+	int order = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		order += LibCC::StringCompare(a, (pass & 1) ? b : c);
+	}
+	ReportBenchmark(t, "StringCompare");
+	DoNotOptimize(order);
+
+	int prefixed = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		prefixed += LibCC::StringStartsWith(c, (pass & 1) ? b : a) ? 1 : 0;
+	}
+	ReportBenchmark(t, "StringStartsWith");
+	TestAssert(prefixed == Passes);
+
+	return true;
+}
+
+bool InternBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 1000;
+#else
+  const int Passes = 200000;
+#endif
+
+	LibCC::StringPool<wchar_t> pool;
+	std::vector<std::wstring> names;
+	std::vector<LibCC::InternedString<wchar_t> > handles;
+	for(int i = 0; i < 64; ++ i)
+	{
+		names.push_back(LibCC::FormatW(L"Subsystem.Component.Category%").i(i).Str());
+		handles.push_back(pool.Intern(names.back()));
+	}
+
+	std::cout << std::endl << "64 category names, " << Passes << " passes:" << std::endl;
+
+	size_t found = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		const std::wstring& find = names[(pass * 7) & 63];
+		found += std::find(names.begin(), names.end(), find) - names.begin();
+	}
+	ReportBenchmark(t, "find by string compare");
+
+	size_t found2 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		LibCC::InternedString<wchar_t> find = handles[(pass * 7) & 63];
+		found2 += std::find(handles.begin(), handles.end(), find) - handles.begin();
+	}
+	ReportBenchmark(t, "find by handle");
+	TestAssert(found == found2);
+
+	size_t looked = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		looked += pool.Intern(names[pass & 63]).size();
+	}
+	ReportBenchmark(t, "Intern (already in pool)");
+	DoNotOptimize(looked);
+
+	size_t formatted = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		formatted += LibCC::FormatW(L"[%] %").s(names[pass & 63]).i(pass).Str().size();
+	}
+	ReportBenchmark(t, "FormatW with a std::wstring category");
+
+	size_t formatted2 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		formatted2 += LibCC::FormatW(L"[%] %").s(handles[pass & 63]).i(pass).Str().size();
+	}
+	ReportBenchmark(t, "FormatW with an interned category");
+	TestAssert(formatted == formatted2);
+
+	return true;
+}
+
+template<typename Char, size_t InlineCapacity>
+void QuickStringSweep(LibCC::Timer& t, int passes, const std::vector<std::basic_string<Char> >& args, size_t& total)
+{
+	typedef LibCC::FormatX<Char, std::char_traits<Char>, std::allocator<Char>, InlineCapacity> FormatT;
+	typedef LibCC::QuickStringData<Char, InlineCapacity> DataT;
+	const char formatA[] = "% % % % %";
+	const std::basic_string<Char> format(formatA, formatA + sizeof(formatA) - 1);
+	StartBenchmark(t);
+	for(int pass = 0; pass < passes; pass ++)
+	{
+		FormatT f(format);
+		for(size_t i = 0; i < args.size(); ++ i)
+		{
+			f.s(args[i]);
+		}
+		total += f.Str().size();
+	}
+	ReportBenchmark(t, LibCC::FormatA("inline capacity %, % byte strings").ul(DataT::Capacity).ul(sizeof(DataT)).Str());
+}
+
+// the inline buffer is never smaller than the heap pointer and sizes, and is rounded up to whole size_t's, so small
+// capacities would all end up the same. these start at the smallest one and go up 16 bytes at a time.
+template<typename Char>
+void QuickStringSweeps(LibCC::Timer& t, int passes, size_t length, const char* name)
+{
+	static const size_t Smallest = LibCC::QuickStringData<Char, 0>::Capacity;
+	static const size_t Step = 16 / sizeof(Char);
+	std::vector<std::basic_string<Char> > args(5, std::basic_string<Char>(length, (Char)'x'));
+	std::cout << std::endl << name << " with 5 args of " << length << " chars, " << passes << " passes:" << std::endl;
+
+	size_t total[5] = { 0 };
+	QuickStringSweep<Char, Smallest>(t, passes, args, total[0]);
+	QuickStringSweep<Char, Smallest + Step>(t, passes, args, total[1]);
+	QuickStringSweep<Char, Smallest + 2 * Step>(t, passes, args, total[2]);
+	QuickStringSweep<Char, Smallest + 3 * Step>(t, passes, args, total[3]);
+	QuickStringSweep<Char, Smallest + 4 * Step>(t, passes, args, total[4]);
+	TestAssert(total[0] == total[1] && total[0] == total[2] && total[0] == total[3] && total[0] == total[4]);
+}
+
+bool QuickStringBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 1000;
+#else
+  const int Passes = 200000;
+#endif
+
+	const size_t lengths[] = { 8, 20, 30, 40, 60 };
+	for(size_t l = 0; l < LibCC::SizeofStaticArray(lengths); ++ l)
+	{
+		QuickStringSweeps<wchar_t>(t, Passes, lengths[l], "FormatW");
+		QuickStringSweeps<char>(t, Passes, lengths[l], "FormatA");
+	}
+
+	return true;
+}
+
+bool ArenaBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 1000;
+#else
+  const int Passes = 100000;
+#endif
+
+	std::wstring arg(60, L'x');
+	const wchar_t* format = L"% % % % % % % % % % % % % % % % % % % %";
+
+	std::cout << std::endl << "FormatW with 20 args of 60 chars, " << Passes << " passes:" << std::endl;
+
+	size_t total = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		LibCC::FormatW f(format);
+		for(int i = 0; i < 20; ++ i)
+		{
+			f.s(arg);
+		}
+		total += f.Str().size();
+	}
+	ReportBenchmark(t, "process heap");
+
+	size_t total2 = 0;
+	LibCC::StringArena arena;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		{
+			LibCC::FormatW f(format, arena);
+			for(int i = 0; i < 20; ++ i)
+			{
+				f.s(arg);
+			}
+			total2 += f.Str().size();
+		}
+		arena.Reset();
+	}
+	ReportBenchmark(t, "StringArena, Reset per message");
+	TestAssert(total == total2);
+
+	return true;
+}
+
+
+bool RopeBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 10;
+#else
+  const int Passes = 200;
+#endif
+	const int Lines = 5000;
+
+	std::cout << std::endl << "Building a " << Lines << " line report, " << Passes << " passes:" << std::endl;
+
+	size_t total = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		std::wstring report;
+		for(int i = 0; i < Lines; ++ i)
+		{
+			report.append(L"row ");
+			report.append(LibCC::FormatW(L"% of %: value=%\r\n").i(i).i(Lines).i(i * 31).Str());
+		}
+		total += report.size();
+	}
+	ReportBenchmark(t, "std::wstring append");
+
+	size_t total2 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		LibCC::StringRope<wchar_t> rope;
+		for(int i = 0; i < Lines; ++ i)
+		{
+			rope.AppendRef(L"row ", 4);
+			LibCC::FormatW f(L"% of %: value=%\r\n");
+			f.i(i).i(Lines).i(i * 31);
+			rope.Take(f);
+		}
+		total2 += rope.Str().size();
+	}
+	ReportBenchmark(t, "StringRope, Take + Str()");
+
+	size_t total3 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		LibCC::StringRope<wchar_t> rope;
+		for(int i = 0; i < Lines; ++ i)
+		{
+			rope.AppendRef(L"row ", 4);
+			rope.Append(LibCC::FormatW(L"% of %: value=%\r\n").i(i).i(Lines).i(i * 31));
+		}
+		total3 += rope.Str().size();
+	}
+	ReportBenchmark(t, "StringRope, Append + Str()");
+
+	TestAssert(total == total2 && total == total3);
+	return true;
+}
+
+
+bool HashMapBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 20000;
+#else
+  const int Passes = 2000000;
+#endif
+	const int Keys = 4096;
+
+	std::vector<std::wstring> keys;
+	for(int i = 0; i < Keys; ++ i)
+	{
+		keys.push_back(LibCC::FormatW(L"Namespace::SomeClassName%").i(i).Str());
+	}
+	std::wstring longKey(1000, L'k');
+
+	std::cout << std::endl << "hashing, " << Passes << " passes:" << std::endl;
+
+	size_t h1 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		h1 += std::hash<std::wstring>()(keys[pass & (Keys - 1)]);
+	}
+	ReportBenchmark(t, "std::hash, ~28 chars");
+	DoNotOptimize(h1);
+
+	size_t h2 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		h2 += LibCC::StringHash(keys[pass & (Keys - 1)]);
+	}
+	ReportBenchmark(t, "StringHash, ~28 chars");
+	DoNotOptimize(h2);
+
+	size_t h3 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes / 20; pass ++)
+	{
+		h3 += std::hash<std::wstring>()(longKey);
+	}
+	ReportBenchmark(t, "std::hash, 1000 chars, 1/20 the passes");
+	DoNotOptimize(h3);
+
+	size_t h4 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes / 20; pass ++)
+	{
+		h4 += LibCC::StringHash(longKey);
+	}
+	ReportBenchmark(t, "StringHash, 1000 chars, 1/20 the passes");
+	DoNotOptimize(h4);
+
+	size_t h5 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes / 20; pass ++)
+	{
+		h5 += LibCC::StringHashI(longKey);
+	}
+	ReportBenchmark(t, "StringHashI, 1000 chars, 1/20 the passes");
+	DoNotOptimize(h5);
+
+	std::cout << std::endl << Keys << " keys, " << Passes << " lookups:" << std::endl;
+
+	std::map<std::wstring, int> ordered;
+	std::unordered_map<std::wstring, int> unordered;
+	LibCC::StringHashMap<wchar_t, int> hashMap;
+	for(int i = 0; i < Keys; ++ i)
+	{
+		ordered[keys[i]] = i;
+		unordered[keys[i]] = i;
+		hashMap[keys[i]] = i;
+	}
+
+	size_t found = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		found += ordered.find(keys[(pass * 7) & (Keys - 1)])->second;
+	}
+	ReportBenchmark(t, "std::map");
+
+	size_t found2 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		found2 += unordered.find(keys[(pass * 7) & (Keys - 1)])->second;
+	}
+	ReportBenchmark(t, "std::unordered_map, std::hash");
+
+	size_t found3 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		found3 += *hashMap.Find(keys[(pass * 7) & (Keys - 1)]);
+	}
+	ReportBenchmark(t, "StringHashMap");
+	TestAssert(found == found2 && found == found3);
+
+	std::cout << std::endl << "building a " << Keys << " key map, " << (Passes / Keys) << " times:" << std::endl;
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes / Keys; pass ++)
+	{
+		std::map<std::wstring, int> m;
+		for(int i = 0; i < Keys; ++ i)
+		{
+			m[keys[i]] = i;
+		}
+	}
+	ReportBenchmark(t, "std::map");
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes / Keys; pass ++)
+	{
+		std::unordered_map<std::wstring, int> m;
+		for(int i = 0; i < Keys; ++ i)
+		{
+			m[keys[i]] = i;
+		}
+	}
+	ReportBenchmark(t, "std::unordered_map, std::hash");
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes / Keys; pass ++)
+	{
+		LibCC::StringHashMap<wchar_t, int> m;
+		for(int i = 0; i < Keys; ++ i)
+		{
+			m[keys[i]] = i;
+		}
+	}
+	ReportBenchmark(t, "StringHashMap");
+
+	return true;
+}
+
+
+bool BatchConvertBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 2;
+#else
+  const int Passes = 50;
+#endif
+	const int Count = 100000;
+
+	std::vector<std::string> in;
+	for(int i = 0; i < Count; ++ i)
+	{
+		in.push_back(LibCC::FormatA("HKEY_LOCAL_MACHINE\\Software\\Vendor\\Product\\Key%").i(i).Str());
+	}
+
+	std::cout << std::endl << Count << " strings to wchar_t, " << Passes << " passes:" << std::endl;
+
+	size_t total = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		std::vector<std::wstring> out(in.size());
+		for(size_t i = 0; i < in.size(); ++ i)
+		{
+			LibCC::StringConvert(in[i], out[i]);
+		}
+		total += out.back().size();
+	}
+	ReportBenchmark(t, "StringConvert per element");
+
+	size_t total2 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		std::vector<std::wstring> out;
+		LibCC::StringConvertBatch(in, out, 1);
+		total2 += out.back().size();
+	}
+	ReportBenchmark(t, "StringConvertBatch, vector, 1 thread");
+
+	size_t total3 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		LibCC::StringTable<wchar_t> out;
+		LibCC::StringConvertBatch(in, out, 1);
+		total3 += out.length(out.size() - 1);
+	}
+	ReportBenchmark(t, "StringConvertBatch, StringTable, 1 thread");
+
+	size_t total4 = 0;
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		LibCC::StringTable<wchar_t> out;
+		LibCC::StringConvertBatch(in, out);
+		total4 += out.length(out.size() - 1);
+	}
+	ReportBenchmark(t, "StringConvertBatch, StringTable, all cores");
+
+	TestAssert(total == total2 && total == total3 && total == total4);
+	return true;
+}
+
+
+// the cost to the calling thread of Log::Message, to a file only
+bool LogBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 1000;
+#else
+  const int Passes = 20000;
+#endif
+
+	std::cout << std::endl << Passes << " log messages to a file:" << std::endl;
+
+	LibCC::Log log("benchmark.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		log.Message(LibCC::FormatW(L"message number % from the benchmark").i(pass));
+	}
+	ReportBenchmark(t, "synchronous");
+
+	log.EnableAsync(true, 65536, LibCC::LogBackpressureBlock);
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		log.Message(LibCC::FormatW(L"message number % from the benchmark").i(pass));
+	}
+	ReportBenchmark(t, "async, producer only");
+	log.Flush();
+	ReportBenchmark(t, "async, including Flush()");
+
+	const int Threads = 4;
+	StartBenchmark(t);
+	std::vector<std::thread> threads;
+	for(int i = 0; i < Threads; ++ i)
+	{
+		threads.push_back(std::thread([&log, Passes, Threads]()
+		{
+			for(int pass = 0; pass < Passes / Threads; pass ++)
+			{
+				log.Message(LibCC::FormatW(L"message number % from the benchmark").i(pass));
+			}
+		}));
+	}
+	for(int i = 0; i < Threads; ++ i)
+	{
+		threads[i].join();
+	}
+	ReportBenchmark(t, "async, 4 producer threads");
+	log.Flush();
+	TestAssert(log.GetQueueStats().dropped == 0);
+
+	return true;
+}
+
+// lines/sec going to a log file. "reopen per line" does what the log thread used to do for each line and each file.
+bool LogFileBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 2000;
+#else
+  const int Passes = 50000;
+#endif
+
+	std::cout << std::endl << Passes << " log lines to a file:" << std::endl;
+
+	const std::string lineA = "[2024-01-01;12:00:00][00001234] message number 12345 from the benchmark|\r\n";
+
+	DeleteFileW(L"benchmark_file.log");
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		HANDLE h = CreateFileW(L"benchmark_file.log", GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, 0, OPEN_ALWAYS, 0, 0);
+		DWORD bw;
+		if(GetFileSize(h, NULL) != 0)
+		{
+			WORD bom = 0;
+			SetFilePointer(h, 0, NULL, FILE_BEGIN);
+			ReadFile(h, &bom, 2, &bw, NULL);
+			SetFilePointer(h, 0, NULL, FILE_END);
+		}
+		WriteFile(h, lineA.c_str(), (DWORD)lineA.size(), &bw, 0);
+		CloseHandle(h);
+	}
+	ReportBenchmark(t, "reopen per line");
+	std::cout << LibCC::FormatA("  % lines/sec\r\n").ul((unsigned long)(Passes / t.GetElapsedSeconds())).Str();
+
+	const size_t bufferSizes[] = { 0, LIBCC_LOG_FILE_BUFFER, LIBCC_LOG_FILE_BUFFER };
+	const bool async[] = { false, false, true };
+	const char* names[] = { "Log, kept open, unbuffered", "Log, kept open, buffered", "Log, kept open, buffered, async" };
+	for(int i = 0; i < 3; ++ i)
+	{
+		DeleteFileW(L"benchmark_file.log");
+		LibCC::Log log("benchmark_file.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+		log.SetFileBuffering(bufferSizes[i], LIBCC_LOG_FLUSH_INTERVAL);
+		log.EnableAsync(async[i], 65536);
+		StartBenchmark(t);
+		for(int pass = 0; pass < Passes; pass ++)
+		{
+			log.Message(L"message number 12345 from the benchmark");
+		}
+		log.Flush();
+		ReportBenchmark(t, names[i]);
+		std::cout << LibCC::FormatA("  % lines/sec\r\n").ul((unsigned long)(Passes / t.GetElapsedSeconds())).Str();
+	}
+	DeleteFileW(L"benchmark_file.log");
+
+	return true;
+}
+
+bool LogBinaryBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 2000;
+#else
+  const int Passes = 100000;
+#endif
+
+	std::cout << std::endl << Passes << " formatted log lines, text vs. binary:" << std::endl;
+
+	const char* names[] = { "text", "text, async", "binary", "binary, async" };
+	for(int i = 0; i < 4; ++ i)
+	{
+		const bool binary = i >= 2;
+		DeleteFileW(L"benchmark_binary.log");
+		{
+			LibCC::Log log;
+			log.EnableBinaryFormat(binary);
+			log.Create("benchmark_binary.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+			log.EnableAsync((i & 1) != 0, 65536);
+			StartBenchmark(t);
+			for(int pass = 0; pass < Passes; pass ++)
+			{
+				if(binary)
+					LIBCC_LOG_TRACE(log, "request % took % ms for %", pass, 1.25, "client-name");
+				else
+					log.Message(LibCC::FormatA("request % took % ms for %").i(pass).d(1.25).s("client-name"));
+			}
+			log.Flush();
+			ReportBenchmark(t, names[i]);
+		}
+		WIN32_FILE_ATTRIBUTE_DATA fad = {};
+		GetFileAttributesExW(L"benchmark_binary.log", GetFileExInfoStandard, &fad);
+		std::cout << LibCC::FormatA("  % lines/sec, % bytes\r\n").ul((unsigned long)(Passes / t.GetElapsedSeconds())).ul(fad.nFileSizeLow).Str();
+	}
+	DeleteFileW(L"benchmark_binary.log");
+
+	return true;
+}
+// lines/sec with 1-64 threads logging at once: every thread through the synchronous writer, through one shared
+// async queue, and through a queue per producer thread.
+bool LogContentionBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 6400;
+#else
+  const int Passes = 256000;
+#endif
+
+	std::cout << std::endl << Passes << " log lines from concurrent threads:" << std::endl;
+
+	const int threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+	const char* names[] = { "sync", "async, shared queue", "async, queue per thread" };
+	for(int c = 0; c < 7; ++ c)
+	{
+		const int Threads = threadCounts[c];
+		for(int i = 0; i < 3; ++ i)
+		{
+			DeleteFileW(L"benchmark_threads.log");
+			LibCC::Log log("benchmark_threads.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+			if(i > 0)
+				log.EnableAsync(true, 8192, LibCC::LogBackpressureBlock, i == 2);
+			StartBenchmark(t);
+			std::vector<std::thread> threads;
+			for(int n = 0; n < Threads; ++ n)
+			{
+				threads.push_back(std::thread([&log, Passes, Threads]()
+				{
+					for(int pass = 0; pass < Passes / Threads; pass ++)
+					{
+						log.Message(L"message number 12345 from the benchmark");
+					}
+				}));
+			}
+			for(int n = 0; n < Threads; ++ n)
+			{
+				threads[n].join();
+			}
+			log.Flush();
+			ReportBenchmark(t, LibCC::FormatA("% threads, %").i(Threads).s(names[i]).Str());
+			std::cout << LibCC::FormatA("  % lines/sec, blocked % times\r\n").ul((unsigned long)(Passes / t.GetElapsedSeconds())).ul((unsigned long)log.GetQueueStats().blocked).Str();
+		}
+	}
+	DeleteFileW(L"benchmark_threads.log");
+
+	return true;
+}
+
+// what a log call below the level costs the caller. LIBCC_LOG checks the level before it builds its arguments;
+// Message() gets them already built.
+bool LogDisabledBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 1000000;
+#else
+  const int Passes = 50000000;
+#endif
+
+	std::cout << std::endl << Passes << " log calls below the level:" << std::endl;
+
+	LibCC::Log log("benchmark_disabled.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+	log.SetLevel(LibCC::LogLevelWarning);
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		LIBCC_LOG(log, LibCC::LogLevelDebug, LibCC::FormatW(L"message number % from the benchmark").i(pass));
+	}
+	ReportBenchmark(t, "LIBCC_LOG");
+	std::cout << LibCC::FormatA("  % ns per call\r\n").d<2>(t.GetElapsedSeconds() * 1e9 / Passes).Str();
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes / 100; pass ++)
+	{
+		log.Message(LibCC::LogLevelDebug, LibCC::FormatW(L"message number % from the benchmark").i(pass));
+	}
+	ReportBenchmark(t, "Message(), 1/100 the calls");
+	std::cout << LibCC::FormatA("  % ns per call\r\n").d<2>(t.GetElapsedSeconds() * 1e9 / (Passes / 100)).Str();
+
+	return true;
+}
+
+// LogScopeMessage: two messages and an indent change each time, from the calling thread's point of view
+bool LogScopeBenchmark()
+{
+  LibCC::Timer t;
+#ifdef _DEBUG
+  const int Passes = 1000;
+#else
+  const int Passes = 50000;
+#endif
+
+	std::cout << std::endl << Passes << " LogScopeMessage scopes:" << std::endl;
+
+	DeleteFileW(L"benchmark_scope.log");
+	LibCC::Log log("benchmark_scope.log", GetModuleHandle(NULL), false, false, true, true, false, false);
+	log.EnableAsync(true, 65536);
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		LibCC::LogScopeMessage scope("benchmark scope", &log);
+	}
+	ReportBenchmark(t, "async, producer only");
+	log.Flush();
+	ReportBenchmark(t, "async, including Flush()");
+
+	StartBenchmark(t);
+	for(int pass = 0; pass < Passes; pass ++)
+	{
+		log.Indent();
+		log.Outdent();
+	}
+	ReportBenchmark(t, "Indent() + Outdent()");
+
+	return true;
+}
+
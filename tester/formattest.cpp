@@ -389,6 +389,30 @@ bool FormatTest()
 	}
 
 
+	// s(maxlen) / qs(maxlen) count code points; surrogate pairs are never split
+	{
+		FormatW fw;
+		std::wstring w = L"ab__cd";
+		w[2] = 0xd83d;
+		w[3] = 0xde00;
+
+		fw.Clear();
+		fw.s<3>(w);
+		TestAssert(fw.Str() == w.substr(0, 4));
+
+		fw.Clear();
+		fw.s(w, 2);
+		TestAssert(fw.Str() == L"ab");
+
+		fw.Clear();
+		fw.qs<5>(w);
+		TestAssert(fw.Str() == L"\"" + w.substr(0, 4) + L"\"");
+
+		FormatA fa;
+		fa.s<3>("abcdef");
+		TestAssert(fa.Str() == "abc");
+	}
+
 	// qs(maxlen) - templated versions
 	{
 		FormatW fw;
@@ -726,5 +750,68 @@ bool FormatTest()
     TestAssert_Eq(FormatW(L"-%-")(ws).Str(), L"-omg-");
   }
 
+	// arguments on both sides of the inline capacity, with a couple of different capacities
+	{
+		std::wstring shortArg(QuickStringData<wchar_t, LIBCC_QUICKSTRING_INLINE>::Capacity, L's');
+		std::wstring longArg(QuickStringData<wchar_t, LIBCC_QUICKSTRING_INLINE>::Capacity + 1, L'l');
+		FormatW fw(L"%|%|%");
+		fw.s(shortArg).s(longArg).qs(shortArg);
+		TestAssert(fw.Str() == shortArg + L"\r\n" + longArg + L"\r\n\"" + shortArg + L"\"");
+		FormatW copy(fw);
+		TestAssert(copy.Str() == fw.Str());
+
+		FormatX<wchar_t, std::char_traits<wchar_t>, std::allocator<wchar_t>, 1> tiny(L"[%,%,%]");
+		tiny.s(longArg).i(25).c('x', 40);
+		TestAssert(tiny.Str() == L"[" + longArg + L",25," + std::wstring(40, L'x') + L"]");
+		FormatW fromTiny;
+		fromTiny.s(tiny);
+		TestAssert(fromTiny.Str() == tiny.Str());
+
+		FormatX<char, std::char_traits<char>, std::allocator<char>, 100> wide("%");
+		wide.s(std::string(100, 'w'));
+		TestAssert(wide.Str() == std::string(100, 'w'));
+
+		// capacity packed into the last unit
+		TestAssert((QuickStringData<char, 31>::Capacity == 31));
+		TestAssert(sizeof(QuickStringData<char, 31>) == 32);
+		TestAssert(sizeof(QuickStringData<wchar_t, 31>) == 32 * sizeof(wchar_t));
+	}
+
+	// arguments allocated from a StringArena
+	{
+		StringArena arena(4096);
+		std::wstring longArg(100, L'a');
+		{
+			std::wstring correct;
+			FormatW fw(L"%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%", arena);// more args than the list holds inline
+			for(int i = 0; i < 40; ++ i)
+			{
+				fw.s(longArg);
+				correct.append(longArg);
+			}
+			TestAssert(fw.Str() == correct);
+			TestAssert(arena.ChunkCount() > 1 && arena.ChunkCount() < 10);// a few chunks, not an allocation per argument
+
+			FormatW copy(fw);
+			TestAssert(copy.Str() == correct);
+		}
+
+		arena.Reset();// everything that used it is gone
+		TestAssert(arena.ChunkCount() == 1);
+		FormatW again(L"% %", arena);
+		again.s(longArg).i(5);
+		TestAssert(again.Str() == longArg + L" 5");
+		TestAssert(arena.ChunkCount() == 1);
+
+		// grow in place when it's the latest allocation
+		char* p = (char*)arena.Allocate(10);
+		TestAssert(arena.Extend(p, 10, 100));
+		char* p2 = (char*)arena.Allocate(10);
+		TestAssert(p2 >= p + 100);
+		TestAssert(!arena.Extend(p, 100, 200));
+		TestAssert(arena.Allocate(100000) != 0);// gets its own chunk
+		TestAssert(arena.ChunkCount() == 2);
+	}
+
 	return true;
 }
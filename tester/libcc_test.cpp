@@ -11,8 +11,36 @@ extern bool StringTest();
 //extern bool PathMatchSpecTest();
 extern bool FormatTest();
 extern bool FormatBenchmark();
+extern bool Utf8Benchmark();
+extern bool CharSetBenchmark();
+extern bool SearchBenchmark();
+extern bool ReplaceManyBenchmark();
+extern bool SplitBenchmark();
+extern bool JoinBenchmark();
+extern bool TrimBenchmark();
+extern bool CaseBenchmark();
+extern bool EqualsBenchmark();
+extern bool InternBenchmark();
+extern bool QuickStringBenchmark();
+extern bool ArenaBenchmark();
+extern bool RopeBenchmark();
+extern bool HashMapBenchmark();
+extern bool BatchConvertBenchmark();
+extern bool LogBenchmark();
+extern bool LogFileBenchmark();
+extern bool LogBinaryBenchmark();
+extern bool LogContentionBenchmark();
+extern bool LogDisabledBenchmark();
+extern bool LogScopeBenchmark();
 //extern bool ParseBenchmark();
 extern void LogTest();
+extern void LogAsyncTest();
+extern void LogRotationTest();
+extern void LogBinaryTest();
+extern void LogThreadQueueTest();
+extern void LogLevelTest();
+extern void LogTimePrefixTest();
+extern void LogIndentTest();
 //extern bool BlobTest();
 //extern bool AllocationTrackerTest();
 extern bool StringCompilationTest();
@@ -72,12 +100,40 @@ void TestCollection()
 	//RunTest(ParseBenchmark);
 
 	//RunTest(LogTest);
+	//RunTest(LogAsyncTest);
+	//RunTest(LogRotationTest);
+	//RunTest(LogBinaryTest);
+	//RunTest(LogThreadQueueTest);
+	//RunTest(LogLevelTest);
+	//RunTest(LogTimePrefixTest);
+	//RunTest(LogIndentTest);
 	//RunTest(AllocationTrackerTest);
 
 	RunTest(StringTest);
 	RunTest(StringCompilationTest);
 	RunTest(FormatTest);
 	// RunTest(FormatBenchmark);
+	// RunTest(Utf8Benchmark);
+	// RunTest(CharSetBenchmark);
+	// RunTest(SearchBenchmark);
+	// RunTest(ReplaceManyBenchmark);
+	// RunTest(SplitBenchmark);
+	// RunTest(JoinBenchmark);
+	// RunTest(TrimBenchmark);
+	// RunTest(CaseBenchmark);
+	// RunTest(EqualsBenchmark);
+	// RunTest(InternBenchmark);
+	// RunTest(QuickStringBenchmark);
+	// RunTest(ArenaBenchmark);
+	// RunTest(RopeBenchmark);
+	// RunTest(HashMapBenchmark);
+	// RunTest(BatchConvertBenchmark);
+	// RunTest(LogBenchmark);
+	// RunTest(LogFileBenchmark);
+	// RunTest(LogBinaryBenchmark);
+	// RunTest(LogContentionBenchmark);
+	// RunTest(LogDisabledBenchmark);
+	// RunTest(LogScopeBenchmark);
 
 	//RunTest(RegistryTest); // careful with this of course.
 	//RunTest(StatusTest);
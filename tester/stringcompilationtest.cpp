@@ -54,45 +54,45 @@ bool StringCompilationTest()
 		StringEquals(x1, w1);
 		StringEquals(x1, x1);
 
-		//StringEqualsI(a1.c_str(), a1.c_str());
-		//StringEqualsI(a1.c_str(), w1.c_str());
-		//StringEqualsI(a1.c_str(), x1.c_str());
-		//StringEqualsI(w1.c_str(), a1.c_str());
-		//StringEqualsI(w1.c_str(), w1.c_str());
-		//StringEqualsI(w1.c_str(), x1.c_str());
-		//StringEqualsI(x1.c_str(), a1.c_str());
-		//StringEqualsI(x1.c_str(), w1.c_str());
-		//StringEqualsI(x1.c_str(), x1.c_str());
-
-		//StringEqualsI(a1.c_str(), a1);
-		//StringEqualsI(a1.c_str(), w1);
-		//StringEqualsI(a1.c_str(), x1);
-		//StringEqualsI(w1.c_str(), a1);
-		//StringEqualsI(w1.c_str(), w1);
-		//StringEqualsI(w1.c_str(), x1);
-		//StringEqualsI(x1.c_str(), a1);
-		//StringEqualsI(x1.c_str(), w1);
-		//StringEqualsI(x1.c_str(), x1);
-
-		//StringEqualsI(a1, a1.c_str());
-		//StringEqualsI(a1, w1.c_str());
-		//StringEqualsI(a1, x1.c_str());
-		//StringEqualsI(w1, a1.c_str());
-		//StringEqualsI(w1, w1.c_str());
-		//StringEqualsI(w1, x1.c_str());
-		//StringEqualsI(x1, a1.c_str());
-		//StringEqualsI(x1, w1.c_str());
-		//StringEqualsI(x1, x1.c_str());
-
-		//StringEqualsI(a1, a1);
-		//StringEqualsI(a1, w1);
-		//StringEqualsI(a1, x1);
-		//StringEqualsI(w1, a1);
-		//StringEqualsI(w1, w1);
-		//StringEqualsI(w1, x1);
-		//StringEqualsI(x1, a1);
-		//StringEqualsI(x1, w1);
-		//StringEqualsI(x1, x1);
+		StringEqualsI(a1.c_str(), a1.c_str());
+		StringEqualsI(a1.c_str(), w1.c_str());
+		StringEqualsI(a1.c_str(), x1.c_str());
+		StringEqualsI(w1.c_str(), a1.c_str());
+		StringEqualsI(w1.c_str(), w1.c_str());
+		StringEqualsI(w1.c_str(), x1.c_str());
+		StringEqualsI(x1.c_str(), a1.c_str());
+		StringEqualsI(x1.c_str(), w1.c_str());
+		StringEqualsI(x1.c_str(), x1.c_str());
+
+		StringEqualsI(a1.c_str(), a1);
+		StringEqualsI(a1.c_str(), w1);
+		StringEqualsI(a1.c_str(), x1);
+		StringEqualsI(w1.c_str(), a1);
+		StringEqualsI(w1.c_str(), w1);
+		StringEqualsI(w1.c_str(), x1);
+		StringEqualsI(x1.c_str(), a1);
+		StringEqualsI(x1.c_str(), w1);
+		StringEqualsI(x1.c_str(), x1);
+
+		StringEqualsI(a1, a1.c_str());
+		StringEqualsI(a1, w1.c_str());
+		StringEqualsI(a1, x1.c_str());
+		StringEqualsI(w1, a1.c_str());
+		StringEqualsI(w1, w1.c_str());
+		StringEqualsI(w1, x1.c_str());
+		StringEqualsI(x1, a1.c_str());
+		StringEqualsI(x1, w1.c_str());
+		StringEqualsI(x1, x1.c_str());
+
+		StringEqualsI(a1, a1);
+		StringEqualsI(a1, w1);
+		StringEqualsI(a1, x1);
+		StringEqualsI(w1, a1);
+		StringEqualsI(w1, w1);
+		StringEqualsI(w1, x1);
+		StringEqualsI(x1, a1);
+		StringEqualsI(x1, w1);
+		StringEqualsI(x1, x1);
 
 
 		StringFindLastOf(a1.c_str(), a1.c_str());
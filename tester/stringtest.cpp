@@ -3,6 +3,7 @@
 
 #include "test.h"
 #include "libcc\stringutil.hpp"
+#include "libcc\rope.hpp"
 #include <vector>
 using namespace LibCC;
 
@@ -198,6 +199,57 @@ bool StringTest()
 		v.clear();
 		StringSplitByString(L"12345", L"aoeu", std::back_inserter(v));
 		TestAssert(v.size() == 1);
+
+		// partial separators are kept in the token
+		va.clear();
+		StringSplitByString("aXbab", "ab", std::back_inserter(va));
+		TestAssert(va.size() == 2);
+		TestAssert(va[0] == "aXb");
+		TestAssert(va[1].empty());
+	}
+
+	{ // *** StringSplit views
+		std::string a = "k=v;x=y, z";
+		std::vector<StringView<char> > t;
+		StringSplitRange<char, StringSplitFinderCharSet<char> > r = StringSplitByChars(a, ";,= ");
+		for(StringSplitRange<char, StringSplitFinderCharSet<char> >::iterator it = r.begin(); it != r.end(); ++ it)
+		{
+			t.push_back(*it);
+		}
+		TestAssert(t.size() == 6);
+		TestAssert(t[0].data() == a.c_str());// points into the source
+		TestAssert(t[1] == StringView<char>("v", 1));
+		TestAssert(t[4].empty());
+		TestAssert(t[5].str() == "z");
+
+		std::wstring w = L"a,b,,c,";
+		std::vector<std::wstring> v;
+		StringSplitRange<wchar_t, StringSplitFinderChar<wchar_t> > rw = StringSplitByChar(w, L',');
+		for(StringSplitRange<wchar_t, StringSplitFinderChar<wchar_t> >::iterator it = rw.begin(); it != rw.end(); ++ it)
+		{
+			v.push_back(it->str());
+		}
+		TestAssert(v.size() == 5);
+		TestAssert(v[2].empty());
+		TestAssert(v[3] == L"c");
+		TestAssert(v[4].empty());
+
+		size_t n = 0;
+		StringSplitRange<char, StringSplitFinderString<char> > rs = StringSplitByString("one--two--three", "--");
+		for(StringSplitRange<char, StringSplitFinderString<char> >::iterator it = rs.begin(); it != rs.end(); ++ it)
+		{
+			n += it->size();
+		}
+		TestAssert(n == 11);
+
+		// empty source has no tokens, no separators gives 1 token
+		TestAssert(StringSplitByChar("", ',').begin() == StringSplitByChar("", ',').end());
+		std::vector<std::string> va;
+		StringSplitByChar("abc", ',', std::back_inserter(va));
+		TestAssert(va.size() == 1);
+		StringSplitByChars("a b\tc", " \t", std::back_inserter(va));
+		TestAssert(va.size() == 4);
+		TestAssert(va[3] == "c");
 	}
 
 	{ // *** StringJoin
@@ -237,6 +289,32 @@ bool StringTest()
 		compare[2] = 9674;
 		compare[3] = 9674;
 		TestAssert(w == compare);
+
+		// mixed types are converted in place
+		va.clear();
+		va.push_back("tube");
+		va.push_back("bowl");
+		w = StringJoin<wchar_t>(va.begin(), va.end(), ", ");
+		TestAssert(w == L"tube, bowl");
+		std::vector<const char*> vp;
+		vp.push_back("a");
+		vp.push_back("");
+		vp.push_back("bc");
+		a = StringJoin<char>(vp.begin(), vp.end(), L"/");
+		TestAssert(a == "a//bc");
+
+		// parallel join gives the same result as the serial one
+		va.clear();
+		for(int i = 0; i < 50000; ++ i)
+		{
+			va.push_back(std::string(i % 7, (char)('a' + i % 26)));
+		}
+		a = StringJoin(va.begin(), va.end(), "--");
+		TestAssert(StringJoinParallel(va.begin(), va.end(), "--", 4) == a);
+		TestAssert(StringJoinParallel(va.begin(), va.end(), "--") == a);
+		TestAssert(StringJoinParallel(va.begin(), va.begin() + 3, "--", 4) == "--b--cc");
+		w = StringJoin<wchar_t>(va.begin(), va.end(), L"|");
+		TestAssert(StringJoinParallel(va.begin(), va.end(), L"|", 3) == w);
 	}
 
 	{ // **** StringTrim
@@ -268,6 +346,44 @@ bool StringTest()
 		std::wstring w2 = L" \t";
 		std::wstring w3 = StringTrim(w1, w2);
 		TestAssert(w3 == L"omg");
+
+		// views & whitespace
+		StringView<char> v = StringTrimView("  \t\r\n x y \v\f");
+		TestAssert(v.str() == "x y");
+		TestAssert(StringTrimView(" \t \n").empty());
+		TestAssert(StringTrimView("").empty());
+		TestAssert(StringTrimView("x").str() == "x");
+		std::string longer = std::string(40, ' ') + "field, with  spaces" + std::string(37, '\t');
+		TestAssert(StringTrimView(longer).str() == "field, with  spaces");
+		longer = std::string(40, ' ') + "\x1f" + std::string(37, ' ');// just below \t and just above \r aren't whitespace
+		TestAssert(StringTrimView(longer).str() == "\x1f");
+		longer = std::string(33, '\n') + "\x08" + std::string(17, '\r') + "\x0e";
+		TestAssert(StringTrimView(longer).size() == 19);
+		TestAssert(StringTrimView(w1).str() == L"omg");
+		std::wstring wideLonger = std::wstring(20, L' ') + L"omg" + std::wstring(20, L' ');
+		wideLonger[25] = 0x2009;// not ASCII whitespace
+		TestAssert(StringTrimView(wideLonger).size() == 6);
+		wideLonger[25] = 0x0920;// low byte is a space
+		TestAssert(StringTrimView(wideLonger).size() == 6);
+
+		// views & sets
+		StringCharSet<char> digits("0123456789");
+		TestAssert(StringTrimView("123x123x321", digits).str() == "x123x");
+		TestAssert(StringTrimView("123x123x321", "213").str() == "x123x");
+		TestAssert(StringTrimView("31337", digits).empty());
+		longer = std::string(20, '7') + "a" + std::string(30, '1') + "b" + std::string(20, '9');
+		TestAssert(StringTrimView(longer, digits).size() == 32);
+
+		// in place
+		a = "  \tin place\r\n";
+		StringTrimInPlace(a);
+		TestAssert(a == "in place");
+		a = "xxinxplacexx";
+		StringTrimInPlace(a, "x");
+		TestAssert(a == "inxplace");
+		a = "xxxx";
+		StringTrimInPlace(a, std::string("x"));
+		TestAssert(a.empty());
 	}
 	
 	{ // **** StringReplace
@@ -310,6 +426,59 @@ bool StringTest()
 		TestAssert(StringReplace(L"hi, fred", L"fred", w3) == L"hi, sally");
 		TestAssert(StringReplace(L"hi, fred", L"fred", L"sally") == L"hi, sally");
 	}
+
+	{ // **** StringSearcher
+		// short needle; first/last char filter. matches straddle the 16 byte blocks
+		std::string a1 = "fredfred fredfred frefre fred and some more text to fill a block, fred";
+		StringSearcher<char> fred("fred");
+		TestAssert(0 == fred.Find(a1));
+		TestAssert(4 == fred.Find(a1, 1));
+		TestAssert(25 == fred.Find(a1, 14));
+		TestAssert(66 == fred.Find(a1, 26));
+		TestAssert(std::string::npos == fred.Find(a1, 67));
+		TestAssert(std::string::npos == fred.Find(a1, 1000));
+		TestAssert(StringContainsString(a1, fred));
+		TestAssert(!StringContainsString("frefre fre", fred));
+		TestAssert(StringReplace(a1, fred, std::string("x")) == "xx xx frefre x and some more text to fill a block, x");
+
+		// long needle; Horspool
+		std::wstring needle = L"0123456789abcdefghijklmnopqrstuvwxyz";
+		std::wstring w1 = L"0123456789abcdefghijklmnopqrstuvwxy 0123456789abcdefghijklmnopqrstuvwxyz!";
+		StringSearcher<wchar_t> w(needle);
+		TestAssert(36 == w.Find(w1));
+		TestAssert(std::wstring::npos == w.Find(w1, 37));
+		TestAssert(StringContainsString(w1, needle));
+		TestAssert(!StringContainsString(w1.substr(0, 50), needle));
+		TestAssert(StringReplace(w1, needle, L"-") == L"0123456789abcdefghijklmnopqrstuvwxy -!");
+
+		// single char and empty needles
+		TestAssert(3 == StringSearcher<char>("d").Find("fred"));
+		TestAssert(2 == StringSearcher<char>("").Find("fred", 4, 2));
+		TestAssert(StringContainsString("fred", ""));
+		TestAssert(!StringContainsString("", "fred"));
+
+		// replacement can shrink the string to nothing
+		TestAssert(StringReplace(std::string("fredfred"), "fred", "").empty());
+	}
+
+	{ // **** StringReplaceMany
+		// escaping; replacements don't see each other's output
+		TestAssert(StringReplaceMany(std::string("<a & b>"), {{"<", "&lt;"}, {">", "&gt;"}, {"&", "&amp;"}}) == "&lt;a &amp; b&gt;");
+		TestAssert(StringReplaceMany(L"ab", {{L"a", L"b"}, {L"b", L"a"}}) == L"ba");
+
+		// leftmost wins, then longest
+		TestAssert(StringReplaceMany("he said hello", {{"he", "she"}, {"hello", "bye"}}) == "she said bye");
+		TestAssert(StringReplaceMany("abcd", {{"bcd", "1"}, {"abc", "2"}}) == "2d");
+		TestAssert(StringReplaceMany("abcd", {{"bc", "1"}, {"abcd", "2"}, {"ab", "3"}}) == "2");
+
+		// reusable; empty input / no matches / empty patterns
+		StringReplacer<char> r({{"$name", "carl"}, {"$n", "5"}, {"", "x"}});
+		TestAssert(r.Replace("hi $name, you have $n messages") == "hi carl, you have 5 messages");
+		TestAssert(r.Replace("$n$name$") == "5carl$");
+		TestAssert(r.Replace("") == "");
+		TestAssert(r.Replace("nothing to see") == "nothing to see");
+		TestAssert(StringReplaceMany(std::string("aaa"), StringReplacer<char>()) == "aaa");
+	}
 	
 	{	// **** StringToUpper
 		std::string a1;
@@ -325,21 +494,21 @@ bool StringTest()
 		std::basic_string<DWORD> correctX;
 		StringConvert(correctW, correctX);
 		
-		//a1 = StringToUpper("ABCDE123!@#abcdefghijklm");
-		//TestAssert(a1 == correctA);
-		//
-		//w1 = StringToUpper(L"ABCDE123!@#abcdefghijklm");
-		//TestAssert(w1 == correctW);
+		a1 = StringToUpper("ABCDE123!@#abcdefghijklm");
+		TestAssert(a1 == correctA);
+		
+		w1 = StringToUpper(L"ABCDE123!@#abcdefghijklm");
+		TestAssert(w1 == correctW);
 
-		//w1 = StringToUpper(srcW);
-		//TestAssert(w1 == correctW);
-		//
-		//a1 = StringToUpper(srcA);
-		//TestAssert(w1 == correctW);
-		//
-		//std::basic_string<DWORD> x1;
-		//x1 = StringToUpper(srcX);
-		//TestAssert(x1 == correctX);
+		w1 = StringToUpper(srcW);
+		TestAssert(w1 == correctW);
+		
+		a1 = StringToUpper(srcA);
+		TestAssert(a1 == correctA);
+		
+		std::basic_string<DWORD> x1;
+		x1 = StringToUpper(srcX);
+		TestAssert(x1 == correctX);
 	}
 	
 	{	// **** StringToLower
@@ -356,21 +525,132 @@ bool StringTest()
 		std::basic_string<DWORD> correctX;
 		StringConvert(correctW, correctX);
 		
-		//a1 = StringToLower("aeousnt234@#$//AEXL>I<TTT");
-		//TestAssert(a1 == correctA);
-		//
-		//w1 = StringToLower(L"aeousnt234@#$//AEXL>I<TTT");
-		//TestAssert(w1 == correctW);
+		a1 = StringToLower("aeousnt234@#$//AEXL>I<TTT");
+		TestAssert(a1 == correctA);
+		
+		w1 = StringToLower(L"aeousnt234@#$//AEXL>I<TTT");
+		TestAssert(w1 == correctW);
 
-		//w1 = StringToLower(srcW);
-		//TestAssert(w1 == correctW);
-		//
-		//a1 = StringToLower(srcA);
-		//TestAssert(w1 == correctW);
-		//
-		//std::basic_string<DWORD> x1;
-		//x1 = StringToLower(srcX);
-		//TestAssert(x1 == correctX);
+		w1 = StringToLower(srcW);
+		TestAssert(w1 == correctW);
+		
+		a1 = StringToLower(srcA);
+		TestAssert(a1 == correctA);
+		
+		std::basic_string<DWORD> x1;
+		x1 = StringToLower(srcX);
+		TestAssert(x1 == correctX);
+	}
+
+	{	// **** StringEqualsI / StringCompareI / StringHashI
+		TestAssert(StringEqualsI("Content-Length", "content-length"));
+		TestAssert(StringEqualsI(std::string("CONTENT-LENGTH"), "content-length"));
+		TestAssert(!StringEqualsI("Content-Length", "content-lengths"));
+		TestAssert(!StringEqualsI("Content-Length", "content_length"));
+		TestAssert(StringEqualsI("", ""));
+		TestAssert(!StringEqualsI("@", "`"));// just outside A-Z / a-z
+		TestAssert(!StringEqualsI("[", "{"));
+		TestAssert(StringEqualsI(std::wstring(L"Hello"), "hELLO"));
+
+		// long enough for the block paths, with the difference near the end
+		std::string longA = "Accept-Encoding: GZIP, Deflate, BR; Q=0.9";
+		std::string longB = "accept-encoding: gzip, deflate, br; q=0.9";
+		TestAssert(StringEqualsI(longA, longB));
+		TestAssert(StringCompareI(longA, longB) == 0);
+		TestAssert(StringHashI(longA) == StringHashI(longB));
+		longB[longB.size() - 1] = '8';
+		TestAssert(!StringEqualsI(longA, longB));
+		TestAssert(StringCompareI(longA, longB) > 0);
+		TestAssert(StringCompareI(longB, longA) < 0);
+		TestAssert(StringCompareI("abc", "ABCD") < 0);
+
+		// non-ASCII goes through the case tables
+		std::wstring w1 = L"\x3a3\x3b9\x3c3\x3c5\x3c6\x3bf\x3c2 stra\xdf" L"e \x416\x438\x437\x43d\x44c";// Greek, German, Cyrillic
+		std::wstring w2 = L"\x3c3\x399\x3a3\x3a5\x3a6\x39f\x3a3 STRA\xdf" L"E \x436\x418\x417\x41d\x42c";
+		TestAssert(StringEqualsI(w1, w2));
+		TestAssert(StringHashI(w1) == StringHashI(w2));
+		TestAssert(StringToLower(L"\x130\x212a") == L"ik");// dotted I, Kelvin sign
+		TestAssert(StringToUpper(L"\x1f0\xdf\x101") == L"\x1f0\xdf\x100");// no 1:1 uppercase for these first two
+		TestAssert(CharToUpper(L'\xff') == L'\x178');
+		TestAssert(CharFoldCase(L'\x3c2') == CharFoldCase(L'\x3a3'));
+		std::basic_string<__int32> x1;
+		x1.push_back(0x10400);// Deseret is outside the BMP
+		x1.push_back('A');
+		TestAssert(StringToLower(x1)[0] == 0x10428);
+		TestAssert(StringToLower(x1)[1] == 'a');
+
+		// in place
+		std::string a1 = "Mixed Case";
+		StringToUpperInPlace(a1);
+		TestAssert(a1 == "MIXED CASE");
+		StringToLowerInPlace(a1);
+		TestAssert(a1 == "mixed case");
+	}
+
+	{	// **** StringHash / StringHashMap
+		// every length through the 48 / 16 / tail paths hashes differently
+		std::string base(200, 'x');
+		std::vector<size_t> byLength;
+		for(size_t i = 0; i <= base.size(); ++ i)
+		{
+			byLength.push_back(StringHash(base.c_str(), i));
+		}
+		std::sort(byLength.begin(), byLength.end());
+		TestAssert(std::unique(byLength.begin(), byLength.end()) == byLength.end());
+		TestAssert(StringHash(base) == StringHash(StringView<char>(base)));
+		TestAssert(StringHash(base, 1) != StringHash(base, 2));
+		std::wstring longW(500, L'A');
+		std::wstring longLowerW(500, L'a');
+		TestAssert(StringHashI(longW) == StringHashI(longLowerW));
+		TestAssert(StringHashI(longW, 7) == StringHashI(longLowerW, 7));
+		TestAssert(StringHash(longW) != StringHash(longLowerW));
+
+		StringHashMap<wchar_t, int> m;
+		TestAssert(m.Find(L"nothing") == 0);
+		for(int i = 0; i < 1000; ++ i)
+		{
+			TestAssert(m.Insert(FormatW(L"key%").i(i).Str(), i));
+		}
+		TestAssert(!m.Insert(L"key5", 0));
+		TestAssert(*m.Find(L"key5") == 5);
+		TestAssert(m.size() == 1000);
+		m[L"key5"] = 55;
+		m[std::wstring(L"new")] ++;
+		TestAssert(*m.Find(std::wstring(L"key5")) == 55 && m[L"new"] == 1);
+		for(int i = 0; i < 1000; i += 2)
+		{
+			TestAssert(m.Erase(FormatW(L"key%").i(i).Str()));
+		}
+		TestAssert(!m.Erase(L"key0"));
+		TestAssert(m.size() == 501);
+		int sum = 0;
+		m.ForEach([&sum](const std::wstring&, int v) { sum += v; });
+		TestAssert(sum == 250000 - 5 + 55 + 1);
+		for(int i = 1; i < 1000; i += 2)
+		{
+			TestAssert(m.Contains(FormatW(L"key%").i(i).Str()));
+		}
+		StringHashMap<wchar_t, int> copy(m);
+		m.clear();
+		TestAssert(m.empty() && copy.size() == 501);
+
+		StringHashMap<char, std::string, StringKeyOpsI<char> > headers;
+		headers.Insert("Content-Type", "text/plain");
+		TestAssert(headers.Find("CONTENT-TYPE") && *headers.Find("content-type") == "text/plain");
+		TestAssert(!headers.Insert("content-type", "text/html"));
+
+#if LIBCC_UTF8 == 1
+		// keys StringEqualsI calls equal, one all ASCII and one not: "k" / KELVIN SIGN, "s" / LATIN SMALL LONG S
+		StringHashMap<char, int, StringKeyOpsI<char> > folded;
+		folded.Insert("k", 1);
+		folded.Insert("s", 2);
+		TestAssert(StringEqualsI(std::string("k"), std::string("\xE2\x84\xAA")));
+		TestAssert(folded.Find("\xE2\x84\xAA") && *folded.Find("\xE2\x84\xAA") == 1);
+		TestAssert(folded.Find("\xC5\xBF") && *folded.Find("\xC5\xBF") == 2);
+		std::string longAscii(300, 'K');
+		std::string longMixed = longAscii.substr(0, 250) + "\xE2\x84\xAA" + longAscii.substr(251);
+		TestAssert(StringHashI(longAscii) == StringHashI(longMixed));
+#endif
 	}
 
 	{ // StringEquals
@@ -447,6 +727,61 @@ bool StringTest()
 
 		a1 = "";
 		TestAssert(!StringEquals(a1, "a"));
+
+		// long enough for the bulk paths, differing only at the end
+		a1 = "GET /some/fairly/long/path/to/a/resource.html HTTP/1.1";
+		std::string a2 = a1;
+		TestAssert(StringEquals(a1, a2));
+		TestAssert(StringEquals(a1.c_str(), a2.c_str()));
+		a2[a2.size() - 1] = '0';
+		TestAssert(!StringEquals(a1, a2));
+		TestAssert(!StringEquals(a1.c_str(), a2.c_str()));
+		w1 = std::wstring(L"embedded\0zero", 13);
+		TestAssert(!StringEquals(w1, std::wstring(L"embedded")));
+	}
+
+	{ // StringCompare
+		TestAssert(StringCompare("abc", "abc") == 0);
+		TestAssert(StringCompare("abc", "abd") < 0);
+		TestAssert(StringCompare("abd", "abc") > 0);
+		TestAssert(StringCompare("ab", "abc") < 0);
+		TestAssert(StringCompare(std::string("abc"), "ab") > 0);
+		TestAssert(StringCompare("", "") == 0);
+		TestAssert(StringCompare("a\xe9", "az") > 0);// unsigned, like std::string
+		TestAssert(StringCompare(L"aoeu", "aoeu") == 0);
+
+		std::wstring w1 = L"0123456789abcdefghijklmnopqrstuvwxyz";
+		std::wstring w2 = w1;
+		w2[20] = 0xff41;
+		TestAssert(StringCompare(w1, w2) < 0);
+		TestAssert(StringCompare(w2, w1) > 0);
+		w2[20] = 0x0100 + w1[20];// the low bytes match
+		TestAssert(StringCompare(w1, w2) < 0);
+		w2 = w1;
+		TestAssert(StringCompare(w1, w2) == 0);
+		TestAssert((StringCompare(w1, w2.substr(0, 35)) > 0));
+	}
+
+	{ // StringStartsWith / StringEndsWith
+		TestAssert(StringStartsWith("WARNING: disk full", "WARNING"));
+		TestAssert(!StringStartsWith("WARN", "WARNING"));// str ends before find does
+		TestAssert(StringStartsWith("", ""));
+		TestAssert(StringStartsWith("x", ""));
+		TestAssert(!StringStartsWith("", "x"));
+		TestAssert(StringStartsWith(std::string("WARNING: disk full"), "WARNING"));
+		TestAssert(!StringStartsWith(std::string("WARN"), std::string("WARNING")));
+		TestAssert(StringStartsWith(L"WARNING: disk full", "WARNING"));
+		TestAssert(StringStartsWith(std::string("WARNING: disk full"), L"WARNING"));
+		TestAssert(!StringStartsWith(L"WARNING: disk full", L"WARNINX"));
+
+		TestAssert(StringEndsWith("report.csv", ".csv"));
+		TestAssert(!StringEndsWith("csv", ".csv"));
+		TestAssert(!StringEndsWith("report.csv", ".CSV"));
+		TestAssert(StringEndsWith("x", ""));
+		TestAssert(StringEndsWith(std::wstring(L"report.csv"), ".csv"));
+		TestAssert(StringEndsWith(std::string("report.csv"), std::string("report.csv")));
+		TestAssert(!StringEndsWith(std::string("report.csv"), std::string("a report.csv")));
+		TestAssert(StringEndsWith(StringView<char>("report.csv", 8), StringView<char>(".c", 2)));
 	}
 	
 	{ // XStringContains
@@ -489,6 +824,41 @@ bool StringTest()
 		TestAssert(std::string::npos == StringFindLastOf(a1, ""));
 	}
 
+	{ // StringCharSet
+		// long enough for the 16-at-a-time path, with matches on both sides of a block boundary
+		std::string a1 = "the quick brown fox, jumps; over the lazy dog\t";
+		std::wstring w1 = L"the quick brown fox, jumps; over the lazy dog\t";
+		StringCharSet<char> seps(",;\t\r\n");
+		TestAssert(seps.Contains(','));
+		TestAssert(!seps.Contains('x'));
+		TestAssert(!seps.Contains((char)0xe9));
+		TestAssert(19 == seps.FindFirst(a1));
+		TestAssert(45 == seps.FindLast(a1));
+		TestAssert(19 == StringFindFirstOf(a1, seps));
+		TestAssert(26 == StringFindFirstOf(a1.c_str() + 20, seps) + 20);
+
+		// big sets go through StringCharSet automatically
+		TestAssert(19 == StringFindFirstOf(a1, ",;\t\r\n"));
+		TestAssert(45 == StringFindLastOf(a1, ",;\t\r\n"));
+		TestAssert(19 == StringFindFirstOf(w1, L",;\t\r\n"));
+		TestAssert(45 == StringFindLastOf(w1, ",;\t\r\n"));
+		TestAssert(std::string::npos == StringFindFirstOf(a1, "#@!%^"));
+
+		// high bytes, and wide chars that don't fit the bitmap
+		std::string a2(40, 'a');
+		a2[33] = (char)0xe9;
+		TestAssert(33 == StringFindFirstOf(a2, "\xe9\xea\xeb\xec"));
+		std::wstring w2(40, L'a');
+		w2[17] = 0x25ca;
+		w2[30] = 0x01e9;// low byte is 0xe9
+		StringCharSet<wchar_t> wide;
+		wide.Add(0x25ca);
+		TestAssert(17 == wide.FindFirst(w2));
+		TestAssert(17 == wide.FindLast(w2));
+		wide.Add(0xe9);
+		TestAssert(std::string::npos == wide.FindFirst(L"aaaaaaaaaaaaaaaaaaaaaaaaa\x01e9"));
+	}
+
 	{// StringConvert
 		// first check that conversions work for different codepages. this test will check all installed codepages. for some reason this test does fail. it should be investigated.
 		EnumCodePagesProc(L"20261");
@@ -851,6 +1221,11 @@ bool StringTest()
 		//TestAssert(ToUTF16(b.GetBuffer(), b.Size()) == L"hi there");
 		//TestAssert(ToUTF16(b, 1252) == L"hi there");
 		//TestAssert(ToUTF16(b) == L"hi there");
+
+		// CP_UTF8 takes the path every codepage takes without Windows
+		TestAssert(ToUTF16("caf\xC3\xA9 \xE2\x82\xAC", CP_UTF8) == L"caf\x00E9 \x20AC");
+		TestAssert(ToUTF16(std::string("caf\xC3\xA9"), CP_UTF8) == L"caf\x00E9");
+		TestAssert(ToUTF16("", CP_UTF8).empty());
 	}
 
 	{// ToANSI
@@ -886,6 +1261,11 @@ bool StringTest()
 		//TestAssert(ToANSI(b.GetBuffer(), b.Size()) == "hi there");
 		//TestAssert(ToANSI(b, 1252) == "hi there");
 		//TestAssert(ToANSI(b) == "hi there");
+
+		// CP_UTF8 takes the path every codepage takes without Windows
+		TestAssert(ToANSI(L"caf\x00E9 \x20AC", CP_UTF8, CP_UTF8) == "caf\xC3\xA9 \xE2\x82\xAC");
+		TestAssert(ToANSI(std::wstring(L"caf\x00E9"), CP_UTF8, CP_UTF8) == "caf\xC3\xA9");
+		TestAssert(ToANSI(L"", CP_UTF8, CP_UTF8).empty());
 	}
 
 	{// toutf8
@@ -943,6 +1323,294 @@ bool StringTest()
 		//ToUTF8(L"aoeu", a);
 	}
 
+	{// UTF8ToUTF16 / UTF16ToUTF8
+		std::wstring w;
+		std::string a;
+
+		// empty
+		UTF8ToUTF16("", 0, w);
+		TestAssert(w.empty());
+		UTF16ToUTF8(L"", 0, a);
+		TestAssert(a.empty());
+
+		// ascii, long enough to go through the wide path
+		a = "the quick brown fox jumps over the lazy dog";
+		UTF8ToUTF16(a.c_str(), a.size(), w);
+		TestAssert(w == L"the quick brown fox jumps over the lazy dog");
+		UTF16ToUTF8(w.c_str(), w.size(), a);
+		TestAssert(a == "the quick brown fox jumps over the lazy dog");
+
+		// 2 and 3 byte sequences mixed in after ascii
+		w = L"abcdefghijklmnopqrstuvwxyz_____";
+		w[20] = 0xe9;
+		w[21] = 9674;
+		UTF16ToUTF8(w.c_str(), w.size(), a);
+		TestAssert(a.size() == w.size() + 1 + 2);
+		TestAssert((BYTE)a[20] == 0xc3);
+		TestAssert((BYTE)a[21] == 0xa9);
+		TestAssert((BYTE)a[22] == 0xe2);
+		TestAssert((BYTE)a[23] == 0x97);
+		TestAssert((BYTE)a[24] == 0x8a);
+		std::wstring w2;
+		UTF8ToUTF16(a.c_str(), a.size(), w2);
+		TestAssert(w2 == w);
+		// agrees with the Win32 conversion
+		TestAssert(ToUTF8(w) == a);
+
+		// measuring doesn't write anything
+		TestAssert(UTF16ToUTF8(w.c_str(), w.size(), 0) == a.size());
+		TestAssert(UTF8ToUTF16(a.c_str(), a.size(), 0) == w.size());
+
+		// 4 byte sequence (U+1F600) becomes a surrogate pair
+		a = "\xf0\x9f\x98\x80";
+		UTF8ToUTF16(a.c_str(), a.size(), w);
+		TestAssert(w.size() == 2);
+		TestAssert(w[0] == 0xd83d);
+		TestAssert(w[1] == 0xde00);
+		UTF16ToUTF8(w.c_str(), w.size(), a);
+		TestAssert(a == "\xf0\x9f\x98\x80");
+
+		// invalid input is replaced with U+FFFD
+		a = "a\xff" "b";
+		UTF8ToUTF16(a.c_str(), a.size(), w);
+		TestAssert(w.size() == 3);
+		TestAssert(w[1] == 0xfffd);
+		w = L"a_b";
+		w[1] = 0xd800;// lone surrogate
+		UTF16ToUTF8(w.c_str(), w.size(), a);
+		TestAssert(a == "a\xef\xbf\xbd" "b");
+	}
+
+	{// code point counting / truncation
+		// "h(e acute)llo (lozenge)(U+1F600)" + enough ascii to hit the 16-at-a-time path
+		std::string a = "h\xc3\xa9llo \xe2\x97\x8a\xf0\x9f\x98\x80 the quick brown fox";
+		TestAssert(Utf8CodePointCount(a.c_str(), a.size()) == 28);
+		TestAssert(Utf8Truncate(a.c_str(), a.size(), 0) == 0);
+		TestAssert(Utf8Truncate(a.c_str(), a.size(), 1) == 1);
+		TestAssert(Utf8Truncate(a.c_str(), a.size(), 2) == 3);// doesn't split the e acute
+		TestAssert(Utf8Truncate(a.c_str(), a.size(), 7) == 10);
+		TestAssert(Utf8Truncate(a.c_str(), a.size(), 8) == 14);
+		TestAssert(Utf8Truncate(a.c_str(), a.size(), 9) == 15);
+		TestAssert(Utf8Truncate(a.c_str(), a.size(), 28) == a.size());
+		TestAssert(Utf8Truncate(a.c_str(), a.size(), 1000) == a.size());
+
+		std::wstring w;
+		UTF8ToUTF16(a.c_str(), a.size(), w);
+		TestAssert(w.size() == 29);
+		TestAssert(Utf16CodePointCount(w.c_str(), w.size()) == 28);
+		TestAssert(Utf16Truncate(w.c_str(), w.size(), 7) == 7);
+		TestAssert(Utf16Truncate(w.c_str(), w.size(), 8) == 9);// doesn't split the surrogate pair
+		TestAssert(Utf16Truncate(w.c_str(), w.size(), 1000) == w.size());
+	}
+
+	{// **** StringConvertBatch / StringTable
+		std::vector<std::string> names;
+		for(int i = 0; i < 500; ++ i)
+		{
+			names.push_back(FormatA("item % of the batch").i(i).Str());
+		}
+		names.push_back("");
+		names.push_back("caf\xe9");
+
+		StringTable<wchar_t> table;
+		StringConvertBatch(names, table);
+		TestAssert(table.size() == names.size());
+		TestAssert(table.str(7) == L"item 7 of the batch");
+		TestAssert(table.length(500) == 0 && table.c_str(500)[0] == 0);
+		TestAssert(table[501].str() == ToUTF16(names[501]));
+		TestAssert(table.c_str(1) == table.c_str(0) + table.length(0) + 1);// one buffer
+
+		std::vector<std::wstring> wide;
+		StringConvertBatch(names, wide, 4);// 4 threads regardless of size
+		TestAssert(wide.size() == names.size());
+		bool same = true;
+		for(size_t i = 0; i < names.size(); ++ i)
+		{
+			same = same && wide[i] == table.str(i) && wide[i] == ToUTF16(names[i]);
+		}
+		TestAssert(same);
+
+		std::vector<std::string> back;
+		StringConvertBatch(wide, back, 1);
+		TestAssert(back == names);
+
+		const char* literals[] = { "one", "two", "three" };
+		StringTable<wchar_t> small;
+		StringConvertBatch(literals, 3, small);
+		TestAssert(small.size() == 3 && small.str(2) == L"three");
+		StringConvertBatch(std::vector<std::string>(), small);
+		TestAssert(small.empty());
+	}
+
+	{// **** StringPool / InternedString
+		StringPool<wchar_t> pool(4);
+		InternedString<wchar_t> a = pool.Intern(L"category");
+		InternedString<wchar_t> b = pool.Intern(std::wstring(L"category"));
+		InternedString<wchar_t> c = pool.Intern(L"other");
+		TestAssert(a == b);
+		TestAssert(a != c);
+		TestAssert(a.c_str() == b.c_str());// same storage
+		TestAssert(a.size() == 8);
+		TestAssert(a.hash() == StringHash(L"category"));
+		TestAssert(pool.Intern(StringView<wchar_t>(L"categoryX", 8)) == a);
+		TestAssert(pool.Find(L"other") == c);
+		TestAssert(pool.Find(L"missing").empty());
+		TestAssert(pool.Intern(L"") == InternedString<wchar_t>());
+
+		// grow the table a few times; old handles stay valid
+		std::vector<std::wstring> names;
+		std::vector<InternedString<wchar_t> > handles;
+		for(int i = 0; i < 1000; ++ i)
+		{
+			names.push_back(FormatW(L"name%").i(i).Str());
+			handles.push_back(pool.Intern(names.back()));
+		}
+		TestAssert(pool.size() == 1002);
+		TestAssert(pool.Find(L"category") == a);
+		TestAssert(a.str() == L"category");
+		bool allSame = true;
+		for(int i = 0; i < 1000; ++ i)
+		{
+			allSame = allSame && pool.Intern(names[i]) == handles[i] && handles[i].str() == names[i];
+		}
+		TestAssert(allSame);
+
+		// FormatX references the interned chars
+		TestAssert(FormatW(L"[%] %").s(a).s(L"x").Str() == L"[category] x");
+		TestAssert(FormatW(L"<%>").s(InternedString<wchar_t>()).Str() == L"<>");
+		FormatW f(L"%%%%%%%%%%%%%%%%%%%%");// more args than QuickStringList holds inline
+		std::wstring correct;
+		for(int i = 0; i < 20; ++ i)
+		{
+			f.s(handles[i]);
+			correct.append(names[i]);
+		}
+		TestAssert(f.Str() == correct);
+		FormatW f2(f);
+		TestAssert(f2.Str() == correct);
+
+		// the global pool
+		TestAssert(StringIntern("abc") == StringIntern(std::string("abc")));
+		TestAssert(StringIntern("abc") != StringIntern("abd"));
+
+		// concurrent interning of overlapping names
+		StringPool<char> shared;
+		std::vector<std::thread> threads;
+		std::vector<int> mismatches(4, 0);
+		for(int t = 0; t < 4; ++ t)
+		{
+			threads.push_back(std::thread([&shared, &mismatches, t]()
+			{
+				for(int i = 0; i < 2000; ++ i)
+				{
+					std::string s = FormatA("k%").i((i * 7 + t * 13) % 2000).Str();
+					InternedString<char> h = shared.Intern(s);
+					if(h.str() != s || shared.Find(s) != h)
+						mismatches[t] ++;
+				}
+			}));
+		}
+		for(size_t t = 0; t < threads.size(); ++ t)
+		{
+			threads[t].join();
+		}
+		TestAssert(shared.size() == 2000);
+		TestAssert(mismatches == std::vector<int>(4, 0));
+	}
+
+	{// **** StringRope
+		StringRope<wchar_t> r;
+		TestAssert(r.empty() && r.Str().empty());
+		const wchar_t* lit = L"header ";
+		r.AppendRef(lit);
+		TestAssert(r.ChunkCount() == 1);
+		std::wstring body(L"a rather long body that does not fit inline");
+		const wchar_t* bodyChars = body.c_str();
+		r.Take(body);
+		TestAssert(body.empty());
+		FormatW f(L"[%]");
+		f.i(42);
+		r.Take(f);
+		TestAssert(f.Str().empty());
+		// copies are packed into one chunk
+		r.Append(L"x").Append(std::wstring(L"yz")).Append(L'!');
+		TestAssert(r.ChunkCount() == 4);
+		r.Append(FormatW(L"<%>").s(L"q"));
+		TestAssert(r.ChunkCount() == 4);
+		r.AppendRef(L"", 0);
+		TestAssert(r.ChunkCount() == 4);
+		std::wstring expected = L"header a rather long body that does not fit inline[42]xyz!<q>";
+		TestAssert(r.Str() == expected);
+		TestAssert(r.size() == expected.size());
+		// the taken string was not copied
+		struct FirstChunkSink
+		{
+			std::vector<const wchar_t*> chunks;
+			void Write(const wchar_t* p, size_t) { chunks.push_back(p); }
+		} chunks;
+		r.Render(chunks);
+		TestAssert(chunks.chunks.size() == 4 && chunks.chunks[0] == lit && chunks.chunks[1] == bodyChars);
+
+		// many copies spill over arena chunks
+		std::wstring big;
+		for(int i = 0; i < 5000; ++ i)
+		{
+			std::wstring n = FormatW(L"%,").i(i).Str();
+			r.Append(n);
+			big.append(n);
+		}
+		TestAssert(r.Str() == expected + big);
+		r.clear();
+		TestAssert(r.size() == 0 && r.ChunkCount() == 0 && r.Str().empty());
+
+		// UTF-8 with a surrogate pair split across chunks
+		StringRope<wchar_t> u;
+		const wchar_t pair[] = { L'a', 0xd83d, 0xde00, L'b', 0 };
+		u.AppendRef(pair, 2).AppendRef(pair + 2, 2);
+		struct StringSinkA
+		{
+			std::string out;
+			void Write(const char* p, size_t len) { out.append(p, len); }
+		} a;
+		Utf8Sink<StringSinkA> utf8(a);
+		u.Render(utf8);
+		utf8.Flush();
+		TestAssert(a.out == "a\xf0\x9f\x98\x80" "b");
+
+		// a high surrogate followed by another high surrogate, or by something else, isn't paired
+		const wchar_t unpaired[] = { L'a', 0xd83d, 0xd83d, 0xde00, 0xd83d, L'c', 0 };
+		a.out.clear();
+		utf8.Write(unpaired, 2);
+		utf8.Write(unpaired + 2, 3);
+		utf8.Write(unpaired + 5, 1);
+		utf8.Flush();
+		TestAssert(a.out == "a\xef\xbf\xbd\xf0\x9f\x98\x80\xef\xbf\xbd" "c");
+
+		// straight to a file
+		wchar_t path[MAX_PATH];
+		GetTempPathW(MAX_PATH, path);
+		std::wstring fileName = std::wstring(path) + L"libcc_rope_test.txt";
+		HANDLE h = CreateFileW(fileName.c_str(), GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+		TestAssert(h != INVALID_HANDLE_VALUE);
+		StringRope<char> ra;
+		ra.AppendRef("one ").Append(std::string(100000, 'x')).AppendRef(" two");
+		{
+			HandleSink sink(h, 4096);
+			ra.Render(sink);
+			sink.Flush();
+			TestAssert(!sink.Failed());
+		}
+		CloseHandle(h);
+		h = CreateFileW(fileName.c_str(), GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		std::string readBack(ra.size() + 1, 0);
+		DWORD br = 0;
+		ReadFile(h, &readBack[0], (DWORD)readBack.size(), &br, 0);
+		CloseHandle(h);
+		DeleteFileW(fileName.c_str());
+		readBack.resize(br);
+		TestAssert(readBack == ra.Str());
+	}
+
   return true;
 }
 